@@ -115,12 +115,14 @@ solution (SOL_NAME)
                 
         libdirs { 
             EXT_ROOT .. "nvapi/x86",
+            EXT_ROOT .. "d3dx9/lib"
         }
-        links { "nvapi" }
+        links { "nvapi", "d3dx9" }
         
         includedirs {
             SYTINNI_ROOT .. "/core",
-            EXT_ROOT
+            EXT_ROOT,
+            EXT_ROOT .. "d3dx9/include"
         }
         files {
             SYTINNI_ROOT .. "/core/**.h",
@@ -141,6 +143,84 @@ solution (SOL_NAME)
                 "xcopy /Y /E /d \"" .. SOL_DATA_DIR .. "\" " .. "\"" .. (SOL_BUILD_DIR .. TARGET_DIR .. "RelWithDebInfo") .. "\""
             }
         
+-- portable command line tools, they don't link against the core
+project "event_log_decoder"
+    commonDefines()
+    commonBuildOptions()
+    flags {
+        "FatalWarnings",
+        "NoEditAndContinue",
+        "NoRTTI"
+    }
+    kind "ConsoleApp"
+
+    files {
+        SYTINNI_ROOT .. "/tools/event_log_decoder/**.h",
+        SYTINNI_ROOT .. "/tools/event_log_decoder/**.cpp"
+    }
+
+-- builds the client independent core sources in, see tools/micro_benchmarks/main.cpp for the Linux command line
+project "micro_benchmarks"
+    commonDefines()
+    commonBuildOptions()
+    flags {
+        "FatalWarnings",
+        "NoEditAndContinue",
+        "NoRTTI"
+    }
+    kind "ConsoleApp"
+
+    defines { "UTINNI_STATIC" }
+
+    includedirs {
+        SYTINNI_ROOT .. "/core",
+        EXT_ROOT
+    }
+    files {
+        SYTINNI_ROOT .. "/tools/micro_benchmarks/**.h",
+        SYTINNI_ROOT .. "/tools/micro_benchmarks/**.cpp",
+        SYTINNI_ROOT .. "/core/swg/misc/swg_math.cpp",
+        SYTINNI_ROOT .. "/core/swg/misc/allocation_tracker.cpp",
+        SYTINNI_ROOT .. "/core/utility/pattern_scanner.cpp",
+        SYTINNI_ROOT .. "/core/utility/gpu_query_ring.cpp",
+        SYTINNI_ROOT .. "/core/utility/shader_cache_index.cpp",
+        SYTINNI_ROOT .. "/core/utility/software_fx.cpp",
+        SYTINNI_ROOT .. "/core/utility/colour_lut.cpp",
+        SYTINNI_ROOT .. "/core/utility/readback_ring.cpp",
+        SYTINNI_ROOT .. "/core/utility/depth_pyramid.cpp",
+        SYTINNI_ROOT .. "/core/utility/depth_fx.cpp",
+        SYTINNI_ROOT .. "/core/utility/resolution_controller.cpp"
+    }
+
+-- assertion tests over the same sources, see tools/unit_tests/main.cpp for the Linux command line
+project "unit_tests"
+    commonDefines()
+    commonBuildOptions()
+    flags {
+        "FatalWarnings",
+        "NoEditAndContinue",
+        "NoRTTI"
+    }
+    kind "ConsoleApp"
+
+    defines { "UTINNI_STATIC" }
+
+    includedirs {
+        SYTINNI_ROOT .. "/core",
+        EXT_ROOT
+    }
+    files {
+        SYTINNI_ROOT .. "/tools/unit_tests/**.h",
+        SYTINNI_ROOT .. "/tools/unit_tests/**.cpp",
+        SYTINNI_ROOT .. "/core/utility/pattern_scanner.cpp",
+        SYTINNI_ROOT .. "/core/utility/gpu_query_ring.cpp",
+        SYTINNI_ROOT .. "/core/utility/shader_cache_index.cpp",
+        SYTINNI_ROOT .. "/core/utility/software_fx.cpp",
+        SYTINNI_ROOT .. "/core/utility/depth_fx.cpp",
+        SYTINNI_ROOT .. "/core/utility/resolution_controller.cpp",
+        SYTINNI_ROOT .. "/core/utility/depth_pyramid.cpp"
+    }
+
 function addPlugin(name)
     project (name)
         commonBuild()
@@ -152,6 +152,61 @@ static const IniConfig::Value defaultSettings[] = {
     { "UtinniCore", "autoLoginUsername", "Local", IniConfig::Value::vt_string },
     { "UtinniCore", "plugins", DEFAULT_PLUGINS, IniConfig::Value::vt_string },
 
+    // Allocation tracking settings, sampleRate 0 only counts
+    { "AllocationTracking", "enabled", "false", IniConfig::Value::vt_bool },
+    { "AllocationTracking", "sampleRate", "64", IniConfig::Value::vt_int },
+
+    // Profiler settings, callbackBudgetMs is the per frame budget of a single plugin callback, 0 disables the warnings.
+    // gpuTimings times the post processing and draw phases with timestamp queries
+    { "Profiler", "enabled", "false", IniConfig::Value::vt_bool },
+    { "Profiler", "callbackBudgetMs", "2.0", IniConfig::Value::vt_float },
+    { "Profiler", "gpuTimings", "false", IniConfig::Value::vt_bool },
+
+    // Binary event log settings, crashDumpSeconds of events are written next to utinni.log when the client crashes
+    { "EventLog", "enabled", "true", IniConfig::Value::vt_bool },
+    { "EventLog", "crashDumpSeconds", "10", IniConfig::Value::vt_float },
+
+    // Frame time telemetry settings, writeSessionReport writes the histograms to the telemetry folder when the client closes
+    { "Telemetry", "enabled", "true", IniConfig::Value::vt_bool },
+    { "Telemetry", "writeSessionReport", "true", IniConfig::Value::vt_bool },
+
+    // Draw call and state change counters, logToFile writes every frame to the telemetry folder
+    { "DrawStats", "enabled", "false", IniConfig::Value::vt_bool },
+    { "DrawStats", "logToFile", "false", IniConfig::Value::vt_bool },
+
+    // Redundant state filter, drops device sets that match the shadowed device state before they reach the driver
+    { "StateCache", "filterRedundant", "true", IniConfig::Value::vt_bool },
+
+    // Compiled shader cache, stores plugin and client shader bytecode in the shader_cache folder
+    { "ShaderCache", "enabled", "true", IniConfig::Value::vt_bool },
+    { "ShaderCache", "maxSizeMb", "64", IniConfig::Value::vt_int },
+
+    // Shared render target pool, free targets are released once the pool grows past the budget
+    { "RenderTargetPool", "budgetMb", "256", IniConfig::Value::vt_int },
+
+    // Colour and depth readback for CPU consumers, depth is the number of frames in flight before one is read
+    { "Readback", "depth", "3", IniConfig::Value::vt_int },
+
+    // Hierarchical min/max depth built after every depth resolve, for plugins doing occlusion tests or cheap depth reads
+    { "DepthPyramid", "enabled", "false", IniConfig::Value::vt_bool },
+
+    // Renders the 3D scene at a reduced resolution when frames take longer than targetFps allows, down to minScale of the
+    // width and height, and upscales it before the UI with sharpness as the amount of sharpening
+    { "DynamicResolution", "enabled", "false", IniConfig::Value::vt_bool },
+    { "DynamicResolution", "targetFps", "60", IniConfig::Value::vt_float },
+    { "DynamicResolution", "minScale", "0.5", IniConfig::Value::vt_float },
+    { "DynamicResolution", "sharpness", "0.3", IniConfig::Value::vt_float },
+
+    // Flythrough benchmark settings, autoRun replays benchmarks/<path>.utcp once a scene is loaded. timeOfDay is 0-1 from 06:00
+    { "Benchmark", "autoRun", "false", IniConfig::Value::vt_bool },
+    { "Benchmark", "path", "default", IniConfig::Value::vt_string },
+    { "Benchmark", "exitWhenDone", "false", IniConfig::Value::vt_bool },
+    { "Benchmark", "timeOfDay", "0.25", IniConfig::Value::vt_float },
+    { "Benchmark", "weatherIndex", "0", IniConfig::Value::vt_int },
+    { "Benchmark", "warmupFrames", "120", IniConfig::Value::vt_int },
+    { "Benchmark", "stepsPerSecond", "60", IniConfig::Value::vt_float },
+    { "Benchmark", "keyframeInterval", "0.25", IniConfig::Value::vt_float },
+
     // Log settings
     { "Log", "writeClassName", "false", IniConfig::Value::vt_bool },
     { "Log", "writeFunctionName", "false", IniConfig::Value::vt_bool },
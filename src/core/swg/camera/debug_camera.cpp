@@ -24,10 +24,12 @@
 
 #include "debug_camera.h"
 #include "camera.h"
+#include "flythrough_benchmark.h"
 #include "swg/scene/ground_scene.h"
 #include "swg/object/player_object.h"
 #include "swg/game/game.h"
 #include "utility/memory.h"
+#include "utility/patch_transaction.h"
 
 namespace swg::debugCamera
 {
@@ -187,6 +189,11 @@ float __fastcall hkAlter(GameCamera* pThis, swgptr EDX, float time)
     float result = 0;
     result = swg::debugCamera::alter(pThis, time);
 
+    if (flythroughBenchmark::updatePlayback(pThis))
+    {
+        return result;
+    }
+
     float speedMulti;
     float wheelSpeedMulti;
     if (speedBoost)
@@ -296,6 +303,8 @@ float __fastcall hkAlter(GameCamera* pThis, swgptr EDX, float time)
         playerObject::teleport(pos.X, 0, pos.Z);
     }
 
+    flythroughBenchmark::updateRecording(pThis, time);
+
     return result;
 }
 
@@ -304,9 +313,9 @@ void detour()
     swg::debugCamera::alter = (swg::debugCamera::pAlter)Detour::Create((LPVOID)swg::debugCamera::alter, hkAlter, DETOUR_TYPE_PUSH_RET);
 }
 
-void patch()
+void patch(memory::PatchTransaction& patches)
 {
     // Enable mouse wheel to be sent to debugCamera::alter
-    memory::nopAddress(0x0051AA8D, 2);
+    patches.nop(0x0051AA8D, 2);
 }
 };
@@ -26,6 +26,11 @@
 #include "utinni.h"
 #include "swg/misc/io_win.h"
 
+namespace memory
+{
+class PatchTransaction;
+}
+
 namespace utinni::debugCamera
 {
 enum Commands
@@ -50,5 +55,5 @@ UTINNI_API extern void enableDragPlayer(bool value);
 void processIoEvent(IoEvent* ioEvent);
 
 void detour();
-void patch();
+void patch(memory::PatchTransaction& patches);
 };
@@ -0,0 +1,584 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "flythrough_benchmark.h"
+#include "camera.h"
+#include "swg/game/game.h"
+#include "swg/misc/config.h"
+#include "swg/misc/frame_telemetry.h"
+#include "swg/scene/ground_scene.h"
+#include "swg/scene/terrain.h"
+#include "imgui/imgui.h"
+#include "utility/event_log.h"
+#include "utility/log.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+using utinni::flythroughBenchmark::Keyframe;
+using utinni::frameTelemetry::FrameTimeHistogram;
+
+constexpr const char* fileHeader = "utcp 1";
+
+std::vector<Keyframe> keyframes;
+std::string pathName = "default";
+std::string pathTerrain;
+
+bool recording = false;
+float recordTime = 0;
+float lastKeyframeTime = 0;
+
+bool playing = false;
+uint32_t playFrame = 0;
+uint32_t warmupFrames = 0;
+float stepsPerSecond = 60;
+float fixedTimeOfDay = 0;
+int fixedWeatherIndex = 0;
+float originalTimeOfDay = 0;
+int originalWeatherIndex = 0;
+LARGE_INTEGER frequency{};
+LARGE_INTEGER previousFrame{};
+std::vector<float> frameTimesMs;
+FrameTimeHistogram* histogram = nullptr;
+
+bool autoRun = false;
+bool autoRunStarted = false;
+bool quitWhenDone = false;
+uint32_t autoRunSettleFrames = 0;
+utinni::CallbackHandle autoRunCallback;
+
+std::string lastResult;
+
+std::string getPathFilename(const char* name)
+{
+    return utinni::getPath() + "benchmarks\\" + name + ".utcp";
+}
+
+float catmullRom(float p0, float p1, float p2, float p3, float u)
+{
+    const float u2 = u * u;
+    const float u3 = u2 * u;
+    return 0.5f * ((2 * p1) + (p2 - p0) * u + (2 * p0 - 5 * p1 + 4 * p2 - p3) * u2 + (3 * p1 - p0 - 3 * p2 + p3) * u3);
+}
+
+Keyframe evaluate(float time)
+{
+    const auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time, [](float t, const Keyframe& keyframe) { return t < keyframe.time; });
+    const int count = (int)keyframes.size();
+    const int i2 = std::clamp((int)(next - keyframes.begin()), 1, count - 1);
+    const int i1 = i2 - 1;
+    const Keyframe& k0 = keyframes[std::max(i1 - 1, 0)];
+    const Keyframe& k1 = keyframes[i1];
+    const Keyframe& k2 = keyframes[i2];
+    const Keyframe& k3 = keyframes[std::min(i2 + 1, count - 1)];
+
+    const float span = k2.time - k1.time;
+    const float u = span > 0 ? std::clamp((time - k1.time) / span, 0.0f, 1.0f) : 0.0f;
+
+    Keyframe result;
+    result.time = time;
+    result.position.X = catmullRom(k0.position.X, k1.position.X, k2.position.X, k3.position.X, u);
+    result.position.Y = catmullRom(k0.position.Y, k1.position.Y, k2.position.Y, k3.position.Y, u);
+    result.position.Z = catmullRom(k0.position.Z, k1.position.Z, k2.position.Z, k3.position.Z, u);
+    result.yaw = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, u);
+    result.pitch = catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, u);
+    return result;
+}
+
+void addKeyframe(utinni::GameCamera* camera)
+{
+    swg::math::Transform* transform = camera->getTransform();
+
+    Keyframe keyframe;
+    keyframe.time = recordTime;
+    keyframe.position = transform->getPosition();
+    keyframe.yaw = transform->getYaw_p2l();
+    keyframe.pitch = transform->getPitch_p2l();
+
+    // Unwrap the yaw so the spline doesn't spin the long way round when it crosses +-180
+    if (!keyframes.empty())
+    {
+        const float previousYaw = keyframes.back().yaw;
+        while (keyframe.yaw - previousYaw > 180.0f)
+        {
+            keyframe.yaw -= 360.0f;
+        }
+        while (keyframe.yaw - previousYaw < -180.0f)
+        {
+            keyframe.yaw += 360.0f;
+        }
+    }
+
+    keyframes.emplace_back(keyframe);
+}
+
+void pinEnvironment()
+{
+    utinni::Terrain* terrain = utinni::Terrain::get();
+    if (terrain != nullptr)
+    {
+        terrain->setTimeOfDay(fixedTimeOfDay);
+        terrain->setWeatherIndex(fixedWeatherIndex);
+    }
+}
+
+bool writeReport(float duration)
+{
+    const std::string directory = utinni::getPath() + "telemetry\\";
+    CreateDirectoryA(directory.c_str(), nullptr);
+
+    const time_t now = time(nullptr);
+    tm local{};
+    localtime_s(&local, &now);
+    char date[32];
+    strftime(date, sizeof(date), "%Y%m%d_%H%M%S", &local);
+    const std::string basename = directory + "benchmark_" + pathName + "_" + date;
+
+    FILE* csv = nullptr;
+    if (fopen_s(&csv, (basename + ".csv").c_str(), "w") != 0 || csv == nullptr)
+    {
+        return false;
+    }
+    fprintf(csv, "frame,path_time,frame_ms\n");
+    for (size_t i = 0; i < frameTimesMs.size(); ++i)
+    {
+        fprintf(csv, "%u,%.4f,%.3f\n", (uint32_t)i, (float)(i + 1) / stepsPerSecond, frameTimesMs[i]);
+    }
+    fclose(csv);
+
+    FILE* json = nullptr;
+    if (fopen_s(&json, (basename + ".json").c_str(), "w") != 0 || json == nullptr)
+    {
+        return false;
+    }
+    fprintf(json, "{\n  \"build\": \"%s %s %s\",\n  \"path\": \"%s\",\n  \"terrain\": \"%s\",\n  \"keyframes\": %u,\n  \"pathSeconds\": %.3f,\n",
+            CONFIG_NAME, __DATE__, __TIME__, pathName.c_str(), pathTerrain.c_str(), (uint32_t)keyframes.size(), duration);
+    fprintf(json, "  \"stepsPerSecond\": %.1f,\n  \"warmupFrames\": %u,\n  \"timeOfDay\": %.4f,\n  \"weatherIndex\": %d,\n", stepsPerSecond, warmupFrames,
+            fixedTimeOfDay, fixedWeatherIndex);
+    fprintf(json, "  \"frames\": %llu,\n  \"meanMs\": %.3f,\n  \"minMs\": %.3f,\n  \"p50Ms\": %.3f,\n  \"p95Ms\": %.3f,\n  \"p99Ms\": %.3f,\n  \"maxMs\": %.3f\n}\n",
+            histogram->getCount(), histogram->getMeanUs() / 1000.0, histogram->getMinUs() / 1000.0, histogram->getPercentileUs(50) / 1000.0,
+            histogram->getPercentileUs(95) / 1000.0, histogram->getPercentileUs(99) / 1000.0, histogram->getMaxUs() / 1000.0);
+    fclose(json);
+    return true;
+}
+
+void finish(bool completed)
+{
+    playing = false;
+
+    utinni::Terrain* terrain = utinni::Terrain::get();
+    if (terrain != nullptr)
+    {
+        terrain->setTimeOfDay(originalTimeOfDay);
+        terrain->setWeatherIndex(originalWeatherIndex);
+    }
+
+    if (completed && histogram->getCount() > 0)
+    {
+        const float duration = keyframes.back().time;
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "%s: %llu frames, mean %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms", pathName.c_str(), histogram->getCount(),
+                 histogram->getMeanUs() / 1000.0, histogram->getPercentileUs(95) / 1000.0, histogram->getPercentileUs(99) / 1000.0, histogram->getMaxUs() / 1000.0);
+        lastResult = buffer;
+        utinni::log::info(("Benchmark finished, " + lastResult).c_str());
+
+        if (!writeReport(duration))
+        {
+            utinni::log::error("Failed to write the benchmark report");
+        }
+    }
+    else
+    {
+        lastResult = pathName + ": stopped";
+        utinni::log::info("Benchmark stopped");
+    }
+    UTINNI_EVENT("Benchmark %s", completed ? "finished" : "stopped");
+
+    if (quitWhenDone)
+    {
+        quitWhenDone = false;
+        utinni::Game::quit();
+    }
+}
+
+void onAutoRunMainLoop()
+{
+    if (autoRunStarted)
+    {
+        return;
+    }
+
+    const utinni::GroundScene* scene = utinni::GroundScene::get();
+    if (scene == nullptr || scene->isLoading || utinni::Terrain::get() == nullptr)
+    {
+        autoRunSettleFrames = 0;
+        return;
+    }
+
+    if (keyframes.empty() && !utinni::flythroughBenchmark::loadPath(utinni::getConfig().getString("Benchmark", "path").c_str()))
+    {
+        autoRunStarted = true; // Nothing to run, don't retry every frame
+        return;
+    }
+
+    // Puts the scene on the terrain the path was recorded on, the camera would otherwise fly over an empty world
+    if (!pathTerrain.empty() && pathTerrain != utinni::Terrain::get()->getFilename())
+    {
+        utinni::log::info(("Benchmark loading terrain " + pathTerrain).c_str());
+        utinni::Game::loadScene(pathTerrain.c_str());
+        return;
+    }
+
+    // Lets the streaming settle for a few seconds of frames before the camera is moved
+    if (++autoRunSettleFrames < 300)
+    {
+        return;
+    }
+
+    autoRunStarted = utinni::flythroughBenchmark::play();
+    quitWhenDone = autoRunStarted && utinni::getConfig().getBool("Benchmark", "exitWhenDone");
+}
+}
+
+namespace utinni::flythroughBenchmark
+{
+void startRecording()
+{
+    if (playing)
+    {
+        return;
+    }
+
+    keyframes.clear();
+    recordTime = 0;
+    lastKeyframeTime = 0;
+    recording = true;
+
+    Terrain* terrain = Terrain::get();
+    pathTerrain = terrain != nullptr ? terrain->getFilename() : "";
+    log::info("Benchmark recording started");
+}
+
+void stopRecording()
+{
+    if (!recording)
+    {
+        return;
+    }
+
+    recording = false;
+
+    // Adds the last pose so the path ends where the camera stopped
+    GroundScene* scene = GroundScene::get();
+    if (scene != nullptr && scene->getCurrentCamera() != nullptr && (keyframes.empty() || keyframes.back().time < recordTime))
+    {
+        addKeyframe((GameCamera*)scene->getCurrentCamera());
+    }
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "Benchmark recording stopped, %u keyframes over %.1f seconds", (uint32_t)keyframes.size(), recordTime);
+    log::info(buffer);
+}
+
+bool isRecording()
+{
+    return recording;
+}
+
+bool savePath(const char* name)
+{
+    if (keyframes.size() < 2)
+    {
+        log::error("Benchmark path needs at least two keyframes to be saved");
+        return false;
+    }
+
+    CreateDirectoryA((getPath() + "benchmarks").c_str(), nullptr);
+
+    FILE* file = nullptr;
+    if (fopen_s(&file, getPathFilename(name).c_str(), "w") != 0 || file == nullptr)
+    {
+        log::error(("Failed to save benchmark path " + getPathFilename(name)).c_str());
+        return false;
+    }
+
+    fprintf(file, "%s\nterrain %s\n", fileHeader, pathTerrain.c_str());
+    for (const Keyframe& keyframe : keyframes)
+    {
+        fprintf(file, "keyframe %.4f %.4f %.4f %.4f %.4f %.4f\n", keyframe.time, keyframe.position.X, keyframe.position.Y, keyframe.position.Z, keyframe.yaw,
+                keyframe.pitch);
+    }
+    fclose(file);
+
+    pathName = name;
+    return true;
+}
+
+bool loadPath(const char* name)
+{
+    FILE* file = nullptr;
+    if (fopen_s(&file, getPathFilename(name).c_str(), "r") != 0 || file == nullptr)
+    {
+        log::error(("Failed to open benchmark path " + getPathFilename(name)).c_str());
+        return false;
+    }
+
+    std::vector<Keyframe> loaded;
+    std::string terrain;
+    char line[512];
+    bool valid = fgets(line, sizeof(line), file) != nullptr && strncmp(line, fileHeader, strlen(fileHeader)) == 0;
+    while (valid && fgets(line, sizeof(line), file) != nullptr)
+    {
+        Keyframe keyframe;
+        if (strncmp(line, "terrain ", 8) == 0)
+        {
+            terrain = line + 8;
+            terrain.erase(terrain.find_last_not_of("\r\n") + 1);
+        }
+        else if (sscanf_s(line, "keyframe %f %f %f %f %f %f", &keyframe.time, &keyframe.position.X, &keyframe.position.Y, &keyframe.position.Z, &keyframe.yaw,
+                          &keyframe.pitch) == 6)
+        {
+            valid = loaded.empty() || keyframe.time > loaded.back().time;
+            loaded.emplace_back(keyframe);
+        }
+    }
+    fclose(file);
+
+    if (!valid || loaded.size() < 2)
+    {
+        log::error(("Benchmark path " + getPathFilename(name) + " is invalid").c_str());
+        return false;
+    }
+
+    keyframes = std::move(loaded);
+    pathTerrain = terrain;
+    pathName = name;
+    return true;
+}
+
+const std::vector<Keyframe>& getKeyframes()
+{
+    return keyframes;
+}
+
+bool play()
+{
+    GroundScene* scene = GroundScene::get();
+    Terrain* terrain = Terrain::get();
+    if (recording || playing || keyframes.size() < 2 || scene == nullptr || terrain == nullptr)
+    {
+        return false;
+    }
+
+    if (!pathTerrain.empty() && pathTerrain != terrain->getFilename())
+    {
+        log::warning(("Benchmark path was recorded on " + pathTerrain).c_str());
+    }
+
+    if (!scene->isFreeCameraActive())
+    {
+        scene->toggleFreeCamera();
+    }
+
+    IniConfig& config = getConfig();
+    warmupFrames = (uint32_t)std::max(config.getInt("Benchmark", "warmupFrames"), 0);
+    stepsPerSecond = std::max(config.getFloat("Benchmark", "stepsPerSecond"), 1.0f);
+    fixedTimeOfDay = config.getFloat("Benchmark", "timeOfDay");
+    fixedWeatherIndex = config.getInt("Benchmark", "weatherIndex");
+    originalTimeOfDay = terrain->getTimeOfDay();
+    originalWeatherIndex = terrain->getWeatherIndex();
+
+    if (histogram == nullptr)
+    {
+        histogram = new FrameTimeHistogram();
+    }
+    histogram->reset();
+    frameTimesMs.clear();
+    frameTimesMs.reserve((size_t)(keyframes.back().time * stepsPerSecond) + 1);
+
+    QueryPerformanceFrequency(&frequency);
+    previousFrame.QuadPart = 0;
+    playFrame = 0;
+    playing = true;
+
+    log::info(("Benchmark started, path " + pathName).c_str());
+    UTINNI_EVENT("Benchmark started");
+    return true;
+}
+
+void stop()
+{
+    if (playing)
+    {
+        finish(false);
+    }
+}
+
+bool isPlaying()
+{
+    return playing;
+}
+
+void enableAutoRun(bool enable)
+{
+    autoRun = enable;
+    if (autoRun && !autoRunCallback.isValid())
+    {
+        autoRunCallback = Game::addMainLoopCallback(onAutoRunMainLoop, "Utinni", "Benchmark auto run");
+    }
+    else if (!autoRun)
+    {
+        autoRunCallback.remove();
+    }
+}
+
+bool updatePlayback(GameCamera* camera)
+{
+    if (!playing)
+    {
+        return false;
+    }
+
+    const float duration = keyframes.back().time;
+    const uint32_t frame = playFrame++;
+    const float time = frame < warmupFrames ? 0.0f : (float)(frame - warmupFrames) / stepsPerSecond;
+    if (time > duration)
+    {
+        finish(true);
+        return false;
+    }
+
+    // Frame times are taken between camera updates, the warm up frames only stream in the start of the path
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (frame > warmupFrames && previousFrame.QuadPart != 0)
+    {
+        const uint32_t frameUs = (uint32_t)((now.QuadPart - previousFrame.QuadPart) * 1000000 / frequency.QuadPart);
+        histogram->record(frameUs);
+        frameTimesMs.emplace_back((float)frameUs / 1000.0f);
+    }
+    previousFrame = now;
+
+    pinEnvironment();
+
+    const Keyframe pose = evaluate(time);
+    swg::math::Transform transform;
+    transform.yaw(pose.yaw);
+    transform.pitch(pose.pitch);
+    transform.setPosition(pose.position);
+
+    swg::math::Vector oldPosition = camera->getTransform()->getPosition();
+    camera->setTransform_o2w(transform);
+    camera->positionAndRotationChanged(false, oldPosition);
+    return true;
+}
+
+void updateRecording(GameCamera* camera, float time)
+{
+    if (!recording)
+    {
+        return;
+    }
+
+    const float interval = std::max(getConfig().getFloat("Benchmark", "keyframeInterval"), 0.01f);
+
+    if (keyframes.empty())
+    {
+        addKeyframe(camera);
+        return;
+    }
+
+    recordTime += time;
+    if (recordTime - lastKeyframeTime >= interval)
+    {
+        lastKeyframeTime = recordTime;
+        addKeyframe(camera);
+    }
+}
+
+void drawUi()
+{
+    static char nameBuffer[64] = "default";
+
+    ImGui::Begin("Flythrough Benchmark", nullptr, ImGuiWindowFlags_NoCollapse);
+    {
+        ImGui::InputText("Path name", nameBuffer, sizeof(nameBuffer));
+
+        if (recording)
+        {
+            if (ImGui::Button("Stop recording"))
+            {
+                stopRecording();
+            }
+            ImGui::SameLine();
+            ImGui::Text("%u keyframes, %.1f s", (uint32_t)keyframes.size(), recordTime);
+        }
+        else if (playing)
+        {
+            if (ImGui::Button("Stop benchmark"))
+            {
+                stop();
+            }
+            ImGui::SameLine();
+            ImGui::Text("Frame %u", playFrame);
+        }
+        else
+        {
+            if (ImGui::Button("Record"))
+            {
+                startRecording();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Save"))
+            {
+                savePath(nameBuffer);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Load"))
+            {
+                loadPath(nameBuffer);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Run"))
+            {
+                play();
+            }
+        }
+
+        if (!keyframes.empty())
+        {
+            ImGui::Text("Path %s: %u keyframes, %.1f s on %s", pathName.c_str(), (uint32_t)keyframes.size(), keyframes.back().time, pathTerrain.c_str());
+        }
+
+        if (!lastResult.empty())
+        {
+            ImGui::TextWrapped("Last run %s", lastResult.c_str());
+        }
+    }
+    ImGui::End();
+}
+}
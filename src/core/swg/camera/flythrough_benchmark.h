@@ -0,0 +1,69 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "swg/misc/swg_math.h"
+
+// Repeatable performance runs. Camera paths are recorded from the debug camera as keyframes and replayed as a Catmull-Rom
+// spline, advancing a fixed amount of path time per frame so every run renders the same frames. Time of day and weather
+// are pinned for the run and the frame times are written as a report next to the frame telemetry.
+namespace utinni
+{
+class GameCamera;
+
+namespace flythroughBenchmark
+{
+struct Keyframe
+{
+    float time;
+    swg::math::Vector position;
+    float yaw;
+    float pitch;
+};
+
+UTINNI_API extern void startRecording();
+UTINNI_API extern void stopRecording();
+UTINNI_API extern bool isRecording();
+
+// Paths are stored as benchmarks/<name>.utcp next to the dll
+UTINNI_API extern bool savePath(const char* name);
+UTINNI_API extern bool loadPath(const char* name);
+UTINNI_API extern const std::vector<Keyframe>& getKeyframes();
+
+UTINNI_API extern bool play();
+UTINNI_API extern void stop();
+UTINNI_API extern bool isPlaying();
+
+UTINNI_API extern void drawUi();
+
+// Runs the path from the Benchmark ini section once the scene has loaded, then optionally quits the client
+void enableAutoRun(bool enable);
+
+// Called from the debug camera alter, returns true when the benchmark positioned the camera this frame
+bool updatePlayback(GameCamera* camera);
+void updateRecording(GameCamera* camera, float time);
+}
+}
@@ -27,6 +27,7 @@
 #include "swg/game/game.h"
 #include "swg/misc/direct_input.h"
 #include "ini.h"
+#include "utility/event_log.h"
 #include "utility/memory.h"
 #include "utility/log.h"
 #include "utility/utility.h"
@@ -123,6 +124,11 @@ int __cdecl hkMainLoop(HINSTANCE hInstance, int unk1, int unk2)
 
 long __stdcall hWriteCrashLog(swgptr unk)
 {
+    log::flush();
+    if (eventLog::isEnabled())
+    {
+        eventLog::dump(getPath() + "utinni_crash_events.utev", getConfig().getFloat("EventLog", "crashDumpSeconds"));
+    }
     CreateDirectory((utility::getWorkingDirectory() + "/" + logDir).c_str(), nullptr);
     return swg::client::writeCrashLog(unk);
 }
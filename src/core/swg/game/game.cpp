@@ -25,14 +25,19 @@
 #include "game.h"
 #include "utinni.h"
 #include "utility/memory.h"
+#include "utility/frame_allocator.h"
 #include "swg/client/client.h"
+#include "swg/misc/allocation_tracker.h"
 #include "swg/misc/config.h"
+#include "swg/misc/frame_telemetry.h"
 #include "swg/scene/ground_scene.h"
 #include "swg/scene/world_snapshot.h"
 #include "swg/object/client_object.h"
 #include "swg/object/object.h"
 #include "swg/ui/imgui_impl.h"
+#include "utility/event_log.h"
 #include "utility/log.h"
+#include "utility/profiler.h"
 #include "ini.h"
 
 namespace swg::game
@@ -80,11 +85,11 @@ namespace utinni
 
 namespace Game
 {
-std::vector<std::function<void()>> installCallbacks;
-std::vector<std::function<void()>> preMainLoopCallbacks;
-std::vector<std::function<void()>> mainLoopCallbacks;
-std::vector<std::function<void()>> setSceneCallbacks;
-std::vector<std::function<void()>> cleanUpSceneCallbacks;
+CallbackList<void()> installCallbacks("Game::installCallbacks");
+CallbackList<void()> preMainLoopCallbacks("Game::preMainLoopCallbacks");
+CallbackList<void()> mainLoopCallbacks("Game::mainLoopCallbacks");
+CallbackList<void()> setSceneCallbacks("Game::setSceneCallbacks");
+CallbackList<void()> cleanUpSceneCallbacks("Game::cleanUpSceneCallbacks");
 }
 
 int getMainLoopCount()
@@ -98,17 +103,17 @@ std::string sceneToLoadTerrainFilename;
 std::string sceneToLoadAvatarObjectFilename = "object/creature/player/shared_human_male.iff";
 void __cdecl hkMainLoop(bool presentToWindow, HWND hwnd, int width, int height)
 {
-    for (const auto& func : Game::preMainLoopCallbacks)
-    {
-        func();
-    }
+    profiler::endFrame();
+    callbackBudget::endFrame();
+    UTINNI_PROFILE_ZONE("Game::mainLoop");
+    UTINNI_EVENT("Main loop %d", getMainLoopCount());
+    frameTelemetry::onMainLoop();
+
+    Game::preMainLoopCallbacks.invoke();
 
     swg::game::mainLoop(presentToWindow, hwnd, width, height);    
 
-    for (const auto& func : Game::mainLoopCallbacks)
-    {
-        func();
-    }
+    Game::mainLoopCallbacks.invoke();
 
     if (loadNewScene && sceneCleaned)
     {
@@ -122,19 +127,20 @@ void __cdecl hkMainLoop(bool presentToWindow, HWND hwnd, int width, int height)
         Game::cleanupScene();
         sceneCleaned = true;
     }
+
+    frameArena::reset();
+    allocationTracker::onFrameEnd();
 }
 
 void __cdecl hkInstall(int application)
 {
+    UTINNI_PROFILE_ZONE("Game::install");
     swg::game::install(application);
 
     repository = std::make_unique<Repository>();
     WorldSnapshot::generateHighestId();
 
-    for (const auto& func : Game::installCallbacks)
-    {
-        func();
-    }
+    Game::installCallbacks.invoke();
 
     if (getConfig().getBool("UtinniCore", "autoLoadScene"))
     {
@@ -144,27 +150,25 @@ void __cdecl hkInstall(int application)
 
 void __cdecl hkSetScene(GroundScene* scene)
 {
+    UTINNI_PROFILE_ZONE("Game::setupScene");
+    UTINNI_EVENT("Setup scene %p", scene);
     swg::game::setupScene(scene);
 
     if (scene != nullptr)
     {
-        for (const auto& func : Game::setSceneCallbacks)
-        {
-            func();
-        }
+        Game::setSceneCallbacks.invoke();
     }
 }
 
 void __cdecl hkCleanupScene()
 {
+    UTINNI_PROFILE_ZONE("Game::cleanupScene");
+    UTINNI_EVENT("Cleanup scene");
     swg::game::cleanupScene();
 
     imgui_gizmo::disable();
 
-    for (const auto& func : Game::cleanUpSceneCallbacks)
-    {
-        func();
-    }
+    Game::cleanUpSceneCallbacks.invoke();
 }
 
 void Game::detour()
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "utinni.h"
+#include "utility/callback_list.h"
 #include "swg/misc/repository.h"
 #include <functional>
 
@@ -35,40 +36,40 @@ class Object;
 
 namespace Game
 {
-    extern UTINNI_API std::vector<std::function<void()>> installCallbacks;
-    extern UTINNI_API std::vector<std::function<void()>> preMainLoopCallbacks;
-    extern UTINNI_API std::vector<std::function<void()>> mainLoopCallbacks;
-    extern UTINNI_API std::vector<std::function<void()>> setSceneCallbacks;
-    extern UTINNI_API std::vector<std::function<void()>> cleanUpSceneCallbacks;
+    extern UTINNI_API CallbackList<void()> installCallbacks;
+    extern UTINNI_API CallbackList<void()> preMainLoopCallbacks;
+    extern UTINNI_API CallbackList<void()> mainLoopCallbacks;
+    extern UTINNI_API CallbackList<void()> setSceneCallbacks;
+    extern UTINNI_API CallbackList<void()> cleanUpSceneCallbacks;
 
     template<typename T>
-    void addInstallCallback(T func)
+    CallbackHandle addInstallCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        installCallbacks.emplace_back(func);
+        return installCallbacks.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPreMainLoopCallback(T func)
+    CallbackHandle addPreMainLoopCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        preMainLoopCallbacks.emplace_back(func);
+        return preMainLoopCallbacks.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addMainLoopCallback(T func)
+    CallbackHandle addMainLoopCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        mainLoopCallbacks.emplace_back(func);
+        return mainLoopCallbacks.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addSetSceneCallback(T func)
+    CallbackHandle addSetSceneCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        setSceneCallbacks.emplace_back(func);
+        return setSceneCallbacks.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addCleanupSceneCallback(T func)
+    CallbackHandle addCleanupSceneCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        cleanUpSceneCallbacks.emplace_back(func);
+        return cleanUpSceneCallbacks.add(func, owner, name, priority);
     }
         
     UTINNI_API void detour();
@@ -0,0 +1,394 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "depth_pyramid.h"
+#include "render_target_pool.h"
+#include "shader_cache.h"
+#include "gpu_profiler.h"
+#include "utility/log.h"
+#include "utility/profiler.h"
+#include "utility/readback_ring.h"
+#include <vector>
+
+namespace
+{
+using utinni::gpu::ReadbackRing;
+
+constexpr uint32_t cpuMaxWidth = 256; // The first level at most this wide is read back, 240x135 at 1080p
+
+struct Vertex
+{
+    float x, y, z, rhw;
+    float u, v;
+};
+
+bool enabled = false;
+bool supported = true; // Until the device turns out not to render to G32R32F
+bool checkedSupport = false;
+
+UINT baseWidth = 0;
+UINT baseHeight = 0;
+std::vector<utinni::renderTargetPool::Lease> levels;
+utinni::shaderCache::BinaryPtr binaries[2]; // From depth, from the level below
+IDirect3DPixelShader9* shaders[2] = {};
+
+ReadbackRing ring;
+IDirect3DSurface9* readbackSurfaces[ReadbackRing::maxSlots] = {};
+uint32_t readbackLevel = 0;
+uint64_t frame = 0;
+uint64_t readbackFrame = 0; // Present the last capture was made in, one per present
+utinni::gpu::DepthPyramid cpuPyramid;
+uint64_t cpuPyramidFrame = 0;
+
+bool checkSupport(IDirect3DDevice9* device)
+{
+    IDirect3D9* d3d = nullptr;
+    D3DDEVICE_CREATION_PARAMETERS parameters;
+    D3DDISPLAYMODE mode;
+    if (FAILED(device->GetDirect3D(&d3d)))
+    {
+        return false;
+    }
+
+    const bool result = SUCCEEDED(device->GetCreationParameters(&parameters)) && SUCCEEDED(device->GetDisplayMode(0, &mode)) &&
+                        SUCCEEDED(d3d->CheckDeviceFormat(parameters.AdapterOrdinal, parameters.DeviceType, mode.Format, D3DUSAGE_RENDERTARGET, D3DRTYPE_TEXTURE, D3DFMT_G32R32F));
+    d3d->Release();
+    return result;
+}
+
+void releaseReadback()
+{
+    ring.reset();
+    for (IDirect3DSurface9*& surface : readbackSurfaces)
+    {
+        if (surface != nullptr)
+        {
+            surface->Release();
+            surface = nullptr;
+        }
+    }
+}
+
+void releaseLevels()
+{
+    levels.clear();
+    releaseReadback();
+    baseWidth = 0;
+    baseHeight = 0;
+}
+
+bool createLevels(IDirect3DDevice9* device, UINT width, UINT height)
+{
+    releaseLevels();
+    baseWidth = width;
+    baseHeight = height;
+
+    readbackLevel = 0;
+    while (width > 1 || height > 1)
+    {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+
+        utinni::renderTargetPool::Lease level = utinni::renderTargetPool::acquire(device, width, height, D3DFMT_G32R32F);
+        if (!level.isValid())
+        {
+            releaseLevels();
+            return false;
+        }
+
+        if (width > cpuMaxWidth)
+        {
+            readbackLevel = (uint32_t)levels.size() + 1;
+        }
+        levels.emplace_back(std::move(level));
+    }
+    return !levels.empty();
+}
+
+bool createShaders(IDirect3DDevice9* device)
+{
+    if (binaries[0] == nullptr)
+    {
+        binaries[0] = utinni::shaderCache::request("shaders/depth_pyramid.ps", "ps_2_0", "main", { { "FROM_DEPTH", "1" } });
+        binaries[1] = utinni::shaderCache::request("shaders/depth_pyramid.ps", "ps_2_0");
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        if (shaders[i] == nullptr && binaries[i]->isCompiled())
+        {
+            device->CreatePixelShader((const DWORD*)binaries[i]->bytecode.data(), &shaders[i]);
+        }
+    }
+    return shaders[0] != nullptr && shaders[1] != nullptr;
+}
+
+void drawLevel(IDirect3DDevice9* device, IDirect3DTexture9* source, uint32_t level)
+{
+    D3DSURFACE_DESC sourceDesc;
+    D3DSURFACE_DESC desc;
+    source->GetLevelDesc(0, &sourceDesc);
+    levels[level].getTexture()->GetLevelDesc(0, &desc);
+
+    // Pretransformed and offset by half a pixel, so the centre of pixel x has u = (2x + 1) / source width
+    const float right = (float)desc.Width - 0.5f;
+    const float bottom = (float)desc.Height - 0.5f;
+    const float u = (float)(desc.Width * 2) / (float)sourceDesc.Width;
+    const float v = (float)(desc.Height * 2) / (float)sourceDesc.Height;
+    const Vertex vertices[4] = {
+        { -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f },
+        { right, -0.5f, 0.0f, 1.0f, u, 0.0f },
+        { -0.5f, bottom, 0.0f, 1.0f, 0.0f, v },
+        { right, bottom, 0.0f, 1.0f, u, v },
+    };
+    const float texelSize[4] = { 1.0f / (float)sourceDesc.Width, 1.0f / (float)sourceDesc.Height, 0.0f, 0.0f };
+
+    device->SetRenderTarget(0, levels[level].getSurface());
+    device->SetPixelShader(shaders[level == 0 ? 0 : 1]);
+    device->SetPixelShaderConstantF(0, texelSize, 1);
+    device->SetTexture(0, source);
+    device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP, 2, vertices, sizeof(Vertex));
+}
+
+void drawLevels(IDirect3DDevice9* device, IDirect3DTexture9* depth)
+{
+    IDirect3DStateBlock9* stateBlock = nullptr;
+    if (FAILED(device->CreateStateBlock(D3DSBT_ALL, &stateBlock)))
+    {
+        return;
+    }
+    stateBlock->Capture();
+
+    IDirect3DSurface9* previousTarget = nullptr;
+    IDirect3DSurface9* previousDepthStencil = nullptr;
+    device->GetRenderTarget(0, &previousTarget);
+    device->GetDepthStencilSurface(&previousDepthStencil);
+
+    device->SetDepthStencilSurface(nullptr);
+    device->SetRenderState(D3DRS_ZENABLE, FALSE);
+    device->SetRenderState(D3DRS_STENCILENABLE, FALSE);
+    device->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+    device->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
+    device->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
+    device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+    device->SetRenderState(D3DRS_SRGBWRITEENABLE, FALSE);
+    device->SetRenderState(D3DRS_COLORWRITEENABLE, 0x0F);
+    device->SetVertexShader(nullptr);
+    device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_POINT);
+    device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_POINT);
+    device->SetSamplerState(0, D3DSAMP_MIPFILTER, D3DTEXF_NONE);
+    device->SetSamplerState(0, D3DSAMP_ADDRESSU, D3DTADDRESS_CLAMP);
+    device->SetSamplerState(0, D3DSAMP_ADDRESSV, D3DTADDRESS_CLAMP);
+    device->SetSamplerState(0, D3DSAMP_SRGBTEXTURE, FALSE);
+    device->SetFVF(D3DFVF_XYZRHW | D3DFVF_TEX1);
+
+    drawLevel(device, depth, 0);
+    for (uint32_t level = 1; level < levels.size(); ++level)
+    {
+        drawLevel(device, levels[level - 1].getTexture(), level);
+    }
+
+    device->SetTexture(0, nullptr);
+    device->SetRenderTarget(0, previousTarget);
+    device->SetDepthStencilSurface(previousDepthStencil);
+    if (previousTarget != nullptr)
+    {
+        previousTarget->Release();
+    }
+    if (previousDepthStencil != nullptr)
+    {
+        previousDepthStencil->Release();
+    }
+
+    stateBlock->Apply();
+    stateBlock->Release();
+}
+
+// Copies the small level to system memory once per present, it's locked when the ring hands it back
+void captureReadback(IDirect3DDevice9* device)
+{
+    if (readbackFrame == frame)
+    {
+        return;
+    }
+
+    const int slot = ring.beginCapture(frame);
+    if (slot < 0)
+    {
+        return;
+    }
+    readbackFrame = frame;
+
+    D3DSURFACE_DESC desc;
+    levels[readbackLevel].getTexture()->GetLevelDesc(0, &desc);
+    IDirect3DSurface9*& surface = readbackSurfaces[slot];
+    if (surface == nullptr && FAILED(device->CreateOffscreenPlainSurface(desc.Width, desc.Height, D3DFMT_G32R32F, D3DPOOL_SYSTEMMEM, &surface, nullptr)))
+    {
+        surface = nullptr;
+    }
+
+    if (surface == nullptr || FAILED(device->GetRenderTargetData(levels[readbackLevel].getSurface(), surface)))
+    {
+        ring.release((uint32_t)slot);
+    }
+}
+
+void deliverReadback()
+{
+    for (int slot = ring.getReadySlot(frame); slot >= 0; slot = ring.getReadySlot(frame))
+    {
+        IDirect3DSurface9* surface = readbackSurfaces[slot];
+        D3DLOCKED_RECT locked;
+        const HRESULT result = surface->LockRect(&locked, nullptr, D3DLOCK_READONLY | D3DLOCK_DONOTWAIT);
+        if (result == D3DERR_WASSTILLDRAWING)
+        {
+            return;
+        }
+
+        if (SUCCEEDED(result))
+        {
+            D3DSURFACE_DESC desc;
+            surface->GetDesc(&desc);
+
+            static std::vector<float> ranges;
+            ranges.resize((size_t)desc.Width * desc.Height * 2);
+            utinni::gpu::packRows(locked.pBits, (uint32_t)locked.Pitch, desc.Width * 8, desc.Height, (uint8_t*)ranges.data());
+            surface->UnlockRect();
+
+            cpuPyramid.buildFromRanges(ranges.data(), desc.Width, desc.Height, readbackLevel + 1, baseWidth, baseHeight);
+            cpuPyramidFrame = ring.getCaptureFrame((uint32_t)slot);
+        }
+        ring.release((uint32_t)slot);
+    }
+}
+}
+
+namespace utinni::depthPyramid
+{
+void enable(bool enable)
+{
+    enabled = enable;
+    if (!enabled)
+    {
+        releaseLevels();
+        cpuPyramid.clear();
+    }
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+bool isSupported()
+{
+    return supported;
+}
+
+uint32_t getLevelCount()
+{
+    return (uint32_t)levels.size();
+}
+
+IDirect3DTexture9* getLevelTexture(uint32_t level)
+{
+    return level < levels.size() ? levels[level].getTexture() : nullptr;
+}
+
+const gpu::DepthPyramid& getCpuPyramid()
+{
+    return cpuPyramid;
+}
+
+uint64_t getCpuPyramidAge()
+{
+    return frame - cpuPyramidFrame;
+}
+
+void build(IDirect3DDevice9* device, IDirect3DTexture9* depth)
+{
+    if (!enabled || depth == nullptr)
+    {
+        return;
+    }
+
+    if (!checkedSupport)
+    {
+        checkedSupport = true;
+        supported = checkSupport(device);
+        if (!supported)
+        {
+            log::warning("Depth pyramid: the device can't render to G32R32F, the pyramid is disabled");
+        }
+    }
+
+    if (!supported || !createShaders(device))
+    {
+        return;
+    }
+
+    UTINNI_PROFILE_ZONE("DepthPyramid::build");
+    UTINNI_GPU_ZONE("DepthPyramid::build");
+
+    D3DSURFACE_DESC desc;
+    depth->GetLevelDesc(0, &desc);
+    if ((desc.Width != baseWidth || desc.Height != baseHeight || levels.empty() || !levels[0].isValid()) && !createLevels(device, desc.Width, desc.Height))
+    {
+        return;
+    }
+
+    drawLevels(device, depth);
+    captureReadback(device);
+}
+
+void onPresent()
+{
+    frame++;
+    if (enabled)
+    {
+        deliverReadback();
+    }
+}
+
+void onReset()
+{
+    // The levels come back empty from the pool, they're acquired again on the next build
+    releaseLevels();
+}
+
+void releaseAll()
+{
+    releaseLevels();
+    cpuPyramid.clear();
+    for (int i = 0; i < 2; ++i)
+    {
+        if (shaders[i] != nullptr)
+        {
+            shaders[i]->Release();
+            shaders[i] = nullptr;
+        }
+        binaries[i] = nullptr;
+    }
+}
+}
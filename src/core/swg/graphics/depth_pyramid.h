@@ -0,0 +1,55 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "utility/depth_pyramid.h"
+#include <d3d9.h>
+
+// Hierarchical min/max depth built from the depth the TextureResolver resolves, right before its callbacks run, so
+// plugins can sample depth at a fraction of the cost or test bounds for occlusion. The GPU levels are D3DFMT_G32R32F with
+// the min in r and the max in g, level i being the depth halved i + 1 times. A small level is read back asynchronously
+// and completed into gpu::DepthPyramid for CPU tests like culling overlays or picking without a collision raycast.
+namespace utinni::depthPyramid
+{
+UTINNI_API extern void enable(bool enable);
+UTINNI_API extern bool isEnabled();
+UTINNI_API extern bool isSupported();
+
+// Valid until the next resolve, or the size changes
+UTINNI_API extern uint32_t getLevelCount();
+UTINNI_API extern IDirect3DTexture9* getLevelTexture(uint32_t level);
+
+// The CPU copy lags the GPU by a few presents, tests against it are only conservative while the camera is still. Base
+// pixels are those of the depth texture
+UTINNI_API extern const gpu::DepthPyramid& getCpuPyramid();
+UTINNI_API extern uint64_t getCpuPyramidAge(); // Presents since the depth in the CPU copy was resolved
+
+// Called by the TextureResolver and the device hooks
+void build(IDirect3DDevice9* device, IDirect3DTexture9* depth);
+void onPresent();
+void onReset();
+void releaseAll();
+}
@@ -30,8 +30,20 @@
 #include "swg/ui/imgui_impl.h"
 #include "swg/ui/cui_manager.h"
 #include "texture_resolver.h"
+#include "gpu_profiler.h"
+#include "draw_stats.h"
+#include "state_cache.h"
+#include "render_target_pool.h"
+#include "readback.h"
+#include "depth_pyramid.h"
+#include "dynamic_resolution.h"
+#include "shader_cache.h"
 #include "graphics.h"
 #include "utility/memory.h"
+#include "utility/address_resolver.h"
+#include "utility/log.h"
+#include "utility/event_log.h"
+#include "utility/profiler.h"
 
 namespace directX
 {
@@ -51,7 +63,20 @@ using pReset = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, D3DPRESENT_PARAMET
 using pDrawIndexedPrimitive = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, D3DPRIMITIVETYPE type, int baseVertexIndex, unsigned int minIndex, unsigned int numVertices, unsigned int startIndex, unsigned int primitiveCount);
 using pSetRenderTarget = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, DWORD index, IDirect3DSurface9* surface);
 using pSetDepthStencil = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, IDirect3DSurface9* surface);
+using pSetViewport = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, const D3DVIEWPORT9* viewport);
 using pSetRenderState = HRESULT(__stdcall*) (LPDIRECT3DDEVICE9 pDevice, D3DRENDERSTATETYPE State, DWORD Value);
+using pDrawPrimitive = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, D3DPRIMITIVETYPE type, unsigned int startVertex, unsigned int primitiveCount);
+using pDrawPrimitiveUP = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, D3DPRIMITIVETYPE type, unsigned int primitiveCount, const void* vertexData, unsigned int vertexStride);
+using pDrawIndexedPrimitiveUP = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, D3DPRIMITIVETYPE type, unsigned int minVertexIndex, unsigned int numVertices, unsigned int primitiveCount, const void* indexData, D3DFORMAT indexFormat, const void* vertexData, unsigned int vertexStride);
+using pSetTexture = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, DWORD stage, IDirect3DBaseTexture9* texture);
+using pSetVertexShader = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, IDirect3DVertexShader9* shader);
+using pSetPixelShader = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, IDirect3DPixelShader9* shader);
+using pSetSamplerState = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value);
+using pSetShaderConstantF = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, UINT startRegister, const float* data, UINT vector4fCount);
+using pCreateStateBlock = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, D3DSTATEBLOCKTYPE type, IDirect3DStateBlock9** stateBlock);
+using pBeginStateBlock = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice);
+using pEndStateBlock = HRESULT(__stdcall*)(LPDIRECT3DDEVICE9 pDevice, IDirect3DStateBlock9** stateBlock);
+using pStateBlockApply = HRESULT(__stdcall*)(IDirect3DStateBlock9* stateBlock);
 
 using pCompileShader = HRESULT(__stdcall*)(LPCSTR pSrcData, UINT srcDataLen, LPVOID* pDefines, LPVOID pInclude, LPCSTR pFunctionName, LPCSTR pProfile, DWORD Flags, LPVOID* ppShader, LPVOID* ppErrorMsgs, LPVOID* ppConstantTable);
 
@@ -62,7 +87,30 @@ pReset reset;
 pDrawIndexedPrimitive drawIndexedPrimitive;
 pSetRenderTarget setRenderTarget;
 pSetDepthStencil setDepthStencil;
+pSetViewport setViewport;
 pSetRenderState setRenderState;
+pDrawPrimitive drawPrimitive;
+pDrawPrimitiveUP drawPrimitiveUP;
+pDrawIndexedPrimitiveUP drawIndexedPrimitiveUP;
+pSetTexture setTexture;
+pSetVertexShader setVertexShader;
+pSetPixelShader setPixelShader;
+pSetSamplerState setSamplerState;
+pSetShaderConstantF setVertexShaderConstantF;
+pSetShaderConstantF setPixelShaderConstantF;
+pCreateStateBlock createStateBlock;
+pBeginStateBlock beginStateBlock;
+pEndStateBlock endStateBlock;
+pStateBlockApply stateBlockApply = nullptr;
+
+void setFillMode(LPDIRECT3DDEVICE9 pDevice, DWORD fillMode)
+{
+    DWORD current = 0;
+    if (!utinni::stateCache::getRenderState(D3DRS_FILLMODE, current) || current != fillMode)
+    {
+        pDevice->SetRenderState(D3DRS_FILLMODE, fillMode);
+    }
+}
 
 pCompileShader compileShader = (pCompileShader)0x62A4F9DB; // from s207_r.dll
 
@@ -190,8 +238,19 @@ enum D3DInformation
 	 d3di_NumberOfFunctions = 118
 };
 
+enum D3DStateBlockInformation
+{
+	 d3dsbi_Queryinterface_Index = 0,
+	 d3dsbi_AddRef_Index = 1,
+	 d3dsbi_Release_Index = 2,
+	 d3dsbi_GetDevice_Index = 3,
+	 d3dsbi_Capture_Index = 4,
+	 d3dsbi_Apply_Index = 5
+};
+
 HRESULT __stdcall hkBeginScene(LPDIRECT3DDEVICE9 pDevice)
 {
+    UTINNI_PROFILE_ZONE("DirectX::beginScene");
 	 if (pDirectXDevice == nullptr)
 	 {
 		  pDirectXDevice = pDevice;
@@ -206,6 +265,7 @@ HRESULT __stdcall hkBeginScene(LPDIRECT3DDEVICE9 pDevice)
 
 HRESULT __stdcall hkEndScene(LPDIRECT3DDEVICE9 pDevice)
 {
+    UTINNI_PROFILE_ZONE("DirectX::endScene");
     //auto depthTexture = directX::getTextureResolver();
     //if (depthTexture != nullptr && depthTexture->isSupported() && depthTexture->getTextureDepth() != nullptr)
     //{
@@ -218,10 +278,19 @@ HRESULT __stdcall hkEndScene(LPDIRECT3DDEVICE9 pDevice)
 
 HRESULT __stdcall hkPresent(LPDIRECT3DDEVICE9 pDevice, const RECT* pSourceRect, const RECT* pDestRect, HWND hDestWindowOverride, const RGNDATA* pDirtyRegion)
 {
+    UTINNI_PROFILE_ZONE("DirectX::present");
 	 HRESULT result = 0;
 
+    // Before the overlay, so captured frames don't include the UI
+    utinni::readback::onPresent(pDevice);
 	 imgui_impl::render();
 
+    // Ends the GPU frame before the present, so the timestamps don't include waiting on vsync
+    utinni::gpuProfiler::onPresent(pDevice);
+    utinni::depthPyramid::onPresent();
+    utinni::dynamicResolution::onPresent();
+    utinni::drawStats::onFrameEnd();
+
 	 // Workaround for WinForms crashes on maximize and minimize/restore, something breaks inside of Present when either occur.
     // ToDo: Find better solution in the future
 	 if (!blockPresentCall)
@@ -239,24 +308,35 @@ HRESULT __stdcall hkPresent(LPDIRECT3DDEVICE9 pDevice, const RECT* pSourceRect,
 		  depthTexture = new TextureResolver();
 	 }
 
-	 if (utinni::Graphics::getCurrentRenderTargetWidth() > 0 && depthTexture->getTextureDepth() == nullptr)
+	 const int width = utinni::Graphics::getCurrentRenderTargetWidth();
+	 const int height = utinni::Graphics::getCurrentRenderTargetHeight();
+	 if (width > 0 && (depthTexture->getTextureDepth() == nullptr || !depthTexture->hasSize(width, height)))
 	 {
-		  depthTexture->createTexture(pDevice, utinni::Graphics::getCurrentRenderTargetWidth(), utinni::Graphics::getCurrentRenderTargetHeight());
+		  depthTexture->createTexture(pDevice, width, height);
 		  //utinni::log::info("Creating Texture");
 	 }
 
+	 utinni::renderTargetPool::onPresent();
 	 imgui_impl::setup(pDevice);
     return result;
 }
 
 HRESULT __stdcall hkReset(LPDIRECT3DDEVICE9 pDevice, D3DPRESENT_PARAMETERS* pPresentationParameters)
 {
+    UTINNI_PROFILE_ZONE("DirectX::reset");
+    UTINNI_EVENT("Device reset to %ux%u, windowed %d", pPresentationParameters->BackBufferWidth, pPresentationParameters->BackBufferHeight, pPresentationParameters->Windowed);
 	 if (depthTexture != nullptr && depthTexture->getTextureDepth() != nullptr)
 	 {
 		  depthTexture->release();
 		  //utinni::log::info("Releasing Texture");
 	 }
 
+	 utinni::gpuProfiler::onReset();
+	 utinni::readback::onReset();
+	 utinni::depthPyramid::onReset();
+	 utinni::dynamicResolution::onReset();
+	 utinni::renderTargetPool::releaseAll();
+	 utinni::stateCache::invalidate();
 	 ImGui_ImplDX9_InvalidateDeviceObjects();
     HRESULT result = reset(pDevice, pPresentationParameters);
 	 ImGui_ImplDX9_CreateDeviceObjects();
@@ -266,54 +346,218 @@ HRESULT __stdcall hkReset(LPDIRECT3DDEVICE9 pDevice, D3DPRESENT_PARAMETERS* pPre
 
 HRESULT __stdcall hkDrawIndexedPrimitive(LPDIRECT3DDEVICE9 pDevice, D3DPRIMITIVETYPE type, int baseVertexIndex, unsigned int minVertexIndex, unsigned int numVertices, unsigned int startIndex, unsigned int primitiveCount)
 {
-    if (pDevice != nullptr && ((enableWireframe && utinni::CuiManager::isRenderingUi()) || (enableWireframe && imgui_impl::isRendering()) || !enableWireframe))
-    {
-        pDevice->SetRenderState(D3DRS_FILLMODE, D3DFILL_SOLID);
-    }
-    else if (pDevice != nullptr && enableWireframe && !utinni::CuiManager::isRenderingUi() && !imgui_impl::isRendering())
+    if (pDevice != nullptr)
     {
-        pDevice->SetRenderState(D3DRS_FILLMODE, D3DFILL_WIREFRAME);
+        const bool wireframe = enableWireframe && !utinni::CuiManager::isRenderingUi() && !imgui_impl::isRendering();
+        setFillMode(pDevice, wireframe ? D3DFILL_WIREFRAME : D3DFILL_SOLID);
     }
 
+    utinni::drawStats::onDraw(primitiveCount);
     HRESULT result = drawIndexedPrimitive(pDevice, type, baseVertexIndex, minVertexIndex, numVertices, startIndex, primitiveCount);
     return result;
 }
 
 HRESULT _stdcall hkSetRenderTarget(LPDIRECT3DDEVICE9 pDevice, DWORD index, IDirect3DSurface9* surface)
 {
-    pDevice->SetRenderState(D3DRS_FILLMODE, D3DFILL_SOLID); // Sets the FillMode to Solid before post processing for Wireframe to work
+    setFillMode(pDevice, D3DFILL_SOLID); // Sets the FillMode to Solid before post processing for Wireframe to work
+
+    utinni::drawStats::onRenderTargetSet(utinni::stateCache::isRenderTargetChange(index, surface));
     HRESULT result = setRenderTarget(pDevice, index, surface);
+    utinni::dynamicResolution::onSetRenderTarget(pDevice, index, surface);
     return result;
 }
 
 HRESULT __stdcall hkSetDepthStencil(LPDIRECT3DDEVICE9 pDevice, IDirect3DSurface9* surface)
 {
+    utinni::drawStats::onDepthStencilSet(utinni::stateCache::isDepthStencilChange(surface));
 	 HRESULT result = setDepthStencil(pDevice, surface);
     return result;
 }
 
+HRESULT __stdcall hkSetViewport(LPDIRECT3DDEVICE9 pDevice, const D3DVIEWPORT9* viewport)
+{
+    D3DVIEWPORT9 scaled;
+    if (viewport != nullptr && utinni::dynamicResolution::scaleViewport(*viewport, scaled))
+    {
+        return setViewport(pDevice, &scaled);
+    }
+    return setViewport(pDevice, viewport);
+}
+
 HRESULT __stdcall hkSetRenderState(LPDIRECT3DDEVICE9 pDevice, D3DRENDERSTATETYPE State, DWORD Value)
 {
+    const bool redundant = utinni::stateCache::isRedundantRenderState(State, Value);
+    utinni::drawStats::onRenderStateSet(redundant);
+    if (redundant && utinni::stateCache::isFilteringEnabled())
+    {
+        return D3D_OK;
+    }
     return setRenderState(pDevice, State, Value);
 }
 
+HRESULT __stdcall hkDrawPrimitive(LPDIRECT3DDEVICE9 pDevice, D3DPRIMITIVETYPE type, unsigned int startVertex, unsigned int primitiveCount)
+{
+    utinni::drawStats::onDraw(primitiveCount);
+    return drawPrimitive(pDevice, type, startVertex, primitiveCount);
+}
+
+HRESULT __stdcall hkDrawPrimitiveUP(LPDIRECT3DDEVICE9 pDevice, D3DPRIMITIVETYPE type, unsigned int primitiveCount, const void* vertexData, unsigned int vertexStride)
+{
+    utinni::drawStats::onDraw(primitiveCount);
+    return drawPrimitiveUP(pDevice, type, primitiveCount, vertexData, vertexStride);
+}
+
+HRESULT __stdcall hkDrawIndexedPrimitiveUP(LPDIRECT3DDEVICE9 pDevice, D3DPRIMITIVETYPE type, unsigned int minVertexIndex, unsigned int numVertices, unsigned int primitiveCount, const void* indexData, D3DFORMAT indexFormat, const void* vertexData, unsigned int vertexStride)
+{
+    utinni::drawStats::onDraw(primitiveCount);
+    return drawIndexedPrimitiveUP(pDevice, type, minVertexIndex, numVertices, primitiveCount, indexData, indexFormat, vertexData, vertexStride);
+}
+
+HRESULT __stdcall hkSetTexture(LPDIRECT3DDEVICE9 pDevice, DWORD stage, IDirect3DBaseTexture9* texture)
+{
+    const bool redundant = utinni::stateCache::isRedundantTexture(stage, texture);
+    utinni::drawStats::onTextureSet(redundant);
+    if (redundant && utinni::stateCache::isFilteringEnabled())
+    {
+        return D3D_OK;
+    }
+    return setTexture(pDevice, stage, texture);
+}
+
+HRESULT __stdcall hkSetVertexShader(LPDIRECT3DDEVICE9 pDevice, IDirect3DVertexShader9* shader)
+{
+    const bool redundant = utinni::stateCache::isRedundantVertexShader(shader);
+    utinni::drawStats::onShaderSet(redundant);
+    if (redundant && utinni::stateCache::isFilteringEnabled())
+    {
+        return D3D_OK;
+    }
+    return setVertexShader(pDevice, shader);
+}
+
+HRESULT __stdcall hkSetPixelShader(LPDIRECT3DDEVICE9 pDevice, IDirect3DPixelShader9* shader)
+{
+    const bool redundant = utinni::stateCache::isRedundantPixelShader(shader);
+    utinni::drawStats::onShaderSet(redundant);
+    if (redundant && utinni::stateCache::isFilteringEnabled())
+    {
+        return D3D_OK;
+    }
+    return setPixelShader(pDevice, shader);
+}
+
+HRESULT __stdcall hkSetSamplerState(LPDIRECT3DDEVICE9 pDevice, DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value)
+{
+    const bool redundant = utinni::stateCache::isRedundantSamplerState(sampler, type, value);
+    utinni::drawStats::onSamplerStateSet(redundant);
+    if (redundant && utinni::stateCache::isFilteringEnabled())
+    {
+        return D3D_OK;
+    }
+    return setSamplerState(pDevice, sampler, type, value);
+}
+
+HRESULT __stdcall hkSetVertexShaderConstantF(LPDIRECT3DDEVICE9 pDevice, UINT startRegister, const float* data, UINT vector4fCount)
+{
+    const bool redundant = utinni::stateCache::isRedundantVertexShaderConstants(startRegister, data, vector4fCount);
+    utinni::drawStats::onShaderConstantSet(redundant);
+    if (redundant && utinni::stateCache::isFilteringEnabled())
+    {
+        return D3D_OK;
+    }
+    return setVertexShaderConstantF(pDevice, startRegister, data, vector4fCount);
+}
+
+HRESULT __stdcall hkSetPixelShaderConstantF(LPDIRECT3DDEVICE9 pDevice, UINT startRegister, const float* data, UINT vector4fCount)
+{
+    const bool redundant = utinni::stateCache::isRedundantPixelShaderConstants(startRegister, data, vector4fCount);
+    utinni::drawStats::onShaderConstantSet(redundant);
+    if (redundant && utinni::stateCache::isFilteringEnabled())
+    {
+        return D3D_OK;
+    }
+    return setPixelShaderConstantF(pDevice, startRegister, data, vector4fCount);
+}
+
+HRESULT __stdcall hkStateBlockApply(IDirect3DStateBlock9* stateBlock)
+{
+    HRESULT result = stateBlockApply(stateBlock);
+    utinni::stateCache::invalidate();
+    return result;
+}
+
+// All state blocks share one vtbl, which is only reachable from a created block
+void detourStateBlockApply(IDirect3DStateBlock9* stateBlock)
+{
+    if (stateBlockApply != nullptr || stateBlock == nullptr)
+    {
+        return;
+    }
+
+    swgptr* stateBlockVtbl = nullptr;
+    memcpy(&stateBlockVtbl, stateBlock, 4);
+    swgptr ApplyAddress = Detour::CheckPointer(stateBlockVtbl[d3dsbi_Apply_Index]);
+    stateBlockApply = (pStateBlockApply)Detour::Create((LPVOID)ApplyAddress, hkStateBlockApply, DETOUR_TYPE_PUSH_RET);
+}
+
+HRESULT __stdcall hkCreateStateBlock(LPDIRECT3DDEVICE9 pDevice, D3DSTATEBLOCKTYPE type, IDirect3DStateBlock9** stateBlock)
+{
+    HRESULT result = createStateBlock(pDevice, type, stateBlock);
+    if (SUCCEEDED(result))
+    {
+        detourStateBlockApply(*stateBlock);
+    }
+    return result;
+}
+
+HRESULT __stdcall hkBeginStateBlock(LPDIRECT3DDEVICE9 pDevice)
+{
+    HRESULT result = beginStateBlock(pDevice);
+    if (SUCCEEDED(result))
+    {
+        utinni::stateCache::beginStateBlock();
+    }
+    return result;
+}
+
+HRESULT __stdcall hkEndStateBlock(LPDIRECT3DDEVICE9 pDevice, IDirect3DStateBlock9** stateBlock)
+{
+    utinni::stateCache::endStateBlock();
+    HRESULT result = endStateBlock(pDevice, stateBlock);
+    if (SUCCEEDED(result))
+    {
+        detourStateBlockApply(*stateBlock);
+    }
+    return result;
+}
+
 HRESULT __stdcall hkD3DXCompileShader(LPCSTR pSrcData, UINT srcDataLen, LPVOID* pDefines, LPVOID pInclude, LPCSTR pFunctionName, LPCSTR pProfile, DWORD Flags, LPVOID* ppShader, LPVOID* ppErrorMsgs, LPVOID* ppConstantTable)
 {
 	 // pixel shaders are precompiled, so it's safe to hard override this as vertex (vs) only
-	 return compileShader(pSrcData, srcDataLen, pDefines, pInclude, pFunctionName, "vs_3_0", Flags, ppShader, ppErrorMsgs, ppConstantTable);
+	 return utinni::shaderCache::compileClientShader(compileShader, pSrcData, srcDataLen, pDefines, pInclude, pFunctionName, "vs_3_0", Flags, ppShader, ppErrorMsgs, ppConstantTable);
 }
 
+memory::ResolvedAddress deviceVtblAddress("IDirect3DDevice9::vtbl", "C7 06 ?? ?? ?? ?? 89 86 ?? ?? ?? ?? 89 86", 2, 0, "d3d9.dll");
+
 swgptr* getVtbl()
 {
 	 swgptr* vtbl = nullptr;
-	 auto pDevice = (LPDIRECT3DDEVICE9)memory::findPattern((swgptr)GetModuleHandle("d3d9.dll"), 0x128000, "\xC7\x06\x00\x00\x00\x00\x89\x86\x00\x00\x00\x00\x89\x86", "xx????xx????xx");
-	 memcpy(&vtbl, (void*)(((swgptr)pDevice) + 2), 4);
+	 const swgptr address = deviceVtblAddress.get();
+	 if (address != 0)
+	 {
+		  memcpy(&vtbl, (void*)address, 4);
+	 }
 	 return vtbl;
 }
 
 void detour()
 {
     auto vtbl = getVtbl();
+    if (vtbl == nullptr)
+    {
+        utinni::log::error("Couldn't find the IDirect3DDevice9 vtable, the DirectX hooks are disabled");
+        return;
+    }
 
 	 swgptr BeginSceneAddress = Detour::CheckPointer(vtbl[d3di_BeginScene_Index]);
     beginScene = (pBeginScene)Detour::Create((LPVOID)BeginSceneAddress, hkBeginScene, DETOUR_TYPE_PUSH_RET);
@@ -336,6 +580,50 @@ void detour()
 	 swgptr SetDepthStencilAddress = Detour::CheckPointer(vtbl[d3di_SetDepthStencilSurface_Index]);
     setDepthStencil = (pSetDepthStencil)Detour::Create((LPVOID)SetDepthStencilAddress, hkSetDepthStencil, DETOUR_TYPE_PUSH_RET);
 
+	 swgptr SetViewportAddress = Detour::CheckPointer(vtbl[d3di_SetViewport_Index]);
+    setViewport = (pSetViewport)Detour::Create((LPVOID)SetViewportAddress, hkSetViewport, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr SetRenderStateAddress = Detour::CheckPointer(vtbl[d3di_SetRenderState_Index]);
+    setRenderState = (pSetRenderState)Detour::Create((LPVOID)SetRenderStateAddress, hkSetRenderState, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr DrawPrimitiveAddress = Detour::CheckPointer(vtbl[d3di_DrawPrimitive_Index]);
+    drawPrimitive = (pDrawPrimitive)Detour::Create((LPVOID)DrawPrimitiveAddress, hkDrawPrimitive, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr DrawPrimitiveUPAddress = Detour::CheckPointer(vtbl[d3di_DrawPrimitiveUP_Index]);
+    drawPrimitiveUP = (pDrawPrimitiveUP)Detour::Create((LPVOID)DrawPrimitiveUPAddress, hkDrawPrimitiveUP, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr DrawIndexedPrimitiveUPAddress = Detour::CheckPointer(vtbl[d3di_DrawIndexedPrimitiveUP_Index]);
+    drawIndexedPrimitiveUP = (pDrawIndexedPrimitiveUP)Detour::Create((LPVOID)DrawIndexedPrimitiveUPAddress, hkDrawIndexedPrimitiveUP, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr SetTextureAddress = Detour::CheckPointer(vtbl[d3di_SetTexture_Index]);
+    setTexture = (pSetTexture)Detour::Create((LPVOID)SetTextureAddress, hkSetTexture, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr SetVertexShaderAddress = Detour::CheckPointer(vtbl[d3di_SetVertexShader_Index]);
+    setVertexShader = (pSetVertexShader)Detour::Create((LPVOID)SetVertexShaderAddress, hkSetVertexShader, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr SetPixelShaderAddress = Detour::CheckPointer(vtbl[d3di_SetPixelShader_Index]);
+    setPixelShader = (pSetPixelShader)Detour::Create((LPVOID)SetPixelShaderAddress, hkSetPixelShader, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr SetSamplerStateAddress = Detour::CheckPointer(vtbl[d3di_SetSamplerState_Index]);
+    setSamplerState = (pSetSamplerState)Detour::Create((LPVOID)SetSamplerStateAddress, hkSetSamplerState, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr SetVertexShaderConstantFAddress = Detour::CheckPointer(vtbl[d3di_SetVertexShaderConstantF_Index]);
+    setVertexShaderConstantF = (pSetShaderConstantF)Detour::Create((LPVOID)SetVertexShaderConstantFAddress, hkSetVertexShaderConstantF, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr SetPixelShaderConstantFAddress = Detour::CheckPointer(vtbl[d3di_SetPixelShaderConstantF_Index]);
+    setPixelShaderConstantF = (pSetShaderConstantF)Detour::Create((LPVOID)SetPixelShaderConstantFAddress, hkSetPixelShaderConstantF, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr CreateStateBlockAddress = Detour::CheckPointer(vtbl[d3di_CreateStateBlock_Index]);
+    createStateBlock = (pCreateStateBlock)Detour::Create((LPVOID)CreateStateBlockAddress, hkCreateStateBlock, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr BeginStateBlockAddress = Detour::CheckPointer(vtbl[d3di_BeginStateBlock_Index]);
+    beginStateBlock = (pBeginStateBlock)Detour::Create((LPVOID)BeginStateBlockAddress, hkBeginStateBlock, DETOUR_TYPE_PUSH_RET);
+
+	 swgptr EndStateBlockAddress = Detour::CheckPointer(vtbl[d3di_EndStateBlock_Index]);
+    endStateBlock = (pEndStateBlock)Detour::Create((LPVOID)EndStateBlockAddress, hkEndStateBlock, DETOUR_TYPE_PUSH_RET);
+
+	 utinni::stateCache::invalidate();
+
 	 // ToDo Potentially make this an option, in case it creates issues
 	 compileShader = (pCompileShader)Detour::Create((LPVOID)compileShader, hkD3DXCompileShader, DETOUR_TYPE_PUSH_RET);
 
@@ -345,6 +633,10 @@ void cleanup()
 {
 	 delete depthTexture;
 	 depthTexture = nullptr;
+	 utinni::readback::releaseAll();
+	 utinni::depthPyramid::releaseAll();
+	 utinni::dynamicResolution::releaseAll();
+	 utinni::renderTargetPool::releaseAll();
 }
 
 TextureResolver* getTextureResolver()
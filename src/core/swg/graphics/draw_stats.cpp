@@ -0,0 +1,429 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "draw_stats.h"
+#include "render_target_pool.h"
+#include "readback.h"
+#include "depth_pyramid.h"
+#include "dynamic_resolution.h"
+#include "state_cache.h"
+#include "imgui/imgui.h"
+#include "utility/log.h"
+#include <cstdio>
+#include <ctime>
+
+namespace
+{
+using utinni::drawStats::Counters;
+using utinni::drawStats::FrameStats;
+
+bool enabled = false;
+FILE* logFile = nullptr;
+
+uint64_t frameCount = 0;
+Counters pending{}; // Since the last popCell
+FrameStats current{};
+FrameStats last{};
+FrameStats peak{};
+
+void writeCsvRow(const char* phase, const Counters& counters)
+{
+    fprintf(logFile, "%llu,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", current.frame, phase, counters.drawCalls, counters.primitives,
+            counters.renderTargetSwitches, counters.depthStencilSwitches, counters.renderStateSets, counters.redundantRenderStateSets, counters.textureSets,
+            counters.redundantTextureSets, counters.shaderSets, counters.redundantShaderSets, counters.samplerStateSets, counters.redundantSamplerStateSets,
+            counters.shaderConstantSets, counters.redundantShaderConstantSets);
+}
+
+void writeFrame()
+{
+    char phase[16];
+    for (int i = 0; i < utinni::drawStats::maxPhases; ++i)
+    {
+        if (current.phases[i].drawCalls > 0 || current.phases[i].renderStateSets > 0)
+        {
+            snprintf(phase, sizeof(phase), "%d", i);
+            writeCsvRow(phase, current.phases[i]);
+        }
+    }
+    writeCsvRow("unphased", current.unphased);
+    writeCsvRow("total", current.total);
+}
+
+void drawRow(const char* name, const Counters& counters)
+{
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::Text("%s", name);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u", counters.drawCalls);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u", counters.primitives);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u", counters.renderTargetSwitches);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u / %u", counters.renderStateSets, counters.redundantRenderStateSets);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u / %u", counters.textureSets, counters.redundantTextureSets);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u / %u", counters.shaderSets, counters.redundantShaderSets);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u / %u", counters.samplerStateSets, counters.redundantSamplerStateSets);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u / %u", counters.shaderConstantSets, counters.redundantShaderConstantSets);
+}
+
+void drawFrameTable(const char* id, const FrameStats& frame)
+{
+    if (ImGui::BeginTable(id, 9, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+    {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Draws");
+        ImGui::TableSetupColumn("Primitives");
+        ImGui::TableSetupColumn("RT switches");
+        ImGui::TableSetupColumn("States / redundant");
+        ImGui::TableSetupColumn("Textures / redundant");
+        ImGui::TableSetupColumn("Shaders / redundant");
+        ImGui::TableSetupColumn("Samplers / redundant");
+        ImGui::TableSetupColumn("Constants / redundant");
+        ImGui::TableHeadersRow();
+
+        char name[16];
+        for (int i = 0; i < utinni::drawStats::maxPhases; ++i)
+        {
+            if (frame.phases[i].drawCalls > 0 || frame.phases[i].renderStateSets > 0)
+            {
+                snprintf(name, sizeof(name), "Phase %d", i);
+                drawRow(name, frame.phases[i]);
+            }
+        }
+        drawRow("Unphased", frame.unphased);
+        drawRow("Total", frame.total);
+        ImGui::EndTable();
+    }
+}
+}
+
+namespace utinni::drawStats
+{
+void Counters::add(const Counters& other)
+{
+    drawCalls += other.drawCalls;
+    primitives += other.primitives;
+    renderTargetSwitches += other.renderTargetSwitches;
+    depthStencilSwitches += other.depthStencilSwitches;
+    renderStateSets += other.renderStateSets;
+    redundantRenderStateSets += other.redundantRenderStateSets;
+    textureSets += other.textureSets;
+    redundantTextureSets += other.redundantTextureSets;
+    shaderSets += other.shaderSets;
+    redundantShaderSets += other.redundantShaderSets;
+    samplerStateSets += other.samplerStateSets;
+    redundantSamplerStateSets += other.redundantSamplerStateSets;
+    shaderConstantSets += other.shaderConstantSets;
+    redundantShaderConstantSets += other.redundantShaderConstantSets;
+}
+
+void enable(bool enable)
+{
+    enabled = enable;
+    pending = Counters();
+    current = FrameStats();
+    if (!enabled)
+    {
+        enableFileLog(false);
+    }
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+void enableFileLog(bool enable)
+{
+    if (enable && logFile == nullptr)
+    {
+        const std::string directory = getPath() + "telemetry\\";
+        CreateDirectoryA(directory.c_str(), nullptr);
+
+        const time_t now = time(nullptr);
+        tm local{};
+        localtime_s(&local, &now);
+        char name[64];
+        strftime(name, sizeof(name), "draw_stats_%Y%m%d_%H%M%S.csv", &local);
+
+        if (fopen_s(&logFile, (directory + name).c_str(), "w") != 0 || logFile == nullptr)
+        {
+            log::error("Failed to create the draw stats log");
+            logFile = nullptr;
+            return;
+        }
+        fprintf(logFile, "frame,phase,draw_calls,primitives,render_target_switches,depth_stencil_switches,render_states,redundant_render_states,textures,"
+                         "redundant_textures,shaders,redundant_shaders,sampler_states,redundant_sampler_states,shader_constants,redundant_shader_constants\n");
+    }
+    else if (!enable && logFile != nullptr)
+    {
+        fclose(logFile);
+        logFile = nullptr;
+    }
+}
+
+bool isFileLogEnabled()
+{
+    return logFile != nullptr;
+}
+
+const FrameStats& getLastFrame()
+{
+    return last;
+}
+
+const FrameStats& getPeakFrame()
+{
+    return peak;
+}
+
+void resetPeak()
+{
+    peak = FrameStats();
+}
+
+void onDraw(uint32_t primitiveCount)
+{
+    if (enabled)
+    {
+        pending.drawCalls++;
+        pending.primitives += primitiveCount;
+    }
+}
+
+void onRenderTargetSet(bool changed)
+{
+    if (enabled && changed)
+    {
+        pending.renderTargetSwitches++;
+    }
+}
+
+void onDepthStencilSet(bool changed)
+{
+    if (enabled && changed)
+    {
+        pending.depthStencilSwitches++;
+    }
+}
+
+void onRenderStateSet(bool redundant)
+{
+    if (enabled)
+    {
+        pending.renderStateSets++;
+        pending.redundantRenderStateSets += redundant ? 1 : 0;
+    }
+}
+
+void onTextureSet(bool redundant)
+{
+    if (enabled)
+    {
+        pending.textureSets++;
+        pending.redundantTextureSets += redundant ? 1 : 0;
+    }
+}
+
+void onShaderSet(bool redundant)
+{
+    if (enabled)
+    {
+        pending.shaderSets++;
+        pending.redundantShaderSets += redundant ? 1 : 0;
+    }
+}
+
+void onSamplerStateSet(bool redundant)
+{
+    if (enabled)
+    {
+        pending.samplerStateSets++;
+        pending.redundantSamplerStateSets += redundant ? 1 : 0;
+    }
+}
+
+void onShaderConstantSet(bool redundant)
+{
+    if (enabled)
+    {
+        pending.shaderConstantSets++;
+        pending.redundantShaderConstantSets += redundant ? 1 : 0;
+    }
+}
+
+void onPhaseEnd(int phase)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    if (phase >= 0 && phase < maxPhases)
+    {
+        current.phases[phase].add(pending);
+    }
+    else
+    {
+        current.unphased.add(pending);
+    }
+    pending = Counters();
+}
+
+void onFrameEnd()
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    current.unphased.add(pending);
+    pending = Counters();
+
+    current.frame = frameCount++;
+    current.total = current.unphased;
+    for (const Counters& phase : current.phases)
+    {
+        current.total.add(phase);
+    }
+
+    if (logFile != nullptr)
+    {
+        writeFrame();
+    }
+
+    last = current;
+    if (current.total.drawCalls > peak.total.drawCalls)
+    {
+        peak = current;
+    }
+    current = FrameStats();
+}
+
+void drawUi()
+{
+    ImGui::Begin("Draw Stats", nullptr, ImGuiWindowFlags_NoCollapse);
+    {
+        bool counting = enabled;
+        if (ImGui::Checkbox("Enabled", &counting))
+        {
+            enable(counting);
+        }
+        ImGui::SameLine();
+        bool fileLog = logFile != nullptr;
+        if (ImGui::Checkbox("Log every frame to file", &fileLog))
+        {
+            enableFileLog(fileLog && enabled);
+        }
+
+        bool filtering = stateCache::isFilteringEnabled();
+        if (ImGui::Checkbox("Drop redundant sets", &filtering))
+        {
+            stateCache::enableFiltering(filtering);
+        }
+        const stateCache::Eliminated& eliminated = stateCache::getEliminated();
+        ImGui::Text("Dropped so far: %llu render states, %llu sampler states, %llu textures, %llu shaders, %llu constant ranges", eliminated.renderStates,
+                    eliminated.samplerStates, eliminated.textures, eliminated.shaders, eliminated.shaderConstants);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset"))
+        {
+            stateCache::resetEliminated();
+        }
+
+        const renderTargetPool::Stats poolStats = renderTargetPool::getStats();
+        ImGui::Text("Render target pool: %u textures, %u leased, %.1f MB, %llu created", poolStats.textureCount, poolStats.leasedCount,
+                    poolStats.allocatedBytes / (1024.0 * 1024.0), poolStats.createdCount);
+
+        const readback::Stats colorReadback = readback::getStats(readback::Source::color);
+        const readback::Stats depthReadback = readback::getStats(readback::Source::depth);
+        ImGui::Text("Readback: colour %u in flight, %llu delivered, %llu dropped; depth %u in flight, %llu delivered, %llu dropped", colorReadback.pendingCount,
+                    colorReadback.deliveredCount, colorReadback.droppedCount, depthReadback.pendingCount, depthReadback.deliveredCount, depthReadback.droppedCount);
+
+        bool pyramid = depthPyramid::isEnabled();
+        if (ImGui::Checkbox("Depth pyramid", &pyramid))
+        {
+            depthPyramid::enable(pyramid);
+        }
+        const gpu::DepthPyramid& cpuPyramid = depthPyramid::getCpuPyramid();
+        if (!depthPyramid::isSupported())
+        {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1, 0.4f, 0.4f, 1), "G32R32F render targets aren't supported by the device");
+        }
+        else if (pyramid && !cpuPyramid.isEmpty())
+        {
+            ImGui::SameLine();
+            ImGui::Text("%u GPU levels, CPU copy %ux%u from %llu presents ago", depthPyramid::getLevelCount(), cpuPyramid.getLevelWidth(0),
+                        cpuPyramid.getLevelHeight(0), depthPyramid::getCpuPyramidAge());
+        }
+
+        bool dynamic = dynamicResolution::isEnabled();
+        if (ImGui::Checkbox("Dynamic resolution", &dynamic))
+        {
+            dynamicResolution::enable(dynamic);
+        }
+        if (dynamic)
+        {
+            const dynamicResolution::Stats resolution = dynamicResolution::getStats();
+            ImGui::SameLine();
+            ImGui::Text("Scale %.2f (%ux%u), frame %.2f ms, average %.2f ms, %llu changes", resolution.scale, resolution.width, resolution.height,
+                        resolution.frameMs, resolution.averageMs, resolution.changeCount);
+
+            gpu::ResolutionController::Settings settings = dynamicResolution::getSettings();
+            float targetFps = 1000.0f / settings.targetMs;
+            const bool changedFps = ImGui::SliderFloat("Target FPS", &targetFps, 20, 144, "%.0f");
+            const bool changedScale = ImGui::SliderFloat("Min scale", &settings.minScale, 0.25f, 1);
+            if (changedFps || changedScale)
+            {
+                settings.targetMs = 1000.0f / targetFps;
+                dynamicResolution::setSettings(settings);
+            }
+
+            float sharpness = dynamicResolution::getSharpness();
+            if (ImGui::SliderFloat("Upscale sharpness", &sharpness, 0, 1))
+            {
+                dynamicResolution::setSharpness(sharpness);
+            }
+        }
+
+        ImGui::Text("Last frame (%llu)", last.frame);
+        drawFrameTable("DrawStatsLast", last);
+
+        ImGui::Text("Peak frame (%llu)", peak.frame);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset peak"))
+        {
+            resetPeak();
+        }
+        drawFrameTable("DrawStatsPeak", peak);
+    }
+    ImGui::End();
+}
+}
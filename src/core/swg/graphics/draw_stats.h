@@ -0,0 +1,87 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+// Per frame counts of what the client asks of the device, from the D3D9 hooks. Everything between two shaderPrimitiveSorter
+// popCells is attributed to the phase that was popped, whatever comes after the last one (UI, post processing) is unphased.
+namespace utinni::drawStats
+{
+struct Counters
+{
+    uint32_t drawCalls;
+    uint32_t primitives;
+    uint32_t renderTargetSwitches;
+    uint32_t depthStencilSwitches;
+    uint32_t renderStateSets;
+    uint32_t redundantRenderStateSets;
+    uint32_t textureSets;
+    uint32_t redundantTextureSets;
+    uint32_t shaderSets;
+    uint32_t redundantShaderSets;
+    uint32_t samplerStateSets;
+    uint32_t redundantSamplerStateSets;
+    uint32_t shaderConstantSets;
+    uint32_t redundantShaderConstantSets;
+
+    void add(const Counters& other);
+};
+
+constexpr int maxPhases = 16;
+
+struct FrameStats
+{
+    uint64_t frame;
+    Counters total;
+    Counters phases[maxPhases];
+    Counters unphased;
+};
+
+UTINNI_API extern void enable(bool enable);
+UTINNI_API extern bool isEnabled();
+
+// Writes every frame's counters to telemetry/draw_stats_<date>_<time>.csv
+UTINNI_API extern void enableFileLog(bool enable);
+UTINNI_API extern bool isFileLogEnabled();
+
+UTINNI_API extern const FrameStats& getLastFrame();
+UTINNI_API extern const FrameStats& getPeakFrame(); // Most draw calls since the last reset
+UTINNI_API extern void resetPeak();
+
+UTINNI_API extern void drawUi();
+
+// Called by the device hooks
+void onDraw(uint32_t primitiveCount);
+void onRenderTargetSet(bool changed);
+void onDepthStencilSet(bool changed);
+void onRenderStateSet(bool redundant);
+void onTextureSet(bool redundant);
+void onShaderSet(bool redundant);
+void onSamplerStateSet(bool redundant);
+void onShaderConstantSet(bool redundant);
+void onPhaseEnd(int phase);
+void onFrameEnd();
+}
@@ -0,0 +1,412 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "dynamic_resolution.h"
+#include "render_target_pool.h"
+#include "shader_cache.h"
+#include "gpu_profiler.h"
+#include "utility/log.h"
+#include "utility/profiler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+using utinni::gpu::ResolutionController;
+
+struct Vertex
+{
+    float x, y, z, rhw;
+    float u, v;
+};
+
+bool enabled = false;
+float sharpness = 0.3f;
+ResolutionController controller;
+
+bool scaling = false;                     // Between beginScene and endScene
+bool sceneTargetBound = false;
+float sceneScale = 1;
+IDirect3DSurface9* sceneTarget = nullptr; // Not referenced, only compared against the targets being set
+D3DSURFACE_DESC sceneDesc;
+D3DVIEWPORT9 sceneViewport = {};          // The last one the client set, put back after the upscale
+D3DVIEWPORT9 lastScaled = {};             // Set again unchanged when the client sets what GetViewport gave it
+UINT scaledWidth = 0;
+UINT scaledHeight = 0;
+
+utinni::renderTargetPool::Lease depthStretch; // Held until the next scene, the TextureResolver's callbacks use it
+utinni::shaderCache::BinaryPtr binaries[2];   // Upscale, depth copy
+IDirect3DPixelShader9* shaders[2] = {};
+IDirect3DStateBlock9* passState = nullptr;    // Created once, captured again before every pass
+
+LARGE_INTEGER frequency = {};
+LARGE_INTEGER previousPresent = {};
+float lastFrameMs = 0;
+
+bool createShaders(IDirect3DDevice9* device)
+{
+    if (binaries[0] == nullptr)
+    {
+        binaries[0] = utinni::shaderCache::request("shaders/upscale.ps", "ps_2_0");
+        binaries[1] = utinni::shaderCache::request("shaders/depth_copy.ps", "ps_2_0");
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        if (shaders[i] == nullptr && binaries[i]->isCompiled())
+        {
+            device->CreatePixelShader((const DWORD*)binaries[i]->bytecode.data(), &shaders[i]);
+        }
+    }
+    return shaders[0] != nullptr && shaders[1] != nullptr;
+}
+
+UINT scaleSize(UINT size)
+{
+    return std::max((UINT)((float)size * sceneScale + 0.5f), 1u);
+}
+
+void setPassState(IDirect3DDevice9* device, D3DTEXTUREFILTERTYPE filter)
+{
+    device->SetRenderState(D3DRS_ZENABLE, FALSE);
+    device->SetRenderState(D3DRS_STENCILENABLE, FALSE);
+    device->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+    device->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
+    device->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
+    device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+    device->SetRenderState(D3DRS_SRGBWRITEENABLE, FALSE);
+    device->SetRenderState(D3DRS_COLORWRITEENABLE, 0x0F);
+    device->SetVertexShader(nullptr);
+    device->SetSamplerState(0, D3DSAMP_MINFILTER, filter);
+    device->SetSamplerState(0, D3DSAMP_MAGFILTER, filter);
+    device->SetSamplerState(0, D3DSAMP_MIPFILTER, D3DTEXF_NONE);
+    device->SetSamplerState(0, D3DSAMP_ADDRESSU, D3DTADDRESS_CLAMP);
+    device->SetSamplerState(0, D3DSAMP_ADDRESSV, D3DTADDRESS_CLAMP);
+    device->SetSamplerState(0, D3DSAMP_SRGBTEXTURE, FALSE);
+    device->SetFVF(D3DFVF_XYZRHW | D3DFVF_TEX1);
+}
+
+// Pretransformed over the whole width x height target, offset by half a pixel, reading [0, u] x [0, v] of the source
+void drawQuad(IDirect3DDevice9* device, UINT width, UINT height, float u, float v)
+{
+    const float right = (float)width - 0.5f;
+    const float bottom = (float)height - 0.5f;
+    const Vertex vertices[4] = {
+        { -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f },
+        { right, -0.5f, 0.0f, 1.0f, u, 0.0f },
+        { -0.5f, bottom, 0.0f, 1.0f, 0.0f, v },
+        { right, bottom, 0.0f, 1.0f, u, v },
+    };
+    device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP, 2, vertices, sizeof(Vertex));
+}
+
+// Draws source's [0, u] x [0, v] over the whole target with the shader, with the device state put back afterwards. Runs
+// inside the client's scene
+void drawPass(IDirect3DDevice9* device, IDirect3DPixelShader9* shader, IDirect3DTexture9* source, IDirect3DSurface9* target, D3DTEXTUREFILTERTYPE filter,
+              float u, float v, const float (*constants)[4] = nullptr, UINT constantCount = 0)
+{
+    if (passState == nullptr && FAILED(device->CreateStateBlock(D3DSBT_ALL, &passState)))
+    {
+        passState = nullptr;
+        return;
+    }
+    passState->Capture();
+
+    IDirect3DSurface9* previousTarget = nullptr;
+    IDirect3DSurface9* previousDepthStencil = nullptr;
+    device->GetRenderTarget(0, &previousTarget);
+    device->GetDepthStencilSurface(&previousDepthStencil);
+
+    D3DSURFACE_DESC desc;
+    target->GetDesc(&desc);
+    device->SetRenderTarget(0, target);
+    device->SetDepthStencilSurface(nullptr);
+    setPassState(device, filter);
+    device->SetPixelShader(shader);
+    if (constantCount > 0)
+    {
+        device->SetPixelShaderConstantF(0, constants[0], constantCount);
+    }
+    device->SetTexture(0, source);
+    drawQuad(device, desc.Width, desc.Height, u, v);
+
+    device->SetTexture(0, nullptr);
+    device->SetRenderTarget(0, previousTarget);
+    device->SetDepthStencilSurface(previousDepthStencil);
+    if (previousTarget != nullptr)
+    {
+        previousTarget->Release();
+    }
+    if (previousDepthStencil != nullptr)
+    {
+        previousDepthStencil->Release();
+    }
+
+    passState->Apply();
+}
+}
+
+namespace utinni::dynamicResolution
+{
+void configure(float targetFps, float minScale, float newSharpness)
+{
+    gpu::ResolutionController::Settings settings = controller.getSettings();
+    settings.targetMs = 1000.0f / std::max(targetFps, 1.0f);
+    settings.minScale = minScale;
+    controller.setSettings(settings);
+    sharpness = newSharpness;
+}
+
+void enable(bool enable)
+{
+    enabled = enable;
+    controller.reset();
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+const gpu::ResolutionController::Settings& getSettings()
+{
+    return controller.getSettings();
+}
+
+void setSettings(const gpu::ResolutionController::Settings& settings)
+{
+    controller.setSettings(settings);
+}
+
+float getSharpness()
+{
+    return sharpness;
+}
+
+void setSharpness(float newSharpness)
+{
+    sharpness = newSharpness;
+}
+
+Stats getStats()
+{
+    return { controller.getScale(), scaledWidth, scaledHeight, lastFrameMs, controller.getAverageMs(), controller.getChangeCount() };
+}
+
+bool getSceneRect(RECT& rect)
+{
+    if (!scaling)
+    {
+        return false;
+    }
+
+    rect = { 0, 0, (LONG)scaledWidth, (LONG)scaledHeight };
+    return true;
+}
+
+IDirect3DTexture9* stretchDepth(IDirect3DDevice9* device, IDirect3DTexture9* depth)
+{
+    if (!scaling || depth == nullptr)
+    {
+        return depth;
+    }
+
+    UTINNI_GPU_ZONE("DynamicResolution::stretchDepth");
+
+    D3DSURFACE_DESC desc;
+    depth->GetLevelDesc(0, &desc);
+    if (!depthStretch.isValid())
+    {
+        depthStretch = renderTargetPool::acquire(device, desc.Width, desc.Height, D3DFMT_R32F);
+        if (!depthStretch.isValid())
+        {
+            return depth;
+        }
+    }
+
+    // Point sampled, blending depths across an edge would make up surfaces that aren't there
+    drawPass(device, shaders[1], depth, depthStretch.getSurface(), D3DTEXF_POINT, (float)scaledWidth / (float)desc.Width, (float)scaledHeight / (float)desc.Height);
+    return depthStretch.getTexture();
+}
+
+IDirect3DTexture9* getStretchedDepth()
+{
+    return depthStretch.getTexture();
+}
+
+void beginScene(IDirect3DDevice9* device)
+{
+    depthStretch.release();
+    sceneScale = controller.getScale();
+    if (!enabled || sceneScale >= 1 || device == nullptr || !createShaders(device))
+    {
+        scaledWidth = 0;
+        scaledHeight = 0;
+        return;
+    }
+
+    if (FAILED(device->GetRenderTarget(0, &sceneTarget)))
+    {
+        sceneTarget = nullptr;
+        return;
+    }
+    sceneTarget->GetDesc(&sceneDesc);
+    sceneTarget->Release();
+
+    scaledWidth = scaleSize(sceneDesc.Width);
+    scaledHeight = scaleSize(sceneDesc.Height);
+    scaling = true;
+    sceneTargetBound = true;
+
+    // Set again through the hook, which scales it
+    D3DVIEWPORT9 viewport;
+    device->GetViewport(&viewport);
+    sceneViewport = viewport;
+    lastScaled = {};
+    device->SetViewport(&viewport);
+}
+
+void endScene(IDirect3DDevice9* device)
+{
+    if (!scaling)
+    {
+        return;
+    }
+    scaling = false;
+
+    UTINNI_PROFILE_ZONE("DynamicResolution::upscale");
+    UTINNI_GPU_ZONE("DynamicResolution::upscale");
+
+    // The region is copied out as the target can't be read while drawn to, into the same spot of a full size copy
+    const renderTargetPool::Lease copy = renderTargetPool::acquire(device, sceneDesc.Width, sceneDesc.Height, sceneDesc.Format);
+    const RECT region = { 0, 0, (LONG)scaledWidth, (LONG)scaledHeight };
+    if (!copy.isValid() || FAILED(device->StretchRect(sceneTarget, &region, copy.getSurface(), &region, D3DTEXF_NONE)))
+    {
+        log::warning("Dynamic resolution: couldn't copy the scene for the upscale, dynamic resolution is disabled");
+        enabled = false;
+        return;
+    }
+
+    const float width = (float)sceneDesc.Width;
+    const float height = (float)sceneDesc.Height;
+    const float constants[2][4] = {
+        { 1.0f / width, 1.0f / height, sharpness, 0.0f },
+        { ((float)scaledWidth - 0.5f) / width, ((float)scaledHeight - 0.5f) / height, 0.0f, 0.0f },
+    };
+    drawPass(device, shaders[0], copy.getTexture(), sceneTarget, D3DTEXF_LINEAR, (float)scaledWidth / width, (float)scaledHeight / height, constants, 2);
+
+    // The state block put the scaled viewport back
+    if (sceneTargetBound)
+    {
+        device->SetViewport(&sceneViewport);
+    }
+}
+
+bool scaleViewport(const D3DVIEWPORT9& viewport, D3DVIEWPORT9& scaled)
+{
+    if (!scaling || !sceneTargetBound || memcmp(&viewport, &lastScaled, sizeof(D3DVIEWPORT9)) == 0)
+    {
+        return false;
+    }
+
+    // Edges are scaled rather than sizes, so viewports that share an edge still do
+    sceneViewport = viewport;
+    const DWORD right = scaleSize(viewport.X + viewport.Width);
+    const DWORD bottom = scaleSize(viewport.Y + viewport.Height);
+    scaled = viewport;
+    scaled.X = std::min((DWORD)((float)viewport.X * sceneScale + 0.5f), right - 1);
+    scaled.Y = std::min((DWORD)((float)viewport.Y * sceneScale + 0.5f), bottom - 1);
+    scaled.Width = right - scaled.X;
+    scaled.Height = bottom - scaled.Y;
+    lastScaled = scaled;
+    return true;
+}
+
+void onSetRenderTarget(IDirect3DDevice9* device, DWORD index, IDirect3DSurface9* surface)
+{
+    if (!scaling || index != 0)
+    {
+        return;
+    }
+
+    // Setting a target resets the viewport to all of it
+    sceneTargetBound = surface == sceneTarget;
+    if (sceneTargetBound)
+    {
+        const D3DVIEWPORT9 viewport = { 0, 0, sceneDesc.Width, sceneDesc.Height, 0.0f, 1.0f };
+        device->SetViewport(&viewport);
+    }
+}
+
+void onPresent()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    const LARGE_INTEGER previous = previousPresent;
+    previousPresent = now;
+    if (previous.QuadPart == 0)
+    {
+        return;
+    }
+
+    // The GPU time leaves out CPU bound stretches a lower resolution wouldn't help with
+    const double gpuMs = gpuProfiler::isEnabled() ? gpuProfiler::getAggregator().getLastFrameMs() : 0.0;
+    lastFrameMs = gpuMs > 0 ? (float)gpuMs : (float)((double)(now.QuadPart - previous.QuadPart) * 1000.0 / (double)frequency.QuadPart);
+    if (enabled)
+    {
+        controller.update(lastFrameMs);
+    }
+}
+
+void onReset()
+{
+    // The scene ends with the reset, the stretched depth comes back empty from the pool
+    scaling = false;
+    depthStretch.release();
+    if (passState != nullptr)
+    {
+        passState->Release();
+        passState = nullptr;
+    }
+}
+
+void releaseAll()
+{
+    onReset();
+    for (int i = 0; i < 2; ++i)
+    {
+        if (shaders[i] != nullptr)
+        {
+            shaders[i]->Release();
+            shaders[i] = nullptr;
+        }
+        binaries[i] = nullptr;
+    }
+}
+}
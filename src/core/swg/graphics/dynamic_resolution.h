@@ -0,0 +1,73 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "utility/resolution_controller.h"
+#include <d3d9.h>
+
+// Dynamic resolution for the 3D scene. While the scene renders, viewports set on the scene's target are scaled down by
+// what gpu::ResolutionController picks from the frame times, and before the UI the reduced region is upscaled to the
+// full target with a sharpening pass. Depth and colour resolved during the scene are stretched to the full size before
+// the TextureResolver's callbacks see them, so post processing works on the same full frame either way.
+namespace utinni::dynamicResolution
+{
+struct Stats
+{
+    float scale;
+    uint32_t width;  // Of the last scene, 0 when it rendered at the full size
+    uint32_t height;
+    float frameMs;   // GPU frame time with GPU timings on, the present interval otherwise
+    float averageMs;
+    uint64_t changeCount;
+};
+
+UTINNI_API extern void configure(float targetFps, float minScale, float sharpness);
+UTINNI_API extern void enable(bool enable);
+UTINNI_API extern bool isEnabled();
+UTINNI_API extern const gpu::ResolutionController::Settings& getSettings();
+UTINNI_API extern void setSettings(const gpu::ResolutionController::Settings& settings);
+UTINNI_API extern float getSharpness();
+UTINNI_API extern void setSharpness(float sharpness);
+UTINNI_API extern Stats getStats();
+
+// The reduced region of the scene's target, false unless the scene is rendering scaled
+UTINNI_API extern bool getSceneRect(RECT& rect);
+
+// The resolved depth stretched from the reduced region to a full size R32F target, the depth itself when not scaled
+IDirect3DTexture9* stretchDepth(IDirect3DDevice9* device, IDirect3DTexture9* depth);
+
+// The depth stretched for the last scene until the next one begins, nullptr when it rendered at the full size
+IDirect3DTexture9* getStretchedDepth();
+
+// Called by the scene render and device hooks
+void beginScene(IDirect3DDevice9* device);
+void endScene(IDirect3DDevice9* device);
+bool scaleViewport(const D3DVIEWPORT9& viewport, D3DVIEWPORT9& scaled);
+void onSetRenderTarget(IDirect3DDevice9* device, DWORD index, IDirect3DSurface9* surface);
+void onPresent();
+void onReset();
+void releaseAll();
+}
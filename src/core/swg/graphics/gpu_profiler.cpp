@@ -0,0 +1,341 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "gpu_profiler.h"
+#include "directx9.h"
+#include "imgui/imgui.h"
+#include "utility/log.h"
+#include "utility/profiler.h"
+#include <cstring>
+
+namespace
+{
+using utinni::gpu::QueryRing;
+
+struct Slot
+{
+    IDirect3DQuery9* disjoint = nullptr;
+    IDirect3DQuery9* frequency = nullptr;
+    IDirect3DQuery9* timestamps[QueryRing::maxQueries] = {};
+};
+
+bool enabled = false;
+bool supported = true; // Until a query fails to be created
+IDirect3DDevice9* queryDevice = nullptr;
+Slot slots[QueryRing::slotCount];
+QueryRing ring;
+utinni::gpu::Aggregator aggregator;
+
+void releaseQueries()
+{
+    for (Slot& slot : slots)
+    {
+        if (slot.disjoint != nullptr)
+        {
+            slot.disjoint->Release();
+        }
+        if (slot.frequency != nullptr)
+        {
+            slot.frequency->Release();
+        }
+        for (IDirect3DQuery9*& query : slot.timestamps)
+        {
+            if (query != nullptr)
+            {
+                query->Release();
+                query = nullptr;
+            }
+        }
+        slot = Slot();
+    }
+    ring.reset();
+    queryDevice = nullptr;
+}
+
+bool createQueries(IDirect3DDevice9* device)
+{
+    if (device->CreateQuery(D3DQUERYTYPE_TIMESTAMP, nullptr) != D3D_OK || device->CreateQuery(D3DQUERYTYPE_TIMESTAMPDISJOINT, nullptr) != D3D_OK ||
+        device->CreateQuery(D3DQUERYTYPE_TIMESTAMPFREQ, nullptr) != D3D_OK)
+    {
+        utinni::log::warning("GPU profiler: timestamp queries aren't supported by the device");
+        return false;
+    }
+
+    for (Slot& slot : slots)
+    {
+        bool created = device->CreateQuery(D3DQUERYTYPE_TIMESTAMPDISJOINT, &slot.disjoint) == D3D_OK;
+        created &= device->CreateQuery(D3DQUERYTYPE_TIMESTAMPFREQ, &slot.frequency) == D3D_OK;
+        for (IDirect3DQuery9*& query : slot.timestamps)
+        {
+            created &= device->CreateQuery(D3DQUERYTYPE_TIMESTAMP, &query) == D3D_OK;
+        }
+
+        if (!created)
+        {
+            utinni::log::error("GPU profiler: failed to create the timestamp queries");
+            releaseQueries();
+            return false;
+        }
+    }
+
+    queryDevice = device;
+    return true;
+}
+
+void issueTimestamp(int query)
+{
+    if (query >= 0)
+    {
+        slots[ring.getCurrentSlot()].timestamps[query]->Issue(D3DISSUE_END);
+    }
+}
+
+// Reads back every slot the ring considers old enough, a slot that still isn't done is left for the next frame
+void readBack()
+{
+    uint64_t timestamps[QueryRing::maxQueries];
+    for (int slotIndex = ring.getReadySlot(); slotIndex >= 0; slotIndex = ring.getReadySlot())
+    {
+        Slot& slot = slots[slotIndex];
+        const QueryRing::Frame& frame = ring.getFrame((uint32_t)slotIndex);
+
+        BOOL disjoint = FALSE;
+        UINT64 frequency = 0;
+        if (slot.disjoint->GetData(&disjoint, sizeof(disjoint), 0) != S_OK || slot.frequency->GetData(&frequency, sizeof(frequency), 0) != S_OK)
+        {
+            return;
+        }
+
+        for (uint32_t i = 0; i < frame.queryCount; ++i)
+        {
+            UINT64 value = 0;
+            if (slot.timestamps[i]->GetData(&value, sizeof(value), 0) != S_OK)
+            {
+                return;
+            }
+            timestamps[i] = value;
+        }
+
+        aggregator.addFrame(frame, timestamps, frequency, disjoint != FALSE);
+        ring.release((uint32_t)slotIndex);
+    }
+}
+
+void beginFrame()
+{
+    const uint32_t slotIndex = ring.beginFrame();
+    Slot& slot = slots[slotIndex];
+    slot.disjoint->Issue(D3DISSUE_BEGIN);
+    slot.timestamps[QueryRing::frameBeginQuery]->Issue(D3DISSUE_END);
+}
+
+void endFrame()
+{
+    const int query = ring.endFrame();
+    if (query >= 0)
+    {
+        Slot& slot = slots[ring.getCurrentSlot()];
+        slot.timestamps[query]->Issue(D3DISSUE_END);
+        slot.frequency->Issue(D3DISSUE_END);
+        slot.disjoint->Issue(D3DISSUE_END);
+    }
+}
+
+double getCpuZoneMs(const std::vector<utinni::profiler::ZoneEvent>& cpuZones, const char* name)
+{
+    uint64_t ticks = 0;
+    bool found = false;
+    for (const utinni::profiler::ZoneEvent& zone : cpuZones)
+    {
+        if (zone.name == name || strcmp(zone.name, name) == 0)
+        {
+            ticks += zone.end - zone.start;
+            found = true;
+        }
+    }
+    return found ? utinni::profiler::ticksToMs(ticks) : -1.0;
+}
+}
+
+namespace utinni::gpuProfiler
+{
+ScopedZone::ScopedZone(const char* name) : active(enabled && ring.isRecording())
+{
+    if (active)
+    {
+        issueTimestamp(ring.beginZone(name));
+    }
+}
+
+ScopedZone::~ScopedZone()
+{
+    if (active && ring.isRecording())
+    {
+        issueTimestamp(ring.endZone());
+    }
+}
+
+void enable(bool enable)
+{
+    enabled = enable;
+    if (!enabled)
+    {
+        releaseQueries();
+        aggregator.reset();
+    }
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+bool isSupported()
+{
+    return supported;
+}
+
+void beginZone(const char* name)
+{
+    if (enabled && ring.isRecording())
+    {
+        issueTimestamp(ring.beginZone(name));
+    }
+}
+
+void endZone()
+{
+    if (enabled && ring.isRecording())
+    {
+        issueTimestamp(ring.endZone());
+    }
+}
+
+void mark(const char* name)
+{
+    if (enabled && ring.isRecording())
+    {
+        issueTimestamp(ring.mark(name));
+    }
+}
+
+const gpu::Aggregator& getAggregator()
+{
+    return aggregator;
+}
+
+void onPresent(IDirect3DDevice9* device)
+{
+    if (!enabled || !supported || device == nullptr)
+    {
+        return;
+    }
+
+    if (queryDevice != device)
+    {
+        releaseQueries();
+        supported = createQueries(device);
+        if (!supported)
+        {
+            return;
+        }
+    }
+
+    endFrame();
+    readBack();
+    beginFrame();
+}
+
+void onReset()
+{
+    // The queries are recreated on the next present, the frames in flight are lost with the device
+    releaseQueries();
+}
+
+void drawUi()
+{
+    ImGui::Begin("GPU Profiler", nullptr, ImGuiWindowFlags_NoCollapse);
+    {
+        bool gpuTimings = enabled;
+        if (ImGui::Checkbox("Enabled", &gpuTimings))
+        {
+            enable(gpuTimings);
+        }
+
+        if (!supported)
+        {
+            ImGui::TextColored(ImVec4(1, 0.4f, 0.4f, 1), "Timestamp queries aren't supported by the device");
+        }
+        else if (enabled)
+        {
+            ImGui::Text("GPU frame %.2f ms (avg %.2f ms), %llu frames, %llu dropped, %llu discarded", aggregator.getLastFrameMs(), aggregator.getAverageFrameMs(),
+                        aggregator.getFrameCount(), ring.getDroppedCount(), aggregator.getDiscardedCount());
+
+            // CPU times of the zones with the same name, from the CPU profiler's last frame
+            std::vector<profiler::ZoneEvent> cpuZones;
+            if (profiler::isEnabled())
+            {
+                uint64_t frameStart;
+                uint64_t frameEnd;
+                profiler::getLastFrameZones(cpuZones, frameStart, frameEnd);
+            }
+
+            if (ImGui::BeginTable("GpuZones", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+            {
+                ImGui::TableSetupColumn("Zone");
+                ImGui::TableSetupColumn("GPU ms");
+                ImGui::TableSetupColumn("GPU avg ms");
+                ImGui::TableSetupColumn("GPU max ms");
+                ImGui::TableSetupColumn("CPU ms");
+                ImGui::TableHeadersRow();
+
+                for (const gpu::ZoneStats& zone : aggregator.getZones())
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%*s%s", zone.depth * 2, "", zone.name);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", zone.lastMs);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", zone.averageMs);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", zone.maxMs);
+                    ImGui::TableNextColumn();
+                    const double cpuMs = getCpuZoneMs(cpuZones, zone.name);
+                    if (cpuMs >= 0)
+                    {
+                        ImGui::Text("%.3f", cpuMs);
+                    }
+                    else
+                    {
+                        ImGui::TextDisabled("-");
+                    }
+                }
+                ImGui::EndTable();
+            }
+        }
+    }
+    ImGui::End();
+}
+}
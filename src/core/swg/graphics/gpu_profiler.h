@@ -0,0 +1,68 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "utility/gpu_query_ring.h"
+#include "utility/profiler.h"
+
+struct IDirect3DDevice9;
+
+// GPU timings from D3D9 timestamp queries. Zones are timestamped on the device timeline and read back a few frames
+// later through gpu::QueryRing, so the CPU never waits on the GPU. Frames the driver reports as disjoint are discarded.
+namespace utinni::gpuProfiler
+{
+class UTINNI_API ScopedZone
+{
+public:
+    explicit ScopedZone(const char* name);
+    ~ScopedZone();
+
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+    bool active;
+};
+
+UTINNI_API extern void enable(bool enable);
+UTINNI_API extern bool isEnabled();
+UTINNI_API extern bool isSupported();
+
+UTINNI_API extern void beginZone(const char* name);
+UTINNI_API extern void endZone();
+
+// Closes the time since the previous mark in the frame under name, for sequential passes like the draw phases
+UTINNI_API extern void mark(const char* name);
+
+UTINNI_API extern const gpu::Aggregator& getAggregator();
+UTINNI_API extern void drawUi();
+
+// Called by the device hooks, onPresent ends the frame, reads back the finished ones and begins the next
+void onPresent(IDirect3DDevice9* device);
+void onReset();
+}
+
+#define UTINNI_GPU_ZONE(name) utinni::gpuProfiler::ScopedZone UTINNI_PROFILE_CONCAT(gpuZone, __LINE__)(name)
@@ -28,7 +28,9 @@
 #include "swg/ui/cui_manager.h"
 #include "utility/utility.h"
 #include "utility/memory.h"
+#include "utility/address_resolver.h"
 #include "utility/log.h"
+#include "utility/profiler.h"
 #include "directx9.h"
 
 namespace swg::graphics
@@ -57,29 +59,54 @@ using pDrawExtent = void(__cdecl*)(utinni::Extent* extent, swgptr vecArgbColor);
 
 using pScreenshot = bool(__cdecl*)(const char* filename);
 
-pInstall install = (pInstall)0x007548A0;
+// The fallbacks are the addresses in the supported client build
+memory::ResolvedAddress installAddress("Graphics::install", "55 8B EC 83 EC ?? 53 56 57 E8 ?? ?? ?? ?? 84 C0", 0, 0x007548A0);
 
-pUpdate update = (pUpdate)0x00755700; 
-pBeginScene beginScene = (pBeginScene)0x00755730; 
-pEndScene endScene = (pEndScene)0x00755740;
+memory::ResolvedAddress updateAddress("Graphics::update", "55 8B EC 51 A1 ?? ?? ?? ?? D9 45 08 D9 1C 24 FF 50", 0, 0x00755700);
+memory::ResolvedAddress beginSceneAddress("Graphics::beginScene", "A1 ?? ?? ?? ?? FF 60 ?? CC", 0, 0x00755730);
+memory::ResolvedAddress endSceneAddress("Graphics::endScene", "A1 ?? ?? ?? ?? FF 60 ?? CC", 0, 0x00755740);
 
-pPresentWindow presentWindow = (pPresentWindow)0x00755810;
-pPresent present = (pPresent)0x00755800; 
+memory::ResolvedAddress presentWindowAddress("Graphics::presentWindow", "A1 ?? ?? ?? ?? FF 60 ?? CC", 0, 0x00755810);
+memory::ResolvedAddress presentAddress("Graphics::present", "A1 ?? ?? ?? ?? FF 60 ?? CC", 0, 0x00755800);
 
-pUseHardwareCursor useHardwareCursor = (pUseHardwareCursor)0x00755940;
-pShowMouseCursor showMouseCursor = (pShowMouseCursor)0x00755A50;
-pSetSystemMouseCursorPosition setSystemMouseCursorPosition = (pSetSystemMouseCursorPosition)0x00755AC0;
+memory::ResolvedAddress useHardwareCursorAddress("Graphics::useHardwareCursor", "55 8B EC 8A 45 08 50 8B 0D ?? ?? ?? ?? FF 51", 0, 0x00755940);
+memory::ResolvedAddress showMouseCursorAddress("Graphics::showMouseCursor", "55 8B EC 8A 45 08 50 8B 0D ?? ?? ?? ?? FF 51", 0, 0x00755A50);
+memory::ResolvedAddress setSystemMouseCursorPositionAddress("Graphics::setSystemMouseCursorPosition", "55 8B EC 8B 45 0C 50 8B 4D 08 51 8B 15", 0, 0x00755AC0);
 
-pResize resize = (pResize)0x00754E40;
-pFlushResources flushResources = (pFlushResources)0x00755520;
+memory::ResolvedAddress resizeAddress("Graphics::resize", "55 8B EC 8B 45 0C 50 8B 4D 08 51 E8", 0, 0x00754E40);
+memory::ResolvedAddress flushResourcesAddress("Graphics::flushResources", "55 8B EC 8A 45 08 50 8B 0D ?? ?? ?? ?? FF 91", 0, 0x00755520);
 
-pTextureListReloadTextures textureListReloadTextures = (pTextureListReloadTextures)0x00764B70;
+memory::ResolvedAddress textureListReloadTexturesAddress("TextureList::reloadTextures", "55 8B EC 83 EC ?? 56 8B 35 ?? ?? ?? ?? 3B 35", 0, 0x00764B70);
 
-pSetStaticShader setStaticShader = (pSetStaticShader)0x00755910;
-pSetObjectToWorldTransformAndScale setObjectToWorldTransformAndScale = (pSetObjectToWorldTransformAndScale)0x00755D30;
-pDrawExtent drawExtent = (pDrawExtent)0x00759A70;
+memory::ResolvedAddress setStaticShaderAddress("Graphics::setStaticShader", "55 8B EC 8B 45 0C 50 8B 4D 08 51 8B 15 ?? ?? ?? ?? FF 92", 0, 0x00755910);
+memory::ResolvedAddress setObjectToWorldTransformAndScaleAddress("Graphics::setObjectToWorldTransformAndScale", "55 8B EC 8B 45 0C 50 8B 4D 08 51 A1 ?? ?? ?? ?? FF 90", 0, 0x00755D30);
+memory::ResolvedAddress drawExtentAddress("Graphics::drawExtent", "55 8B EC 83 EC ?? 8B 45 08 85 C0 74", 0, 0x00759A70);
 
-pScreenshot screenshot = (pScreenshot)0x00755890;
+memory::ResolvedAddress screenshotAddress("Graphics::screenshot", "55 8B EC 8B 45 08 50 8B 0D ?? ?? ?? ?? FF 91", 0, 0x00755890);
+
+pInstall install = nullptr;
+
+pUpdate update = nullptr;
+pBeginScene beginScene = nullptr;
+pEndScene endScene = nullptr;
+
+pPresentWindow presentWindow = nullptr;
+pPresent present = nullptr;
+
+pUseHardwareCursor useHardwareCursor = nullptr;
+pShowMouseCursor showMouseCursor = nullptr;
+pSetSystemMouseCursorPosition setSystemMouseCursorPosition = nullptr;
+
+pResize resize = nullptr;
+pFlushResources flushResources = nullptr;
+
+pTextureListReloadTextures textureListReloadTextures = nullptr;
+
+pSetStaticShader setStaticShader = nullptr;
+pSetObjectToWorldTransformAndScale setObjectToWorldTransformAndScale = nullptr;
+pDrawExtent drawExtent = nullptr;
+
+pScreenshot screenshot = nullptr;
 }
 
 namespace utinni
@@ -89,20 +116,20 @@ namespace Graphics
 {
 std::string screenshotsDir = "screenshots/";
 
-std::vector<std::function<void(float elapsedTime)>> preUpdateCallback;
-std::vector<std::function<void(float elapsedTime)>> postUpdateCallback;
+CallbackList<void(float elapsedTime)> preUpdateCallback("Graphics::preUpdateCallback");
+CallbackList<void(float elapsedTime)> postUpdateCallback("Graphics::postUpdateCallback");
 
-std::vector<std::function<void()>> preBeginSceneCallback;
-std::vector<std::function<void()>> postBeginSceneCallback;
+CallbackList<void()> preBeginSceneCallback("Graphics::preBeginSceneCallback");
+CallbackList<void()> postBeginSceneCallback("Graphics::postBeginSceneCallback");
 
-std::vector<std::function<void()>> preEndSceneCallback;
-std::vector<std::function<void()>> postEndSceneCallback;
+CallbackList<void()> preEndSceneCallback("Graphics::preEndSceneCallback");
+CallbackList<void()> postEndSceneCallback("Graphics::postEndSceneCallback");
 
-std::vector<std::function<void(HWND hwnd, int width, int height)>> prePresentWindowCallback;
-std::vector<std::function<void(HWND hwnd, int width, int height)>> postPresentWindowCallback;
+CallbackList<void(HWND hwnd, int width, int height)> prePresentWindowCallback("Graphics::prePresentWindowCallback");
+CallbackList<void(HWND hwnd, int width, int height)> postPresentWindowCallback("Graphics::postPresentWindowCallback");
 
-std::vector<std::function<void()>> prePresentCallback;
-std::vector<std::function<void()>> postPresentCallback;
+CallbackList<void()> prePresentCallback("Graphics::prePresentCallback");
+CallbackList<void()> postPresentCallback("Graphics::postPresentCallback");
 }
 
 void Graphics::useHardwareCursor(bool value)
@@ -157,6 +184,7 @@ void Graphics::drawExtent(Extent* extent, swgptr vecArgbColor)
 
 bool __cdecl hkInstall()
 {
+    UTINNI_PROFILE_ZONE("Graphics::install");
     bool result = swg::graphics::install();
 
     directX::detour();
@@ -166,79 +194,54 @@ bool __cdecl hkInstall()
 
 void __cdecl hkUpdate(float elapsedTime)
 {
-    for (const auto& func : Graphics::preUpdateCallback)
-    {
-        func(elapsedTime);
-    }
+    UTINNI_PROFILE_ZONE("Graphics::update");
+    Graphics::preUpdateCallback.invoke(elapsedTime);
 
     swg::graphics::update(elapsedTime);
 
-    for (const auto& func : Graphics::postUpdateCallback)
-    {
-        func(elapsedTime);
-    }
+    Graphics::postUpdateCallback.invoke(elapsedTime);
 }
 
 void __cdecl hkBeginScene()
 {
-    for (const auto& func : Graphics::preBeginSceneCallback)
-    {
-        func();
-    }
+    UTINNI_PROFILE_ZONE("Graphics::beginScene");
+    Graphics::preBeginSceneCallback.invoke();
 
     swg::graphics::beginScene();
 
-    for (const auto& func : Graphics::postBeginSceneCallback)
-    {
-        func();
-    }
+    Graphics::postBeginSceneCallback.invoke();
 }
 
 int oldWidth = 0;
 int oldHeight = 0;
 void __cdecl hkEndScene()
 {
-    for (const auto& func : Graphics::preEndSceneCallback)
-    {
-        func();
-    }
+    UTINNI_PROFILE_ZONE("Graphics::endScene");
+    Graphics::preEndSceneCallback.invoke();
 
     swg::graphics::endScene();
 
-    for (const auto& func : Graphics::postEndSceneCallback)
-    {
-        func();
-    }
+    Graphics::postEndSceneCallback.invoke();
 }
 
 void __cdecl hkPresentWindow(HWND hwnd, int width, int height)
 {
-    for (const auto& func : Graphics::prePresentWindowCallback)
-    {
-        func(hwnd, width, height);
-    }
+    UTINNI_PROFILE_ZONE("Graphics::presentWindow");
+    Graphics::prePresentWindowCallback.invoke(hwnd, width, height);
 
     swg::graphics::presentWindow(hwnd, width, height);
 
-    for (const auto& func : Graphics::postPresentWindowCallback)
-    {
-        func(hwnd, width, height);
-    }
+    Graphics::postPresentWindowCallback.invoke(hwnd, width, height);
 }
 
 void __cdecl hkPresent()
 {
-    for (const auto& func : Graphics::prePresentCallback)
-    {
-        func();
-    }
+    UTINNI_PROFILE_ZONE("Graphics::present");
+    Graphics::prePresentCallback.invoke();
 
     swg::graphics::present();
 
-    for (const auto& func : Graphics::postPresentCallback)
-    {
-        func();
-    }
+    Graphics::postPresentCallback.invoke();
 }
 
 bool __cdecl hkScreenshot(const char* filename)
@@ -262,16 +265,28 @@ bool __cdecl hkScreenshot(const char* filename)
 
 void Graphics::detour()
 {
-    swg::graphics::install = (swg::graphics::pInstall)Detour::Create(swg::graphics::install, hkInstall, DETOUR_TYPE_PUSH_RET);
+    using namespace swg::graphics;
+
+    memory::resolve(useHardwareCursorAddress, useHardwareCursor);
+    memory::resolve(showMouseCursorAddress, showMouseCursor);
+    memory::resolve(setSystemMouseCursorPositionAddress, setSystemMouseCursorPosition);
+    memory::resolve(resizeAddress, resize);
+    memory::resolve(flushResourcesAddress, flushResources);
+    memory::resolve(textureListReloadTexturesAddress, textureListReloadTextures);
+    memory::resolve(setStaticShaderAddress, setStaticShader);
+    memory::resolve(setObjectToWorldTransformAndScaleAddress, setObjectToWorldTransformAndScale);
+    memory::resolve(drawExtentAddress, drawExtent);
+
+    memory::detour(installAddress, install, hkInstall, DETOUR_TYPE_PUSH_RET);
 
-    swg::graphics::update = (swg::graphics::pUpdate)Detour::Create(swg::graphics::update, hkUpdate, DETOUR_TYPE_PUSH_RET);
-    swg::graphics::beginScene = (swg::graphics::pBeginScene)Detour::Create(swg::graphics::beginScene, hkBeginScene, DETOUR_TYPE_JMP, 5);
-    swg::graphics::endScene = (swg::graphics::pEndScene)Detour::Create(swg::graphics::endScene, hkEndScene, DETOUR_TYPE_JMP, 5);
+    memory::detour(updateAddress, update, hkUpdate, DETOUR_TYPE_PUSH_RET);
+    memory::detour(beginSceneAddress, beginScene, hkBeginScene, DETOUR_TYPE_JMP, 5);
+    memory::detour(endSceneAddress, endScene, hkEndScene, DETOUR_TYPE_JMP, 5);
 
-    swg::graphics::presentWindow = (swg::graphics::pPresentWindow)Detour::Create(swg::graphics::presentWindow, hkPresentWindow, DETOUR_TYPE_JMP, 5);
-    swg::graphics::present = (swg::graphics::pPresent)Detour::Create(swg::graphics::present, hkPresent, DETOUR_TYPE_JMP, 5);
+    memory::detour(presentWindowAddress, presentWindow, (pPresentWindow)hkPresentWindow, DETOUR_TYPE_JMP, 5);
+    memory::detour(presentAddress, present, hkPresent, DETOUR_TYPE_JMP, 5);
 
-    swg::graphics::screenshot = (swg::graphics::pScreenshot)Detour::Create(swg::graphics::screenshot, hkScreenshot, DETOUR_TYPE_PUSH_RET);
+    memory::detour(screenshotAddress, screenshot, hkScreenshot, DETOUR_TYPE_PUSH_RET);
 }
 
 }
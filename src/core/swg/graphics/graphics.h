@@ -25,6 +25,7 @@
 #pragma once
 
 #include "utinni.h"
+#include "utility/callback_list.h"
 #include "swg/misc/swg_math.h"
 #include "swg/appearance/extent.h"
 #include <functional>
@@ -34,79 +35,79 @@ namespace utinni
 
 namespace Graphics
 {
-    extern UTINNI_API std::vector<std::function<void(float elapsedTime)>> preUpdateCallback;
-    extern UTINNI_API std::vector<std::function<void(float elapsedTime)>> postUpdateCallback;
+    extern UTINNI_API CallbackList<void(float elapsedTime)> preUpdateCallback;
+    extern UTINNI_API CallbackList<void(float elapsedTime)> postUpdateCallback;
                
-    extern UTINNI_API std::vector<std::function<void()>> preBeginSceneCallback;
-    extern UTINNI_API std::vector<std::function<void()>> postBeginSceneCallback;
+    extern UTINNI_API CallbackList<void()> preBeginSceneCallback;
+    extern UTINNI_API CallbackList<void()> postBeginSceneCallback;
                                                        
-    extern UTINNI_API std::vector<std::function<void()>> preEndSceneCallback;
-    extern UTINNI_API std::vector<std::function<void()>> postEndSceneCallback;
+    extern UTINNI_API CallbackList<void()> preEndSceneCallback;
+    extern UTINNI_API CallbackList<void()> postEndSceneCallback;
              
-    extern UTINNI_API std::vector<std::function<void(HWND hwnd, int width, int height)>> prePresentWindowCallback;
-    extern UTINNI_API std::vector<std::function<void(HWND hwnd, int width, int height)>> postPresentWindowCallback;
+    extern UTINNI_API CallbackList<void(HWND hwnd, int width, int height)> prePresentWindowCallback;
+    extern UTINNI_API CallbackList<void(HWND hwnd, int width, int height)> postPresentWindowCallback;
                
-    extern UTINNI_API std::vector<std::function<void()>> prePresentCallback;
-    extern UTINNI_API std::vector<std::function<void()>> postPresentCallback;
+    extern UTINNI_API CallbackList<void()> prePresentCallback;
+    extern UTINNI_API CallbackList<void()> postPresentCallback;
 
     template<typename T>
-    void addPreUpdateLoopCallback(T func)
+    CallbackHandle addPreUpdateLoopCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        preUpdateCallback.emplace_back(func);
+        return preUpdateCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPostUpdateLoopCallback(T func)
+    CallbackHandle addPostUpdateLoopCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        postUpdateCallback.emplace_back(func);
+        return postUpdateCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPreBeginSceneCallback(T func)
+    CallbackHandle addPreBeginSceneCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        preBeginSceneCallback.emplace_back(func);
+        return preBeginSceneCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPostBeginSceneCallback(T func)
+    CallbackHandle addPostBeginSceneCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        postBeginSceneCallback.emplace_back(func);
+        return postBeginSceneCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPreEndSceneCallback(T func)
+    CallbackHandle addPreEndSceneCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        preEndSceneCallback.emplace_back(func);
+        return preEndSceneCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPostEndSceneCallback(T func)
+    CallbackHandle addPostEndSceneCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        postEndSceneCallback.emplace_back(func);
+        return postEndSceneCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPrePresentWindowCallback(T func)
+    CallbackHandle addPrePresentWindowCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        prePresentWindowCallback.emplace_back(func);
+        return prePresentWindowCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPostPresentWindowCallback(T func)
+    CallbackHandle addPostPresentWindowCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        postPresentWindowCallback.emplace_back(func);
+        return postPresentWindowCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPrePresentCallback(T func)
+    CallbackHandle addPrePresentCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        prePresentCallback.emplace_back(func);
+        return prePresentCallback.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPostPresentCallback(void(*func)())
+    CallbackHandle addPostPresentCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        postPresentCallback.emplace_back(func);
+        return postPresentCallback.add(func, owner, name, priority);
     }
 
     
@@ -24,47 +24,53 @@
 
 #include "post_processing.h"
 #include "directx9.h"
+#include "dynamic_resolution.h"
+#include "utility/address_resolver.h"
+#include "utility/profiler.h"
 
 namespace swg::bloom
 {
 using pPreSceneRender = void(__cdecl*)();
 using pPostSceneRender = void(__cdecl*)();
 
-pPreSceneRender preSceneRender = (pPreSceneRender)0x0064B500;
-pPostSceneRender postSceneRender = (pPostSceneRender)0x0064B560;
+memory::ResolvedAddress preSceneRenderAddress("Bloom::preSceneRender", "A1 ?? ?? ?? ?? 85 C0 74 ?? 80 3D ?? ?? ?? ?? 00", 0, 0x0064B500);
+memory::ResolvedAddress postSceneRenderAddress("Bloom::postSceneRender", "A1 ?? ?? ?? ?? 85 C0 74 ?? 80 3D ?? ?? ?? ?? 00", 0, 0x0064B560);
+
+pPreSceneRender preSceneRender = nullptr;
+pPostSceneRender postSceneRender = nullptr;
 
 }
 
 namespace utinni::postProcessing
 {
 
-std::vector<std::function<void()>> preSceneRenderCallbacks;
-std::vector<std::function<void()>> postSceneRenderCallbacks;
+CallbackList<void()> preSceneRenderCallbacks("PostProcessing::preSceneRenderCallbacks");
+CallbackList<void()> postSceneRenderCallbacks("PostProcessing::postSceneRenderCallbacks");
 
 void __cdecl hkPreSceneRender() // Originally a Bloom class function, repurposed to be a general PostProcessing function.
 {
-    for (const auto& func : preSceneRenderCallbacks)
-    {
-        func();
-    }
+    UTINNI_PROFILE_ZONE("PostProcessing::preSceneRender");
+    preSceneRenderCallbacks.invoke();
 
     swg::bloom::preSceneRender();
+
+    // After the bloom, which may have moved the scene to its own target
+    utinni::dynamicResolution::beginScene(directX::getDevice());
 }
 
 void __cdecl hkPostSceneRender() // Originally a Bloom class function, repurposed to be a general PostProcessing function.
 {
+    UTINNI_PROFILE_ZONE("PostProcessing::postSceneRender");
+    utinni::dynamicResolution::endScene(directX::getDevice());
     swg::bloom::postSceneRender();
 
-    for (const auto& func : postSceneRenderCallbacks)
-    {
-        func();
-    }
+    postSceneRenderCallbacks.invoke();
 }
 
 void detour()
 {
-    swg::bloom::preSceneRender = (swg::bloom::pPreSceneRender)Detour::Create(swg::bloom::preSceneRender, hkPreSceneRender, DETOUR_TYPE_PUSH_RET);
-    swg::bloom::postSceneRender = (swg::bloom::pPostSceneRender)Detour::Create(swg::bloom::postSceneRender, hkPostSceneRender, DETOUR_TYPE_PUSH_RET);
+    memory::detour(swg::bloom::preSceneRenderAddress, swg::bloom::preSceneRender, hkPreSceneRender, DETOUR_TYPE_PUSH_RET);
+    memory::detour(swg::bloom::postSceneRenderAddress, swg::bloom::postSceneRender, hkPostSceneRender, DETOUR_TYPE_PUSH_RET);
 
 }
 }
\ No newline at end of file
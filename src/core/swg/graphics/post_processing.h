@@ -25,23 +25,24 @@
 #pragma once
 
 #include "utinni.h"
+#include "utility/callback_list.h"
 #include <functional>
 
 namespace utinni::postProcessing
 {
-extern UTINNI_API std::vector<std::function<void()>> preSceneRenderCallbacks;
-extern UTINNI_API std::vector<std::function<void()>> postSceneRenderCallbacks;
+extern UTINNI_API CallbackList<void()> preSceneRenderCallbacks;
+extern UTINNI_API CallbackList<void()> postSceneRenderCallbacks;
 
 template<typename T>
-void addPreSceneRenderCallback(T func)
+CallbackHandle addPreSceneRenderCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
 {
-    preSceneRenderCallbacks.emplace_back(func);
+    return preSceneRenderCallbacks.add(func, owner, name, priority);
 }
 
 template<typename T>
-void addPostSceneRenderCallback(T func)
+CallbackHandle addPostSceneRenderCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
 {
-    postSceneRenderCallbacks.emplace_back(func);
+    return postSceneRenderCallbacks.add(func, owner, name, priority);
 }
 
 void detour();
@@ -0,0 +1,508 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "readback.h"
+#include "directx9.h"
+#include "dynamic_resolution.h"
+#include "render_target_pool.h"
+#include "shader_cache.h"
+#include "utility/log.h"
+#include "utility/profiler.h"
+#include "utility/readback_ring.h"
+#include <algorithm>
+
+namespace utinni::readback
+{
+CallbackList<void(const Frame&)> consumers("Readback::consumers");
+}
+
+namespace
+{
+using utinni::gpu::ReadbackRing;
+using utinni::readback::Source;
+
+// A capture is first copied on the GPU into a pooled render target with an event query behind it. Only once the event
+// has passed is the copy downloaded with GetRenderTargetData, which would otherwise wait for the GPU to catch up
+struct Slot
+{
+    enum State
+    {
+        st_idle,
+        st_copying,
+        st_downloading
+    };
+
+    State state = st_idle;
+    utinni::renderTargetPool::Lease copy; // Held until the download is queued
+    IDirect3DQuery9* copied = nullptr;
+    IDirect3DSurface9* surface = nullptr; // System memory
+};
+
+struct Target
+{
+    Source source;
+    ReadbackRing ring;
+    Slot slots[ReadbackRing::maxSlots];
+    UINT width = 0;
+    UINT height = 0;
+    D3DFORMAT format = D3DFMT_UNKNOWN;
+    uint32_t requestedCount = 0;
+    bool continuous = false;
+    uint64_t deliveredCount = 0;
+    utinni::readback::Frame delivery; // Reused between deliveries, so the buffer is only allocated once per size
+};
+
+struct DepthVertex
+{
+    float x, y, z, rhw;
+    float u, v;
+};
+
+Target targets[2] = { { Source::color }, { Source::depth } };
+uint64_t frame = 0;
+utinni::shaderCache::BinaryPtr depthCopyBinary;
+IDirect3DPixelShader9* depthCopyShader = nullptr;
+IDirect3DStateBlock9* depthCopyState = nullptr; // Created once, captured again before every depth copy
+
+Target& getTarget(Source source)
+{
+    return targets[source == Source::color ? 0 : 1];
+}
+
+uint32_t getBytesPerPixel(D3DFORMAT format)
+{
+    switch (format)
+    {
+    case D3DFMT_R5G6B5:
+    case D3DFMT_X1R5G5B5:
+    case D3DFMT_A1R5G5B5:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+// Drops whatever is in flight, the queries and system memory surfaces are kept
+void resetSlots(Target& target)
+{
+    target.ring.reset();
+    for (Slot& slot : target.slots)
+    {
+        slot.state = Slot::st_idle;
+        slot.copy.release();
+    }
+}
+
+void releaseQueries(Target& target)
+{
+    for (Slot& slot : target.slots)
+    {
+        if (slot.copied != nullptr)
+        {
+            slot.copied->Release();
+            slot.copied = nullptr;
+        }
+    }
+}
+
+void releaseSurfaces(Target& target)
+{
+    resetSlots(target);
+    releaseQueries(target);
+    for (Slot& slot : target.slots)
+    {
+        if (slot.surface != nullptr)
+        {
+            slot.surface->Release();
+            slot.surface = nullptr;
+        }
+    }
+    target.width = 0;
+    target.height = 0;
+    target.format = D3DFMT_UNKNOWN;
+}
+
+// Captures in flight at the old size are dropped, the slots are created again as they're used
+void setSize(Target& target, UINT width, UINT height, D3DFORMAT format)
+{
+    if (target.width != width || target.height != height || target.format != format)
+    {
+        releaseSurfaces(target);
+        target.width = width;
+        target.height = height;
+        target.format = format;
+    }
+}
+
+bool createSlot(IDirect3DDevice9* device, Target& target, Slot& slot)
+{
+    if (slot.surface == nullptr && FAILED(device->CreateOffscreenPlainSurface(target.width, target.height, target.format, D3DPOOL_SYSTEMMEM, &slot.surface, nullptr)))
+    {
+        utinni::log::warning("Readback: couldn't create a system memory surface");
+        slot.surface = nullptr;
+    }
+    if (slot.copied == nullptr && FAILED(device->CreateQuery(D3DQUERYTYPE_EVENT, &slot.copied)))
+    {
+        utinni::log::warning("Readback: event queries aren't supported");
+        slot.copied = nullptr;
+    }
+    return slot.surface != nullptr && slot.copied != nullptr;
+}
+
+// Claims a slot and a pooled target to copy the capture into, -1 when every slot is in flight or it couldn't be created
+int beginCapture(IDirect3DDevice9* device, Target& target)
+{
+    const int index = target.ring.beginCapture(frame);
+    if (index < 0)
+    {
+        return -1;
+    }
+
+    Slot& slot = target.slots[index];
+    if (createSlot(device, target, slot))
+    {
+        slot.copy = utinni::renderTargetPool::acquire(device, target.width, target.height, target.format);
+        if (slot.copy.isValid())
+        {
+            return index;
+        }
+    }
+
+    target.ring.release((uint32_t)index);
+    return -1;
+}
+
+// Issues the event behind the copy, or frees the slot when the copy couldn't be queued
+void endCapture(Target& target, int index, bool copied)
+{
+    Slot& slot = target.slots[index];
+    if (copied && SUCCEEDED(slot.copied->Issue(D3DISSUE_END)))
+    {
+        slot.state = Slot::st_copying;
+        return;
+    }
+
+    slot.copy.release();
+    target.ring.release((uint32_t)index);
+}
+
+// Queues the download of every copy the GPU has finished, a copy that isn't done yet is checked again at the next present
+void download(IDirect3DDevice9* device, Target& target)
+{
+    for (uint32_t i = 0; i < target.ring.getSlotCount(); ++i)
+    {
+        Slot& slot = target.slots[i];
+        BOOL done = FALSE;
+        if (slot.state != Slot::st_copying || slot.copied->GetData(&done, sizeof(done), 0) != S_OK)
+        {
+            continue;
+        }
+
+        if (SUCCEEDED(device->GetRenderTargetData(slot.copy.getSurface(), slot.surface)))
+        {
+            slot.state = Slot::st_downloading;
+        }
+        else
+        {
+            slot.state = Slot::st_idle;
+            target.ring.release(i);
+        }
+
+        // The device orders later uses of the pooled target after the download
+        slot.copy.release();
+    }
+}
+
+bool wantsCapture(const Target& target)
+{
+    return (target.continuous || target.requestedCount > 0) && !utinni::readback::consumers.empty();
+}
+
+// Delivers every slot that's old enough, oldest first. A capture that is still copying or downloading is left for the
+// next present
+void deliver(Target& target)
+{
+    for (int index = target.ring.getReadySlot(frame); index >= 0; index = target.ring.getReadySlot(frame))
+    {
+        Slot& slot = target.slots[index];
+        if (slot.state != Slot::st_downloading)
+        {
+            return;
+        }
+
+        D3DLOCKED_RECT locked;
+        const HRESULT result = slot.surface->LockRect(&locked, nullptr, D3DLOCK_READONLY | D3DLOCK_DONOTWAIT);
+        if (result == D3DERR_WASSTILLDRAWING)
+        {
+            return;
+        }
+
+        if (SUCCEEDED(result))
+        {
+            utinni::readback::Frame& out = target.delivery;
+            out.source = target.source;
+            out.frame = target.ring.getCaptureFrame((uint32_t)index);
+            out.width = target.width;
+            out.height = target.height;
+            out.bytesPerPixel = getBytesPerPixel(target.format);
+            out.format = target.format;
+
+            const uint32_t rowBytes = out.width * out.bytesPerPixel;
+            out.data.resize((size_t)rowBytes * out.height);
+            utinni::gpu::packRows(locked.pBits, (uint32_t)locked.Pitch, rowBytes, out.height, out.data.data());
+            slot.surface->UnlockRect();
+
+            target.deliveredCount++;
+            utinni::readback::consumers.invoke(out);
+        }
+        slot.state = Slot::st_idle;
+        target.ring.release((uint32_t)index);
+    }
+}
+
+void captureColor(IDirect3DDevice9* device, Target& target)
+{
+    IDirect3DSurface9* backBuffer = nullptr;
+    if (FAILED(device->GetBackBuffer(0, 0, D3DBACKBUFFER_TYPE_MONO, &backBuffer)))
+    {
+        return;
+    }
+
+    D3DSURFACE_DESC desc;
+    backBuffer->GetDesc(&desc);
+    setSize(target, desc.Width, desc.Height, desc.Format);
+
+    // The copy also resolves a multisampled back buffer, which GetRenderTargetData couldn't read
+    const int index = beginCapture(device, target);
+    if (index >= 0)
+    {
+        endCapture(target, index, SUCCEEDED(device->StretchRect(backBuffer, nullptr, target.slots[index].copy.getSurface(), nullptr, D3DTEXF_NONE)));
+    }
+    backBuffer->Release();
+}
+
+IDirect3DPixelShader9* getDepthCopyShader(IDirect3DDevice9* device)
+{
+    if (depthCopyBinary == nullptr)
+    {
+        depthCopyBinary = utinni::shaderCache::request("shaders/depth_copy.ps", "ps_2_0");
+    }
+
+    if (depthCopyShader == nullptr && depthCopyBinary->isCompiled())
+    {
+        device->CreatePixelShader((const DWORD*)depthCopyBinary->bytecode.data(), &depthCopyShader);
+    }
+    return depthCopyShader;
+}
+
+// INTZ can only be sampled, so the depth is drawn into a pooled R32F target and that is copied to system memory
+bool drawDepthCopy(IDirect3DDevice9* device, IDirect3DTexture9* depth, IDirect3DSurface9* renderTarget, UINT width, UINT height)
+{
+    if (depthCopyState == nullptr && FAILED(device->CreateStateBlock(D3DSBT_ALL, &depthCopyState)))
+    {
+        depthCopyState = nullptr;
+        return false;
+    }
+    depthCopyState->Capture();
+
+    IDirect3DSurface9* previousTarget = nullptr;
+    IDirect3DSurface9* previousDepthStencil = nullptr;
+    device->GetRenderTarget(0, &previousTarget);
+    device->GetDepthStencilSurface(&previousDepthStencil);
+
+    device->SetRenderTarget(0, renderTarget);
+    device->SetDepthStencilSurface(nullptr);
+    device->SetRenderState(D3DRS_ZENABLE, FALSE);
+    device->SetRenderState(D3DRS_STENCILENABLE, FALSE);
+    device->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+    device->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
+    device->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
+    device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+    device->SetRenderState(D3DRS_SRGBWRITEENABLE, FALSE);
+    device->SetRenderState(D3DRS_COLORWRITEENABLE, 0x0F);
+    device->SetVertexShader(nullptr);
+    device->SetPixelShader(depthCopyShader);
+    device->SetTexture(0, depth);
+    device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_POINT);
+    device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_POINT);
+    device->SetSamplerState(0, D3DSAMP_MIPFILTER, D3DTEXF_NONE);
+    device->SetSamplerState(0, D3DSAMP_ADDRESSU, D3DTADDRESS_CLAMP);
+    device->SetSamplerState(0, D3DSAMP_ADDRESSV, D3DTADDRESS_CLAMP);
+    device->SetFVF(D3DFVF_XYZRHW | D3DFVF_TEX1);
+
+    // Pretransformed, offset by half a pixel so texels map to pixels one to one
+    const float right = (float)width - 0.5f;
+    const float bottom = (float)height - 0.5f;
+    const DepthVertex vertices[4] = {
+        { -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f },
+        { right, -0.5f, 0.0f, 1.0f, 1.0f, 0.0f },
+        { -0.5f, bottom, 0.0f, 1.0f, 0.0f, 1.0f },
+        { right, bottom, 0.0f, 1.0f, 1.0f, 1.0f },
+    };
+
+    bool drawn = false;
+    if (SUCCEEDED(device->BeginScene()))
+    {
+        drawn = SUCCEEDED(device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP, 2, vertices, sizeof(DepthVertex)));
+        device->EndScene();
+    }
+
+    device->SetRenderTarget(0, previousTarget);
+    device->SetDepthStencilSurface(previousDepthStencil);
+    if (previousTarget != nullptr)
+    {
+        previousTarget->Release();
+    }
+    if (previousDepthStencil != nullptr)
+    {
+        previousDepthStencil->Release();
+    }
+
+    depthCopyState->Apply();
+    return drawn;
+}
+
+void releaseDepthCopyState()
+{
+    if (depthCopyState != nullptr)
+    {
+        depthCopyState->Release();
+        depthCopyState = nullptr;
+    }
+}
+
+void captureDepth(IDirect3DDevice9* device, Target& target)
+{
+    directX::TextureResolver* resolver = directX::getTextureResolver();
+    IDirect3DTexture9* depth = utinni::dynamicResolution::getStretchedDepth();
+    if (depth == nullptr)
+    {
+        depth = resolver != nullptr ? resolver->getTextureDepth() : nullptr;
+    }
+    if (depth == nullptr || getDepthCopyShader(device) == nullptr)
+    {
+        return;
+    }
+
+    D3DSURFACE_DESC desc;
+    depth->GetLevelDesc(0, &desc);
+    setSize(target, desc.Width, desc.Height, D3DFMT_R32F);
+
+    const int index = beginCapture(device, target);
+    if (index >= 0)
+    {
+        endCapture(target, index, drawDepthCopy(device, depth, target.slots[index].copy.getSurface(), desc.Width, desc.Height));
+    }
+}
+
+void capture(IDirect3DDevice9* device, Target& target)
+{
+    if (!wantsCapture(target))
+    {
+        return;
+    }
+
+    if (target.source == Source::color)
+    {
+        captureColor(device, target);
+    }
+    else
+    {
+        captureDepth(device, target);
+    }
+
+    if (target.requestedCount > 0)
+    {
+        target.requestedCount--;
+    }
+}
+}
+
+namespace utinni::readback
+{
+void configure(uint32_t depth)
+{
+    const uint32_t slotCount = std::min(std::max(depth, 1u), ReadbackRing::maxSlots);
+    for (Target& target : targets)
+    {
+        releaseSurfaces(target);
+        target.ring.configure(slotCount, slotCount - 1);
+    }
+}
+
+void request(Source source, uint32_t frameCount)
+{
+    getTarget(source).requestedCount += frameCount;
+}
+
+void setContinuous(Source source, bool continuous)
+{
+    getTarget(source).continuous = continuous;
+}
+
+Stats getStats(Source source)
+{
+    const Target& target = getTarget(source);
+    return { target.ring.getPendingCount(), target.ring.getCapturedCount(), target.deliveredCount, target.ring.getDroppedCount() };
+}
+
+void onPresent(IDirect3DDevice9* device)
+{
+    UTINNI_PROFILE_ZONE("Readback::onPresent");
+    frame++;
+    for (Target& target : targets)
+    {
+        download(device, target);
+        deliver(target);
+        capture(device, target);
+    }
+}
+
+void onReset()
+{
+    // The system memory surfaces survive the reset, only what was in flight and the queries are lost
+    for (Target& target : targets)
+    {
+        resetSlots(target);
+        releaseQueries(target);
+    }
+    releaseDepthCopyState();
+}
+
+void releaseAll()
+{
+    for (Target& target : targets)
+    {
+        releaseSurfaces(target);
+    }
+    releaseDepthCopyState();
+
+    if (depthCopyShader != nullptr)
+    {
+        depthCopyShader->Release();
+        depthCopyShader = nullptr;
+    }
+    depthCopyBinary = nullptr;
+}
+}
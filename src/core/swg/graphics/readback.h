@@ -0,0 +1,88 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "utility/callback_list.h"
+#include <d3d9.h>
+#include <vector>
+
+// Asynchronous readback of the back buffer and the resolved depth for CPU consumers like screenshot encoders, depth
+// analysis or image tests. A capture is copied on the GPU into a pooled render target and an event query is issued behind
+// it. GetRenderTargetData into a system memory surface of a small ring (see utility/readback_ring.h) is only called once
+// that event has passed, and the surface is only locked a few presents later. Neither the CPU nor the GPU waits on the
+// other as long as the GPU keeps up with the ring depth; a capture that isn't done yet is just delivered later.
+// Colour is captured before the ImGui overlay is drawn, depth is the last depth the TextureResolver resolved.
+namespace utinni::readback
+{
+enum class Source
+{
+    color,
+    depth
+};
+
+// data is tightly packed, width * bytesPerPixel bytes per row. Colour is in the back buffer format, usually
+// D3DFMT_X8R8G8B8 or D3DFMT_A8R8G8B8, depth is D3DFMT_R32F holding the raw depth buffer values
+struct Frame
+{
+    Source source;
+    uint64_t frame; // Present the capture was made in
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytesPerPixel;
+    D3DFORMAT format;
+    std::vector<uint8_t> data;
+};
+
+struct Stats
+{
+    uint32_t pendingCount;
+    uint64_t capturedCount;
+    uint64_t deliveredCount;
+    uint64_t droppedCount; // Captures skipped as every slot was in flight
+};
+
+// Invoked on the render thread at present, the frame is reused afterwards so consumers have to copy what they keep
+extern UTINNI_API CallbackList<void(const Frame&)> consumers;
+
+template<typename T>
+CallbackHandle addConsumer(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
+{
+    return consumers.add(func, owner, name, priority);
+}
+
+// Number of slots per source, frames are delivered depth - 1 presents after they were captured
+UTINNI_API extern void configure(uint32_t depth);
+
+// Captures the next frameCount presents, or every present while continuous
+UTINNI_API extern void request(Source source, uint32_t frameCount = 1);
+UTINNI_API extern void setContinuous(Source source, bool continuous);
+UTINNI_API extern Stats getStats(Source source);
+
+// Called by the device hooks. The captures in flight are dropped on a reset
+void onPresent(IDirect3DDevice9* device);
+void onReset();
+void releaseAll();
+}
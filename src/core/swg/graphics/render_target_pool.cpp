@@ -0,0 +1,283 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "render_target_pool.h"
+#include "utility/log.h"
+#include <algorithm>
+#include <vector>
+
+namespace utinni::renderTargetPool
+{
+struct Entry
+{
+    Desc desc;
+    IDirect3DTexture9* texture;
+    IDirect3DSurface9* surface;
+    uint64_t size;
+    uint32_t references;
+    uint64_t lastUsedFrame;
+};
+}
+
+namespace
+{
+using utinni::renderTargetPool::Desc;
+using utinni::renderTargetPool::Entry;
+
+constexpr uint64_t unusedFrames = 300; // Free textures left this long, like the old size after a resize, are released
+
+std::vector<Entry*> entries;
+uint64_t frame = 0;
+uint64_t budget = 256ull * 1024 * 1024;
+uint64_t allocatedBytes = 0;
+uint64_t createdCount = 0;
+bool warnedOverBudget = false;
+
+uint32_t getBytesPerPixel(D3DFORMAT format)
+{
+    switch (format)
+    {
+    case D3DFMT_R16F:
+    case D3DFMT_L16:
+    case D3DFMT_D16:
+        return 2;
+    case D3DFMT_A16B16G16R16:
+    case D3DFMT_A16B16G16R16F:
+    case D3DFMT_G32R32F:
+        return 8;
+    case D3DFMT_A32B32G32R32F:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
+void releaseTexture(Entry* entry)
+{
+    if (entry->surface != nullptr)
+    {
+        entry->surface->Release();
+        entry->surface = nullptr;
+    }
+    if (entry->texture != nullptr)
+    {
+        entry->texture->Release();
+        entry->texture = nullptr;
+        allocatedBytes -= entry->size;
+    }
+}
+
+// Entries that are leased stay around without a texture until their last lease goes
+void removeFreeEntries(uint64_t usedBefore, uint64_t targetBytes)
+{
+    std::vector<Entry*> candidates;
+    for (Entry* entry : entries)
+    {
+        if (entry->references == 0 && entry->lastUsedFrame < usedBefore)
+        {
+            candidates.push_back(entry);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) { return a->lastUsedFrame < b->lastUsedFrame; });
+
+    for (Entry* entry : candidates)
+    {
+        if (allocatedBytes <= targetBytes)
+        {
+            break;
+        }
+        releaseTexture(entry);
+        entries.erase(std::find(entries.begin(), entries.end(), entry));
+        delete entry;
+    }
+}
+
+void addReference(Entry* entry)
+{
+    if (entry != nullptr)
+    {
+        entry->references++;
+    }
+}
+
+void removeReference(Entry* entry)
+{
+    if (entry == nullptr || --entry->references > 0)
+    {
+        return;
+    }
+
+    if (entry->texture == nullptr)
+    {
+        // Lost to a reset
+        entries.erase(std::find(entries.begin(), entries.end(), entry));
+        delete entry;
+        return;
+    }
+    entry->lastUsedFrame = frame;
+}
+}
+
+namespace utinni::renderTargetPool
+{
+Lease::Lease(Entry* entry) : entry(entry)
+{
+    addReference(entry);
+}
+
+Lease::Lease(const Lease& other) : entry(other.entry)
+{
+    addReference(entry);
+}
+
+Lease::Lease(Lease&& other) noexcept : entry(other.entry)
+{
+    other.entry = nullptr;
+}
+
+Lease& Lease::operator=(const Lease& other)
+{
+    if (entry != other.entry)
+    {
+        addReference(other.entry);
+        removeReference(entry);
+        entry = other.entry;
+    }
+    return *this;
+}
+
+Lease& Lease::operator=(Lease&& other) noexcept
+{
+    if (this != &other)
+    {
+        removeReference(entry);
+        entry = other.entry;
+        other.entry = nullptr;
+    }
+    return *this;
+}
+
+Lease::~Lease()
+{
+    release();
+}
+
+IDirect3DTexture9* Lease::getTexture() const
+{
+    return entry != nullptr ? entry->texture : nullptr;
+}
+
+IDirect3DSurface9* Lease::getSurface() const
+{
+    return entry != nullptr ? entry->surface : nullptr;
+}
+
+void Lease::release()
+{
+    removeReference(entry);
+    entry = nullptr;
+}
+
+Lease acquire(IDirect3DDevice9* device, UINT width, UINT height, D3DFORMAT format, DWORD usage)
+{
+    const Desc desc{ width, height, format, usage };
+    for (Entry* entry : entries)
+    {
+        if (entry->references == 0 && entry->texture != nullptr && entry->desc == desc)
+        {
+            return Lease(entry);
+        }
+    }
+
+    const uint64_t size = (uint64_t)width * height * getBytesPerPixel(format);
+    if (allocatedBytes + size > budget)
+    {
+        removeFreeEntries(frame + 1, budget > size ? budget - size : 0);
+        if (allocatedBytes + size > budget && !warnedOverBudget)
+        {
+            warnedOverBudget = true;
+            char message[128];
+            snprintf(message, sizeof(message), "Render target pool is over its budget, %.1f MB leased", (allocatedBytes + size) / (1024.0 * 1024.0));
+            log::warning(message);
+        }
+    }
+
+    IDirect3DTexture9* texture = nullptr;
+    if (device == nullptr || FAILED(device->CreateTexture(width, height, 1, usage, format, D3DPOOL_DEFAULT, &texture, nullptr)))
+    {
+        return Lease();
+    }
+
+    auto entry = new Entry{ desc, texture, nullptr, size, 0, frame };
+    texture->GetSurfaceLevel(0, &entry->surface);
+    entries.push_back(entry);
+    allocatedBytes += size;
+    createdCount++;
+    return Lease(entry);
+}
+
+void setBudget(uint64_t bytes)
+{
+    budget = bytes;
+    warnedOverBudget = false;
+}
+
+Stats getStats()
+{
+    Stats stats{ (uint32_t)entries.size(), 0, allocatedBytes, createdCount };
+    for (const Entry* entry : entries)
+    {
+        stats.leasedCount += entry->references > 0 ? 1 : 0;
+    }
+    return stats;
+}
+
+void onPresent()
+{
+    frame++;
+    if (frame > unusedFrames)
+    {
+        removeFreeEntries(frame - unusedFrames, 0);
+    }
+}
+
+void releaseAll()
+{
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        Entry* entry = *it;
+        releaseTexture(entry);
+        if (entry->references == 0)
+        {
+            it = entries.erase(it);
+            delete entry;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    warnedOverBudget = false;
+}
+}
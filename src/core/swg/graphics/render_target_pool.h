@@ -0,0 +1,87 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include <d3d9.h>
+
+// Default pool textures shared by the core and the plugins, keyed by size, format and usage. Textures go back to the pool
+// when their last lease is released, so transient targets taken for a pass are reused by the next plugin or frame. Free
+// textures that go unused for a while, or that don't fit the budget, are released at present, and a device reset releases
+// everything so nothing in the default pool is left behind.
+namespace utinni::renderTargetPool
+{
+struct Desc
+{
+    UINT width;
+    UINT height;
+    D3DFORMAT format;
+    DWORD usage;
+
+    bool operator==(const Desc& other) const { return width == other.width && height == other.height && format == other.format && usage == other.usage; }
+};
+
+struct Entry;
+
+// Reference counted, copies share the texture. A lease taken before a device reset is still safe to hold and release, but
+// comes back empty
+class UTINNI_API Lease
+{
+public:
+    Lease() = default;
+    explicit Lease(Entry* entry);
+    Lease(const Lease& other);
+    Lease(Lease&& other) noexcept;
+    Lease& operator=(const Lease& other);
+    Lease& operator=(Lease&& other) noexcept;
+    ~Lease();
+
+    IDirect3DTexture9* getTexture() const;
+    IDirect3DSurface9* getSurface() const; // Level 0, owned by the pool
+    bool isValid() const { return getTexture() != nullptr; }
+    void release();
+
+private:
+    Entry* entry = nullptr;
+};
+
+struct Stats
+{
+    uint32_t textureCount;
+    uint32_t leasedCount;
+    uint64_t allocatedBytes;
+    uint64_t createdCount; // Since the start
+};
+
+// usage is D3DUSAGE_RENDERTARGET or D3DUSAGE_DEPTHSTENCIL, the texture has a single level. Returns an empty lease if the
+// device can't create it
+UTINNI_API extern Lease acquire(IDirect3DDevice9* device, UINT width, UINT height, D3DFORMAT format, DWORD usage = D3DUSAGE_RENDERTARGET);
+
+UTINNI_API extern void setBudget(uint64_t bytes);
+UTINNI_API extern Stats getStats();
+
+void onPresent();
+void releaseAll();
+}
@@ -24,7 +24,10 @@
 
 #include "shader.h"
 #include "swg/graphics/directx9.h"
+#include "swg/graphics/draw_stats.h"
+#include "swg/graphics/gpu_profiler.h"
 #include "utility/memory.h"
+#include "utility/profiler.h"
 
 namespace swg::shaderPrimitiveSorter
 {
@@ -38,21 +41,21 @@ directX::TextureResolver* depthTexture;
 int vecOffset = 0;
 int phase = 0;
 constexpr uint8_t phaseStructSize = 36;
-constexpr swgptr midPopCell_Call = 0x772D60;
-constexpr swgptr start_midPopCell = 0x00773E39;
-constexpr swgptr return_midPopCell = 0x00773E41;
-__declspec(naked) void midPopCell()
+
+// GPU marks need names that outlive the frame
+constexpr const char* phaseNames[] = {
+    "Draw phase 0", "Draw phase 1", "Draw phase 2", "Draw phase 3", "Draw phase 4", "Draw phase 5", "Draw phase 6", "Draw phase 7",
+    "Draw phase 8", "Draw phase 9", "Draw phase 10", "Draw phase 11", "Draw phase 12", "Draw phase 13", "Draw phase 14", "Draw phase 15"
+};
+
+void __cdecl onPopCell()
 {
-    __asm
-    {
-        mov vecOffset, esi
-        pushad
-        pushfd
-        call midPopCell_Call
-    }
+    UTINNI_PROFILE_ZONE("Shader::popCell");
 
     depthTexture = directX::getTextureResolver();
     phase = vecOffset / phaseStructSize;
+    gpuProfiler::mark(phase >= 0 && phase < (int)std::size(phaseNames) ? phaseNames[phase] : "Draw phase other");
+    drawStats::onPhaseEnd(phase);
     if (phase == depthTexture->getStage()) // divide offset by struct size to get stage
     {
         if (depthTexture != nullptr && depthTexture->isSupported() && depthTexture->getTextureDepth() != nullptr)
@@ -61,13 +64,21 @@ __declspec(naked) void midPopCell()
         }
     }
 
-    for (const auto& func : drawPhaseCallbacks)
-    {
-        func(phase);
-    }
+    drawPhaseCallbacks.invoke(phase);
+}
 
+constexpr swgptr midPopCell_Call = 0x772D60;
+constexpr swgptr start_midPopCell = 0x00773E39;
+constexpr swgptr return_midPopCell = 0x00773E41;
+__declspec(naked) void midPopCell()
+{
     __asm
     {
+        mov vecOffset, esi
+        pushad
+        pushfd
+        call midPopCell_Call
+        call onPopCell
         popfd
         popad
         add esi, 0x24
@@ -75,7 +86,7 @@ __declspec(naked) void midPopCell()
     }
 }
 
-std::vector<std::function<void(int currentPhase)>> drawPhaseCallbacks;
+CallbackList<void(int currentPhase)> drawPhaseCallbacks("Shader::drawPhaseCallbacks");
 
 void detour()
 {
@@ -25,17 +25,18 @@
 #pragma once
 
 #include "utinni.h"
+#include "utility/callback_list.h"
 #include <functional>
 
 namespace utinni::shaderPrimitiveSorter
 {
 
-extern UTINNI_API std::vector<std::function<void(int currentPhase)>> drawPhaseCallbacks;
+extern UTINNI_API CallbackList<void(int currentPhase)> drawPhaseCallbacks;
 
 template<typename T>
-void addDrawPhaseCallback(void (*func)(int currentPhase))
+CallbackHandle addDrawPhaseCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
 {
-    drawPhaseCallbacks.emplace_back(func);
+    return drawPhaseCallbacks.add(func, owner, name, priority);
 }
 
 void detour();
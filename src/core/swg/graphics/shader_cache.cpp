@@ -0,0 +1,390 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "shader_cache.h"
+#include "utility/log.h"
+#include "d3dx9.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+using utinni::shaderCache::BinaryPtr;
+using utinni::shaderCache::Binary;
+using utinni::shaderCache::Define;
+
+struct Job
+{
+    BinaryPtr binary;
+    std::string path;
+    std::string profile;
+    std::string entry;
+    std::vector<Define> defines;
+    uint64_t key;
+};
+
+bool enabled = false;
+uint64_t maxSize = 0;
+std::string directory;
+
+// Timed like the log, shutdown runs on process detach where the worker may have been terminated holding it
+std::timed_mutex indexMutex;
+utinni::shaderCache::Index cacheIndex;
+bool indexDirty = false;
+
+std::mutex queueMutex;
+std::condition_variable queueCondition;
+std::deque<Job> queue;
+bool workerStarted = false;
+
+std::mutex completedMutex;
+std::condition_variable completedCondition;
+
+bool readFile(const std::string& filename, std::vector<uint8_t>& data)
+{
+    FILE* file = nullptr;
+    if (fopen_s(&file, filename.c_str(), "rb") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data.resize(size > 0 ? (size_t)size : 0);
+    const bool success = size >= 0 && fread(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+    return success;
+}
+
+bool writeFile(const std::string& filename, const void* data, size_t size)
+{
+    FILE* file = nullptr;
+    if (fopen_s(&file, filename.c_str(), "wb") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    const bool success = fwrite(data, 1, size, file) == size;
+    fclose(file);
+    return success;
+}
+
+void saveIndex()
+{
+    std::string text;
+    {
+        std::lock_guard<std::timed_mutex> lock(indexMutex);
+        if (!indexDirty)
+        {
+            return;
+        }
+        text = cacheIndex.serialize();
+        indexDirty = false;
+    }
+    writeFile(directory + "index.txt", text.data(), text.size());
+}
+
+void evict()
+{
+    std::vector<uint64_t> evicted;
+    {
+        std::lock_guard<std::timed_mutex> lock(indexMutex);
+        evicted = cacheIndex.evict(maxSize);
+        indexDirty |= !evicted.empty();
+    }
+
+    for (const uint64_t key : evicted)
+    {
+        DeleteFileA((directory + utinni::shaderCache::getFileName(key)).c_str());
+    }
+}
+
+bool load(uint64_t key, std::vector<uint8_t>& bytecode)
+{
+    if (!enabled)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::timed_mutex> lock(indexMutex);
+        if (!cacheIndex.contains(key))
+        {
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> file;
+    const bool success = readFile(directory + utinni::shaderCache::getFileName(key), file) && utinni::shaderCache::unpack(file, key, bytecode);
+
+    std::lock_guard<std::timed_mutex> lock(indexMutex);
+    if (success)
+    {
+        cacheIndex.touch(key, file.size());
+    }
+    else
+    {
+        cacheIndex.remove(key);
+    }
+    indexDirty = true;
+    return success;
+}
+
+void store(uint64_t key, const std::vector<uint8_t>& bytecode)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    const std::vector<uint8_t> file = utinni::shaderCache::pack(key, bytecode);
+    if (!writeFile(directory + utinni::shaderCache::getFileName(key), file.data(), file.size()))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::timed_mutex> lock(indexMutex);
+        cacheIndex.touch(key, file.size());
+        indexDirty = true;
+    }
+    evict();
+}
+
+void complete(const BinaryPtr& binary, int state)
+{
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        binary->state.store(state, std::memory_order_release);
+    }
+    completedCondition.notify_all();
+}
+
+void compile(Job& job)
+{
+    std::vector<D3DXMACRO> macros;
+    for (const Define& define : job.defines)
+    {
+        macros.push_back({ define.name.c_str(), define.value.c_str() });
+    }
+    macros.push_back({ nullptr, nullptr });
+
+    LPD3DXBUFFER code = nullptr;
+    LPD3DXBUFFER errors = nullptr;
+    const HRESULT result = D3DXCompileShaderFromFile(job.path.c_str(), macros.data(), nullptr, job.entry.c_str(), job.profile.c_str(), 0, &code, &errors, nullptr);
+
+    if (errors != nullptr)
+    {
+        job.binary->errors = (const char*)errors->GetBufferPointer();
+        errors->Release();
+    }
+
+    if (FAILED(result) || code == nullptr)
+    {
+        utinni::log::error(("Failed to compile " + job.binary->name + ": " + job.binary->errors).c_str());
+        complete(job.binary, Binary::st_failed);
+        return;
+    }
+
+    const auto data = (const uint8_t*)code->GetBufferPointer();
+    job.binary->bytecode.assign(data, data + code->GetBufferSize());
+    code->Release();
+
+    store(job.key, job.binary->bytecode);
+    complete(job.binary, Binary::st_compiled);
+}
+
+void workerLoop()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if (queue.empty())
+            {
+                lock.unlock();
+                saveIndex();
+                lock.lock();
+            }
+            queueCondition.wait(lock, []() { return !queue.empty(); });
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        compile(job);
+    }
+}
+
+std::vector<Define> toDefines(const D3DXMACRO* macros)
+{
+    std::vector<Define> defines;
+    for (; macros != nullptr && macros->Name != nullptr; ++macros)
+    {
+        defines.push_back({ macros->Name, macros->Definition != nullptr ? macros->Definition : "" });
+    }
+    return defines;
+}
+}
+
+namespace utinni::shaderCache
+{
+void init(bool enable, uint64_t maxBytes)
+{
+    enabled = enable;
+    maxSize = maxBytes;
+    directory = getPath() + "shader_cache\\";
+    if (!enabled)
+    {
+        return;
+    }
+
+    CreateDirectoryA(directory.c_str(), nullptr);
+
+    std::vector<uint8_t> text;
+    {
+        std::lock_guard<std::timed_mutex> lock(indexMutex);
+        if (readFile(directory + "index.txt", text))
+        {
+            cacheIndex.deserialize(std::string(text.begin(), text.end()));
+        }
+        cacheIndex.beginSession();
+        indexDirty = true;
+    }
+    evict();
+
+    char message[128];
+    snprintf(message, sizeof(message), "Shader cache holds %u shaders, %.1f MB", (uint32_t)cacheIndex.getCount(), cacheIndex.getTotalSize() / (1024.0 * 1024.0));
+    log::info(message);
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+BinaryPtr request(const std::string& path, const char* profile, const char* entry, const std::vector<Define>& defines)
+{
+    auto binary = std::make_shared<Binary>();
+    binary->name = path;
+    for (const Define& define : defines)
+    {
+        binary->name += " " + define.name;
+    }
+
+    const std::string fullPath = getPath() + path;
+    std::vector<uint8_t> source;
+    if (!readFile(fullPath, source))
+    {
+        binary->errors = "Failed to read " + fullPath;
+        log::error(binary->errors.c_str());
+        binary->state.store(Binary::st_failed);
+        return binary;
+    }
+
+    const uint64_t key = makeKey(hash(source.data(), source.size()), profile, entry, defines);
+    if (load(key, binary->bytecode))
+    {
+        binary->state.store(Binary::st_compiled);
+        return binary;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(Job{ binary, fullPath, profile, entry, defines, key });
+        if (!workerStarted)
+        {
+            workerStarted = true;
+            std::thread(workerLoop).detach();
+        }
+    }
+    queueCondition.notify_one();
+    return binary;
+}
+
+void wait(const BinaryPtr& binary)
+{
+    std::unique_lock<std::mutex> lock(completedMutex);
+    completedCondition.wait(lock, [&binary]() { return binary->isReady(); });
+}
+
+size_t getQueuedCount()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queue.size();
+}
+
+HRESULT compileClientShader(pCompileShader compile, LPCSTR pSrcData, UINT srcDataLen, LPVOID* pDefines, LPVOID pInclude, LPCSTR pFunctionName, LPCSTR pProfile, DWORD Flags, LPVOID* ppShader, LPVOID* ppErrorMsgs, LPVOID* ppConstantTable)
+{
+    if (!enabled || pSrcData == nullptr || ppShader == nullptr || ppConstantTable != nullptr || pInclude != nullptr)
+    {
+        return compile(pSrcData, srcDataLen, pDefines, pInclude, pFunctionName, pProfile, Flags, ppShader, ppErrorMsgs, ppConstantTable);
+    }
+
+    char profile[64];
+    snprintf(profile, sizeof(profile), "%s/%08x", pProfile != nullptr ? pProfile : "", (uint32_t)Flags);
+    const uint64_t key = makeKey(hash(pSrcData, srcDataLen), profile, pFunctionName != nullptr ? pFunctionName : "", toDefines((const D3DXMACRO*)pDefines));
+
+    std::vector<uint8_t> bytecode;
+    LPD3DXBUFFER buffer = nullptr;
+    if (load(key, bytecode) && SUCCEEDED(D3DXCreateBuffer((DWORD)bytecode.size(), &buffer)))
+    {
+        memcpy(buffer->GetBufferPointer(), bytecode.data(), bytecode.size());
+        *ppShader = buffer;
+        if (ppErrorMsgs != nullptr)
+        {
+            *ppErrorMsgs = nullptr;
+        }
+        return D3D_OK;
+    }
+
+    const HRESULT result = compile(pSrcData, srcDataLen, pDefines, pInclude, pFunctionName, pProfile, Flags, ppShader, ppErrorMsgs, ppConstantTable);
+    if (SUCCEEDED(result) && *ppShader != nullptr)
+    {
+        const auto compiled = (LPD3DXBUFFER)*ppShader;
+        const auto data = (const uint8_t*)compiled->GetBufferPointer();
+        store(key, std::vector<uint8_t>(data, data + compiled->GetBufferSize()));
+    }
+    return result;
+}
+
+void shutdown()
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    std::unique_lock<std::timed_mutex> lock(indexMutex, std::chrono::milliseconds(100));
+    if (lock.owns_lock() && indexDirty)
+    {
+        const std::string text = cacheIndex.serialize();
+        indexDirty = false;
+        lock.unlock();
+        writeFile(directory + "index.txt", text.data(), text.size());
+    }
+}
+}
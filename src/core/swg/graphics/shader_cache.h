@@ -0,0 +1,75 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "utility/shader_cache_index.h"
+#include <atomic>
+#include <memory>
+#include <d3d9.h>
+
+// Compiled shader bytecode kept on disk in shader_cache/, keyed by the source, profile, entry point and defines (see
+// utility/shader_cache_index.h). Hits are read straight from disk, misses are compiled with D3DX on a background thread
+// so loading and resizing never wait on the HLSL compiler.
+namespace utinni::shaderCache
+{
+struct Binary
+{
+    enum State
+    {
+        st_pending,
+        st_compiled,
+        st_failed
+    };
+
+    std::string name;
+    std::atomic<int> state{ st_pending };
+    std::vector<uint8_t> bytecode; // Valid once compiled
+    std::string errors;
+
+    bool isReady() const { return state.load(std::memory_order_acquire) != st_pending; }
+    bool isCompiled() const { return state.load(std::memory_order_acquire) == st_compiled; }
+};
+
+using BinaryPtr = std::shared_ptr<Binary>;
+
+// Loads the index and evicts past maxBytes, a disabled cache still compiles in the background but never touches the disk
+void init(bool enable, uint64_t maxBytes);
+UTINNI_API extern bool isEnabled();
+
+// path is relative to the utinni folder, a hit is ready on return
+UTINNI_API extern BinaryPtr request(const std::string& path, const char* profile, const char* entry = "main", const std::vector<Define>& defines = {});
+UTINNI_API extern void wait(const BinaryPtr& binary);
+UTINNI_API extern size_t getQueuedCount();
+
+using pCompileShader = HRESULT(__stdcall*)(LPCSTR pSrcData, UINT srcDataLen, LPVOID* pDefines, LPVOID pInclude, LPCSTR pFunctionName, LPCSTR pProfile, DWORD Flags, LPVOID* ppShader, LPVOID* ppErrorMsgs, LPVOID* ppConstantTable);
+
+// The client's D3DXCompileShader through the cache. Compiles that ask for a constant table or use an include handler
+// always go to the compiler, as neither is part of the cache
+HRESULT compileClientShader(pCompileShader compile, LPCSTR pSrcData, UINT srcDataLen, LPVOID* pDefines, LPVOID pInclude, LPCSTR pFunctionName, LPCSTR pProfile, DWORD Flags, LPVOID* ppShader, LPVOID* ppErrorMsgs, LPVOID* ppConstantTable);
+
+// Writes the index, compiles still in flight are simply picked up again next session
+void shutdown();
+}
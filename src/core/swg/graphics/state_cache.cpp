@@ -0,0 +1,234 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "state_cache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+constexpr int renderStateCount = 256;
+constexpr int samplerSlotCount = 21; // 16 pixel samplers, the displacement map sampler and 4 vertex samplers
+constexpr int samplerStateCount = 14;
+constexpr int renderTargetCount = 4;
+constexpr UINT vertexConstantCount = 256;
+constexpr UINT pixelConstantCount = 224;
+
+const void* const unknownObject = reinterpret_cast<const void*>(~swgptr(0));
+
+struct ShaderConstants
+{
+    float values[vertexConstantCount][4];
+    bool known[vertexConstantCount];
+};
+
+bool filtering = true;
+bool recording = false;
+utinni::stateCache::Eliminated eliminated{};
+
+DWORD renderStates[renderStateCount];
+bool renderStateKnown[renderStateCount];
+DWORD samplerStates[samplerSlotCount][samplerStateCount];
+bool samplerStateKnown[samplerSlotCount][samplerStateCount];
+const void* textures[samplerSlotCount];
+const void* vertexShader = unknownObject;
+const void* pixelShader = unknownObject;
+const void* renderTargets[renderTargetCount];
+const void* depthStencil = unknownObject;
+ShaderConstants vertexConstants;
+ShaderConstants pixelConstants;
+
+int getSamplerSlot(DWORD sampler)
+{
+    if (sampler < 16)
+    {
+        return sampler;
+    }
+    if (sampler >= D3DDMAPSAMPLER && sampler <= D3DVERTEXTEXTURESAMPLER3)
+    {
+        return 16 + (sampler - D3DDMAPSAMPLER);
+    }
+    return -1;
+}
+
+bool countEliminated(bool redundant, uint64_t& counter)
+{
+    if (redundant && filtering)
+    {
+        counter++;
+    }
+    return redundant;
+}
+
+bool isRedundantObject(const void*& shadow, const void* object)
+{
+    if (recording)
+    {
+        return false;
+    }
+
+    const bool redundant = shadow == object;
+    shadow = object;
+    return redundant;
+}
+
+bool isRedundantConstants(ShaderConstants& shadow, UINT registerCount, UINT startRegister, const float* data, UINT vector4fCount)
+{
+    if (recording || data == nullptr || startRegister >= registerCount || vector4fCount > registerCount - startRegister)
+    {
+        return false;
+    }
+
+    const size_t size = vector4fCount * sizeof(shadow.values[0]);
+    const bool allKnown = std::all_of(shadow.known + startRegister, shadow.known + startRegister + vector4fCount, [](bool known) { return known; });
+    if (allKnown && memcmp(shadow.values[startRegister], data, size) == 0)
+    {
+        return true;
+    }
+
+    memcpy(shadow.values[startRegister], data, size);
+    std::fill(shadow.known + startRegister, shadow.known + startRegister + vector4fCount, true);
+    return false;
+}
+}
+
+namespace utinni::stateCache
+{
+void enableFiltering(bool enable)
+{
+    filtering = enable;
+}
+
+bool isFilteringEnabled()
+{
+    return filtering;
+}
+
+const Eliminated& getEliminated()
+{
+    return eliminated;
+}
+
+void resetEliminated()
+{
+    eliminated = Eliminated();
+}
+
+bool isRedundantRenderState(D3DRENDERSTATETYPE state, DWORD value)
+{
+    if (recording || (DWORD)state >= renderStateCount)
+    {
+        return false;
+    }
+
+    const bool redundant = renderStateKnown[state] && renderStates[state] == value;
+    renderStates[state] = value;
+    renderStateKnown[state] = true;
+    return countEliminated(redundant, eliminated.renderStates);
+}
+
+bool isRedundantSamplerState(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value)
+{
+    const int slot = getSamplerSlot(sampler);
+    if (recording || slot < 0 || (DWORD)type >= samplerStateCount)
+    {
+        return false;
+    }
+
+    const bool redundant = samplerStateKnown[slot][type] && samplerStates[slot][type] == value;
+    samplerStates[slot][type] = value;
+    samplerStateKnown[slot][type] = true;
+    return countEliminated(redundant, eliminated.samplerStates);
+}
+
+bool isRedundantTexture(DWORD stage, const IDirect3DBaseTexture9* texture)
+{
+    const int slot = getSamplerSlot(stage);
+    return slot >= 0 && countEliminated(isRedundantObject(textures[slot], texture), eliminated.textures);
+}
+
+bool isRedundantVertexShader(const IDirect3DVertexShader9* shader)
+{
+    return countEliminated(isRedundantObject(vertexShader, shader), eliminated.shaders);
+}
+
+bool isRedundantPixelShader(const IDirect3DPixelShader9* shader)
+{
+    return countEliminated(isRedundantObject(pixelShader, shader), eliminated.shaders);
+}
+
+bool isRedundantVertexShaderConstants(UINT startRegister, const float* data, UINT vector4fCount)
+{
+    return countEliminated(isRedundantConstants(vertexConstants, vertexConstantCount, startRegister, data, vector4fCount), eliminated.shaderConstants);
+}
+
+bool isRedundantPixelShaderConstants(UINT startRegister, const float* data, UINT vector4fCount)
+{
+    return countEliminated(isRedundantConstants(pixelConstants, pixelConstantCount, startRegister, data, vector4fCount), eliminated.shaderConstants);
+}
+
+bool isRenderTargetChange(DWORD index, const IDirect3DSurface9* surface)
+{
+    return index < renderTargetCount && !isRedundantObject(renderTargets[index], surface);
+}
+
+bool isDepthStencilChange(const IDirect3DSurface9* surface)
+{
+    return !isRedundantObject(depthStencil, surface);
+}
+
+bool getRenderState(D3DRENDERSTATETYPE state, DWORD& value)
+{
+    if ((DWORD)state >= renderStateCount || !renderStateKnown[state])
+    {
+        return false;
+    }
+
+    value = renderStates[state];
+    return true;
+}
+
+void beginStateBlock()
+{
+    recording = true;
+}
+
+void endStateBlock()
+{
+    recording = false;
+}
+
+void invalidate()
+{
+    std::fill(std::begin(renderStateKnown), std::end(renderStateKnown), false);
+    std::fill(&samplerStateKnown[0][0], &samplerStateKnown[0][0] + samplerSlotCount * samplerStateCount, false);
+    std::fill(std::begin(textures), std::end(textures), unknownObject);
+    std::fill(std::begin(renderTargets), std::end(renderTargets), unknownObject);
+    std::fill(std::begin(vertexConstants.known), std::end(vertexConstants.known), false);
+    std::fill(std::begin(pixelConstants.known), std::end(pixelConstants.known), false);
+    vertexShader = unknownObject;
+    pixelShader = unknownObject;
+    depthStencil = unknownObject;
+}
+}
@@ -0,0 +1,69 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include <d3d9.h>
+
+// Shadow of the device state last set through the D3D9 hooks. The isRedundant functions record the new value and report
+// whether it matches what the device already has, with filtering enabled the hooks then drop the call before the driver.
+// Device objects can't be reused at the same address while bound, as the device holds a reference to them.
+namespace utinni::stateCache
+{
+struct Eliminated
+{
+    uint64_t renderStates;
+    uint64_t samplerStates;
+    uint64_t textures;
+    uint64_t shaders;
+    uint64_t shaderConstants;
+};
+
+UTINNI_API extern void enableFiltering(bool enable);
+UTINNI_API extern bool isFilteringEnabled();
+
+UTINNI_API extern const Eliminated& getEliminated();
+UTINNI_API extern void resetEliminated();
+
+// Called by the device hooks
+bool isRedundantRenderState(D3DRENDERSTATETYPE state, DWORD value);
+bool isRedundantSamplerState(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value);
+bool isRedundantTexture(DWORD stage, const IDirect3DBaseTexture9* texture);
+bool isRedundantVertexShader(const IDirect3DVertexShader9* shader);
+bool isRedundantPixelShader(const IDirect3DPixelShader9* shader);
+bool isRedundantVertexShaderConstants(UINT startRegister, const float* data, UINT vector4fCount);
+bool isRedundantPixelShaderConstants(UINT startRegister, const float* data, UINT vector4fCount);
+
+// Render target and depth stencil sets are only tracked, setting a render target also resets the viewport
+bool isRenderTargetChange(DWORD index, const IDirect3DSurface9* surface);
+bool isDepthStencilChange(const IDirect3DSurface9* surface);
+
+bool getRenderState(D3DRENDERSTATETYPE state, DWORD& value);
+
+// Sets while recording a state block don't reach the device, applying one changes state behind the shadow
+void beginStateBlock();
+void endStateBlock();
+void invalidate();
+}
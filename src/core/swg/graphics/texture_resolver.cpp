@@ -26,6 +26,10 @@
 #include "texture_resolver.h"
 #include "../game/game.h"
 #include "../camera/camera.h"
+#include "gpu_profiler.h"
+#include "depth_pyramid.h"
+#include "dynamic_resolution.h"
+#include "utility/profiler.h"
 
 #include <DirectXMath.h>
 #include <d3d9types.h>
@@ -40,12 +44,15 @@
 namespace directX
 {
 
-std::vector<std::function<void(IDirect3DDevice9*, IDirect3DTexture9*, IDirect3DTexture9*)>> resolveCallbacks;
+utinni::CallbackList<void(IDirect3DDevice9*, IDirect3DTexture9*, IDirect3DTexture9*)> resolveCallbacks("TextureResolver::resolveCallbacks");
 
 // ?getBuffer@Commander@DPVS@@IBE?AW4BufferType@LibraryDefs@2@AAPBEAAH1@Z
 
 TextureResolver::TextureResolver()
     : pTextureDepth(nullptr)
+	 , pTextureColor(nullptr)
+	 , width(0)
+	 , height(0)
 	 , m_isNVAPI(false)
 	 , m_isSupported(false)
 	 , pRegisteredDSS(nullptr)
@@ -65,10 +72,21 @@ void TextureResolver::createTexture(LPDIRECT3DDEVICE9 pDevice, int width, int he
 {
 	 if (m_isSupported)
 	 {
+		  release(); // The previous size goes back to the pool
+
 		  _pDevice = pDevice;
+		  this->width = width;
+		  this->height = height;
 		  D3DFORMAT format = FOURCC_INTZ; //m_isNVAPI ? FOURCC_INTZ : FOURCC_RAWZ;
-		  pDevice->CreateTexture(width, height, 1, D3DUSAGE_DEPTHSTENCIL, format, D3DPOOL_DEFAULT, &pTextureDepth, nullptr);
-		  pDevice->CreateTexture(width, height, 1, D3DUSAGE_RENDERTARGET, D3DFMT_X8R8G8B8, D3DPOOL_DEFAULT, &pTextureColor, nullptr);
+		  depthLease = utinni::renderTargetPool::acquire(pDevice, width, height, format, D3DUSAGE_DEPTHSTENCIL);
+		  colorLease = utinni::renderTargetPool::acquire(pDevice, width, height, D3DFMT_X8R8G8B8, D3DUSAGE_RENDERTARGET);
+		  pTextureDepth = depthLease.getTexture();
+		  pTextureColor = colorLease.getTexture();
+		  if (pTextureDepth == nullptr || pTextureColor == nullptr)
+		  {
+				release();
+				return;
+		  }
 
 
 		  if (m_isNVAPI)
@@ -94,11 +112,8 @@ void TextureResolver::release()
 		  {
 				NvAPI_D3D9_UnregisterResource(pTextureDepth);
 		  }
-		  if (pTextureDepth != nullptr)
-		  {
-				pTextureDepth->Release();
-				pTextureDepth = nullptr;
-		  }
+		  depthLease.release();
+		  pTextureDepth = nullptr;
 	 }
 
 	 if (pRegisteredDSS)
@@ -107,11 +122,7 @@ void TextureResolver::release()
 		  {
 				NvAPI_D3D9_UnregisterResource(pRegisteredDSS);
 		  }
-		  if (pRegisteredDSS != nullptr)
-		  {
-				pRegisteredDSS->Release();
-				pRegisteredDSS = nullptr;
-		  }
+		  pRegisteredDSS = nullptr; // Not referenced, resolveDepth releases it right after registering
 	 }
 
 	 if (pTextureColor)
@@ -120,11 +131,8 @@ void TextureResolver::release()
 		  {
 				NvAPI_D3D9_UnregisterResource(pTextureColor);
 		  }
-		  if (pTextureColor != nullptr)
-		  {
-				pTextureColor->Release();
-				pTextureColor = nullptr;
-		  }
+		  colorLease.release();
+		  pTextureColor = nullptr;
 	 }
 }
 
@@ -134,22 +142,6 @@ TextureResolver::~TextureResolver()
 	 release();
 }
 
-void copyTextureData(LPDIRECT3DTEXTURE9 pTexture, D3DSURFACE_DESC textureDesc)
-{
-	 D3DLOCKED_RECT lockedRect;
-	 RECT rect;
-	 rect.top = 0;
-	 rect.left = 0;
-	 rect.right = textureDesc.Width;
-	 rect.bottom = textureDesc.Height;
-
-	 pTexture->LockRect(0, &lockedRect, &rect, 0);
-	 const size_t size = textureDesc.Width * textureDesc.Height * lockedRect.Pitch;
-	 std::vector<byte> textureData(size);
-	 memcpy(textureData.data(), lockedRect.pBits, size);
-	 pTexture->UnlockRect(0);
-}
-
 void resolveDepthWithResz(const LPDIRECT3DDEVICE9 pDevice, LPDIRECT3DTEXTURE9 pTexture)
 {
 	 pDevice->SetVertexShader(nullptr);
@@ -202,12 +194,12 @@ void TextureResolver::resolveDepth(const LPDIRECT3DDEVICE9 pDevice, IDirect3DSur
 	 {
 		  resolveDepthWithResz(pDevice, pTextureDepth);
 	 }
-
-	 //copyTextureData(pTexture, textureDesc);
 }
 
 void TextureResolver::resolveDepth()
 {
+	 UTINNI_PROFILE_ZONE("TextureResolver::resolveDepth");
+	 UTINNI_GPU_ZONE("TextureResolver::resolveDepth");
 	 if (m_isNVAPI)
 	 {
 		  IDirect3DSurface9* pDSS = nullptr;
@@ -231,7 +223,11 @@ void TextureResolver::resolveDepth()
 		  LPDIRECT3DSURFACE9 pSurface;
 	      pTextureColor->GetSurfaceLevel(0, &pSurface);
 	      _pDevice->GetRenderTarget(0, &pRenderTarget);
-	      _pDevice->StretchRect(pRenderTarget, nullptr, pSurface, nullptr, D3DTEXF_NONE);
+
+		  // A scaled scene only covers part of the target, it's stretched to the full size
+		  RECT sceneRect;
+		  const bool scaled = utinni::dynamicResolution::getSceneRect(sceneRect);
+	      _pDevice->StretchRect(pRenderTarget, scaled ? &sceneRect : nullptr, pSurface, nullptr, scaled ? D3DTEXF_LINEAR : D3DTEXF_NONE);
 		  pRenderTarget->Release();
 		  pSurface->Release();
 	 }
@@ -240,9 +236,8 @@ void TextureResolver::resolveDepth()
 		  resolveDepthWithResz(_pDevice, pTextureDepth);
 	 }
 
-	 for (const auto& func : resolveCallbacks)
-	 {
-		  func(_pDevice, pTextureDepth, pTextureColor);
-	 }
+	 IDirect3DTexture9* depth = utinni::dynamicResolution::stretchDepth(_pDevice, pTextureDepth);
+	 utinni::depthPyramid::build(_pDevice, depth);
+	 resolveCallbacks.invoke(_pDevice, depth, pTextureColor);
 }
 }
\ No newline at end of file
@@ -1,19 +1,25 @@
 #pragma once
 
 #include "utinni.h"
+#include "utility/callback_list.h"
+#include "render_target_pool.h"
 #include <d3d9.h>
 #include <functional>
 #include <vector>
 
 namespace directX
 {
-extern UTINNI_API std::vector<std::function<void(IDirect3DDevice9*, IDirect3DTexture9* depth, IDirect3DTexture9* color)>> resolveCallbacks;
+extern UTINNI_API utinni::CallbackList<void(IDirect3DDevice9*, IDirect3DTexture9* depth, IDirect3DTexture9* color)> resolveCallbacks;
 
 class TextureResolver
 {
 private:
 	 IDirect3DTexture9* pTextureDepth;
 	 IDirect3DTexture9* pTextureColor;
+	 utinni::renderTargetPool::Lease depthLease;
+	 utinni::renderTargetPool::Lease colorLease;
+	 int width;
+	 int height;
 	 bool m_isRESZ;
 	 bool m_isINTZ;
 	 bool m_isNVAPI;
@@ -32,6 +38,7 @@ public:
 
 	 LPDIRECT3DTEXTURE9 getTextureDepth() { return pTextureDepth; }
 	 LPDIRECT3DTEXTURE9 getTextureColor() { return pTextureColor; }
+	 bool hasSize(int w, int h) { return width == w && height == h; }
 	 bool isINTZ() { return m_isINTZ; }
 	 bool isSupported() { return m_isSupported; }
 	 bool isNvidia() { return m_isNVAPI; }
@@ -40,9 +47,9 @@ public:
 	 void setStage(int value) { stage = value; }
 	
 	 template<typename T>
-     void addCallback(T func)
+     utinni::CallbackHandle addCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
      {
-         resolveCallbacks.emplace_back(func);
+         return resolveCallbacks.add(func, owner, name, priority);
      }
 };
 
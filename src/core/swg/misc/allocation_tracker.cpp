@@ -0,0 +1,445 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "allocation_tracker.h"
+#include "utility/log.h"
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#ifndef _WIN32
+#include <execinfo.h>
+#endif
+
+namespace
+{
+constexpr int sizeClassCount = 14; // <=16 bytes up to <=64k, and everything larger
+constexpr int maxTagCount = 32;
+constexpr int maxStackDepth = 12;
+constexpr int frameHistoryCount = 600;
+constexpr uint32_t sampledFilterSize = 1 << 16;
+
+template <typename T>
+void increment(std::atomic<T>& value, T amount)
+{
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Only written by the thread that owns them, so a plain load and store does and the hot path has no locked instructions.
+// The atomics keep the reports, which read them from another thread, free of data races
+struct Counters
+{
+    std::atomic<uint32_t> allocations{ 0 };
+    std::atomic<uint32_t> deallocations{ 0 };
+    std::atomic<uint64_t> bytesAllocated{ 0 };
+    std::atomic<uint64_t> bytesDeallocated{ 0 };
+
+    void add(size_t size)
+    {
+        increment(allocations, 1u);
+        increment(bytesAllocated, (uint64_t)size);
+    }
+
+    void remove(size_t size)
+    {
+        increment(deallocations, 1u);
+        increment(bytesDeallocated, (uint64_t)size);
+    }
+};
+
+struct ThreadCounters
+{
+    Counters totals;
+    Counters sizeClasses[sizeClassCount];
+    Counters tags[maxTagCount];
+    Counters untagged;
+};
+
+// The sum over all threads
+struct Totals
+{
+    uint32_t allocations = 0;
+    uint32_t deallocations = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t bytesDeallocated = 0;
+
+    void add(const Counters& counters)
+    {
+        allocations += counters.allocations.load(std::memory_order_relaxed);
+        deallocations += counters.deallocations.load(std::memory_order_relaxed);
+        bytesAllocated += counters.bytesAllocated.load(std::memory_order_relaxed);
+        bytesDeallocated += counters.bytesDeallocated.load(std::memory_order_relaxed);
+    }
+};
+
+struct SampledAllocation
+{
+    size_t size;
+    const char* tag;
+    uint32_t frame;
+    uint16_t stackDepth;
+    void* stack[maxStackDepth];
+};
+
+struct FrameSample
+{
+    uint32_t frame;
+    uint32_t allocations;
+    uint32_t deallocations;
+    uint64_t bytesAllocated;
+    uint64_t bytesDeallocated;
+};
+
+bool enabled = false;
+uint32_t sampleRate = 64;
+std::atomic<uint32_t> frameNumber{ 0 };
+
+std::atomic<const char*> tagNames[maxTagCount];
+
+// Never freed, the counts of a thread that has exited still belong in the report
+std::mutex threadCountersMutex;
+std::vector<ThreadCounters*> allThreadCounters;
+
+thread_local ThreadCounters* threadCounters = nullptr;
+thread_local const char* currentTag = nullptr;
+thread_local uint32_t allocationsUntilSample = 0;
+
+// Rough filter of sampled addresses, so deallocations of allocations that weren't sampled never take the lock
+std::atomic<uint8_t> sampledFilter[sampledFilterSize];
+std::mutex sampledMutex;
+std::unordered_map<void*, SampledAllocation> sampledAllocations;
+
+std::array<FrameSample, frameHistoryCount> frameHistory;
+uint32_t frameHistoryCountWritten = 0;
+Totals lastTotals;
+
+int getSizeClass(size_t size)
+{
+    int sizeClass = 0;
+    size_t classSize = 16;
+    while (size > classSize && sizeClass < sizeClassCount - 1)
+    {
+        classSize <<= 1;
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+ThreadCounters& getThreadCounters()
+{
+    if (threadCounters == nullptr)
+    {
+        threadCounters = new ThreadCounters();
+        std::lock_guard<std::mutex> lock(threadCountersMutex);
+        allThreadCounters.emplace_back(threadCounters);
+    }
+    return *threadCounters;
+}
+
+template <typename Select>
+Totals sumCounters(Select select)
+{
+    Totals totals;
+    std::lock_guard<std::mutex> lock(threadCountersMutex);
+    for (const ThreadCounters* counters : allThreadCounters)
+    {
+        totals.add(select(*counters));
+    }
+    return totals;
+}
+
+Counters& getTagCounters(ThreadCounters& counters, const char* tag)
+{
+    if (tag == nullptr)
+    {
+        return counters.untagged;
+    }
+
+    for (int i = 0; i < maxTagCount; ++i)
+    {
+        const char* name = tagNames[i].load(std::memory_order_acquire);
+        if (name == tag)
+        {
+            return counters.tags[i];
+        }
+
+        if (name == nullptr)
+        {
+            const char* expected = nullptr;
+            if (tagNames[i].compare_exchange_strong(expected, tag) || expected == tag)
+            {
+                return counters.tags[i];
+            }
+        }
+    }
+
+    return counters.untagged; // Out of tag slots
+}
+
+uint32_t getFilterIndex(void* address)
+{
+    return (uint32_t)((uintptr_t)address >> 3) & (sampledFilterSize - 1);
+}
+
+std::string getSymbolName(void* address)
+{
+#ifdef _WIN32
+    HMODULE module = nullptr;
+    char buffer[MAX_PATH] = "?";
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)address, &module))
+    {
+        GetModuleFileNameA(module, buffer, sizeof(buffer));
+    }
+
+    const char* moduleName = strrchr(buffer, '\\');
+    moduleName = moduleName != nullptr ? moduleName + 1 : buffer;
+
+    char result[MAX_PATH + 16];
+    snprintf(result, sizeof(result), "%s+0x%X", moduleName, (swgptr)address - (swgptr)module);
+    return result;
+#else
+    char result[32]; // Only the counting and sampling are built outside of Windows, for the micro benchmarks
+    snprintf(result, sizeof(result), "%p", address);
+    return result;
+#endif
+}
+}
+
+namespace utinni::allocationTracker
+{
+Tag::Tag(const char* name) : previous(currentTag)
+{
+    currentTag = name;
+}
+
+Tag::~Tag()
+{
+    currentTag = previous;
+}
+
+void enable(bool enable, int rate)
+{
+    enabled = enable;
+    sampleRate = (uint32_t)std::max(rate, 0);
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+void onAllocate(void* address, size_t size)
+{
+    if (address == nullptr)
+    {
+        return;
+    }
+
+    ThreadCounters& counters = getThreadCounters();
+    counters.totals.add(size);
+    counters.sizeClasses[getSizeClass(size)].add(size);
+    getTagCounters(counters, currentTag).add(size);
+
+    if (sampleRate == 0)
+    {
+        return;
+    }
+
+    if (allocationsUntilSample > 0)
+    {
+        allocationsUntilSample--;
+        return;
+    }
+    allocationsUntilSample = sampleRate - 1;
+
+    SampledAllocation sample;
+    sample.size = size;
+    sample.tag = currentTag;
+    sample.frame = frameNumber.load(std::memory_order_relaxed);
+#ifdef _WIN32
+    sample.stackDepth = CaptureStackBackTrace(2, maxStackDepth, sample.stack, nullptr);
+#else
+    sample.stackDepth = (uint16_t)backtrace(sample.stack, maxStackDepth);
+#endif
+
+    sampledFilter[getFilterIndex(address)].store(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(sampledMutex);
+    sampledAllocations[address] = sample;
+}
+
+void onDeallocate(void* address, size_t size)
+{
+    if (address == nullptr)
+    {
+        return;
+    }
+
+    ThreadCounters& counters = getThreadCounters();
+    counters.totals.remove(size);
+    counters.sizeClasses[getSizeClass(size)].remove(size);
+
+    if (sampledFilter[getFilterIndex(address)].load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(sampledMutex);
+    sampledAllocations.erase(address);
+}
+
+void onFrameEnd()
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    const uint32_t frame = frameNumber.fetch_add(1, std::memory_order_relaxed);
+    const Totals current = sumCounters([](const ThreadCounters& counters) -> const Counters& { return counters.totals; });
+
+    frameHistory[frameHistoryCountWritten % frameHistoryCount] = {
+        frame,
+        current.allocations - lastTotals.allocations,
+        current.deallocations - lastTotals.deallocations,
+        current.bytesAllocated - lastTotals.bytesAllocated,
+        current.bytesDeallocated - lastTotals.bytesDeallocated
+    };
+    frameHistoryCountWritten++;
+    lastTotals = current;
+}
+
+void logReport(int minLeakAgeFrames)
+{
+    char buffer[512];
+
+    const Totals totals = sumCounters([](const ThreadCounters& counters) -> const Counters& { return counters.totals; });
+    snprintf(buffer, sizeof(buffer), "Allocations: %u allocated (%llu bytes), %u freed (%llu bytes)", totals.allocations, (unsigned long long)totals.bytesAllocated, totals.deallocations, (unsigned long long)totals.bytesDeallocated);
+    log::info(buffer);
+
+    for (int i = 0; i < sizeClassCount; ++i)
+    {
+        const Totals counters = sumCounters([i](const ThreadCounters& threadCounters) -> const Counters& { return threadCounters.sizeClasses[i]; });
+        if (counters.allocations == 0)
+        {
+            continue;
+        }
+
+        if (i < sizeClassCount - 1)
+        {
+            snprintf(buffer, sizeof(buffer), "  <= %6u bytes: %u allocs, %u frees, %llu bytes live", 16u << i, counters.allocations, counters.deallocations, (unsigned long long)(counters.bytesAllocated - counters.bytesDeallocated));
+        }
+        else
+        {
+            snprintf(buffer, sizeof(buffer), "   > %6u bytes: %u allocs, %u frees, %llu bytes live", 16u << (i - 1), counters.allocations, counters.deallocations, (unsigned long long)(counters.bytesAllocated - counters.bytesDeallocated));
+        }
+        log::info(buffer);
+    }
+
+    for (int i = 0; i < maxTagCount; ++i)
+    {
+        const char* name = tagNames[i].load();
+        if (name != nullptr)
+        {
+            const Totals tagCounters = sumCounters([i](const ThreadCounters& threadCounters) -> const Counters& { return threadCounters.tags[i]; });
+            snprintf(buffer, sizeof(buffer), "  [%s] %u allocs, %llu bytes", name, tagCounters.allocations, (unsigned long long)tagCounters.bytesAllocated);
+            log::info(buffer);
+        }
+    }
+
+    // Group the old sampled allocations by callstack, these are the leak candidates
+    struct LeakGroup
+    {
+        const SampledAllocation* sample;
+        uint32_t count;
+        uint64_t bytes;
+    };
+
+    std::lock_guard<std::mutex> lock(sampledMutex);
+
+    std::unordered_map<uint64_t, LeakGroup> leakGroups;
+    const uint32_t frame = frameNumber.load();
+    for (const auto& sampled : sampledAllocations)
+    {
+        const SampledAllocation& sample = sampled.second;
+        if (frame - sample.frame < (uint32_t)minLeakAgeFrames)
+        {
+            continue;
+        }
+
+        uint64_t hash = 0xCBF29CE484222325;
+        for (int i = 0; i < sample.stackDepth; ++i)
+        {
+            hash = (hash ^ (uintptr_t)sample.stack[i]) * 0x100000001B3;
+        }
+
+        LeakGroup& group = leakGroups.try_emplace(hash, LeakGroup{ &sample, 0, 0 }).first->second;
+        group.count++;
+        group.bytes += sample.size;
+    }
+
+    std::vector<const LeakGroup*> sortedGroups;
+    for (const auto& group : leakGroups)
+    {
+        sortedGroups.emplace_back(&group.second);
+    }
+    std::sort(sortedGroups.begin(), sortedGroups.end(), [](const LeakGroup* a, const LeakGroup* b) { return a->bytes > b->bytes; });
+
+    snprintf(buffer, sizeof(buffer), "Sampled allocations older than %d frames: %u callstacks (1 in %u allocations sampled)", minLeakAgeFrames, (uint32_t)sortedGroups.size(), sampleRate);
+    log::info(buffer);
+
+    for (const LeakGroup* group : sortedGroups)
+    {
+        snprintf(buffer, sizeof(buffer), "  %u x %llu bytes [%s]", group->count, (unsigned long long)group->bytes, group->sample->tag != nullptr ? group->sample->tag : "untagged");
+        log::info(buffer);
+
+        for (int i = 0; i < group->sample->stackDepth; ++i)
+        {
+            log::info(("    " + getSymbolName(group->sample->stack[i])).c_str());
+        }
+    }
+}
+
+bool exportFrameRates(const std::string& filename)
+{
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "frame,allocations,deallocations,bytesAllocated,bytesDeallocated\n";
+
+    const uint32_t count = std::min<uint32_t>(frameHistoryCountWritten, frameHistoryCount);
+    for (uint32_t i = frameHistoryCountWritten - count; i < frameHistoryCountWritten; ++i)
+    {
+        const FrameSample& sample = frameHistory[i % frameHistoryCount];
+        file << sample.frame << "," << sample.allocations << "," << sample.deallocations << "," << sample.bytesAllocated << "," << sample.bytesDeallocated << "\n";
+    }
+
+    return true;
+}
+}
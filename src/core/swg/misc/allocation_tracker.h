@@ -0,0 +1,59 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+// Opt-in instrumentation of the client allocator wrappers in swg_memory. Counting is per thread and takes no locks, every
+// sampleRate-th allocation is additionally recorded with its callstack so allocations that are never freed
+// show up in the report.
+namespace utinni::allocationTracker
+{
+// Tags allocations made on this thread while in scope with the name of the calling subsystem
+class UTINNI_API Tag
+{
+public:
+    explicit Tag(const char* name);
+    ~Tag();
+
+    Tag(const Tag&) = delete;
+    Tag& operator=(const Tag&) = delete;
+
+private:
+    const char* previous;
+};
+
+UTINNI_API extern void enable(bool enable, int sampleRate = 64);
+UTINNI_API extern bool isEnabled();
+
+void onAllocate(void* address, size_t size);
+void onDeallocate(void* address, size_t size);
+void onFrameEnd();
+
+// Logs the per size class and per tag counters, plus the sampled allocations older than minLeakAgeFrames grouped by callstack
+UTINNI_API extern void logReport(int minLeakAgeFrames = 300);
+// Writes the allocation counts and bytes of the recent frames as CSV
+UTINNI_API extern bool exportFrameRates(const std::string& filename);
+}
@@ -24,6 +24,7 @@
 
 #include "crc_string.h"
 #include "swg_memory.h"
+#include "allocation_tracker.h"
 
 namespace swg::crcString
 {
@@ -39,11 +40,13 @@ namespace utinni
 {
 PersistentCrcString* PersistentCrcString::ctor(const char* str)
 {
+    allocationTracker::Tag tag("PersistentCrcString::ctor");
     return swg::crcString::persistentCrcString_ctor(allocate(sizeof(PersistentCrcString)), str, true);
 }
 
 ConstCharCrcString* ConstCharCrcString::ctor(const char* str)
 {
+    allocationTracker::Tag tag("ConstCharCrcString::ctor");
     return swg::crcString::constCharCrcString_ctor(allocate(sizeof(ConstCharCrcString)), str);
 }
 
@@ -0,0 +1,412 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "frame_telemetry.h"
+#include "swg/scene/ground_scene.h"
+#include "swg/scene/terrain.h"
+#include "swg/scene/world_snapshot.h"
+#include "utility/string_utility.h"
+#include "imgui/imgui.h"
+#include <intrin.h>
+#include <cstdio>
+#include <ctime>
+#include <map>
+
+namespace
+{
+using utinni::frameTelemetry::FrameTimeHistogram;
+
+constexpr const char* noTerrainKey = "(no terrain)";
+constexpr const char* terrainSnapshotKey = "(terrain default)";
+
+struct Histograms
+{
+    FrameTimeHistogram session;
+    std::map<std::string, FrameTimeHistogram, std::less<>> scenes;
+    std::map<std::string, FrameTimeHistogram, std::less<>> snapshots;
+};
+
+bool enabled = true;
+Histograms* histograms = nullptr; // Heap allocated, the scene maps hold a few KB per key
+LARGE_INTEGER frequency{};
+LARGE_INTEGER previousFrame{};
+
+std::string currentSceneKey;
+std::string currentSnapshotKey;
+FrameTimeHistogram* currentScene = nullptr;
+FrameTimeHistogram* currentSnapshot = nullptr;
+
+time_t sessionStart = 0;
+
+Histograms& getHistograms()
+{
+    if (histograms == nullptr)
+    {
+        histograms = new Histograms();
+    }
+    return *histograms;
+}
+
+FrameTimeHistogram* findOrAdd(std::map<std::string, FrameTimeHistogram, std::less<>>& map, const char* key)
+{
+    auto it = map.find(key);
+    if (it == map.end())
+    {
+        it = map.emplace(key, FrameTimeHistogram()).first;
+    }
+    return &it->second;
+}
+
+// Cheap per frame check, only does the map lookup when the terrain or snapshot changed
+void updateCurrentKeys()
+{
+    utinni::Terrain* terrain = utinni::Terrain::get();
+    const char* sceneKey = terrain != nullptr ? terrain->getFilename() : noTerrainKey;
+    if (sceneKey == nullptr)
+    {
+        sceneKey = noTerrainKey;
+    }
+
+    const std::string& loadedSnapshot = utinni::WorldSnapshot::getLoadedName();
+    const char* snapshotKey = loadedSnapshot.empty() ? terrainSnapshotKey : loadedSnapshot.c_str();
+
+    if (currentScene == nullptr || currentSceneKey != sceneKey)
+    {
+        currentSceneKey = sceneKey;
+        currentScene = findOrAdd(getHistograms().scenes, sceneKey);
+    }
+
+    if (currentSnapshot == nullptr || currentSnapshotKey != snapshotKey)
+    {
+        currentSnapshotKey = snapshotKey;
+        currentSnapshot = findOrAdd(getHistograms().snapshots, snapshotKey);
+    }
+}
+
+double toMs(uint32_t us)
+{
+    return (double)us / 1000.0;
+}
+
+void writeCsvRow(FILE* file, const char* keyType, const std::string& key, const FrameTimeHistogram& histogram)
+{
+    fprintf(file, "%s,\"%s\",%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", keyType, stringUtility::toCsvEscaped(key.c_str()).c_str(), histogram.getCount(), histogram.getMeanUs() / 1000.0,
+            toMs(histogram.getMinUs()), toMs(histogram.getPercentileUs(50)), toMs(histogram.getPercentileUs(95)), toMs(histogram.getPercentileUs(99)),
+            toMs(histogram.getMaxUs()));
+}
+
+void writeJsonHistogram(FILE* file, const std::string& key, const FrameTimeHistogram& histogram, bool last)
+{
+    fprintf(file, "    { \"key\": \"%s\", \"frames\": %llu, \"meanMs\": %.3f, \"minMs\": %.3f, \"p50Ms\": %.3f, \"p95Ms\": %.3f, \"p99Ms\": %.3f, \"maxMs\": %.3f, \"buckets\": [",
+            stringUtility::toJsonEscaped(key.c_str()).c_str(), histogram.getCount(), histogram.getMeanUs() / 1000.0, toMs(histogram.getMinUs()), toMs(histogram.getPercentileUs(50)),
+            toMs(histogram.getPercentileUs(95)), toMs(histogram.getPercentileUs(99)), toMs(histogram.getMaxUs()));
+
+    // Only the non empty buckets, as [lowest us, highest us, count]
+    bool first = true;
+    for (uint32_t i = 0; i < FrameTimeHistogram::bucketCount; ++i)
+    {
+        if (histogram.getBucketValue(i) > 0)
+        {
+            fprintf(file, "%s[%u,%u,%u]", first ? "" : ",", FrameTimeHistogram::getBucketLowestUs(i), FrameTimeHistogram::getBucketHighestUs(i), histogram.getBucketValue(i));
+            first = false;
+        }
+    }
+    fprintf(file, "] }%s\n", last ? "" : ",");
+}
+
+void writeJsonMap(FILE* file, const char* name, const std::map<std::string, FrameTimeHistogram, std::less<>>& map, bool last)
+{
+    fprintf(file, "  \"%s\": [\n", name);
+    size_t i = 0;
+    for (const auto& [key, histogram] : map)
+    {
+        writeJsonHistogram(file, key, histogram, ++i == map.size());
+    }
+    fprintf(file, "  ]%s\n", last ? "" : ",");
+}
+
+void drawTableRow(const char* keyType, const std::string& key, const FrameTimeHistogram& histogram, bool isCurrent)
+{
+    if (histogram.getCount() == 0)
+    {
+        return;
+    }
+
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::Text("%s", keyType);
+    ImGui::TableNextColumn();
+    if (isCurrent)
+    {
+        ImGui::TextColored(ImVec4(0.4f, 0.8f, 1.0f, 1.0f), "%s", key.c_str());
+    }
+    else
+    {
+        ImGui::Text("%s", key.c_str());
+    }
+    ImGui::TableNextColumn();
+    ImGui::Text("%llu", histogram.getCount());
+    ImGui::TableNextColumn();
+    ImGui::Text("%.2f", histogram.getMeanUs() / 1000.0);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.2f", toMs(histogram.getPercentileUs(50)));
+    ImGui::TableNextColumn();
+    ImGui::Text("%.2f", toMs(histogram.getPercentileUs(95)));
+    ImGui::TableNextColumn();
+    ImGui::Text("%.2f", toMs(histogram.getPercentileUs(99)));
+    ImGui::TableNextColumn();
+    ImGui::Text("%.2f", toMs(histogram.getMaxUs()));
+}
+}
+
+namespace utinni::frameTelemetry
+{
+uint32_t FrameTimeHistogram::getBucketIndex(uint32_t valueUs)
+{
+    if (valueUs > maxValueUs)
+    {
+        valueUs = maxValueUs;
+    }
+
+    if (valueUs < 2 * subBucketHalfCount)
+    {
+        return valueUs;
+    }
+
+    unsigned long magnitude;
+    _BitScanReverse(&magnitude, valueUs);
+    const uint32_t shift = magnitude - subBucketBits;
+    return shift * subBucketHalfCount + (valueUs >> shift);
+}
+
+uint32_t FrameTimeHistogram::getBucketLowestUs(uint32_t index)
+{
+    if (index < 2 * subBucketHalfCount)
+    {
+        return index;
+    }
+
+    const uint32_t shift = index / subBucketHalfCount - 1;
+    return (index - shift * subBucketHalfCount) << shift;
+}
+
+uint32_t FrameTimeHistogram::getBucketHighestUs(uint32_t index)
+{
+    if (index < 2 * subBucketHalfCount)
+    {
+        return index;
+    }
+
+    const uint32_t shift = index / subBucketHalfCount - 1;
+    return ((index - shift * subBucketHalfCount + 1) << shift) - 1;
+}
+
+void FrameTimeHistogram::record(uint32_t valueUs)
+{
+    buckets[getBucketIndex(valueUs)]++;
+    count++;
+    sumUs += valueUs;
+    minUs = valueUs < minUs ? valueUs : minUs;
+    maxUs = valueUs > maxUs ? valueUs : maxUs;
+}
+
+void FrameTimeHistogram::reset()
+{
+    *this = FrameTimeHistogram();
+}
+
+uint32_t FrameTimeHistogram::getPercentileUs(double percentile) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)count + 0.5);
+    target = target < 1 ? 1 : (target > count ? count : target);
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < bucketCount; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= target)
+        {
+            const uint32_t middle = (getBucketLowestUs(i) + getBucketHighestUs(i)) / 2;
+            return middle > maxUs ? maxUs : middle;
+        }
+    }
+    return maxUs;
+}
+
+void enable(bool enable)
+{
+    enabled = enable;
+    previousFrame.QuadPart = 0;
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+void onMainLoop()
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+        sessionStart = time(nullptr);
+    }
+
+    const LARGE_INTEGER previous = previousFrame;
+    previousFrame = now;
+
+    const GroundScene* scene = GroundScene::get();
+    if (previous.QuadPart == 0 || scene == nullptr || scene->isLoading)
+    {
+        return;
+    }
+
+    const uint32_t frameUs = (uint32_t)((now.QuadPart - previous.QuadPart) * 1000000 / frequency.QuadPart);
+
+    updateCurrentKeys();
+    getHistograms().session.record(frameUs);
+    currentScene->record(frameUs);
+    currentSnapshot->record(frameUs);
+}
+
+void reset()
+{
+    delete histograms;
+    histograms = nullptr;
+    currentScene = nullptr;
+    currentSnapshot = nullptr;
+    sessionStart = time(nullptr);
+}
+
+void drawUi()
+{
+    ImGui::Begin("Frame Telemetry", nullptr, ImGuiWindowFlags_NoCollapse);
+    {
+        bool telemetryEnabled = enabled;
+        if (ImGui::Checkbox("Enabled", &telemetryEnabled))
+        {
+            enable(telemetryEnabled);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset"))
+        {
+            reset();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Write report"))
+        {
+            writeReport();
+        }
+
+        const Histograms& all = getHistograms();
+        if (ImGui::BeginTable("FrameTimes", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+        {
+            ImGui::TableSetupColumn("");
+            ImGui::TableSetupColumn("Key");
+            ImGui::TableSetupColumn("Frames");
+            ImGui::TableSetupColumn("Mean ms");
+            ImGui::TableSetupColumn("p50 ms");
+            ImGui::TableSetupColumn("p95 ms");
+            ImGui::TableSetupColumn("p99 ms");
+            ImGui::TableSetupColumn("Max ms");
+            ImGui::TableHeadersRow();
+
+            drawTableRow("session", "all frames", all.session, false);
+            for (const auto& [key, histogram] : all.scenes)
+            {
+                drawTableRow("terrain", key, histogram, &histogram == currentScene);
+            }
+            for (const auto& [key, histogram] : all.snapshots)
+            {
+                drawTableRow("snapshot", key, histogram, &histogram == currentSnapshot);
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+bool writeReport()
+{
+    const Histograms& all = getHistograms();
+    if (all.session.getCount() == 0)
+    {
+        return false;
+    }
+
+    const std::string directory = getPath() + "telemetry\\";
+    CreateDirectoryA(directory.c_str(), nullptr);
+
+    tm localStart{};
+    localtime_s(&localStart, &sessionStart);
+    char name[64];
+    strftime(name, sizeof(name), "frame_times_%Y%m%d_%H%M%S", &localStart);
+    const std::string basename = directory + name;
+
+    FILE* csv = nullptr;
+    if (fopen_s(&csv, (basename + ".csv").c_str(), "w") != 0 || csv == nullptr)
+    {
+        return false;
+    }
+    fprintf(csv, "type,key,frames,mean_ms,min_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+    writeCsvRow(csv, "session", "all frames", all.session);
+    for (const auto& [key, histogram] : all.scenes)
+    {
+        writeCsvRow(csv, "terrain", key, histogram);
+    }
+    for (const auto& [key, histogram] : all.snapshots)
+    {
+        writeCsvRow(csv, "snapshot", key, histogram);
+    }
+    fclose(csv);
+
+    FILE* json = nullptr;
+    if (fopen_s(&json, (basename + ".json").c_str(), "w") != 0 || json == nullptr)
+    {
+        return false;
+    }
+    fprintf(json, "{\n  \"build\": \"%s %s %s\",\n  \"sessionStart\": %lld,\n  \"sessionEnd\": %lld,\n", CONFIG_NAME, __DATE__, __TIME__,
+            (long long)sessionStart, (long long)time(nullptr));
+    fprintf(json, "  \"session\": [\n");
+    writeJsonHistogram(json, "all frames", all.session, true);
+    fprintf(json, "  ],\n");
+    writeJsonMap(json, "terrains", all.scenes, false);
+    writeJsonMap(json, "snapshots", all.snapshots, true);
+    fprintf(json, "}\n");
+    fclose(json);
+    return true;
+}
+}
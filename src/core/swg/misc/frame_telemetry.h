@@ -0,0 +1,77 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+// Frame time telemetry. Every main loop the wall time since the previous one is recorded into log-linear histograms
+// (HdrHistogram style, ~1.6% precision from 1 us to 60 s) for the whole session, the current terrain and the current
+// world snapshot. Loading frames are skipped. Reports are written as CSV and JSON so builds can be compared.
+namespace utinni::frameTelemetry
+{
+class UTINNI_API FrameTimeHistogram
+{
+public:
+    static constexpr uint32_t subBucketBits = 6;
+    static constexpr uint32_t subBucketHalfCount = 1 << subBucketBits;
+    static constexpr uint32_t maxValueUs = 60 * 1000 * 1000;
+    static constexpr uint32_t bucketCount = (25 - subBucketBits) * subBucketHalfCount + 2 * subBucketHalfCount; // maxValueUs is below 2^26
+
+    void record(uint32_t valueUs);
+    void reset();
+
+    uint64_t getCount() const { return count; }
+    uint32_t getMinUs() const { return count > 0 ? minUs : 0; }
+    uint32_t getMaxUs() const { return maxUs; }
+    double getMeanUs() const { return count > 0 ? (double)sumUs / (double)count : 0; }
+
+    // Value at the percentile, 0-100, as the middle of its bucket
+    uint32_t getPercentileUs(double percentile) const;
+
+    uint32_t getBucketValue(uint32_t index) const { return buckets[index]; }
+    static uint32_t getBucketIndex(uint32_t valueUs);
+    static uint32_t getBucketLowestUs(uint32_t index);
+    static uint32_t getBucketHighestUs(uint32_t index);
+
+private:
+    uint32_t buckets[bucketCount] = {};
+    uint64_t count = 0;
+    uint64_t sumUs = 0;
+    uint32_t minUs = UINT32_MAX;
+    uint32_t maxUs = 0;
+};
+
+UTINNI_API extern void enable(bool enable);
+UTINNI_API extern bool isEnabled();
+
+// Called at the start of every Game::mainLoop
+void onMainLoop();
+
+UTINNI_API extern void reset();
+UTINNI_API extern void drawUi();
+
+// Writes frame_times_<date>_<time>.csv and .json to the telemetry folder next to the dll, returns false if either failed
+UTINNI_API extern bool writeReport();
+}
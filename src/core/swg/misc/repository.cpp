@@ -31,7 +31,7 @@
 namespace utinni
 {
 static std::vector<std::string> filenames;
-static std::map<std::string, Repository::DirectoryInfo> directories;
+static std::map<std::string, Repository::DirectoryInfo, std::less<>> directories; // Transparent compare, lookups by const char* don't allocate
 
 Repository::Repository()
 {
@@ -77,11 +77,16 @@ std::string Repository::getFilenameAt(int index)
 std::vector<std::string> Repository::getDirectoryFilenames(const char* directoryName)
 {
     const auto dirInfo = directories.find(directoryName);
+    if (dirInfo == directories.end())
+    {
+        return std::vector<std::string>();
+    }
     return std::vector<std::string>(&filenames[dirInfo->second.startIndex], &filenames[dirInfo->second.startIndex + dirInfo->second.size]);
 }
 
 Repository::DirectoryInfo* Repository::getDirectoryInfo(const char* directoryName)
 {
-    return &directories.find(directoryName)->second;
+    const auto dirInfo = directories.find(directoryName);
+    return dirInfo != directories.end() ? &dirInfo->second : nullptr;
 }
 }
@@ -23,15 +23,18 @@
 **/
 
 #include "swg_math.h"
+#include <cmath>
 
 static constexpr float pi = 3.14159265358979323846f;
 
 namespace swg::math
 {
 
+#ifndef UTINNI_STATIC
 using pVectorNormalize = bool(__thiscall*)(Vector* pThis);
 
 pVectorNormalize vectorNormalize = (pVectorNormalize)0x00AB5C40;
+#endif
 
 Vector2d::Vector2d()
     : X(0)
@@ -118,7 +121,21 @@ bool Vector::operator!=(const Vector& vector) const
 
 bool Vector::normalize()
 {
+#ifdef UTINNI_STATIC
+    // Outside of the client, same result as the client's Vector::normalize
+    const float length = sqrtf(X * X + Y * Y + Z * Z);
+    if (length < 1.0e-5f)
+    {
+        return false;
+    }
+
+    X /= length;
+    Y /= length;
+    Z /= length;
+    return true;
+#else
     return vectorNormalize(this);
+#endif
 }
 
 Transform::Transform()
@@ -641,8 +658,8 @@ UiPoint::UiPoint()
 }
 
 UiPoint::UiPoint(int x, int y)
-    : X(0)
-    , Y(0)
+    : X(x)
+    , Y(y)
 {
 }
 
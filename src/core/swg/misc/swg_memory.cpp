@@ -23,6 +23,7 @@
 **/
 
 #include "swg_memory.h"
+#include "allocation_tracker.h"
 
 namespace swg::memory
 {
@@ -43,21 +44,39 @@ namespace utinni
 {
 void* allocate(size_t size)
 {
-    return swg::memory::allocate(size);
+    void* result = swg::memory::allocate(size);
+    if (allocationTracker::isEnabled())
+    {
+        allocationTracker::onAllocate(result, size);
+    }
+    return result;
 }
 
 void* allocateString(size_t size)
 {
-    return swg::memory::allocateString(size);
+    void* result = swg::memory::allocateString(size);
+    if (allocationTracker::isEnabled())
+    {
+        allocationTracker::onAllocate(result, size);
+    }
+    return result;
 }
 
 void deallocate(void* address, size_t size)
 {
+    if (allocationTracker::isEnabled())
+    {
+        allocationTracker::onDeallocate(address, size);
+    }
     swg::memory::deallocate(address, size);
 }
 
 void deallocateString(void* address, size_t size)
 {
+    if (allocationTracker::isEnabled())
+    {
+        allocationTracker::onDeallocate(address, size);
+    }
     swg::memory::deallocateString(address, size);
 }
 }
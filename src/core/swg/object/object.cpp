@@ -28,6 +28,7 @@
 #include "swg/misc/swg_math.h"
 #include "swg/misc/network.h"
 #include "swg/misc/swg_memory.h"
+#include "swg/misc/allocation_tracker.h"
 #include "swg/misc/swg_utility.h"
 
 namespace swg::objectTemplateList
@@ -189,16 +190,19 @@ SharedObjectTemplate* ObjectTemplateList::getObjectTemplateByIff(swgptr iff)
 
 ConstCharCrcString getCrcStringByCrc(unsigned int crc)
 {
+    allocationTracker::Tag tag("ObjectTemplateList::getCrcString");
     return *(ConstCharCrcString*)swg::objectTemplateList::getCrcStringByCrc(allocate(sizeof(ConstCharCrcString)), crc);
 }
 
 ConstCharCrcString ObjectTemplateList::getCrcStringByName(const char* name)
 {
+    allocationTracker::Tag tag("ObjectTemplateList::getCrcString");
     return *(ConstCharCrcString*)swg::objectTemplateList::getCrcStringByCrc(allocate(sizeof(ConstCharCrcString)), calculateCrc(name));
 }
 
 swgptr ObjectTemplateList::getCrcStringByNameAsPtr(const char* name)
 {
+    allocationTracker::Tag tag("ObjectTemplateList::getCrcString");
     return swg::objectTemplateList::getCrcStringByCrc(allocate(sizeof(ConstCharCrcString)), calculateCrc(name));
 }
 
@@ -239,6 +243,7 @@ const char* SharedBuildingObjectTemplate::getInteriorLayoutFilename()
 
 Object* Object::ctor()
 {
+    allocationTracker::Tag tag("Object::ctor");
     return swg::object::ctor((Object*)allocate(160));
 }
 
@@ -27,6 +27,7 @@
 #include "world_snapshot.h"
 #include "render_world.h"
 #include "swg/misc/swg_memory.h"
+#include "swg/misc/allocation_tracker.h"
 #include "swg/game/game.h"
 #include "swg/object/client_object.h"
 #include "utility/string_utility.h"
@@ -71,6 +72,7 @@ GroundScene* GroundScene::get() // Static GroundScene Pointer
 
 GroundScene* GroundScene::ctor(const char* terrainFilename, const char* avatarObjectFilename)
 {
+    allocationTracker::Tag tag("GroundScene::ctor");
     return swg::groundScene::ctor(utinni::allocate(0xF4), terrainFilename, avatarObjectFilename, 0);
 }
 
@@ -96,33 +98,24 @@ std::string GroundScene::getName()
 
 namespace GroundSceneNamespace
 {
-std::vector<std::function<void(utinni::GroundScene* pThis)>> preDrawLoopCallbacks;
-std::vector<std::function<void(utinni::GroundScene* pThis)>> postDrawLoopCallbacks;
-std::vector<std::function<void(utinni::GroundScene* pThis, float time)>> updateLoopCallbacks;
-std::vector<std::function<void()>> cameraChangeCallbacks;
+CallbackList<void(utinni::GroundScene* pThis)> preDrawLoopCallbacks("GroundScene::preDrawLoopCallbacks");
+CallbackList<void(utinni::GroundScene* pThis)> postDrawLoopCallbacks("GroundScene::postDrawLoopCallbacks");
+CallbackList<void(utinni::GroundScene* pThis, float time)> updateLoopCallbacks("GroundScene::updateLoopCallbacks");
+CallbackList<void()> cameraChangeCallbacks("GroundScene::cameraChangeCallbacks");
 }
 
 void __fastcall hkDrawLoop(GroundScene* pThis, DWORD EDX)
 {
-    for (const auto& func : GroundSceneNamespace::preDrawLoopCallbacks)
-    {
-        func(pThis);
-    }
+    GroundSceneNamespace::preDrawLoopCallbacks.invoke(pThis);
 
     swg::groundScene::draw(pThis);
 
-    for (const auto& func : GroundSceneNamespace::postDrawLoopCallbacks)
-    {
-        func(pThis);
-    }
+    GroundSceneNamespace::postDrawLoopCallbacks.invoke(pThis);
 }
 
 void __fastcall hkUpdateLoop(GroundScene* pThis, DWORD EDX, float time)
 {
-    for (const auto& func : GroundSceneNamespace::updateLoopCallbacks)
-    {
-        func(pThis, time);
-    }
+    GroundSceneNamespace::updateLoopCallbacks.invoke(pThis, time);
     swg::groundScene::update(pThis, time);
 }
 
@@ -166,10 +159,7 @@ void GroundScene::toggleFreeCamera()
         swg::groundScene::changeCamera(this, Camera::Modes::cm_Free, 0);
     }
 
-    for (const auto& func : GroundSceneNamespace::cameraChangeCallbacks)
-    {
-        func();
-    }
+    GroundSceneNamespace::cameraChangeCallbacks.invoke();
 }
 
 void GroundScene::changeCameraMode(int cameraMode)
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "utinni.h"
+#include "utility/callback_list.h"
 #include "scene.h"
 #include "swg/camera/camera.h"
 #include <functional>
@@ -37,10 +38,10 @@ class GroundScene;
 
 namespace GroundSceneNamespace
 {
-extern UTINNI_API std::vector<std::function<void(utinni::GroundScene* pThis)>> preDrawLoopCallbacks;
-extern UTINNI_API std::vector<std::function<void(utinni::GroundScene* pThis)>> postDrawLoopCallbacks;
-extern UTINNI_API std::vector<std::function<void(utinni::GroundScene* pThis, float time)>> updateLoopCallbacks;
-extern UTINNI_API std::vector<std::function<void()>> cameraChangeCallbacks;
+extern UTINNI_API CallbackList<void(utinni::GroundScene* pThis)> preDrawLoopCallbacks;
+extern UTINNI_API CallbackList<void(utinni::GroundScene* pThis)> postDrawLoopCallbacks;
+extern UTINNI_API CallbackList<void(utinni::GroundScene* pThis, float time)> updateLoopCallbacks;
+extern UTINNI_API CallbackList<void()> cameraChangeCallbacks;
 }
 
 class UTINNI_API GroundScene : public NetworkScene
@@ -90,27 +91,27 @@ public:
     std::string getName();
 
     template<typename T>
-    void addPreDrawLoopCallback(T func)
+    CallbackHandle addPreDrawLoopCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        GroundSceneNamespace::preDrawLoopCallbacks.emplace_back(func);
+        return GroundSceneNamespace::preDrawLoopCallbacks.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addPostDrawLoopCallback(T func)
+    CallbackHandle addPostDrawLoopCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        GroundSceneNamespace::postDrawLoopCallbacks.emplace_back(func);
+        return GroundSceneNamespace::postDrawLoopCallbacks.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addUpdateLoopCallback(T func)
+    CallbackHandle addUpdateLoopCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        GroundSceneNamespace::updateLoopCallbacks.emplace_back(func);
+        return GroundSceneNamespace::updateLoopCallbacks.add(func, owner, name, priority);
     }
 
     template<typename T>
-    void addCameraChangeCallback(T func)
+    CallbackHandle addCameraChangeCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
     {
-        GroundSceneNamespace::cameraChangeCallbacks.emplace_back(func);
+        return GroundSceneNamespace::cameraChangeCallbacks.add(func, owner, name, priority);
     }
 
     static void detour();
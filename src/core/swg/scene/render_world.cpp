@@ -24,6 +24,7 @@
 
 #include "render_world.h"
 #include "swg/graphics/directx9.h"
+#include "utility/profiler.h"
 
 namespace swg::renderWorld
 {
@@ -45,6 +46,7 @@ void addObjectNotifications(Object* obj)
 
 void __cdecl hkRender(swgptr pCamera)
 {
+    UTINNI_PROFILE_ZONE("RenderWorld::render");
     swg::renderWorld::render(pCamera);
 
     //auto depthTexture = directX::getTextureResolver();
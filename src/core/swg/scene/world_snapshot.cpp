@@ -402,6 +402,8 @@ WorldSnapshotReaderWriter::Node* WorldSnapshotReaderWriter::Node::getLastChild()
     return children->back();
 }
 
+static std::string loadedName;
+
 void WorldSnapshot::load(const std::string& name)
 {
     if (name.empty())
@@ -412,6 +414,7 @@ void WorldSnapshot::load(const std::string& name)
     memory::nopAddress(0x0059C3F3, 6); // Removes the grabbing of current .trn name to allow the loading of any .ws
 
     swg::worldsnapshot::load(name.c_str());
+    loadedName = name;
 }
 
 void WorldSnapshot::unload() 
@@ -428,6 +431,12 @@ void WorldSnapshot::unload()
     }
 
     swg::worldsnapshot::unload();
+    loadedName.clear();
+}
+
+const std::string& WorldSnapshot::getLoadedName()
+{
+    return loadedName;
 }
 
 void WorldSnapshot::reload()
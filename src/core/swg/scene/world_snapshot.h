@@ -105,6 +105,9 @@ public:
     static void unload();
     static void reload();
 
+    // Name of the snapshot loaded through load, empty when the game's own snapshot for the terrain is in use
+    static const std::string& getLoadedName();
+
     static bool getPreloadSnapshot();
     static void setPreloadSnapshot(bool preloadSnapshot);
 
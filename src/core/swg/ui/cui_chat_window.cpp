@@ -26,6 +26,8 @@
 #include "command_parser.h"
 #include "utinni_command_parser.h"
 #include "swg/misc/swg_memory.h"
+#include "utility/patch_transaction.h"
+#include "utility/log.h"
 
 namespace swg::cuiChatWindow
 {
@@ -95,25 +97,24 @@ void CuiChatWindow::sendMessage(const char* msg, bool addToChatHistory)
     // which we don't need for the purpose of this function anyway,
     // we need to patch out calls utilizing that parameter inside the SWG function,
     // else we crash due to access violations
-    const auto origBytes1 = memory::nopAddress(0x00914245, 5);
-    const auto origBytes2 = memory::nopAddress(0x00914250, 5);
-    const auto origBytes3 = memory::nopAddress(0x0091425D, 5);
-    const auto origBytes4 = memory::nopAddress(0x0091427D, 5);
-    const auto origBytes5 = memory::nopAddress(0x009142E4, 5);
-
-    memory::set(0x0091428C, 0x75, 1);
+    memory::PatchTransaction patches;
+    patches.nop(0x00914245, 5)
+           .nop(0x00914250, 5)
+           .nop(0x0091425D, 5)
+           .nop(0x0091427D, 5)
+           .nop(0x009142E4, 5)
+           .set(0x0091428C, 0x75, 1); // jz -> jnz
+    if (!patches.commit())
+    {
+        utinni::log::error("CuiChatWindow::sendMessage couldn't patch sendInput, the message wasn't sent");
+        return;
+    }
 
     swg::cuiConsoleHelper::sendInput(pCuiConsoleHelper, swg::WString(msg), 0, addToChatHistory);
 
     // Once the call has been made, the function needs to be restored
     // for potential swg calls that might utilize the parameter
-    memory::restoreBytes(origBytes1);
-    memory::restoreBytes(origBytes2);
-    memory::restoreBytes(origBytes3);
-    memory::restoreBytes(origBytes4);
-    memory::restoreBytes(origBytes5);
-
-    memory::set(0x0091428C, 0x74, 1);
+    patches.rollback();
 }
 
 void __fastcall hkEnableTextInput(swgptr pThis, swgptr EDX, bool value, bool setKeyboardInput, bool unfocus)
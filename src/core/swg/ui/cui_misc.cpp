@@ -25,6 +25,7 @@
 #include "cui_misc.h"
 #include "controls/ui_textbox.h"
 #include "ini.h"
+#include "utility/patch_transaction.h"
 #include <fstream>
 
 namespace swg::cuiMisc
@@ -55,25 +56,25 @@ void reloadUi()
     swg::cuiMisc::swgCuiHudFactoryReloadUi();
 }
 
-void patch()
+void patch(memory::PatchTransaction& patches)
 {
     if (getConfig().getBool("UtinniCore", "enableOfflineScenes"))
     {
         // Enable the Load Scene button inside the login screen
-        memory::nopAddress(0x00C8D250, 15);
+        patches.nop(0x00C8D250, 15);
 
         // Enable the Location button inside the ESC menu inside a scene
         static constexpr byte locationBtnPatchBuffer[] = { 0x6A, 0x01, // push 1
                                           0x51, // push ecx
                                           0x8B, 0xCE, // mov ecx, esi
                                           0xE8, 0x17, 0x43, 0xD4, 0xFF }; // call client.9C18A0
-        memory::copy(0x00C7D57F, locationBtnPatchBuffer);
+        patches.copy(0x00C7D57F, locationBtnPatchBuffer);
 
 
         // Disable the CUI resize based on RESO chunk in settings
-        memory::nopAddress(0x009CC385, 6); // Removes RESO.Y changing CUI.X
-        memory::nopAddress(0x009CC39C, 5); // Removes RESO.Y changing CUI.Y
-        memory::nopAddress(0x009CC3BD, 3); // Removes isOk bool being set to false
+        patches.nop(0x009CC385, 6); // Removes RESO.Y changing CUI.X
+        patches.nop(0x009CC39C, 5); // Removes RESO.Y changing CUI.Y
+        patches.nop(0x009CC3BD, 3); // Removes isOk bool being set to false
     }
 }
 }
@@ -25,11 +25,16 @@
 #pragma once
 #include "utinni.h"
 
+namespace memory
+{
+class PatchTransaction;
+}
+
 namespace utinni::cuiMisc
 {
 UTINNI_API void reloadUi();
 
-extern void patch();
+extern void patch(memory::PatchTransaction& patches);
 }
 
 namespace utinni::cuiLoginScreen
@@ -38,6 +38,7 @@
 #include "swg/game/game.h"
 #include "swg/scene/render_world.h"
 #include "utility/log.h"
+#include "utility/profiler.h"
 #include <vector>
 #include <functional>
 
@@ -47,7 +48,7 @@ using namespace swg::math;
 namespace imgui_impl
 {
 
-std::vector<std::function<void()>> renderCallbacks;
+CallbackList<void()> renderCallbacks("ImGui::renderCallbacks");
 
 bool rendering;
 bool enableUi;
@@ -169,6 +170,7 @@ bool isSetup = false;
  {
 	 if (isSetup)
      {
+         UTINNI_PROFILE_ZONE("ImGui::draw");
          ImGui_ImplDX9_NewFrame();
          ImGui_ImplWin32_NewFrame();
          ImGui::NewFrame();
@@ -195,10 +197,7 @@ bool isSetup = false;
          }
          if (enableUi)
          {
-             for (const auto& func : renderCallbacks) // ToDo add an additional callback to host controls in the future main ImGui window
-             {
-                 func();
-             }
+             renderCallbacks.invoke(); // ToDo add an additional callback to host controls in the future main ImGui window
          }
          imgui_gizmo::draw();
 
@@ -213,6 +212,7 @@ bool isSetup = false;
  {
 	  if (isSetup)
 	  {
+			UTINNI_PROFILE_ZONE("ImGui::render");
 			rendering = true;
 			ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
 			rendering = false;
@@ -228,10 +228,10 @@ bool isRendering()
 
 namespace imgui_gizmo
 {
-std::vector<std::function<void()>> onGizmoEnabledCallbacks;
-std::vector<std::function<void()>> onGizmoDisabledCallbacks;
-std::vector<std::function<void()>> onGizmoPositionChangedCallbacks;
-std::vector<std::function<void()>> onGizmoRotationChangedCallbacks;
+CallbackList<void()> onGizmoEnabledCallbacks("ImGuiGizmo::onGizmoEnabledCallbacks");
+CallbackList<void()> onGizmoDisabledCallbacks("ImGuiGizmo::onGizmoDisabledCallbacks");
+CallbackList<void()> onGizmoPositionChangedCallbacks("ImGuiGizmo::onGizmoPositionChangedCallbacks");
+CallbackList<void()> onGizmoRotationChangedCallbacks("ImGuiGizmo::onGizmoRotationChangedCallbacks");
 
 bool enabled = false;
 bool gizmoHasMouseHover = false;
@@ -251,10 +251,7 @@ void enable(Object* obj)
 	 object = obj;
 	 enabled = true;
 
-	 for (const auto& func : onGizmoEnabledCallbacks)
-	 {
-		  func();
-	 }
+	 onGizmoEnabledCallbacks.invoke();
 }
 
 void disable()
@@ -262,10 +259,7 @@ void disable()
 	 enabled = false;
 	 object = nullptr;
 
-	 for (const auto& func : onGizmoDisabledCallbacks)
-	 {
-		  func();
-	 }
+	 onGizmoDisabledCallbacks.invoke();
 
 	 // Ensure it's set to false in case the gizmo is disabled with mouse hovered
 	 gizmoHasMouseHover = false;
@@ -445,18 +439,12 @@ void draw()
 		  {
 				if (originalTransform.getPosition() != object->getTransform_o2w()->getPosition())
 				{
-					 for (const auto& func : onGizmoPositionChangedCallbacks)
-					 {
-						  func();
-					 }
+					 onGizmoPositionChangedCallbacks.invoke();
 				}
 
 				if (!object->getTransform_o2w()->isRotationEqual(originalTransform))
 				{
-					 for (const auto& func : onGizmoRotationChangedCallbacks)
-					 {
-						  func();
-					 }
+					 onGizmoRotationChangedCallbacks.invoke();
 				}
 		  }
 		  wasUsed = false;
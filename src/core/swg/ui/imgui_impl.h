@@ -26,6 +26,7 @@
 
 #include <d3d9.h>
 #include "utinni.h"
+#include "utility/callback_list.h"
 #include <functional>
 
 namespace utinni
@@ -41,12 +42,12 @@ extern void draw();
 extern void render();
 extern bool isRendering();
 
-extern UTINNI_API std::vector<std::function<void()>> renderCallbacks;
+extern UTINNI_API CallbackList<void()> renderCallbacks;
 
 template<typename T>
-void addRenderCallback(T func)
+CallbackHandle addRenderCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
 {
-    renderCallbacks.emplace_back(func);
+    return renderCallbacks.add(func, owner, name, priority);
 }
 
 UTINNI_API extern bool isInternalUiHovered();
@@ -60,30 +61,30 @@ UTINNI_API extern void disable();
 UTINNI_API extern bool isEnabled();
 UTINNI_API extern bool hasMouseHover();
 
-extern UTINNI_API std::vector<std::function<void()>> onGizmoEnabledCallbacks;
-extern UTINNI_API std::vector<std::function<void()>> onGizmoRotationChangedCallbacks;
-extern UTINNI_API std::vector<std::function<void()>> onGizmoDisabledCallbacks;
-extern UTINNI_API std::vector<std::function<void()>> onGizmoPositionChangedCallbacks;
+extern UTINNI_API CallbackList<void()> onGizmoEnabledCallbacks;
+extern UTINNI_API CallbackList<void()> onGizmoRotationChangedCallbacks;
+extern UTINNI_API CallbackList<void()> onGizmoDisabledCallbacks;
+extern UTINNI_API CallbackList<void()> onGizmoPositionChangedCallbacks;
 
 template<typename T>
-void addOnEnabledCallback(T func)
+CallbackHandle addOnEnabledCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
 {
-    onGizmoEnabledCallbacks.emplace_back(func);
+    return onGizmoEnabledCallbacks.add(func, owner, name, priority);
 }
 template<typename T>
-void addOnDisabledCallback(T func)
+CallbackHandle addOnDisabledCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
 {
-    onGizmoDisabledCallbacks.emplace_back(func);
+    return onGizmoDisabledCallbacks.add(func, owner, name, priority);
 }
 template<typename T>
-void addOnPositionChangedCallback(T func)
+CallbackHandle addOnPositionChangedCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
 {
-    onGizmoPositionChangedCallbacks.emplace_back(func);
+    return onGizmoPositionChangedCallbacks.add(func, owner, name, priority);
 }
 template<typename T>
-void addOnRotationChangedCallback(T func)
+CallbackHandle addOnRotationChangedCallback(T func, const char* owner = "unknown", const char* name = "unnamed", int priority = 0)
 {
-    onGizmoRotationChangedCallbacks.emplace_back(func);
+    return onGizmoRotationChangedCallbacks.add(func, owner, name, priority);
 }
 
 UTINNI_API extern void toggleGizmoMode();
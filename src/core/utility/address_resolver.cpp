@@ -0,0 +1,347 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "address_resolver.h"
+#include "pattern_scanner.h"
+#include "utility/log.h"
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace
+{
+using namespace memory;
+
+struct CachedAddress
+{
+    uint32_t signatureHash;
+    swgptr rva;
+};
+
+struct CachedModule
+{
+    uint32_t key = 0;
+    std::unordered_map<std::string, CachedAddress> addresses;
+};
+
+const char* cacheFilename = "address_cache.txt";
+
+std::mutex resolveMutex;
+bool isCacheLoaded = false;
+std::unordered_map<std::string, CachedModule> cache;
+
+std::vector<ResolvedAddress*>& getRegistry()
+{
+    static std::vector<ResolvedAddress*> registry;
+    return registry;
+}
+
+std::string getModuleKeyName(const char* moduleName)
+{
+    return moduleName != nullptr ? moduleName : "client";
+}
+
+bool isSameModule(const char* a, const char* b)
+{
+    if (a == nullptr || b == nullptr)
+    {
+        return a == b;
+    }
+    return _stricmp(a, b) == 0;
+}
+
+uint32_t fnv1a(const void* data, size_t length, uint32_t hash = 0x811C9DC5)
+{
+    const byte* bytes = (const byte*)data;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+// Identifies a build of a module by its PE header, which is far cheaper than hashing the whole file on every launch
+uint32_t getModuleKey(swgptr baseAddress)
+{
+    const auto dosHeader = (const IMAGE_DOS_HEADER*)baseAddress;
+    const auto ntHeaders = (const IMAGE_NT_HEADERS*)(baseAddress + dosHeader->e_lfanew);
+
+    uint32_t hash = fnv1a(&ntHeaders->FileHeader, sizeof(IMAGE_FILE_HEADER));
+    hash = fnv1a(&ntHeaders->OptionalHeader.CheckSum, sizeof(DWORD), hash);
+    hash = fnv1a(&ntHeaders->OptionalHeader.SizeOfImage, sizeof(DWORD), hash);
+    hash = fnv1a(&ntHeaders->OptionalHeader.AddressOfEntryPoint, sizeof(DWORD), hash);
+    return hash;
+}
+
+void loadCache()
+{
+    isCacheLoaded = true;
+
+    std::ifstream file(utinni::getPath() + cacheFilename);
+    std::string line;
+    CachedModule* currentModule = nullptr;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string type;
+        std::string name;
+        stream >> type >> name;
+
+        if (type == "module")
+        {
+            currentModule = &cache[name];
+            stream >> std::hex >> currentModule->key;
+        }
+        else if (type == "address" && currentModule != nullptr)
+        {
+            CachedAddress cached{};
+            stream >> std::hex >> cached.signatureHash >> cached.rva;
+            if (!stream.fail())
+            {
+                currentModule->addresses[name] = cached;
+            }
+        }
+    }
+}
+
+void saveCache()
+{
+    std::ofstream file(utinni::getPath() + cacheFilename, std::ios::trunc);
+    file << std::hex;
+    for (const auto& module : cache)
+    {
+        file << "module " << module.first << " " << module.second.key << "\n";
+        for (const auto& address : module.second.addresses)
+        {
+            file << "address " << address.first << " " << address.second.signatureHash << " " << address.second.rva << "\n";
+        }
+    }
+}
+
+const char* getSourceName(ResolvedAddress::Source source)
+{
+    switch (source)
+    {
+    case ResolvedAddress::rs_cache:
+        return "cache";
+    case ResolvedAddress::rs_verified:
+        return "verified";
+    case ResolvedAddress::rs_scan:
+        return "scan";
+    case ResolvedAddress::rs_fallback:
+        return "fallback";
+    case ResolvedAddress::rs_failed:
+        return "failed";
+    default:
+        return "unresolved";
+    }
+}
+
+double getElapsedMs(const std::chrono::high_resolution_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool matchesAt(const Pattern& pattern, swgptr matchAddress, swgptr baseAddress, size_t length)
+{
+    return pattern.isValid() && matchAddress >= baseAddress && matchAddress + pattern.size() <= baseAddress + length && pattern.matches((const byte*)matchAddress);
+}
+}
+
+namespace memory
+{
+
+ResolvedAddress::ResolvedAddress(const char* name, const char* signature, int offset, swgptr fallback, const char* moduleName)
+    : name(name)
+    , signature(signature)
+    , moduleName(moduleName)
+    , offset(offset)
+    , fallback(fallback)
+{
+    getRegistry().emplace_back(this);
+}
+
+void ResolvedAddress::useFallback(double timeMs)
+{
+    address = fallback;
+    source = fallback != 0 ? rs_fallback : rs_failed;
+    resolveTimeMs = timeMs;
+    if (source == rs_failed)
+    {
+        utinni::log::error(("Required address " + std::string(name) + " could not be resolved, its hook is skipped").c_str());
+    }
+}
+
+swgptr ResolvedAddress::get()
+{
+    if (source == rs_unresolved)
+    {
+        resolveAll(moduleName);
+    }
+    return address;
+}
+
+void ResolvedAddress::resolveAll(const char* moduleName)
+{
+    std::lock_guard<std::mutex> lock(resolveMutex);
+
+    std::vector<ResolvedAddress*> pending;
+    for (ResolvedAddress* entry : getRegistry())
+    {
+        if (!entry->isResolved() && isSameModule(entry->moduleName, moduleName))
+        {
+            pending.emplace_back(entry);
+        }
+    }
+
+    if (pending.empty())
+    {
+        return;
+    }
+
+    const auto totalStart = std::chrono::high_resolution_clock::now();
+    const std::string moduleKeyName = getModuleKeyName(moduleName);
+
+    swgptr baseAddress;
+    size_t length;
+    if (!getModuleRange(moduleName, baseAddress, length))
+    {
+        utinni::log::error(("Address resolver failed to find module " + moduleKeyName + ", using fallback addresses").c_str());
+        for (ResolvedAddress* entry : pending)
+        {
+            entry->useFallback(0);
+        }
+        return;
+    }
+
+    if (!isCacheLoaded)
+    {
+        loadCache();
+    }
+
+    CachedModule& cachedModule = cache[moduleKeyName];
+    const uint32_t moduleKey = getModuleKey(baseAddress);
+    if (cachedModule.key != moduleKey)
+    {
+        cachedModule.key = moduleKey;
+        cachedModule.addresses.clear();
+    }
+
+    // Warm start, only verify the cached addresses still match their signature
+    bool isCacheDirty = false;
+    PatternScanner scanner;
+    std::vector<ResolvedAddress*> toScan;
+    for (ResolvedAddress* entry : pending)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        const Pattern pattern(entry->signature);
+        const uint32_t signatureHash = fnv1a(entry->signature, strlen(entry->signature));
+
+        const auto cached = cachedModule.addresses.find(entry->name);
+        if (cached != cachedModule.addresses.end() && cached->second.signatureHash == signatureHash &&
+            matchesAt(pattern, baseAddress + cached->second.rva - entry->offset, baseAddress, length))
+        {
+            entry->address = baseAddress + cached->second.rva;
+            entry->source = rs_cache;
+            entry->resolveTimeMs = getElapsedMs(start);
+            continue;
+        }
+
+        // On the build the hooks were written against the known address already matches, no need to scan for it
+        if (entry->fallback != 0 && matchesAt(pattern, entry->fallback - entry->offset, baseAddress, length))
+        {
+            entry->address = entry->fallback;
+            entry->source = rs_verified;
+            entry->resolveTimeMs = getElapsedMs(start);
+            cachedModule.addresses[entry->name] = { signatureHash, entry->address - baseAddress };
+            isCacheDirty = true;
+            continue;
+        }
+
+        scanner.add(pattern);
+        toScan.emplace_back(entry);
+    }
+
+    // Cold start or stale cache, scan for all the remaining signatures in one pass
+    if (!toScan.empty())
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        const auto matches = scanner.scan(baseAddress, length);
+        const double scanTimeMs = getElapsedMs(start);
+
+        std::vector<uint32_t> matchCounts(toScan.size(), 0);
+        for (const auto& match : matches)
+        {
+            ResolvedAddress* entry = toScan[match.patternIndex];
+            if (matchCounts[match.patternIndex]++ == 0)
+            {
+                entry->address = match.address + entry->offset;
+            }
+        }
+
+        for (size_t i = 0; i < toScan.size(); ++i)
+        {
+            ResolvedAddress* entry = toScan[i];
+            entry->resolveTimeMs = scanTimeMs;
+            // Of several matches the known address is the safer bet, without one the first match is all there is
+            if (matchCounts[i] > 1)
+            {
+                utinni::log::warning(("Signature " + std::string(entry->name) + " is not unique").c_str());
+            }
+            if (matchCounts[i] == 1 || (matchCounts[i] > 1 && entry->fallback == 0))
+            {
+                entry->source = rs_scan;
+                cachedModule.addresses[entry->name] = { fnv1a(entry->signature, strlen(entry->signature)), entry->address - baseAddress };
+                continue;
+            }
+
+            if (matchCounts[i] == 0)
+            {
+                utinni::log::warning(("Signature " + std::string(entry->name) + " was not found").c_str());
+            }
+            entry->useFallback(scanTimeMs);
+            cachedModule.addresses.erase(entry->name);
+        }
+
+        isCacheDirty = true;
+    }
+
+    if (isCacheDirty)
+    {
+        saveCache();
+    }
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "Resolved %u addresses in %s in %.3f ms (%u scanned)", (uint32_t)pending.size(), moduleKeyName.c_str(), getElapsedMs(totalStart), (uint32_t)toScan.size());
+    utinni::log::info(buffer);
+    for (const ResolvedAddress* entry : pending)
+    {
+        snprintf(buffer, sizeof(buffer), "  %-48s 0x%08X %-8s %.3f ms", entry->name, entry->address, getSourceName(entry->source), entry->resolveTimeMs);
+        utinni::log::info(buffer);
+    }
+}
+
+}
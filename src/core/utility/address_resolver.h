@@ -0,0 +1,107 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+namespace memory
+{
+// An address that is located by signature instead of being hardcoded. Declare it at namespace scope next to the
+// hook that uses it, all pending addresses of a module are then resolved together in a single scan on the first get().
+// Results are cached to disk keyed by the module's PE header, a warm start only verifies the cached bytes. The fallback
+// is the address in the client build the hooks were written against, it is checked against the signature before
+// scanning and used as is when the scan comes up empty. Without a fallback the address is required, a miss is logged
+// as an error and get() returns 0, so the hook has to be skipped.
+class UTINNI_API ResolvedAddress
+{
+public:
+    enum Source
+    {
+        rs_unresolved,
+        rs_cache,
+        rs_verified, // The fallback matched the signature
+        rs_scan,
+        rs_fallback,
+        rs_failed
+    };
+
+    // offset is added to the start of the match, moduleName nullptr is the client executable
+    ResolvedAddress(const char* name, const char* signature, int offset = 0, swgptr fallback = 0, const char* moduleName = nullptr);
+    ResolvedAddress(const ResolvedAddress&) = delete;
+    ResolvedAddress& operator=(const ResolvedAddress&) = delete;
+
+    swgptr get();
+
+    // Resolves every pending address of the module (nullptr for the client executable) and logs a report
+    static void resolveAll(const char* moduleName = nullptr);
+
+    const char* getName() const { return name; }
+    const char* getSignature() const { return signature; }
+    const char* getModuleName() const { return moduleName; }
+    int getOffset() const { return offset; }
+    swgptr getFallback() const { return fallback; }
+
+    bool isResolved() const { return source != rs_unresolved; }
+    bool isFound() const { return address != 0; }
+    Source getSource() const { return source; }
+    double getResolveTimeMs() const { return resolveTimeMs; }
+
+private:
+    void useFallback(double timeMs);
+
+    const char* name;
+    const char* signature;
+    const char* moduleName;
+    int offset;
+    swgptr fallback;
+
+    swgptr address = 0;
+    Source source = rs_unresolved;
+    double resolveTimeMs = 0;
+};
+
+// Points function at the resolved address, false when a required address wasn't found (the resolver logs it)
+template <typename T>
+bool resolve(ResolvedAddress& address, T& function)
+{
+    function = (T)address.get();
+    return function != nullptr;
+}
+
+// Detours the function at the resolved address and points original at the trampoline, a required address that wasn't
+// found leaves original nullptr and the function unhooked
+template <typename T>
+bool detour(ResolvedAddress& address, T& original, T hook, DETOUR_TYPE type, int length = DETOUR_LEN_AUTO)
+{
+    if (!resolve(address, original))
+    {
+        return false;
+    }
+
+    original = (T)Detour::Create((LPVOID)original, (LPVOID)hook, type, length);
+    return true;
+}
+
+}
@@ -0,0 +1,212 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "callback_list.h"
+#include "utility/event_log.h"
+#include "utility/log.h"
+#include <algorithm>
+#include <cstdio>
+#include <unordered_set>
+
+namespace
+{
+constexpr uint64_t warningIntervalFrames = 300; // Per callback, so a slow callback doesn't flood the log
+constexpr uint64_t sampleIntervalFrames = 16; // Accounting interval while neither the budget nor the profiler needs every frame
+
+double budgetMs = 0;
+uint64_t budgetTicks = 0;
+uint64_t frameCount = 0;
+uint64_t accountedFrames = 0;
+std::atomic<bool> accountingFrame{ true }; // Read by invoke on any thread, only changed at the frame end
+
+// The profiler rings keep zone names for thousands of frames, past the release of the stats, so the names are never freed
+const char* internName(const std::string& name)
+{
+    static std::mutex namesMutex;
+    static auto names = new std::unordered_set<std::string>();
+
+    std::lock_guard<std::mutex> lock(namesMutex);
+    return names->emplace(name).first->c_str();
+}
+
+std::vector<utinni::CallbackListBase*>& getLists()
+{
+    static std::vector<utinni::CallbackListBase*> lists; // The lists are globals spread over several translation units
+    return lists;
+}
+
+double getAverageMs(const utinni::CallbackStats& stats)
+{
+    return accountedFrames > 0 ? utinni::profiler::ticksToMs(stats.totalTicks) / (double)accountedFrames : 0;
+}
+}
+
+namespace utinni
+{
+CallbackListBase::CallbackListBase(const char* name) : name(name)
+{
+    getLists().emplace_back(this);
+}
+
+CallbackListBase::~CallbackListBase()
+{
+    auto& lists = getLists();
+    lists.erase(std::remove(lists.begin(), lists.end(), this), lists.end());
+}
+
+bool CallbackListBase::isAccountingFrame()
+{
+    return accountingFrame.load(std::memory_order_relaxed);
+}
+
+CallbackStats* CallbackListBase::createStats(const char* owner, const char* callbackName, int priority)
+{
+    auto callbackStats = std::make_unique<CallbackStats>();
+    callbackStats->listName = name;
+    callbackStats->owner = owner != nullptr ? owner : "unknown";
+    callbackStats->name = callbackName != nullptr ? callbackName : "unnamed";
+    callbackStats->zoneName = internName(callbackStats->name);
+    callbackStats->priority = priority;
+
+    stats.emplace_back(std::move(callbackStats));
+    return stats.back().get();
+}
+
+void CallbackListBase::releaseStats(CallbackStats* callbackStats)
+{
+    // Order doesn't matter, the report sorts by cost
+    const auto it = std::find_if(stats.begin(), stats.end(), [callbackStats](const std::unique_ptr<CallbackStats>& entry) { return entry.get() == callbackStats; });
+    if (it != stats.end())
+    {
+        std::swap(*it, stats.back());
+        stats.pop_back();
+    }
+}
+}
+
+namespace utinni::callbackBudget
+{
+void setBudgetMs(double ms)
+{
+    budgetMs = ms;
+    budgetTicks = ms > 0 ? profiler::msToTicks(ms) : 0;
+}
+
+double getBudgetMs()
+{
+    return budgetMs;
+}
+
+void endFrame()
+{
+    frameCount++;
+    const bool accounted = accountingFrame.load(std::memory_order_relaxed);
+    if (accounted)
+    {
+        accountedFrames++;
+    }
+
+    for (CallbackListBase* list : getLists())
+    {
+        list->collect();
+        if (!accounted)
+        {
+            continue;
+        }
+
+        for (const auto& callbackStats : list->getStats())
+        {
+            CallbackStats& stats = *callbackStats;
+
+            if (budgetTicks > 0 && stats.frameTicks > budgetTicks)
+            {
+                stats.overBudgetFrames++;
+                if (stats.lastWarningFrame == 0 || frameCount - stats.lastWarningFrame >= warningIntervalFrames)
+                {
+                    stats.lastWarningFrame = frameCount;
+
+                    char buffer[256];
+                    snprintf(buffer, sizeof(buffer), "Callback %s/%s in %s took %.2f ms over %u calls, budget is %.2f ms",
+                             stats.owner.c_str(), stats.name.c_str(), stats.listName, profiler::ticksToMs(stats.frameTicks), stats.frameCalls, budgetMs);
+                    log::warning(buffer);
+                }
+                UTINNI_EVENT("Callback %s over budget, %.3f ms", stats.name.c_str(), profiler::ticksToMs(stats.frameTicks));
+            }
+
+            stats.lastFrameTicks = stats.frameTicks;
+            stats.lastFrameCalls = stats.frameCalls;
+            stats.worstFrameTicks = std::max(stats.worstFrameTicks, stats.frameTicks);
+            stats.totalTicks += stats.frameTicks;
+            stats.totalCalls += stats.frameCalls;
+            stats.frameTicks = 0;
+            stats.frameCalls = 0;
+        }
+    }
+
+    accountingFrame.store(budgetTicks > 0 || profiler::isEnabled() || frameCount % sampleIntervalFrames == 0, std::memory_order_relaxed);
+}
+
+void getStats(std::vector<CallbackStats>& stats)
+{
+    stats.clear();
+    for (const CallbackListBase* list : getLists())
+    {
+        for (const auto& callbackStats : list->getStats())
+        {
+            if (callbackStats->registered)
+            {
+                stats.emplace_back(*callbackStats);
+            }
+        }
+    }
+
+    std::sort(stats.begin(), stats.end(), [](const CallbackStats& a, const CallbackStats& b) { return a.totalTicks > b.totalTicks; });
+}
+
+uint64_t getFrameCount()
+{
+    return frameCount;
+}
+
+void logReport(size_t maxEntries)
+{
+    std::vector<CallbackStats> stats;
+    getStats(stats);
+
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "Callback budget report, %u callbacks over %llu frames (%llu accounted), budget %.2f ms", (uint32_t)stats.size(), frameCount,
+             accountedFrames, budgetMs);
+    log::info(buffer);
+
+    const size_t count = std::min(maxEntries, stats.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        const CallbackStats& entry = stats[i];
+        snprintf(buffer, sizeof(buffer), "  %-40s %s/%s: avg %.3f ms, last %.3f ms, worst %.3f ms, %.1f calls/frame, %u frames over budget",
+                 entry.listName, entry.owner.c_str(), entry.name.c_str(), getAverageMs(entry), profiler::ticksToMs(entry.lastFrameTicks),
+                 profiler::ticksToMs(entry.worstFrameTicks), accountedFrames > 0 ? (double)entry.totalCalls / (double)accountedFrames : 0.0, entry.overBudgetFrames);
+        log::info(buffer);
+    }
+}
+}
@@ -0,0 +1,328 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "utility/inline_delegate.h"
+#include "utility/profiler.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace utinni
+{
+class CallbackListBase;
+
+// Cost of a single registered callback, in TSC ticks
+struct CallbackStats
+{
+    const char* listName = nullptr;
+    std::string owner;
+    std::string name;
+    const char* zoneName = nullptr; // Interned copy of name, the profiler rings keep it after the stats are released
+    int priority = 0;
+    bool registered = true;
+
+    uint64_t frameTicks = 0;
+    uint32_t frameCalls = 0;
+
+    uint64_t lastFrameTicks = 0;
+    uint32_t lastFrameCalls = 0;
+    uint64_t worstFrameTicks = 0;
+    uint64_t totalTicks = 0;
+    uint64_t totalCalls = 0;
+    uint32_t overBudgetFrames = 0;
+    uint64_t lastWarningFrame = 0;
+};
+
+// Returned on registration, removing through a stale handle (already removed, or the slot was reused) does nothing
+struct CallbackHandle
+{
+    CallbackListBase* list = nullptr;
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+
+    bool isValid() const { return list != nullptr; }
+    inline void remove();
+};
+
+// Non template part of CallbackList, keeps every list in a registry so the budget report and the frame end collection can walk all callbacks
+class UTINNI_API CallbackListBase
+{
+public:
+    explicit CallbackListBase(const char* name);
+    virtual ~CallbackListBase();
+
+    CallbackListBase(const CallbackListBase&) = delete;
+    CallbackListBase& operator=(const CallbackListBase&) = delete;
+
+    const char* getName() const { return name; }
+    const std::vector<std::unique_ptr<CallbackStats>>& getStats() const { return stats; }
+
+    virtual bool remove(uint32_t slot, uint32_t generation) = 0;
+
+    // Frees removed callbacks and retired snapshots, called from callbackBudget::endFrame when no list is being invoked
+    virtual void collect() = 0;
+
+protected:
+    // False on frames without per callback accounting, invoke then skips the timing and the profiler zones
+    static bool isAccountingFrame();
+
+    CallbackStats* createStats(const char* owner, const char* callbackName, int priority);
+    void releaseStats(CallbackStats* callbackStats); // Only from collect, invoke may still read the stats until then
+
+    std::mutex mutex;
+
+private:
+    const char* name;
+    std::vector<std::unique_ptr<CallbackStats>> stats;
+};
+
+void CallbackHandle::remove()
+{
+    if (list != nullptr)
+    {
+        list->remove(slot, generation);
+        list = nullptr;
+    }
+}
+
+// Callback registry for the game hooks. Every callback is registered with an owner, a name and a priority (lower runs first,
+// equal priorities run in registration order). Invocations are timed on accounting frames, see callbackBudget for the report.
+// Registration and removal are locked and publish an immutable snapshot, invoke only loads the current snapshot, so callbacks
+// can be added or removed from inside a callback. Removal only flags the slot, the slot, its stats and the old snapshots are
+// freed at the next frame end.
+template<typename Signature>
+class CallbackList;
+
+template<typename... Args>
+class CallbackList<void(Args...)> : public CallbackListBase
+{
+public:
+    explicit CallbackList(const char* name) : CallbackListBase(name) { }
+
+    ~CallbackList() override
+    {
+        delete snapshot.load();
+        for (const Snapshot* retiredSnapshot : retired)
+        {
+            delete retiredSnapshot;
+        }
+    }
+
+    template<typename T>
+    CallbackHandle add(T&& func, const char* owner, const char* callbackName, int priority = 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        uint32_t index;
+        if (!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            index = (uint32_t)slots.size();
+            slots.emplace_back(std::make_unique<Slot>());
+        }
+
+        Slot& slot = *slots[index];
+        slot.delegate.assign(std::forward<T>(func));
+        slot.stats = createStats(owner, callbackName, priority);
+        slot.priority = priority;
+        slot.order = nextOrder++;
+        slot.alive.store(true, std::memory_order_release);
+
+        publish();
+        return { this, index, slot.generation };
+    }
+
+    bool remove(uint32_t index, uint32_t generation) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (index >= slots.size())
+        {
+            return false;
+        }
+
+        Slot& slot = *slots[index];
+        if (slot.generation != generation || !slot.alive.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+
+        slot.alive.store(false, std::memory_order_release);
+        slot.generation++;
+        slot.stats->registered = false;
+        removedSlots.emplace_back(index);
+        return true;
+    }
+
+    void collect() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!removedSlots.empty())
+        {
+            publish();
+            for (const uint32_t index : removedSlots)
+            {
+                Slot& slot = *slots[index];
+                slot.delegate.reset();
+                releaseStats(slot.stats);
+                slot.stats = nullptr;
+                freeSlots.emplace_back(index);
+            }
+            removedSlots.clear();
+        }
+
+        for (const Snapshot* retiredSnapshot : retired)
+        {
+            delete retiredSnapshot;
+        }
+        retired.clear();
+    }
+
+    void invoke(Args... args)
+    {
+        const Snapshot* current = snapshot.load(std::memory_order_acquire);
+        if (current == nullptr || current->empty())
+        {
+            return;
+        }
+
+        if (!isAccountingFrame())
+        {
+            for (const Slot* slot : *current)
+            {
+                if (slot->alive.load(std::memory_order_acquire))
+                {
+                    slot->delegate(args...);
+                }
+            }
+            return;
+        }
+
+        UTINNI_PROFILE_ZONE(getName());
+
+        for (const Slot* slot : *current)
+        {
+            if (!slot->alive.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+
+            CallbackStats* slotStats = slot->stats;
+            const uint64_t start = __rdtsc();
+            {
+                UTINNI_PROFILE_ZONE(slotStats->zoneName);
+                slot->delegate(args...);
+            }
+            slotStats->frameTicks += __rdtsc() - start;
+            slotStats->frameCalls++;
+        }
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t size() const
+    {
+        const Snapshot* current = snapshot.load(std::memory_order_acquire);
+        return current != nullptr ? current->size() : 0;
+    }
+
+private:
+    struct Slot
+    {
+        InlineDelegate<void(Args...)> delegate;
+        CallbackStats* stats = nullptr;
+        int priority = 0;
+        uint32_t order = 0;
+        uint32_t generation = 0;
+        std::atomic<bool> alive{ false };
+    };
+
+    using Snapshot = std::vector<const Slot*>;
+
+    // Caller holds the mutex
+    void publish()
+    {
+        auto next = new Snapshot();
+        next->reserve(slots.size());
+        for (const auto& slot : slots)
+        {
+            if (slot->alive.load(std::memory_order_relaxed))
+            {
+                next->emplace_back(slot.get());
+            }
+        }
+
+        std::sort(next->begin(), next->end(), [](const Slot* a, const Slot* b)
+        {
+            return a->priority != b->priority ? a->priority < b->priority : a->order < b->order;
+        });
+
+        Snapshot* previous = snapshot.exchange(next, std::memory_order_acq_rel);
+        if (previous != nullptr)
+        {
+            retired.emplace_back(previous);
+        }
+    }
+
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> removedSlots;
+    std::vector<Snapshot*> retired;
+    std::atomic<Snapshot*> snapshot{ nullptr };
+    uint32_t nextOrder = 0;
+};
+
+namespace callbackBudget
+{
+// Per callback, per frame budget. Callbacks over it log a warning, 0 disables the warnings.
+// With a budget set or the profiler enabled every frame is accounted, otherwise only every 16th frame, for the report
+UTINNI_API extern void setBudgetMs(double budgetMs);
+UTINNI_API extern double getBudgetMs();
+
+// Rolls the frame counters over, checks the budget and collects removed callbacks, called at the start of every Game::mainLoop
+UTINNI_API extern void endFrame();
+
+// Copies the stats of every registered callback, sorted by average cost per frame
+UTINNI_API extern void getStats(std::vector<CallbackStats>& stats);
+UTINNI_API extern uint64_t getFrameCount();
+
+UTINNI_API extern void logReport(size_t maxEntries = 15);
+}
+
+}
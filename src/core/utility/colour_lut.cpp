@@ -0,0 +1,392 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "colour_lut.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+using utinni::colourLut::Cube;
+
+float saturate(float value)
+{
+    return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+bool parseFloats(std::istringstream& stream, float* values, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        std::string token;
+        if (!(stream >> token))
+        {
+            return false;
+        }
+
+        char* end;
+        values[i] = strtof(token.c_str(), &end);
+        if (*end != '\0')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+namespace utinni::colourLut
+{
+Cube::Cube(uint32_t size) : size(size), entries((size_t)size * size * size * 3)
+{
+    const float scale = 1.0f / (float)(size - 1);
+    for (uint32_t b = 0; b < size; ++b)
+    {
+        for (uint32_t g = 0; g < size; ++g)
+        {
+            for (uint32_t r = 0; r < size; ++r)
+            {
+                float* entry = getEntry(r, g, b);
+                entry[0] = (float)r * scale;
+                entry[1] = (float)g * scale;
+                entry[2] = (float)b * scale;
+            }
+        }
+    }
+}
+
+void Cube::sample(const float rgb[3], float result[3]) const
+{
+    uint32_t index[3];
+    float fraction[3];
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        const float position = saturate(rgb[channel]) * (float)(size - 1);
+        index[channel] = std::min((uint32_t)position, size - 2);
+        fraction[channel] = position - (float)index[channel];
+    }
+
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        float corners[4];
+        for (uint32_t corner = 0; corner < 4; ++corner)
+        {
+            const uint32_t g = index[1] + (corner & 1);
+            const uint32_t b = index[2] + (corner >> 1);
+            const float low = getEntry(index[0], g, b)[channel];
+            const float high = getEntry(index[0] + 1, g, b)[channel];
+            corners[corner] = low + (high - low) * fraction[0];
+        }
+
+        const float bottom = corners[0] + (corners[1] - corners[0]) * fraction[1];
+        const float top = corners[2] + (corners[3] - corners[2]) * fraction[1];
+        result[channel] = bottom + (top - bottom) * fraction[2];
+    }
+}
+
+bool Cube::loadCube(const std::string& text, std::string& error)
+{
+    uint32_t cubeSize = 0;
+    float domainMin[3] = { 0, 0, 0 };
+    float domainMax[3] = { 1, 1, 1 };
+    std::vector<float> values;
+
+    std::istringstream lines(text);
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        lineNumber++;
+        std::istringstream stream(line);
+        std::string keyword;
+        if (!(stream >> keyword) || keyword[0] == '#' || keyword == "TITLE")
+        {
+            continue;
+        }
+
+        bool valid = true;
+        if (keyword == "LUT_3D_SIZE")
+        {
+            float parsed;
+            valid = parseFloats(stream, &parsed, 1) && parsed >= 2 && parsed <= 256;
+            cubeSize = valid ? (uint32_t)parsed : 0;
+        }
+        else if (keyword == "LUT_1D_SIZE")
+        {
+            error = "1D LUTs aren't supported";
+            return false;
+        }
+        else if (keyword == "DOMAIN_MIN")
+        {
+            valid = parseFloats(stream, domainMin, 3);
+        }
+        else if (keyword == "DOMAIN_MAX")
+        {
+            valid = parseFloats(stream, domainMax, 3);
+        }
+        else if (keyword == "LUT_3D_INPUT_RANGE")
+        {
+            float range[2];
+            valid = parseFloats(stream, range, 2);
+            std::fill(domainMin, domainMin + 3, range[0]);
+            std::fill(domainMax, domainMax + 3, range[1]);
+        }
+        else
+        {
+            // A data line, the keyword is the red value
+            std::istringstream entry(line);
+            float rgb[3];
+            valid = parseFloats(entry, rgb, 3);
+            values.insert(values.end(), rgb, rgb + 3);
+        }
+
+        if (!valid)
+        {
+            error = "Malformed line " + std::to_string(lineNumber);
+            return false;
+        }
+    }
+
+    if (cubeSize == 0)
+    {
+        error = "No LUT_3D_SIZE";
+        return false;
+    }
+
+    if (values.size() != (size_t)cubeSize * cubeSize * cubeSize * 3)
+    {
+        error = "Expected " + std::to_string(cubeSize * cubeSize * cubeSize) + " entries, found " + std::to_string(values.size() / 3);
+        return false;
+    }
+
+    bool defaultDomain = true;
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        if (!(domainMax[channel] > domainMin[channel]))
+        {
+            error = "Empty domain";
+            return false;
+        }
+        defaultDomain &= domainMin[channel] == 0.0f && domainMax[channel] == 1.0f;
+    }
+
+    size = cubeSize;
+    entries = std::move(values);
+
+    if (!defaultDomain)
+    {
+        // Look up where every 0-1 entry falls in the file's domain
+        const Cube source = *this;
+        *this = Cube(size);
+        for (size_t i = 0; i < entries.size(); i += 3)
+        {
+            float rgb[3];
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                rgb[channel] = (entries[i + channel] - domainMin[channel]) / (domainMax[channel] - domainMin[channel]);
+            }
+            source.sample(rgb, &entries[i]);
+        }
+    }
+    return true;
+}
+
+bool Cube::fromStrip(const softwareFx::Image& strip)
+{
+    const uint32_t stripSize = strip.height;
+    if (stripSize < 2 || strip.width != stripSize * stripSize || strip.pixels.size() != (size_t)strip.width * strip.height * 4)
+    {
+        return false;
+    }
+
+    size = stripSize;
+    entries.resize((size_t)size * size * size * 3);
+    for (uint32_t b = 0; b < size; ++b)
+    {
+        for (uint32_t g = 0; g < size; ++g)
+        {
+            const uint8_t* texel = strip.getRow(g) + (size_t)b * size * 4;
+            for (uint32_t r = 0; r < size; ++r, texel += 4)
+            {
+                float* entry = getEntry(r, g, b);
+                entry[0] = (float)texel[0] / 255.0f;
+                entry[1] = (float)texel[1] / 255.0f;
+                entry[2] = (float)texel[2] / 255.0f;
+            }
+        }
+    }
+    return true;
+}
+
+softwareFx::Image Cube::toStrip() const
+{
+    softwareFx::Image strip(size * size, size);
+    for (uint32_t b = 0; b < size; ++b)
+    {
+        for (uint32_t g = 0; g < size; ++g)
+        {
+            uint8_t* texel = strip.getRow(g) + (size_t)b * size * 4;
+            for (uint32_t r = 0; r < size; ++r, texel += 4)
+            {
+                const float* entry = getEntry(r, g, b);
+                texel[0] = (uint8_t)(saturate(entry[0]) * 255.0f + 0.5f);
+                texel[1] = (uint8_t)(saturate(entry[1]) * 255.0f + 0.5f);
+                texel[2] = (uint8_t)(saturate(entry[2]) * 255.0f + 0.5f);
+                texel[3] = 255;
+            }
+        }
+    }
+    return strip;
+}
+
+Cube blend(const Cube& a, const Cube& b, float amount)
+{
+    const uint32_t size = a.getSize();
+    const float scale = 1.0f / (float)(size - 1);
+    Cube result = a;
+    for (uint32_t blue = 0; blue < size; ++blue)
+    {
+        for (uint32_t green = 0; green < size; ++green)
+        {
+            for (uint32_t red = 0; red < size; ++red)
+            {
+                float other[3];
+                if (b.getSize() == size)
+                {
+                    std::copy(b.getEntry(red, green, blue), b.getEntry(red, green, blue) + 3, other);
+                }
+                else
+                {
+                    const float rgb[3] = { (float)red * scale, (float)green * scale, (float)blue * scale };
+                    b.sample(rgb, other);
+                }
+
+                float* entry = result.getEntry(red, green, blue);
+                for (int channel = 0; channel < 3; ++channel)
+                {
+                    entry[channel] += (other[channel] - entry[channel]) * amount;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+Cube bake(const std::vector<Operation>& operations, uint32_t size)
+{
+    Cube result(size);
+    for (uint32_t b = 0; b < size; ++b)
+    {
+        for (uint32_t g = 0; g < size; ++g)
+        {
+            for (uint32_t r = 0; r < size; ++r)
+            {
+                float* rgb = result.getEntry(r, g, b);
+                for (const Operation& operation : operations)
+                {
+                    if (operation.type == Operation::ot_tone)
+                    {
+                        for (int channel = 0; channel < 3; ++channel)
+                        {
+                            rgb[channel] *= operation.value[channel];
+                        }
+                    }
+                    else if (operation.type == Operation::ot_lut && operation.lut != nullptr && operation.lut->isValid())
+                    {
+                        float looked[3];
+                        operation.lut->sample(rgb, looked);
+                        for (int channel = 0; channel < 3; ++channel)
+                        {
+                            rgb[channel] += (looked[channel] - rgb[channel]) * operation.value[0];
+                        }
+                    }
+                    else if (operation.type == Operation::ot_saturation)
+                    {
+                        // Rec. 709 luma, the same weights the ascii pass uses
+                        const float luma = rgb[0] * 0.2126f + rgb[1] * 0.7152f + rgb[2] * 0.0722f;
+                        for (int channel = 0; channel < 3; ++channel)
+                        {
+                            rgb[channel] = luma + (rgb[channel] - luma) * operation.value[0];
+                        }
+                    }
+                    else if (operation.type == Operation::ot_gamma && operation.value[0] > 0)
+                    {
+                        for (int channel = 0; channel < 3; ++channel)
+                        {
+                            rgb[channel] = std::pow(rgb[channel], 1.0f / operation.value[0]);
+                        }
+                    }
+
+                    for (int channel = 0; channel < 3; ++channel)
+                    {
+                        rgb[channel] = saturate(rgb[channel]);
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+void Timeline::setKeys(const std::vector<std::pair<float, const Cube*>>& keys, uint32_t stepCount)
+{
+    steps.clear();
+    if (keys.empty() || stepCount == 0)
+    {
+        return;
+    }
+
+    std::vector<std::pair<float, const Cube*>> sorted = keys;
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<float, const Cube*>& a, const std::pair<float, const Cube*>& b) { return a.first < b.first; });
+
+    steps.reserve(stepCount);
+    for (uint32_t step = 0; step < stepCount; ++step)
+    {
+        const float time = (float)step / (float)stepCount;
+
+        // The keys either side, wrapping around the ends of the cycle
+        size_t next = 0;
+        while (next < sorted.size() && sorted[next].first <= time)
+        {
+            next++;
+        }
+        const size_t previous = next == 0 ? sorted.size() - 1 : next - 1;
+        const float previousTime = next == 0 ? sorted[previous].first - 1.0f : sorted[previous].first;
+        const float nextTime = next == sorted.size() ? sorted[0].first + 1.0f : sorted[next].first;
+        const Cube& nextCube = *sorted[next == sorted.size() ? 0 : next].second;
+
+        const float span = nextTime - previousTime;
+        const float amount = span > 0 ? (time - previousTime) / span : 0.0f;
+        steps.push_back(blend(*sorted[previous].second, nextCube, amount));
+    }
+}
+
+uint32_t Timeline::getStep(float time) const
+{
+    const float wrapped = time - std::floor(time);
+    return (uint32_t)(wrapped * (float)steps.size() + 0.5f) % (uint32_t)steps.size();
+}
+}
@@ -0,0 +1,100 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "software_fx.h"
+#include <string>
+#include <vector>
+
+// 3D colour LUTs for the grading pass. A chain of colour operations baked into one LUT costs the single lookup the grading
+// shader does anyway, whatever is in the chain. LUTs come from the strip textures in shaders/luts (size slices of
+// size x size side by side, red across a slice, green down and blue picking the slice) or from .cube files.
+namespace utinni::colourLut
+{
+class UTINNI_API Cube
+{
+public:
+    Cube() = default;
+    explicit Cube(uint32_t size); // Identity
+
+    uint32_t getSize() const { return size; }
+    bool isValid() const { return size >= 2; }
+
+    float* getEntry(uint32_t r, uint32_t g, uint32_t b) { return entries.data() + (((size_t)b * size + g) * size + r) * 3; }
+    const float* getEntry(uint32_t r, uint32_t g, uint32_t b) const { return entries.data() + (((size_t)b * size + g) * size + r) * 3; }
+
+    // Trilinear, the input is clamped to 0-1
+    void sample(const float rgb[3], float result[3]) const;
+
+    // 3D .cube files, 1D ones aren't supported. A DOMAIN_MIN/DOMAIN_MAX other than 0-1 is resampled to 0-1
+    bool loadCube(const std::string& text, std::string& error);
+
+    bool fromStrip(const softwareFx::Image& strip);
+    softwareFx::Image toStrip() const;
+
+private:
+    uint32_t size = 0;
+    std::vector<float> entries; // RGB, red changing fastest like in .cube files
+};
+
+// b is resampled when it's another size than a
+UTINNI_API Cube blend(const Cube& a, const Cube& b, float amount);
+
+struct Operation
+{
+    enum Type
+    {
+        ot_tone,       // Multiplies by value[0-2], what the hue pass does
+        ot_lut,        // Looks up lut and blends the result in by value[0]
+        ot_saturation, // value[0], 0 is grey and 1 unchanged
+        ot_gamma,      // pow(x, 1 / value[0])
+    };
+
+    Type type;
+    float value[3];
+    const Cube* lut;
+};
+
+// Runs every entry of an identity LUT through the operations in order. Every step is clamped to 0-1 like the separate
+// passes' 8 bit targets did
+UTINNI_API Cube bake(const std::vector<Operation>& operations, uint32_t size);
+
+// LUTs keyed over a 0-1 cycle, such as the time of day, blended at a fixed number of steps up front so following the
+// cycle only ever switches between ready LUTs. The cycle wraps around from the last key to the first
+class UTINNI_API Timeline
+{
+public:
+    void setKeys(const std::vector<std::pair<float, const Cube*>>& keys, uint32_t steps);
+
+    bool isEmpty() const { return steps.empty(); }
+    uint32_t getStepCount() const { return (uint32_t)steps.size(); }
+    uint32_t getStep(float time) const;
+    const Cube& getCube(uint32_t step) const { return steps[step]; }
+
+private:
+    std::vector<Cube> steps;
+};
+}
@@ -0,0 +1,457 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "depth_fx.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+using utinni::depthFx::FloatImage;
+using utinni::depthFx::Projection;
+using utinni::softwareFx::Image;
+
+constexpr float pi = 3.14159265f;
+constexpr float skyDepth = 0.9999f;      // Raw depth at or past this has nothing to occlude
+constexpr float spiralTurns = 7;         // Of the SSAO sample spiral
+constexpr float maxScreenRadius = 0.1f;  // SSAO radius cap in uv, keeps close surfaces from sampling half the screen
+constexpr float depthSharpness = 8;      // A blur tap this fraction of the depth away gets no weight
+constexpr float goldenAngle = 2.39996323f;
+
+struct Vector
+{
+    float x, y, z;
+
+    Vector operator-(const Vector& other) const { return { x - other.x, y - other.y, z - other.z }; }
+    float dot(const Vector& other) const { return x * other.x + y * other.y + z * other.z; }
+    Vector cross(const Vector& other) const { return { y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x }; }
+};
+
+float saturate(float value)
+{
+    return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+uint8_t quantize(float value)
+{
+    return (uint8_t)(saturate(value) * 255.0f + 0.5f);
+}
+
+// Point sampling with a clamped sampler
+float samplePoint(const FloatImage& image, float u, float v)
+{
+    return image.get((int32_t)std::floor(u * (float)image.width), (int32_t)std::floor(v * (float)image.height));
+}
+
+const uint8_t* getPixel(const Image& image, int32_t x, int32_t y)
+{
+    x = std::min(std::max(x, 0), (int32_t)image.width - 1);
+    y = std::min(std::max(y, 0), (int32_t)image.height - 1);
+    return image.getRow((uint32_t)y) + x * 4;
+}
+
+void sampleBilinear(const Image& image, float u, float v, float (&colour)[4])
+{
+    const float x = u * (float)image.width - 0.5f;
+    const float y = v * (float)image.height - 0.5f;
+    const int32_t x0 = (int32_t)std::floor(x);
+    const int32_t y0 = (int32_t)std::floor(y);
+    const float fx = x - (float)x0;
+    const float fy = y - (float)y0;
+
+    const uint8_t* texels[4] = { getPixel(image, x0, y0), getPixel(image, x0 + 1, y0), getPixel(image, x0, y0 + 1), getPixel(image, x0 + 1, y0 + 1) };
+    const float weights[4] = { (1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy };
+    for (int c = 0; c < 4; ++c)
+    {
+        colour[c] = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            colour[c] += (float)texels[i][c] / 255.0f * weights[i];
+        }
+    }
+}
+
+// The depth texel a reduced texel reads sits half a full texel past the reduced texel's centre, so the point sampler
+// never lands on a texel edge
+float sampleDepth(const FloatImage& depth, float u, float v)
+{
+    return samplePoint(depth, u + 0.5f / (float)depth.width, v + 0.5f / (float)depth.height);
+}
+
+// View space position of the depth texel sampleDepth reads, placed at the texel's centre so neighbours on a flat surface
+// stay on it however coarse the depth steps are. Off screen taps land on the edge texel
+Vector getViewPosition(const FloatImage& depth, const Projection& projection, float u, float v)
+{
+    const float texelU = std::min(std::max(std::floor(u * (float)depth.width + 0.5f), 0.0f), (float)depth.width - 1);
+    const float texelV = std::min(std::max(std::floor(v * (float)depth.height + 0.5f), 0.0f), (float)depth.height - 1);
+    const float z = projection.getLinearDepth(depth.get((int32_t)texelU, (int32_t)texelV));
+    const float centreU = (texelU + 0.5f) / (float)depth.width;
+    const float centreV = (texelV + 0.5f) / (float)depth.height;
+    return { (centreU * 2 - 1) * projection.tanHalfFovX * z, (1 - centreV * 2) * projection.tanHalfFovY * z, z };
+}
+
+// The smaller depth step, a step that is empty as the neighbour was clamped to the same texel at the screen edge is skipped
+Vector pickStep(const Vector& forward, const Vector& backward)
+{
+    const bool useForward = forward.dot(forward) > 0 && (std::abs(forward.z) < std::abs(backward.z) || backward.dot(backward) == 0);
+    return useForward ? forward : backward;
+}
+
+// The surface normal from the neighbour on each axis with the smaller depth step, so edges don't bend it
+Vector getNormal(const FloatImage& depth, const Projection& projection, float u, float v, float texelU, float texelV, const Vector& position)
+{
+    const Vector right = getViewPosition(depth, projection, u + texelU, v);
+    const Vector left = getViewPosition(depth, projection, u - texelU, v);
+    const Vector down = getViewPosition(depth, projection, u, v + texelV);
+    const Vector up = getViewPosition(depth, projection, u, v - texelV);
+
+    const Vector dx = pickStep(right - position, position - left);
+    const Vector dy = pickStep(down - position, position - up);
+
+    Vector normal = dx.cross(dy);
+    const float length = std::sqrt(normal.dot(normal));
+    if (length <= 0)
+    {
+        return { 0, 0, -1 };
+    }
+
+    const float scale = normal.z > 0 ? -1.0f / length : 1.0f / length; // Facing the camera
+    return { normal.x * scale, normal.y * scale, normal.z * scale };
+}
+
+float getSignedCoc(uint8_t alpha)
+{
+    return (float)alpha / 255.0f * 2 - 1;
+}
+
+void blurOcclusionPass(FloatImage& occlusion, const FloatImage& occlusionDepth, const utinni::depthFx::SsaoSettings& settings, int32_t stepX, int32_t stepY)
+{
+    const FloatImage source = occlusion;
+    const int32_t radius = (int32_t)settings.blurRadius;
+    for (uint32_t y = 0; y < occlusion.height; ++y)
+    {
+        for (uint32_t x = 0; x < occlusion.width; ++x)
+        {
+            const float z = occlusionDepth.get((int32_t)x, (int32_t)y);
+            float weightSum = (float)(radius + 1);
+            float sum = source.get((int32_t)x, (int32_t)y) * weightSum;
+            for (int32_t offset = -radius; offset <= radius; ++offset)
+            {
+                if (offset == 0)
+                {
+                    continue;
+                }
+
+                const int32_t sx = (int32_t)x + offset * stepX;
+                const int32_t sy = (int32_t)y + offset * stepY;
+                const float weight = (float)(radius + 1 - std::abs(offset)) * saturate(1 - std::abs(occlusionDepth.get(sx, sy) - z) * depthSharpness / z);
+                sum += source.get(sx, sy) * weight;
+                weightSum += weight;
+            }
+            occlusion.getRow(y)[x] = sum / weightSum;
+        }
+    }
+}
+}
+
+namespace utinni::depthFx
+{
+const char* const qualityNames[4] = { "Low", "Medium", "High", "Ultra" };
+
+float FloatImage::get(int32_t x, int32_t y) const
+{
+    x = std::min(std::max(x, 0), (int32_t)width - 1);
+    y = std::min(std::max(y, 0), (int32_t)height - 1);
+    return values[(size_t)y * width + x];
+}
+
+void applyPreset(Quality quality, SsaoSettings& settings)
+{
+    static const uint32_t presets[4][3] = { { 4, 6, 1 }, { 4, 8, 2 }, { 2, 12, 2 }, { 2, 16, 3 } };
+    const uint32_t* preset = presets[(int)quality];
+    settings.divisor = preset[0];
+    settings.sampleCount = preset[1];
+    settings.blurRadius = preset[2];
+}
+
+void applyPreset(Quality quality, DofSettings& settings)
+{
+    static const uint32_t presets[4][2] = { { 4, 8 }, { 4, 12 }, { 2, 16 }, { 2, 24 } };
+    const uint32_t* preset = presets[(int)quality];
+    settings.divisor = preset[0];
+    settings.sampleCount = preset[1];
+}
+
+uint32_t getReducedSize(uint32_t size, uint32_t divisor)
+{
+    return std::max((size + divisor - 1) / divisor, 1u);
+}
+
+float getCircleOfConfusion(float linearDepth, const DofSettings& settings)
+{
+    const float difference = linearDepth - settings.focusDistance;
+    const float coc = saturate((std::abs(difference) - settings.focusRange) / std::max(settings.blurRange, 0.001f));
+    return difference < 0 ? -coc : coc;
+}
+
+void computeOcclusion(const FloatImage& depth, const Projection& projection, const SsaoSettings& settings, FloatImage& occlusion, FloatImage& occlusionDepth)
+{
+    const uint32_t width = getReducedSize(depth.width, settings.divisor);
+    const uint32_t height = getReducedSize(depth.height, settings.divisor);
+    occlusion = FloatImage(width, height, 1);
+    occlusionDepth = FloatImage(width, height);
+
+    const float texelU = 1.0f / (float)width;
+    const float texelV = 1.0f / (float)height;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const float u = ((float)x + 0.5f) * texelU;
+            const float v = ((float)y + 0.5f) * texelV;
+            const float raw = sampleDepth(depth, u, v);
+            const Vector position = getViewPosition(depth, projection, u, v);
+            const float z = position.z;
+            occlusionDepth.getRow(y)[x] = z;
+            if (raw >= skyDepth)
+            {
+                continue;
+            }
+
+            const Vector normal = getNormal(depth, projection, u, v, texelU, texelV, position);
+
+            float radiusV = settings.radius * 0.5f / (z * projection.tanHalfFovY);
+            float radiusU = settings.radius * 0.5f / (z * projection.tanHalfFovX);
+            if (radiusV > maxScreenRadius)
+            {
+                radiusU *= maxScreenRadius / radiusV;
+                radiusV = maxScreenRadius;
+            }
+
+            // Every pixel of a 4x4 block turns the spiral differently, the blur evens the pattern out
+            const float rotation = 2 * pi * (float)((x & 3) * 4 + (y & 3)) / 16.0f;
+            const float radiusSquared = settings.radius * settings.radius;
+
+            float sum = 0;
+            for (uint32_t i = 0; i < settings.sampleCount; ++i)
+            {
+                const float t = ((float)i + 0.5f) / (float)settings.sampleCount;
+                const float angle = t * 2 * pi * spiralTurns + rotation;
+                const float su = u + std::cos(angle) * t * radiusU;
+                const float sv = v + std::sin(angle) * t * radiusV;
+
+                const Vector sample = getViewPosition(depth, projection, su, sv);
+                const Vector offset = sample - position;
+                const float distanceSquared = offset.dot(offset);
+                if (distanceSquared > 0)
+                {
+                    const float cosine = offset.dot(normal) / std::sqrt(distanceSquared);
+                    sum += std::max(cosine - settings.bias, 0.0f) * std::max(1 - distanceSquared / radiusSquared, 0.0f);
+                }
+            }
+            occlusion.getRow(y)[x] = saturate(1 - 2 * settings.intensity * sum / (float)settings.sampleCount);
+        }
+    }
+}
+
+void blurOcclusion(FloatImage& occlusion, const FloatImage& occlusionDepth, const SsaoSettings& settings)
+{
+    if (settings.blurRadius == 0)
+    {
+        return;
+    }
+
+    blurOcclusionPass(occlusion, occlusionDepth, settings, 1, 0);
+    blurOcclusionPass(occlusion, occlusionDepth, settings, 0, 1);
+}
+
+void applyOcclusion(const Image& src, const FloatImage& depth, const Projection& projection, const FloatImage& occlusion, const FloatImage& occlusionDepth,
+                    const SsaoSettings& settings, Image& dst)
+{
+    dst = Image(src.width, src.height);
+    for (uint32_t y = 0; y < src.height; ++y)
+    {
+        const uint8_t* in = src.getRow(y);
+        uint8_t* out = dst.getRow(y);
+        for (uint32_t x = 0; x < src.width; ++x)
+        {
+            const float u = ((float)x + 0.5f) / (float)src.width;
+            const float v = ((float)y + 0.5f) / (float)src.height;
+            const float z = projection.getLinearDepth(samplePoint(depth, u, v));
+
+            // Bilinear weights between the four nearest reduced texels, scaled down by how far their depth is off
+            const float px = u * (float)occlusion.width - 0.5f;
+            const float py = v * (float)occlusion.height - 0.5f;
+            const int32_t x0 = (int32_t)std::floor(px);
+            const int32_t y0 = (int32_t)std::floor(py);
+            const float fx = px - (float)x0;
+            const float fy = py - (float)y0;
+
+            float sum = 0;
+            float weightSum = 0;
+            for (int32_t i = 0; i < 4; ++i)
+            {
+                const int32_t tx = x0 + (i & 1);
+                const int32_t ty = y0 + (i >> 1);
+                const float bilinear = ((i & 1) ? fx : 1 - fx) * ((i >> 1) ? fy : 1 - fy);
+                const float weight = bilinear / (0.01f + std::abs(occlusionDepth.get(tx, ty) - z) / z);
+                sum += occlusion.get(tx, ty) * weight;
+                weightSum += weight;
+            }
+
+            const float ao = weightSum > 0 ? sum / weightSum : 1.0f;
+            const float scale = 1 - settings.strength * (1 - ao);
+            for (int c = 0; c < 3; ++c)
+            {
+                out[x * 4 + c] = quantize((float)in[x * 4 + c] / 255.0f * scale);
+            }
+            out[x * 4 + 3] = in[x * 4 + 3];
+        }
+    }
+}
+
+void ssao(const Image& src, const FloatImage& depth, const Projection& projection, const SsaoSettings& settings, Image& dst)
+{
+    FloatImage occlusion;
+    FloatImage occlusionDepth;
+    computeOcclusion(depth, projection, settings, occlusion, occlusionDepth);
+    blurOcclusion(occlusion, occlusionDepth, settings);
+    applyOcclusion(src, depth, projection, occlusion, occlusionDepth, settings, dst);
+}
+
+void downsampleForDof(const Image& src, const FloatImage& depth, const Projection& projection, const DofSettings& settings, Image& reduced)
+{
+    const uint32_t divisor = settings.divisor;
+    reduced = Image(getReducedSize(src.width, divisor), getReducedSize(src.height, divisor));
+    for (uint32_t y = 0; y < reduced.height; ++y)
+    {
+        uint8_t* out = reduced.getRow(y);
+        for (uint32_t x = 0; x < reduced.width; ++x)
+        {
+            // The block average, the shader gets it from bilinear taps on the corners between texel pairs
+            float colour[3] = {};
+            for (uint32_t by = 0; by < divisor; ++by)
+            {
+                for (uint32_t bx = 0; bx < divisor; ++bx)
+                {
+                    const uint8_t* texel = getPixel(src, (int32_t)(x * divisor + bx), (int32_t)(y * divisor + by));
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        colour[c] += (float)texel[c];
+                    }
+                }
+            }
+
+            const float u = ((float)x + 0.5f) / (float)reduced.width;
+            const float v = ((float)y + 0.5f) / (float)reduced.height;
+            const float coc = getCircleOfConfusion(projection.getLinearDepth(sampleDepth(depth, u, v)), settings);
+            for (int c = 0; c < 3; ++c)
+            {
+                out[x * 4 + c] = quantize(colour[c] / (255.0f * (float)(divisor * divisor)));
+            }
+            out[x * 4 + 3] = quantize(coc * 0.5f + 0.5f);
+        }
+    }
+}
+
+void blurDof(const Image& reduced, const DofSettings& settings, Image& blurred)
+{
+    blurred = Image(reduced.width, reduced.height);
+    const float maxRadius = settings.maxBlur / (float)settings.divisor;
+    for (uint32_t y = 0; y < reduced.height; ++y)
+    {
+        uint8_t* out = blurred.getRow(y);
+        for (uint32_t x = 0; x < reduced.width; ++x)
+        {
+            const uint8_t* centre = reduced.getRow(y) + x * 4;
+            const float centreCoc = getSignedCoc(centre[3]);
+
+            float sum[3] = { (float)centre[0], (float)centre[1], (float)centre[2] };
+            float weightSum = 1;
+            for (uint32_t i = 0; i < settings.sampleCount; ++i)
+            {
+                // Evenly over the disc, a tap counts when its own blur reaches this far. Taps behind are held to the
+                // centre's blur, so a sharp foreground doesn't pick up the blurred background
+                const float radius = std::sqrt(((float)i + 0.5f) / (float)settings.sampleCount) * maxRadius;
+                const float angle = (float)i * goldenAngle;
+                const int32_t tx = (int32_t)std::floor((float)x + 0.5f + std::cos(angle) * radius);
+                const int32_t ty = (int32_t)std::floor((float)y + 0.5f + std::sin(angle) * radius);
+                const uint8_t* tap = getPixel(reduced, tx, ty);
+
+                const float tapCoc = getSignedCoc(tap[3]);
+                const float reach = tapCoc > centreCoc ? std::min(std::abs(tapCoc), std::abs(centreCoc)) : std::abs(tapCoc);
+                const float weight = saturate(reach * maxRadius - radius + 1);
+                for (int c = 0; c < 3; ++c)
+                {
+                    sum[c] += (float)tap[c] * weight;
+                }
+                weightSum += weight;
+            }
+
+            for (int c = 0; c < 3; ++c)
+            {
+                out[x * 4 + c] = quantize(sum[c] / (255.0f * weightSum));
+            }
+            out[x * 4 + 3] = centre[3];
+        }
+    }
+}
+
+void composeDof(const Image& src, const FloatImage& depth, const Projection& projection, const Image& blurred, const DofSettings& settings, Image& dst)
+{
+    dst = Image(src.width, src.height);
+    for (uint32_t y = 0; y < src.height; ++y)
+    {
+        const uint8_t* in = src.getRow(y);
+        uint8_t* out = dst.getRow(y);
+        for (uint32_t x = 0; x < src.width; ++x)
+        {
+            const float u = ((float)x + 0.5f) / (float)src.width;
+            const float v = ((float)y + 0.5f) / (float)src.height;
+
+            // From the full resolution depth, so the edges of what's in focus stay sharp
+            const float coc = std::abs(getCircleOfConfusion(projection.getLinearDepth(samplePoint(depth, u, v)), settings));
+            const float blend = saturate(coc * settings.maxBlur / (float)settings.divisor);
+
+            float colour[4];
+            sampleBilinear(blurred, u, v, colour);
+            for (int c = 0; c < 3; ++c)
+            {
+                const float sharp = (float)in[x * 4 + c] / 255.0f;
+                out[x * 4 + c] = quantize(sharp + (colour[c] - sharp) * blend);
+            }
+            out[x * 4 + 3] = in[x * 4 + 3];
+        }
+    }
+}
+
+void depthOfField(const Image& src, const FloatImage& depth, const Projection& projection, const DofSettings& settings, Image& dst)
+{
+    Image reduced;
+    Image blurred;
+    downsampleForDof(src, depth, projection, settings, reduced);
+    blurDof(reduced, settings, blurred);
+    composeDof(src, depth, projection, blurred, settings, dst);
+}
+}
@@ -0,0 +1,125 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include "software_fx.h"
+#include <vector>
+
+// The depth driven SytnersFX passes, screen space ambient occlusion and depth of field, with their quality presets and
+// CPU references of the kernels in data/shaders/depth_fx.ps. Both effects run at a half or quarter of the resolution
+// and are brought back up against the full resolution depth. The references follow the shaders pass for pass, so they
+// can be checked on dumped depth and colour (see swg/graphics/readback.h) without a GPU, up to the GPU's 16 bit float
+// and 8 bit storage.
+namespace utinni::depthFx
+{
+// Single channel float image, raw depth as the depth buffer stores it, linear depth or occlusion
+struct FloatImage
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> values;
+
+    FloatImage() = default;
+    FloatImage(uint32_t width, uint32_t height, float value = 0) : width(width), height(height), values((size_t)width * height, value) {}
+
+    float get(int32_t x, int32_t y) const; // Clamped to the edges
+    float* getRow(uint32_t y) { return values.data() + (size_t)y * width; }
+    const float* getRow(uint32_t y) const { return values.data() + (size_t)y * width; }
+};
+
+// The camera's perspective projection, what depth_fx.ps gets in c0
+struct Projection
+{
+    float nearPlane = 1;
+    float farPlane = 1000;
+    float tanHalfFovX = 1;
+    float tanHalfFovY = 0.75f;
+
+    float getLinearDepth(float depth) const { return nearPlane * farPlane / (farPlane - depth * (farPlane - nearPlane)); }
+};
+
+enum class Quality
+{
+    low,
+    medium,
+    high,
+    ultra
+};
+
+UTINNI_API extern const char* const qualityNames[4];
+
+struct SsaoSettings
+{
+    // Set by the presets
+    uint32_t divisor = 4;      // 2 or 4
+    uint32_t sampleCount = 8;  // 4 - 16
+    uint32_t blurRadius = 2;   // Texels either side at the reduced resolution, 0 skips the blur
+
+    float radius = 1.5f;       // World units
+    float intensity = 1.0f;
+    float bias = 0.05f;        // Cosine below which neighbours don't occlude, hides self occlusion on flat surfaces
+    float strength = 0.8f;     // How much of the occlusion the colour gets
+};
+
+struct DofSettings
+{
+    // Set by the presets
+    uint32_t divisor = 4;
+    uint32_t sampleCount = 12; // 8 - 24
+
+    float focusDistance = 10;  // World units from the camera
+    float focusRange = 5;      // Sharp this far either side of the focus distance
+    float blurRange = 40;      // Beyond the sharp range the blur grows to its maximum over this distance
+    float maxBlur = 12;        // Radius in full resolution pixels
+};
+
+// Only change the performance fields, the look is left alone
+UTINNI_API void applyPreset(Quality quality, SsaoSettings& settings);
+UTINNI_API void applyPreset(Quality quality, DofSettings& settings);
+
+UTINNI_API uint32_t getReducedSize(uint32_t size, uint32_t divisor);
+
+// Signed circle of confusion, -1 nearest to 1 furthest, 0 in focus
+UTINNI_API float getCircleOfConfusion(float linearDepth, const DofSettings& settings);
+
+// SSAO passes. occlusion and its linear depth are at the reduced size, 1 is unoccluded
+UTINNI_API void computeOcclusion(const FloatImage& depth, const Projection& projection, const SsaoSettings& settings, FloatImage& occlusion, FloatImage& occlusionDepth);
+UTINNI_API void blurOcclusion(FloatImage& occlusion, const FloatImage& occlusionDepth, const SsaoSettings& settings);
+UTINNI_API void applyOcclusion(const softwareFx::Image& src, const FloatImage& depth, const Projection& projection, const FloatImage& occlusion,
+                               const FloatImage& occlusionDepth, const SsaoSettings& settings, softwareFx::Image& dst);
+
+// All of the above
+UTINNI_API void ssao(const softwareFx::Image& src, const FloatImage& depth, const Projection& projection, const SsaoSettings& settings, softwareFx::Image& dst);
+
+// DOF passes. The reduced colour keeps the signed circle of confusion in alpha as 0-255
+UTINNI_API void downsampleForDof(const softwareFx::Image& src, const FloatImage& depth, const Projection& projection, const DofSettings& settings, softwareFx::Image& reduced);
+UTINNI_API void blurDof(const softwareFx::Image& reduced, const DofSettings& settings, softwareFx::Image& blurred);
+UTINNI_API void composeDof(const softwareFx::Image& src, const FloatImage& depth, const Projection& projection, const softwareFx::Image& blurred,
+                           const DofSettings& settings, softwareFx::Image& dst);
+
+// All of the above
+UTINNI_API void depthOfField(const softwareFx::Image& src, const FloatImage& depth, const Projection& projection, const DofSettings& settings, softwareFx::Image& dst);
+}
@@ -0,0 +1,168 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "depth_pyramid.h"
+#include <algorithm>
+
+namespace utinni::gpu
+{
+void DepthPyramid::build(const float* depth, uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0)
+    {
+        clear();
+        return;
+    }
+
+    baseShift = 0;
+    baseWidth = width;
+    baseHeight = height;
+
+    DepthRange* texels = resizeLevels(width, height);
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        texels[i] = { depth[i], depth[i] };
+    }
+    buildLevels();
+}
+
+void DepthPyramid::buildFromRanges(const float* ranges, uint32_t width, uint32_t height, uint32_t newBaseShift, uint32_t newBaseWidth, uint32_t newBaseHeight)
+{
+    if (width == 0 || height == 0)
+    {
+        clear();
+        return;
+    }
+
+    baseShift = newBaseShift;
+    baseWidth = newBaseWidth;
+    baseHeight = newBaseHeight;
+
+    DepthRange* texels = resizeLevels(width, height);
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        texels[i] = { ranges[i * 2], ranges[i * 2 + 1] };
+    }
+    buildLevels();
+}
+
+void DepthPyramid::clear()
+{
+    levels.clear();
+    baseShift = 0;
+    baseWidth = 0;
+    baseHeight = 0;
+}
+
+DepthRange* DepthPyramid::resizeLevels(uint32_t width, uint32_t height)
+{
+    // The level vectors keep their allocations while the size stays the same, a pyramid rebuilt every frame doesn't
+    // allocate
+    uint32_t count = 1;
+    for (uint32_t w = width, h = height; w > 1 || h > 1; w = (w + 1) / 2, h = (h + 1) / 2)
+    {
+        count++;
+    }
+
+    levels.resize(count);
+    for (Level& level : levels)
+    {
+        level.width = width;
+        level.height = height;
+        level.texels.resize((size_t)width * height);
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+    return levels[0].texels.data();
+}
+
+void DepthPyramid::buildLevels()
+{
+    for (size_t i = 1; i < levels.size(); ++i)
+    {
+        const Level& source = levels[i - 1];
+        Level& level = levels[i];
+        for (uint32_t y = 0; y < level.height; ++y)
+        {
+            const DepthRange* row0 = source.texels.data() + (size_t)(y * 2) * source.width;
+            const DepthRange* row1 = source.texels.data() + (size_t)std::min(y * 2 + 1, source.height - 1) * source.width;
+            DepthRange* out = level.texels.data() + (size_t)y * level.width;
+            for (uint32_t x = 0; x < level.width; ++x)
+            {
+                const uint32_t x0 = x * 2;
+                const uint32_t x1 = std::min(x0 + 1, source.width - 1);
+                out[x].min = std::min(std::min(row0[x0].min, row0[x1].min), std::min(row1[x0].min, row1[x1].min));
+                out[x].max = std::max(std::max(row0[x0].max, row0[x1].max), std::max(row1[x0].max, row1[x1].max));
+            }
+        }
+    }
+}
+
+DepthRange DepthPyramid::getRange(int x0, int y0, int x1, int y1) const
+{
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, (int)baseWidth);
+    y1 = std::min(y1, (int)baseHeight);
+    if (levels.empty() || x0 >= x1 || y0 >= y1)
+    {
+        return { 1.0f, 0.0f };
+    }
+
+    // Coarsest detail where the last pixel is at most one texel after the first on both axes
+    uint32_t level = 0;
+    while (level + 1 < levels.size())
+    {
+        const uint32_t shift = baseShift + level;
+        if (((uint32_t)(x1 - 1) >> shift) - ((uint32_t)x0 >> shift) <= 1 && ((uint32_t)(y1 - 1) >> shift) - ((uint32_t)y0 >> shift) <= 1)
+        {
+            break;
+        }
+        level++;
+    }
+
+    const Level& source = levels[level];
+    const uint32_t shift = baseShift + level;
+    const uint32_t tx1 = std::min((uint32_t)(x1 - 1) >> shift, source.width - 1);
+    const uint32_t ty1 = std::min((uint32_t)(y1 - 1) >> shift, source.height - 1);
+
+    DepthRange range = { 1.0f, 0.0f };
+    for (uint32_t ty = std::min((uint32_t)y0 >> shift, ty1); ty <= ty1; ++ty)
+    {
+        for (uint32_t tx = std::min((uint32_t)x0 >> shift, tx1); tx <= tx1; ++tx)
+        {
+            const DepthRange& texel = source.texels[(size_t)ty * source.width + tx];
+            range.min = std::min(range.min, texel.min);
+            range.max = std::max(range.max, texel.max);
+        }
+    }
+    return range;
+}
+
+bool DepthPyramid::isOccluded(int x0, int y0, int x1, int y1, float nearestDepth) const
+{
+    const DepthRange range = getRange(x0, y0, x1, y1);
+    return range.min <= range.max && nearestDepth > range.max;
+}
+}
@@ -0,0 +1,86 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include <vector>
+
+// CPU side of the hierarchical depth (Hi-Z) pyramid, kept free of any graphics API. Every texel holds the min and max
+// depth of the base pixels it covers. A level is half the size of the one below rounded up, so texel x of level n covers
+// base pixels [x << n, (x + 1) << n) exactly and odd sizes need no special footprints. Depth is the raw depth buffer
+// value, larger is further away.
+namespace utinni::gpu
+{
+struct DepthRange
+{
+    float min;
+    float max;
+};
+
+class UTINNI_API DepthPyramid
+{
+public:
+    // From a full resolution depth buffer. Rebuilding at the same size reuses the allocations
+    void build(const float* depth, uint32_t width, uint32_t height);
+
+    // From min/max pairs read back from the GPU pyramid, their level being baseShift halvings below the base resolution
+    void buildFromRanges(const float* ranges, uint32_t width, uint32_t height, uint32_t baseShift, uint32_t baseWidth, uint32_t baseHeight);
+
+    void clear();
+    bool isEmpty() const { return levels.empty(); }
+
+    uint32_t getBaseWidth() const { return baseWidth; }
+    uint32_t getBaseHeight() const { return baseHeight; }
+    uint32_t getLevelCount() const { return (uint32_t)levels.size(); }
+    uint32_t getLevelShift(uint32_t level) const { return baseShift + level; }
+    uint32_t getLevelWidth(uint32_t level) const { return levels[level].width; }
+    uint32_t getLevelHeight(uint32_t level) const { return levels[level].height; }
+    const DepthRange* getLevel(uint32_t level) const { return levels[level].texels.data(); }
+
+    // Depth range over base pixels [x0, x1) x [y0, y1), clamped to the screen. Read from the level where the rectangle
+    // covers at most 2x2 texels, so the range is conservative but may include pixels just outside of it
+    DepthRange getRange(int x0, int y0, int x1, int y1) const;
+
+    // Whether everything in the rectangle is behind the depth buffer, nearestDepth being the closest depth of the tested
+    // bounds. False without a pyramid, as nothing can be culled then
+    bool isOccluded(int x0, int y0, int x1, int y1, float nearestDepth) const;
+
+private:
+    struct Level
+    {
+        uint32_t width;
+        uint32_t height;
+        std::vector<DepthRange> texels;
+    };
+
+    DepthRange* resizeLevels(uint32_t width, uint32_t height);
+    void buildLevels();
+
+    std::vector<Level> levels;
+    uint32_t baseShift = 0;
+    uint32_t baseWidth = 0;
+    uint32_t baseHeight = 0;
+};
+}
@@ -0,0 +1,220 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "event_log.h"
+#include "utility/log.h"
+#include "utility/profiler.h"
+#include <intrin.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+using namespace utinni::eventLog;
+
+constexpr uint32_t fileVersion = 1;
+constexpr uint32_t recordsPerThread = 8192;
+constexpr uint32_t recordMask = recordsPerThread - 1;
+constexpr uint32_t dumpReadMargin = 64; // Oldest records that may be overwritten while another thread dumps
+
+struct Record
+{
+    uint64_t tsc;
+    uint32_t id;
+    uint32_t size;
+    uint8_t payload[payloadCapacity];
+};
+static_assert(sizeof(Record) == 64, "Records are meant to fill a cache line");
+
+struct ThreadBuffer
+{
+    uint32_t threadId = 0;
+    std::atomic<uint32_t> writeIndex{ 0 };
+    Record records[recordsPerThread];
+};
+
+struct Format
+{
+    std::string format;
+    std::string file;
+    uint32_t line;
+    std::vector<uint8_t> argTypes;
+};
+
+bool enabled = false;
+
+// Timed, dump runs from the crash handler where the crashed thread may hold either of them
+constexpr std::chrono::milliseconds dumpLockTimeout(100);
+
+std::timed_mutex formatsMutex;
+std::unordered_map<uint32_t, Format> formats;
+
+std::timed_mutex buffersMutex;
+std::vector<ThreadBuffer*> buffers;
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+ThreadBuffer* getThreadBuffer()
+{
+    if (threadBuffer == nullptr)
+    {
+        threadBuffer = new ThreadBuffer(); // Lives as long as the process so a crash dump can still read it after the thread exits
+        threadBuffer->threadId = GetCurrentThreadId();
+
+        std::lock_guard<std::timed_mutex> lock(buffersMutex);
+        buffers.emplace_back(threadBuffer);
+    }
+    return threadBuffer;
+}
+
+template<typename T>
+void writeValue(FILE* file, const T& value)
+{
+    fwrite(&value, sizeof(T), 1, file);
+}
+
+void writeString(FILE* file, const std::string& text)
+{
+    const uint16_t length = (uint16_t)std::min<size_t>(text.size(), UINT16_MAX);
+    writeValue(file, length);
+    fwrite(text.data(), 1, length, file);
+}
+}
+
+namespace utinni::eventLog
+{
+void enable(bool enable)
+{
+    enabled = enable;
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+bool registerFormat(uint32_t id, const char* format, const char* file, uint32_t line, const uint8_t* argTypes, uint32_t argCount)
+{
+    std::lock_guard<std::timed_mutex> lock(formatsMutex);
+
+    const auto it = formats.find(id);
+    if (it != formats.end())
+    {
+        if (it->second.line != line || it->second.format != format)
+        {
+            char buffer[512];
+            snprintf(buffer, sizeof(buffer), "Event site id collision between %s:%u and %s:%u", it->second.file.c_str(), it->second.line, file, line);
+            log::warning(buffer);
+        }
+        return false;
+    }
+
+    formats.emplace(id, Format{ format, file, line, std::vector<uint8_t>(argTypes, argTypes + argCount) });
+    return true;
+}
+
+void write(uint32_t id, const uint8_t* payload, uint32_t size)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    const uint32_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+
+    Record& record = buffer->records[index & recordMask];
+    record.tsc = __rdtsc();
+    record.id = id;
+    record.size = size;
+    memcpy(record.payload, payload, size);
+
+    buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+bool dump(const std::string& filename, double seconds)
+{
+    FILE* file = nullptr;
+    if (fopen_s(&file, filename.c_str(), "wb") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    const uint64_t dumpTsc = __rdtsc();
+    const uint64_t ticksPerSecond = profiler::msToTicks(1000.0);
+    const uint64_t oldestTsc = dumpTsc - std::min<uint64_t>(dumpTsc, (uint64_t)(seconds * (double)ticksPerSecond));
+
+    FILETIME dumpTime;
+    GetSystemTimeAsFileTime(&dumpTime);
+
+    fwrite("UTEV", 1, 4, file);
+    writeValue(file, fileVersion);
+    writeValue(file, ticksPerSecond);
+    writeValue(file, dumpTsc);
+    writeValue(file, ((uint64_t)dumpTime.dwHighDateTime << 32) | dumpTime.dwLowDateTime);
+
+    // Without the lock after the timeout, a possibly inconsistent dump beats hanging the crash handler
+    {
+        std::unique_lock<std::timed_mutex> lock(formatsMutex, dumpLockTimeout);
+        writeValue(file, (uint32_t)formats.size());
+        for (const auto& [id, format] : formats)
+        {
+            writeValue(file, id);
+            writeValue(file, format.line);
+            writeValue(file, (uint8_t)format.argTypes.size());
+            fwrite(format.argTypes.data(), 1, format.argTypes.size(), file);
+            writeString(file, format.format);
+            writeString(file, format.file);
+        }
+    }
+
+    std::unique_lock<std::timed_mutex> lock(buffersMutex, dumpLockTimeout);
+    writeValue(file, (uint32_t)buffers.size());
+    for (const ThreadBuffer* buffer : buffers)
+    {
+        const uint32_t writeIndex = buffer->writeIndex.load(std::memory_order_acquire);
+        uint32_t readIndex = writeIndex > recordsPerThread - dumpReadMargin ? writeIndex - (recordsPerThread - dumpReadMargin) : 0;
+
+        // Records are in TSC order per thread, skip the ones older than the requested window
+        while (readIndex != writeIndex && buffer->records[readIndex & recordMask].tsc < oldestTsc)
+        {
+            ++readIndex;
+        }
+
+        writeValue(file, buffer->threadId);
+        writeValue(file, writeIndex - readIndex);
+        for (uint32_t i = readIndex; i != writeIndex; ++i)
+        {
+            const Record& record = buffer->records[i & recordMask];
+            const uint8_t size = (uint8_t)std::min(record.size, payloadCapacity);
+            writeValue(file, record.tsc);
+            writeValue(file, record.id);
+            writeValue(file, size);
+            fwrite(record.payload, 1, size, file);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+}
@@ -0,0 +1,210 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include <cstring>
+#include <type_traits>
+
+// Binary event log, cheap enough to leave on every frame. An event is a call site id, computed at compile time from the file and
+// line, the TSC and the raw arguments, written to a fixed size record in a ring per thread. The format string and argument types
+// are registered once per call site. dump() writes the last seconds of every thread in a compact binary format, which
+// src/tools/event_log_decoder turns back into text or CSV.
+//
+//     UTINNI_EVENT("Device reset to %ux%u", width, height);
+namespace utinni::eventLog
+{
+enum ArgType : uint8_t
+{
+    at_int32 = 1,
+    at_uint32,
+    at_int64,
+    at_uint64,
+    at_double,
+    at_pointer,
+    at_string
+};
+
+constexpr uint32_t maxArgs = 8;
+constexpr uint32_t payloadCapacity = 48;
+
+UTINNI_API extern void enable(bool enable);
+UTINNI_API extern bool isEnabled();
+
+UTINNI_API extern bool registerFormat(uint32_t id, const char* format, const char* file, uint32_t line, const uint8_t* argTypes, uint32_t argCount);
+UTINNI_API extern void write(uint32_t id, const uint8_t* payload, uint32_t size);
+
+// Writes the events of the last seconds of every thread, returns false if the file couldn't be written. Safe to call from the crash
+// handler, a lock held by the crashed thread is given up on after 100 ms
+UTINNI_API extern bool dump(const std::string& filename, double seconds);
+
+constexpr uint32_t makeSiteId(const char* file, uint32_t line)
+{
+    uint32_t hash = 2166136261u;
+    for (; *file != '\0'; ++file)
+    {
+        hash = (hash ^ (uint8_t)*file) * 16777619u;
+    }
+    hash = (hash ^ line) * 16777619u;
+    return hash != 0 ? hash : 1;
+}
+
+template<typename> constexpr bool unsupportedArgType = false;
+
+template<typename T>
+constexpr ArgType getArgType()
+{
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*> || std::is_same_v<U, std::string>)
+    {
+        return at_string;
+    }
+    else if constexpr (std::is_floating_point_v<U>)
+    {
+        return at_double;
+    }
+    else if constexpr (std::is_pointer_v<U>)
+    {
+        return at_pointer;
+    }
+    else if constexpr (std::is_enum_v<U>)
+    {
+        return getArgType<std::underlying_type_t<U>>();
+    }
+    else if constexpr (std::is_integral_v<U>)
+    {
+        if constexpr (sizeof(U) <= 4)
+        {
+            return std::is_signed_v<U> ? at_int32 : at_uint32;
+        }
+        else
+        {
+            return std::is_signed_v<U> ? at_int64 : at_uint64;
+        }
+    }
+    else
+    {
+        static_assert(unsupportedArgType<U>, "Unsupported event argument type");
+        return at_int32;
+    }
+}
+
+// Packs the arguments into the record payload, strings are length prefixed and truncated to the space that's left
+class PayloadWriter
+{
+public:
+    template<typename T>
+    void put(const T& value)
+    {
+        constexpr ArgType type = getArgType<T>();
+        if constexpr (type == at_string)
+        {
+            putString(toCString(value));
+        }
+        else if constexpr (type == at_double)
+        {
+            putRaw((double)value);
+        }
+        else if constexpr (type == at_pointer)
+        {
+            putRaw((uint64_t)(uintptr_t)value);
+        }
+        else if constexpr (type == at_int32 || type == at_uint32)
+        {
+            putRaw((uint32_t)value);
+        }
+        else
+        {
+            putRaw((uint64_t)value);
+        }
+    }
+
+    const uint8_t* getData() const { return data; }
+    uint32_t getSize() const { return size; }
+
+private:
+    template<typename T>
+    void putRaw(T value)
+    {
+        if (size + sizeof(T) <= payloadCapacity)
+        {
+            memcpy(data + size, &value, sizeof(T));
+            size += sizeof(T);
+        }
+        else
+        {
+            size = payloadCapacity; // Arguments that don't fit are dropped, the decoder stops at the end of the payload
+        }
+    }
+
+    void putString(const char* text)
+    {
+        if (size >= payloadCapacity)
+        {
+            return;
+        }
+
+        const size_t length = text != nullptr ? strlen(text) : 0;
+        const uint8_t written = (uint8_t)(length < payloadCapacity - size - 1 ? length : payloadCapacity - size - 1);
+        data[size++] = written;
+        memcpy(data + size, text, written);
+        size += written;
+    }
+
+    static const char* toCString(const char* text) { return text; }
+    static const char* toCString(const std::string& text) { return text.c_str(); }
+
+    uint8_t data[payloadCapacity];
+    uint32_t size = 0;
+};
+
+template<typename... Args>
+bool registerSite(uint32_t id, const char* file, uint32_t line, const char* format, const Args&...)
+{
+    static_assert(sizeof...(Args) <= maxArgs, "Too many event arguments");
+    const uint8_t argTypes[] = { (uint8_t)0, (uint8_t)getArgType<Args>()... };
+    return registerFormat(id, format, file, line, argTypes + 1, sizeof...(Args));
+}
+
+template<typename... Args>
+void emit(uint32_t id, const char*, const Args&... args)
+{
+    PayloadWriter writer;
+    (writer.put(args), ...);
+    write(id, writer.getData(), writer.getSize());
+}
+}
+
+#define UTINNI_EVENT(...) \
+    do \
+    { \
+        if (utinni::eventLog::isEnabled()) \
+        { \
+            constexpr uint32_t utinniEventId = utinni::eventLog::makeSiteId(__FILE__, __LINE__); \
+            static const bool utinniEventRegistered = utinni::eventLog::registerSite(utinniEventId, __FILE__, __LINE__, __VA_ARGS__); \
+            (void)utinniEventRegistered; \
+            utinni::eventLog::emit(utinniEventId, __VA_ARGS__); \
+        } \
+    } while (false)
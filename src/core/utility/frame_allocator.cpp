@@ -0,0 +1,136 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "frame_allocator.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+constexpr size_t initialCapacity = 256 * 1024;
+
+std::unique_ptr<byte[]> buffer;
+size_t capacity = 0;
+size_t used = 0;
+size_t lastAllocationOffset = 0;
+
+// Allocations that didn't fit into the buffer, freed on reset. The buffer then grows to the peak usage so it doesn't happen again
+std::vector<std::unique_ptr<byte[]>> overflowAllocations;
+size_t overflowSize = 0;
+size_t overflowCount = 0;
+
+size_t frameHighWaterMark = 0;
+size_t lastFrameHighWaterMark = 0;
+size_t highWaterMark = 0;
+}
+
+namespace utinni::frameArena
+{
+void* allocate(size_t size, size_t alignment)
+{
+    if (buffer == nullptr)
+    {
+        capacity = initialCapacity;
+        buffer = std::make_unique<byte[]>(capacity);
+    }
+
+    const size_t offset = (used + alignment - 1) & ~(alignment - 1);
+    if (offset + size > capacity)
+    {
+        overflowCount++;
+        overflowSize += size + alignment;
+        frameHighWaterMark = std::max(frameHighWaterMark, used + overflowSize);
+
+        overflowAllocations.emplace_back(std::make_unique<byte[]>(size + alignment));
+        const uintptr_t address = (uintptr_t)overflowAllocations.back().get();
+        return (void*)((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    lastAllocationOffset = offset;
+    used = offset + size;
+    frameHighWaterMark = std::max(frameHighWaterMark, used + overflowSize);
+    return buffer.get() + offset;
+}
+
+void deallocate(void* address, size_t size)
+{
+    // Popping the last allocation keeps a growing vector from leaving all its old copies behind
+    if (buffer != nullptr && address == buffer.get() + lastAllocationOffset && lastAllocationOffset + size == used)
+    {
+        used = lastAllocationOffset;
+    }
+}
+
+const char* copyString(const char* str)
+{
+    const size_t length = strlen(str) + 1;
+    char* result = (char*)allocate(length, 1);
+    memcpy(result, str, length);
+    return result;
+}
+
+void reset()
+{
+    lastFrameHighWaterMark = frameHighWaterMark;
+    highWaterMark = std::max(highWaterMark, frameHighWaterMark);
+
+    if (!overflowAllocations.empty())
+    {
+        overflowAllocations.clear();
+        capacity = std::max(capacity * 2, frameHighWaterMark);
+        buffer = std::make_unique<byte[]>(capacity);
+    }
+
+    used = 0;
+    lastAllocationOffset = 0;
+    overflowSize = 0;
+    frameHighWaterMark = 0;
+}
+
+size_t getCapacity()
+{
+    return capacity;
+}
+
+size_t getUsed()
+{
+    return used + overflowSize;
+}
+
+size_t getLastFrameHighWaterMark()
+{
+    return lastFrameHighWaterMark;
+}
+
+size_t getHighWaterMark()
+{
+    return highWaterMark;
+}
+
+size_t getOverflowCount()
+{
+    return overflowCount;
+}
+}
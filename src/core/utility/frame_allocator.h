@@ -0,0 +1,81 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include <cstddef>
+
+// Linear scratch memory that lives until the end of the current frame, reset at the end of Game::mainLoop.
+// Meant for per-frame work on the main thread (ImGui callbacks, temporary lists), allocations are a pointer bump
+// and there is no need to free them. Don't hold on to anything allocated from it past the current frame.
+namespace utinni::frameArena
+{
+UTINNI_API extern void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+UTINNI_API extern void deallocate(void* address, size_t size); // Only reclaims the most recent allocation
+UTINNI_API extern const char* copyString(const char* str);
+
+UTINNI_API extern void reset();
+
+UTINNI_API extern size_t getCapacity();
+UTINNI_API extern size_t getUsed();
+UTINNI_API extern size_t getLastFrameHighWaterMark();
+UTINNI_API extern size_t getHighWaterMark();
+UTINNI_API extern size_t getOverflowCount(); // Allocations that didn't fit and fell back to the heap since startup
+}
+
+namespace utinni
+{
+// STL allocator adapter for the frame arena
+template<typename T>
+struct FrameAllocator
+{
+    using value_type = T;
+
+    FrameAllocator() = default;
+
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(size_t count)
+    {
+        return (T*)frameArena::allocate(count * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T* address, size_t count)
+    {
+        frameArena::deallocate(address, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const FrameAllocator<U>&) const { return true; }
+
+    template<typename U>
+    bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+}
@@ -0,0 +1,276 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "gpu_query_ring.h"
+#include <cstring>
+
+namespace
+{
+constexpr double averageWeight = 0.05;
+
+double ticksToMs(uint64_t begin, uint64_t end, uint64_t frequency)
+{
+    // Timestamps can go backwards across a disjoint the caller didn't catch, those zones just read as 0
+    return end > begin ? (double)(end - begin) * 1000.0 / (double)frequency : 0.0;
+}
+}
+
+namespace utinni::gpu
+{
+uint32_t QueryRing::beginFrame()
+{
+    if (recording)
+    {
+        endFrame();
+    }
+
+    currentSlot = (uint32_t)(frameIndex % slotCount);
+    Frame& frame = frames[currentSlot];
+    if (frame.pending)
+    {
+        droppedCount++;
+    }
+
+    frame.index = frameIndex++;
+    frame.zoneCount = 0;
+    frame.queryCount = 2; // Frame begin and end
+    frame.pending = false;
+
+    recording = true;
+    depth = 0;
+    overflowDepth = 0;
+    lastMarkQuery = frameBeginQuery;
+    return currentSlot;
+}
+
+int QueryRing::endFrame()
+{
+    if (!recording)
+    {
+        return -1;
+    }
+
+    // Zones left open end with the frame
+    Frame& frame = frames[currentSlot];
+    while (depth > 0)
+    {
+        const int zone = openZones[--depth];
+        if (zone >= 0)
+        {
+            frame.zones[zone].endQuery = frameEndQuery;
+        }
+    }
+
+    recording = false;
+    frame.pending = true;
+    return frameEndQuery;
+}
+
+int QueryRing::allocateQuery()
+{
+    Frame& frame = frames[currentSlot];
+    return frame.queryCount < maxQueries ? (int)frame.queryCount++ : -1;
+}
+
+int QueryRing::beginZone(const char* name)
+{
+    if (!recording)
+    {
+        return -1;
+    }
+
+    if (depth >= maxDepth)
+    {
+        overflowDepth++;
+        return -1;
+    }
+
+    Frame& frame = frames[currentSlot];
+    const int query = frame.zoneCount < maxZones ? allocateQuery() : -1;
+    if (query < 0)
+    {
+        openZones[depth++] = -1;
+        return -1;
+    }
+
+    const int zone = (int)frame.zoneCount++;
+    frame.zones[zone] = { name, depth, (uint32_t)query, frameEndQuery };
+    openZones[depth++] = zone;
+    return query;
+}
+
+int QueryRing::endZone()
+{
+    if (!recording)
+    {
+        return -1;
+    }
+
+    if (overflowDepth > 0)
+    {
+        overflowDepth--;
+        return -1;
+    }
+
+    if (depth == 0)
+    {
+        return -1;
+    }
+
+    const int zone = openZones[--depth];
+    if (zone < 0)
+    {
+        return -1;
+    }
+
+    const int query = allocateQuery();
+    if (query < 0)
+    {
+        return -1; // Ends with the frame instead
+    }
+
+    frames[currentSlot].zones[zone].endQuery = (uint32_t)query;
+    return query;
+}
+
+int QueryRing::mark(const char* name)
+{
+    if (!recording)
+    {
+        return -1;
+    }
+
+    Frame& frame = frames[currentSlot];
+    const int query = frame.zoneCount < maxZones ? allocateQuery() : -1;
+    if (query < 0)
+    {
+        return -1;
+    }
+
+    frame.zones[frame.zoneCount++] = { name, depth, lastMarkQuery, (uint32_t)query };
+    lastMarkQuery = (uint32_t)query;
+    return query;
+}
+
+int QueryRing::getReadySlot() const
+{
+    int oldest = -1;
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        const Frame& frame = frames[i];
+        if (frame.pending && frameIndex - frame.index >= frameLatency && (oldest < 0 || frame.index < frames[oldest].index))
+        {
+            oldest = (int)i;
+        }
+    }
+    return oldest;
+}
+
+void QueryRing::release(uint32_t slot)
+{
+    frames[slot].pending = false;
+}
+
+void QueryRing::reset()
+{
+    for (Frame& frame : frames)
+    {
+        frame.pending = false;
+    }
+    recording = false;
+    depth = 0;
+    overflowDepth = 0;
+}
+
+bool Aggregator::addFrame(const QueryRing::Frame& frame, const uint64_t* timestamps, uint64_t frequency, bool disjoint)
+{
+    // A disjoint frame had its clock change mid frame, the timestamps can't be compared
+    if (disjoint || frequency == 0 || timestamps[QueryRing::frameEndQuery] < timestamps[QueryRing::frameBeginQuery])
+    {
+        discardedCount++;
+        return false;
+    }
+
+    const bool first = frameCount == 0;
+    frameCount++;
+
+    if (++windowFrames > maxWindowFrames)
+    {
+        windowFrames = 1;
+        for (ZoneStats& zone : zones)
+        {
+            zone.maxMs = zone.windowMaxMs;
+            zone.windowMaxMs = 0;
+        }
+    }
+
+    lastFrameMs = ticksToMs(timestamps[QueryRing::frameBeginQuery], timestamps[QueryRing::frameEndQuery], frequency);
+    averageFrameMs = first ? lastFrameMs : averageFrameMs + (lastFrameMs - averageFrameMs) * averageWeight;
+
+    // Zones not in this frame read 0 for it, so a pass that was switched off fades out of the averages
+    for (ZoneStats& zone : zones)
+    {
+        zone.lastMs = 0;
+    }
+
+    for (uint32_t i = 0; i < frame.zoneCount; ++i)
+    {
+        const QueryRing::Zone& zone = frame.zones[i];
+        ZoneStats& stats = findOrAdd(zone.name, zone.depth);
+        stats.lastMs += ticksToMs(timestamps[zone.beginQuery], timestamps[zone.endQuery], frequency);
+    }
+
+    for (ZoneStats& zone : zones)
+    {
+        zone.averageMs = zone.frameCount++ == 0 ? zone.lastMs : zone.averageMs + (zone.lastMs - zone.averageMs) * averageWeight;
+        zone.windowMaxMs = zone.lastMs > zone.windowMaxMs ? zone.lastMs : zone.windowMaxMs;
+        zone.maxMs = zone.windowMaxMs > zone.maxMs ? zone.windowMaxMs : zone.maxMs;
+    }
+    return true;
+}
+
+ZoneStats& Aggregator::findOrAdd(const char* name, uint32_t depth)
+{
+    for (ZoneStats& zone : zones)
+    {
+        if (zone.depth == depth && (zone.name == name || strcmp(zone.name, name) == 0))
+        {
+            return zone;
+        }
+    }
+
+    zones.push_back({ name, depth, 0, 0, 0, 0, 0 });
+    return zones.back();
+}
+
+void Aggregator::reset()
+{
+    zones.clear();
+    lastFrameMs = 0;
+    averageFrameMs = 0;
+    frameCount = 0;
+    discardedCount = 0;
+    windowFrames = 0;
+}
+}
@@ -0,0 +1,142 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+// Bookkeeping for GPU timestamp queries, kept free of any graphics API so it can be driven with made up timestamps.
+// A frame records its zones as pairs of query indices into its slot, the slot is only read back once the GPU is
+// frameLatency frames behind, so reading never waits on the GPU. Slots that still aren't resolved by the time the ring
+// wraps around are dropped instead of stalling.
+namespace utinni::gpu
+{
+class UTINNI_API QueryRing
+{
+public:
+    static constexpr uint32_t frameLatency = 3;
+    static constexpr uint32_t slotCount = frameLatency + 1;
+    static constexpr uint32_t maxZones = 64;
+    static constexpr uint32_t maxDepth = 16;
+    static constexpr uint32_t frameBeginQuery = 0;
+    static constexpr uint32_t frameEndQuery = 1;
+    static constexpr uint32_t maxQueries = 2 + maxZones * 2;
+
+    struct Zone
+    {
+        const char* name;
+        uint32_t depth;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+    };
+
+    struct Frame
+    {
+        uint64_t index = 0;
+        uint32_t zoneCount = 0;
+        uint32_t queryCount = 0;
+        bool pending = false; // Ended and waiting to be read back
+        Zone zones[maxZones];
+    };
+
+    // Starts recording into the next slot and returns it, a slot that is still pending is dropped
+    uint32_t beginFrame();
+
+    // Closes any open zones, returns the query for the frame end timestamp or -1 when no frame is being recorded
+    int endFrame();
+
+    bool isRecording() const { return recording; }
+    uint32_t getCurrentSlot() const { return currentSlot; }
+    const Frame& getFrame(uint32_t slot) const { return frames[slot]; }
+
+    // Return the query index to issue a timestamp into, -1 when there's no frame or it's out of zones. Nesting is kept
+    // balanced even when a zone didn't fit
+    int beginZone(const char* name);
+    int endZone();
+
+    // Sequential zones, each mark closes the time since the previous mark (or the frame begin) under its name
+    int mark(const char* name);
+
+    // Oldest pending slot that is at least frameLatency frames old, -1 if none
+    int getReadySlot() const;
+    void release(uint32_t slot);
+
+    uint64_t getDroppedCount() const { return droppedCount; }
+    void reset();
+
+private:
+    Frame frames[slotCount];
+    uint64_t frameIndex = 0;
+    uint32_t currentSlot = 0;
+    bool recording = false;
+
+    int openZones[maxDepth] = {};
+    uint32_t depth = 0;
+    uint32_t overflowDepth = 0;
+    uint32_t lastMarkQuery = frameBeginQuery;
+
+    uint64_t droppedCount = 0;
+
+    int allocateQuery();
+};
+
+struct ZoneStats
+{
+    const char* name;
+    uint32_t depth;
+    double lastMs;
+    double averageMs;
+    double maxMs; // Over the last one to two windows of frames
+    double windowMaxMs;
+    uint64_t frameCount;
+};
+
+// Turns resolved frames into per zone timings, zones are matched by name and depth
+class UTINNI_API Aggregator
+{
+public:
+    static constexpr uint32_t maxWindowFrames = 120;
+
+    // timestamps holds the resolved value of every query of the frame, frequency is in ticks per second. Frames that can't
+    // be trusted (disjoint, no frequency or a frame end before its begin) are discarded and counted, returns false for those
+    bool addFrame(const QueryRing::Frame& frame, const uint64_t* timestamps, uint64_t frequency, bool disjoint = false);
+
+    const std::vector<ZoneStats>& getZones() const { return zones; }
+    double getLastFrameMs() const { return lastFrameMs; }
+    double getAverageFrameMs() const { return averageFrameMs; }
+    uint64_t getFrameCount() const { return frameCount; }
+    uint64_t getDiscardedCount() const { return discardedCount; }
+    void reset();
+
+private:
+    std::vector<ZoneStats> zones;
+    double lastFrameMs = 0;
+    double averageFrameMs = 0;
+    uint64_t frameCount = 0;
+    uint64_t discardedCount = 0;
+    uint32_t windowFrames = 0;
+
+    ZoneStats& findOrAdd(const char* name, uint32_t depth);
+};
+}
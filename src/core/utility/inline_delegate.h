@@ -0,0 +1,104 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace utinni
+{
+// Type erased callable like std::function, but callables up to inlineSize bytes are stored inside the delegate instead of
+// on the heap, and it's a single indirect call through a plain function pointer. Not copyable or movable, the callback
+// lists keep their delegates at a stable address and assign them in place.
+template<typename Signature>
+class InlineDelegate;
+
+template<typename Return, typename... Args>
+class InlineDelegate<Return(Args...)>
+{
+public:
+    static constexpr size_t inlineSize = 4 * sizeof(void*);
+
+    InlineDelegate() = default;
+    ~InlineDelegate() { reset(); }
+
+    InlineDelegate(const InlineDelegate&) = delete;
+    InlineDelegate& operator=(const InlineDelegate&) = delete;
+
+    template<typename T>
+    void assign(T&& func)
+    {
+        using Callable = std::decay_t<T>;
+
+        reset();
+        if constexpr (fitsInline<Callable>())
+        {
+            new (storage) Callable(std::forward<T>(func));
+            invoker = [](void* object, Args... args) -> Return { return (*static_cast<Callable*>(object))(std::forward<Args>(args)...); };
+            destroyer = [](void* object) { static_cast<Callable*>(object)->~Callable(); };
+        }
+        else
+        {
+            *reinterpret_cast<Callable**>(storage) = new Callable(std::forward<T>(func));
+            invoker = [](void* object, Args... args) -> Return { return (**static_cast<Callable**>(object))(std::forward<Args>(args)...); };
+            destroyer = [](void* object) { delete *static_cast<Callable**>(object); };
+        }
+    }
+
+    void reset()
+    {
+        if (destroyer != nullptr)
+        {
+            destroyer(storage);
+        }
+        invoker = nullptr;
+        destroyer = nullptr;
+    }
+
+    Return operator()(Args... args) const
+    {
+        return invoker(const_cast<unsigned char*>(storage), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const { return invoker != nullptr; }
+
+    template<typename Callable>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(Callable) <= inlineSize && alignof(Callable) <= alignof(std::max_align_t);
+    }
+
+private:
+    using Invoker = Return(*)(void* object, Args... args);
+    using Destroyer = void(*)(void* object);
+
+    alignas(std::max_align_t) unsigned char storage[inlineSize];
+    Invoker invoker = nullptr;
+    Destroyer destroyer = nullptr;
+};
+
+}
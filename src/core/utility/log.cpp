@@ -23,99 +23,340 @@
 **/
 
 #include "log.h"
-#include "spdlog/spdlog.h"
-#include <spdlog/sinks/basic_file_sink.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <share.h>
+#include <thread>
 
-static std::vector<std::string> logMessageBuffer;
-static std::vector<void(*)(const char* msg)> outputSinkCallbacks;
+// Asynchronous log backend. Producers copy the message into a slot of a bounded lock-free MPSC ring (Vyukov's bounded queue),
+// a background writer thread formats the drained messages, writes them to the file in a single batch and feeds the output
+// callbacks and the bounded history. Producers never block: when the ring is full the message is dropped and counted.
+namespace
+{
+enum Level : uint8_t
+{
+    lv_debug,
+    lv_info,
+    lv_warning,
+    lv_error,
+    lv_critical
+};
 
-namespace utinni::log
+constexpr const char* levelNames[] = { "debug", "info", "warning", "error", "critical" };
+
+constexpr uint32_t ringSize = 4096;
+constexpr uint32_t ringMask = ringSize - 1;
+constexpr uint32_t inlineTextSize = 224; // Longer messages are copied to the heap
+constexpr uint32_t historySize = 2048;
+constexpr DWORD writerIntervalMs = 10;
+
+struct Entry
 {
-class OutputSink : public spdlog::sinks::base_sink<std::mutex>
+    std::atomic<uint32_t> sequence;
+    Level level;
+    uint32_t length;
+    FILETIME time;
+    char* longText;
+    char text[inlineTextSize];
+};
+
+Entry ring[ringSize];
+std::atomic<uint32_t> enqueuePosition{ 0 };
+uint32_t dequeuePosition = 0;
+std::atomic<uint32_t> droppedCount{ 0 };
+uint32_t reportedDroppedCount = 0;
+
+const bool isRingInitialized = []()
 {
-public:
-    OutputSink()
+    for (uint32_t i = 0; i < ringSize; ++i)
     {
-        set_pattern("[%H:%M:%S] [%l]%! %v");
+        ring[i].sequence.store(i, std::memory_order_relaxed);
     }
+    return true;
+}();
+
+// Held by whoever drains the ring, the writer thread or a synchronous flush
+std::timed_mutex consumerMutex;
+FILE* file = nullptr;
+std::string batch;
+HANDLE wakeEvent = nullptr;
 
-protected:
-    void sink_it_(const spdlog::details::log_msg& msg) override
+std::vector<void(*)(const char* msg)> outputSinkCallbacks;
+
+std::mutex historyMutex;
+std::vector<std::string> history;
+uint32_t historyStart = 0;
+
+void enqueue(Level level, const char* text)
+{
+    const size_t length = text != nullptr ? strlen(text) : 0;
+
+    uint32_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Entry* entry;
+    for (;;)
     {
-        spdlog::memory_buf_t formatted;
-        base_sink<std::mutex>::formatter_->format(msg, formatted);
+        entry = &ring[position & ringMask];
+        const int32_t difference = (int32_t)(entry->sequence.load(std::memory_order_acquire) - position);
+        if (difference == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
 
-        const std::string formattedString = fmt::to_string(formatted);
+    GetSystemTimeAsFileTime(&entry->time);
+    entry->level = level;
+    entry->length = (uint32_t)length;
+    if (length < inlineTextSize)
+    {
+        entry->longText = nullptr;
+        memcpy(entry->text, text, length);
+    }
+    else
+    {
+        entry->longText = new char[length];
+        memcpy(entry->longText, text, length);
+    }
+    entry->sequence.store(position + 1, std::memory_order_release);
 
-        logMessageBuffer.emplace_back(formattedString);
-        for (const auto& func : outputSinkCallbacks)
+    if (level >= lv_error && wakeEvent != nullptr)
+    {
+        SetEvent(wakeEvent);
+    }
+}
+
+void appendLine(const SYSTEMTIME& time, const char* level, const char* text, size_t length)
+{
+    char prefix[48];
+    const int prefixLength = snprintf(prefix, sizeof(prefix), "[%02u:%02u:%02u] [%s] ", time.wHour, time.wMinute, time.wSecond, level);
+
+    const size_t lineStart = batch.size();
+    batch.append(prefix, prefixLength);
+    batch.append(text, length);
+    batch.append("\r\n");
+
+    std::string line = batch.substr(lineStart);
+    for (const auto& func : outputSinkCallbacks)
+    {
+        func(line.c_str());
+    }
+
+    std::lock_guard<std::mutex> lock(historyMutex);
+    if (history.size() < historySize)
+    {
+        history.emplace_back(std::move(line));
+    }
+    else
+    {
+        history[historyStart] = std::move(line);
+        historyStart = (historyStart + 1) % historySize;
+    }
+}
+
+// Caller holds consumerMutex
+void drain()
+{
+    batch.clear();
+
+    for (;;)
+    {
+        Entry* entry = &ring[dequeuePosition & ringMask];
+        if ((int32_t)(entry->sequence.load(std::memory_order_acquire) - (dequeuePosition + 1)) < 0)
+        {
+            break;
+        }
+
+        FILETIME localTime;
+        SYSTEMTIME time;
+        FileTimeToLocalFileTime(&entry->time, &localTime);
+        FileTimeToSystemTime(&localTime, &time);
+
+        if (entry->longText != nullptr)
+        {
+            appendLine(time, levelNames[entry->level], entry->longText, entry->length);
+            delete[] entry->longText;
+            entry->longText = nullptr;
+        }
+        else
         {
-            func(formattedString.c_str());
+            appendLine(time, levelNames[entry->level], entry->text, entry->length);
         }
+
+        entry->sequence.store(dequeuePosition + ringSize, std::memory_order_release);
+        dequeuePosition++;
     }
 
-    void flush_() override { }
-};
-    
-void create()
+    const uint32_t dropped = droppedCount.load(std::memory_order_relaxed);
+    if (dropped != reportedDroppedCount)
+    {
+        char text[96];
+        snprintf(text, sizeof(text), "%u log messages dropped, the log ring was full", dropped - reportedDroppedCount);
+        reportedDroppedCount = dropped;
+
+        FILETIME now;
+        FILETIME localTime;
+        SYSTEMTIME time;
+        GetSystemTimeAsFileTime(&now);
+        FileTimeToLocalFileTime(&now, &localTime);
+        FileTimeToSystemTime(&localTime, &time);
+        appendLine(time, levelNames[lv_warning], text, strlen(text));
+    }
+
+    if (file != nullptr && !batch.empty())
+    {
+        fwrite(batch.data(), 1, batch.size(), file);
+        fflush(file);
+    }
+}
+
+void writerLoop()
 {
-    spdlog::set_level(spdlog::level::debug);
+    for (;;)
+    {
+        WaitForSingleObject(wakeEvent, writerIntervalMs);
 
-    spdlog::set_pattern("[%H:%M:%S] [%l]%! %v");
-    spdlog::flush_on(spdlog::level::info);
+        std::lock_guard<std::timed_mutex> lock(consumerMutex);
+        drain();
+    }
+}
+}
 
+namespace utinni::log
+{
+void create()
+{
     const std::string logName = "utinni";
     const std::string previousLogFilename = getPath() + logName + "_previous.log";
     const std::string logFilename = getPath() + logName + ".log";
 
-    // Delete previous log and rename the current log to previous log, so spdlog can create a clean new log
+    // Delete previous log and rename the current log to previous log, so a clean new log is created
     std::remove(previousLogFilename.c_str());
     std::rename(logFilename.c_str(), previousLogFilename.c_str());
 
-    auto file_logger = spdlog::basic_logger_mt("UtinniLog", logFilename);
-    file_logger->sinks().emplace_back(std::make_shared<OutputSink>());
-    spdlog::set_default_logger(file_logger);
+    {
+        std::lock_guard<std::timed_mutex> lock(consumerMutex);
+        file = _fsopen(logFilename.c_str(), "wb", _SH_DENYWR); // Shared for reading so the log can be followed while running
+        batch.reserve(64 * 1024);
+    }
 
+    wakeEvent = CreateEvent(nullptr, false, false, nullptr);
+    std::thread(writerLoop).detach();
+}
+
+void flush()
+{
+    // Timed, the writer thread may already have been terminated while holding the lock when this runs on process detach
+    std::unique_lock<std::timed_mutex> lock(consumerMutex, std::chrono::milliseconds(100));
+    if (lock.owns_lock())
+    {
+        drain();
+    }
 }
 
 void critical(const char* text)
 {
-    spdlog::critical(text);
+    enqueue(lv_critical, text);
+    flush();
 }
 
 void debug(const char* text)
 {
-    spdlog::debug(text);
+    enqueue(lv_debug, text);
 }
 
 void error(const char* text)
 {
-    spdlog::error(text);
+    enqueue(lv_error, text);
 }
 
 void info(const char* text)
 {
-    spdlog::info(text);
+    enqueue(lv_info, text);
 }
 
 void warning(const char* text)
 {
-    spdlog::warn(text);
+    enqueue(lv_warning, text);
 }
 
 void addOutputSinkCallback(void(*func)(const char* msg))
 {
+    std::lock_guard<std::timed_mutex> lock(consumerMutex);
     outputSinkCallbacks.emplace_back(func);
 }
 
+uint32_t getDroppedCount()
+{
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
 int getMessageBufferCount()
 {
-    return logMessageBuffer.size();
+    std::lock_guard<std::mutex> lock(historyMutex);
+    return (int)history.size();
+}
+
+bool copyMessageAt(int i, char* buffer, size_t bufferSize)
+{
+    if (buffer == nullptr || bufferSize == 0)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(historyMutex);
+    if (i < 0 || (size_t)i >= history.size())
+    {
+        buffer[0] = 0;
+        return false;
+    }
+
+    const std::string& message = history[(historyStart + i) % history.size()];
+    const size_t length = std::min(message.size(), bufferSize - 1);
+    memcpy(buffer, message.c_str(), length);
+    buffer[length] = 0;
+    return true;
 }
 
 const char* getMessageAt(int i)
 {
-    return logMessageBuffer[i].c_str();
+    // The ring slot can be overwritten by the writer thread at any time, so the caller gets a copy that only this thread touches
+    thread_local std::string message;
+
+    std::lock_guard<std::mutex> lock(historyMutex);
+    if (i < 0 || (size_t)i >= history.size())
+    {
+        message.clear();
+    }
+    else
+    {
+        message = history[(historyStart + i) % history.size()];
+    }
+    return message.c_str();
+}
+
+void getMessages(std::vector<std::string>& messages)
+{
+    std::lock_guard<std::mutex> lock(historyMutex);
+    messages.clear();
+    messages.reserve(history.size());
+    for (size_t i = 0; i < history.size(); ++i)
+    {
+        messages.emplace_back(history[(historyStart + i) % history.size()]);
+    }
 }
 
 }
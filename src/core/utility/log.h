@@ -30,14 +30,29 @@ namespace utinni::log
 {
 void create();
 
+// Drains the pending messages to the file on the calling thread. Messages are otherwise written by a background thread,
+// critical messages flush immediately.
+UTINNI_API extern void flush();
+
 UTINNI_API extern void critical(const char* text);
 UTINNI_API extern void debug(const char* text);
 UTINNI_API extern void error(const char* text);
 UTINNI_API extern void info(const char* text);
 UTINNI_API extern void warning(const char* text);
 
+// Called from the log writer thread with the formatted line
 UTINNI_API extern void addOutputSinkCallback(void(*func)(const char* msg));
 
+// Messages dropped because the ring was full, logging never blocks the caller
+UTINNI_API extern uint32_t getDroppedCount();
+
+// Bounded history of the most recent formatted messages, oldest first. The writer thread keeps appending, so indices shift
+// between calls; getMessages copies the whole history under a single lock.
 UTINNI_API extern int getMessageBufferCount();
-UTINNI_API extern const char* getMessageAt(int i);
+// Copies message i into the buffer, truncated and null terminated. Returns false, with an empty buffer, when out of range
+UTINNI_API extern bool copyMessageAt(int i, char* buffer, size_t bufferSize);
+UTINNI_API extern void getMessages(std::vector<std::string>& messages);
+
+// Kept for existing plugins. Returns a per thread copy, valid until the next getMessageAt call on the same thread, "" when out of range
+[[deprecated("Use copyMessageAt or getMessages")]] UTINNI_API extern const char* getMessageAt(int i);
 }
\ No newline at end of file
@@ -23,52 +23,47 @@
 **/
 
 #include "memory.h"
+#include "pattern_scanner.h"
+#include "patch_transaction.h"
 #include <TlHelp32.h>
-#include <Psapi.h>
 
 namespace memory
 {
 
 swgptr findPattern(swgptr startAddress, size_t length, const char* pattern, const char* mask)
 {
-	 swgptr pos = 0;
-    const size_t searchLength = strlen(mask) - 1;
-	 for (swgptr returnAddress = startAddress; returnAddress < startAddress + length; returnAddress++)
-	 {
-		  if (*(PBYTE)returnAddress == ((PBYTE)pattern)[pos] || mask[pos] == '?')
-		  {
-				if (mask[pos + 1] == '\0')
-				{
-					 return returnAddress - searchLength;
-				}
-				pos++;
-		  }
-		  else
-		  {
-				pos = 0;
-		  }
-	 }
-	 return 0;
+    PatternScanner scanner;
+    scanner.add(pattern, mask);
+
+    const auto matches = scanner.scan(startAddress, length, true);
+    return matches.empty() ? 0 : matches[0].address;
 }
 
 swgptr findPattern(const char* moduleName, const char* pattern, const char* mask)
 {
-	 HINSTANCE moduleHandle = GetModuleHandle(moduleName);
-	 MODULEINFO moduleInfo;
-	 GetModuleInformation(GetCurrentProcess(), moduleHandle, &moduleInfo, sizeof(MODULEINFO));
+    swgptr startAddress;
+    size_t length;
+    if (!getModuleRange(moduleName, startAddress, length))
+    {
+        return 0;
+    }
+
+    return findPattern(startAddress, length, pattern, mask);
+}
+
+swgptr findPattern(const char* moduleName, const char* signature)
+{
+    PatternScanner scanner;
+    scanner.add(signature);
 
-	 return findPattern((swgptr)moduleHandle, moduleInfo.SizeOfImage, pattern, mask);
+    const auto matches = scanner.scanModule(moduleName, true);
+    return matches.empty() ? 0 : matches[0].address;
 }
 
+// Each of these is a single write transaction, batch patches with a PatchTransaction to share the page protection changes
 void copy(swgptr pDest, swgptr pSource, size_t length)
 {
-	 DWORD oldProtect;
-	 DWORD newProtect;
-
-	 const LPVOID addr = (LPVOID)pDest;
-	 VirtualProtect(addr, length, PAGE_EXECUTE_READWRITE, &oldProtect);
-	 memcpy(addr, (LPVOID)pSource, length);
-	 VirtualProtect(addr, length, oldProtect, &newProtect);
+	 PatchTransaction().copy(pDest, (const void*)pSource, length).commit();
 }
 
 void write(swgptr address, swgptr value, int length)
@@ -78,30 +73,18 @@ void write(swgptr address, swgptr value, int length)
 
 void set(swgptr pDest, swgptr value, size_t length)
 {
-	 DWORD oldProtect;
-	 DWORD newProtect;
-
-	 const LPVOID addr = (LPVOID)pDest;
-	 VirtualProtect(addr, length, PAGE_EXECUTE_READWRITE, &oldProtect);
-	 memset(addr, value, length);
-	 VirtualProtect(addr, length, oldProtect, &newProtect);
+	 PatchTransaction().set(pDest, (byte)value, length).commit();
 }
 
 void patchAddress(swgptr address, swgptr value)
 {
-	 DWORD oldProtect;
-	 DWORD newProtect;
-
-	 VirtualProtect((LPVOID)address, 4, PAGE_EXECUTE_READWRITE, &oldProtect);
-	 write<swgptr>(address, value);
-	 VirtualProtect((LPVOID)address, 4, oldProtect, &newProtect);
+	 PatchTransaction().patchAddress(address, value).commit();
 }
 
 std::tuple<swgptr, std::vector<char>> nopAddress(swgptr address, int nopCount)
 {
-	 // Not the most efficient. ToDo improve in the future
 	 std::vector<char> originalBytes((const char*)address, (const char*)address + nopCount);
-	 set(address, 0x90, nopCount); // 0x90 = NOP
+	 PatchTransaction().nop(address, nopCount).commit();
 	 return std::tuple<swgptr, std::vector<char>>(address, originalBytes);
 }
 
@@ -112,17 +95,7 @@ void restoreBytes(const std::tuple <swgptr, std::vector<char>>& originalBytes)
 
 void createJMP(swgptr address, swgptr jumpToAddress, size_t overrideLength)
 {
-	 DWORD oldProtect;
-	 DWORD newProtect;
-
-    VirtualProtect((LPVOID)address, overrideLength, PAGE_EXECUTE_READWRITE, &oldProtect);
-	 write<unsigned char>(address, 0xE9); // 0xE9 = JMP
-	 write<swgptr>(address + 0x1, (jumpToAddress - address) - 5); 
-	 for (swgptr i = 0x5; i < overrideLength; i++)
-	 {
-		  write<unsigned char>(address + i, 0x90); // 0x90 = NOP
-	 }
-	 VirtualProtect((LPVOID)address, overrideLength, oldProtect, &newProtect);
+	 PatchTransaction().jmp(address, jumpToAddress, overrideLength).commit();
 }
 
 swgptr getAddress(swgptr baseAddress, int ptrDepth)
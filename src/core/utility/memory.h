@@ -30,6 +30,7 @@ namespace memory
 {
 UTINNI_API extern swgptr findPattern(swgptr startAddress, size_t length, const char* pattern, const char* mask);
 UTINNI_API extern swgptr findPattern(const char* moduleName, const char* pattern, const char* mask);
+UTINNI_API extern swgptr findPattern(const char* moduleName, const char* signature); // IDA-style signature, "C7 06 ?? ?? 89 86"
 
 template<typename T>
 extern T read(swgptr address)
@@ -0,0 +1,217 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "patch_transaction.h"
+#include "utility/log.h"
+#include <algorithm>
+
+namespace
+{
+swgptr getPageSize()
+{
+    static swgptr pageSize = 0;
+    if (pageSize == 0)
+    {
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        pageSize = systemInfo.dwPageSize;
+    }
+    return pageSize;
+}
+}
+
+namespace memory
+{
+
+byte* PatchTransaction::addWrite(swgptr address, size_t length)
+{
+    writes.push_back({ address, length, patchedBytes.size() });
+    patchedBytes.resize(patchedBytes.size() + length);
+    return &patchedBytes[patchedBytes.size() - length];
+}
+
+PatchTransaction& PatchTransaction::copy(swgptr address, const void* source, size_t length)
+{
+    memcpy(addWrite(address, length), source, length);
+    return *this;
+}
+
+PatchTransaction& PatchTransaction::set(swgptr address, byte value, size_t length)
+{
+    memset(addWrite(address, length), value, length);
+    return *this;
+}
+
+PatchTransaction& PatchTransaction::patchAddress(swgptr address, swgptr value)
+{
+    return copy(address, &value, sizeof(swgptr));
+}
+
+PatchTransaction& PatchTransaction::nop(swgptr address, size_t length)
+{
+    return set(address, 0x90, length); // 0x90 = NOP
+}
+
+PatchTransaction& PatchTransaction::jmp(swgptr address, swgptr jumpToAddress, size_t overrideLength)
+{
+    if (overrideLength < 5)
+    {
+        // The jump alone takes 5 bytes, anything shorter would overwrite the following instruction
+        utinni::log::error("PatchTransaction::jmp needs an override length of at least 5 bytes, the transaction won't commit");
+        rejected = true;
+        return *this;
+    }
+
+    byte* data = addWrite(address, overrideLength);
+    const swgptr relativeAddress = (jumpToAddress - address) - 5;
+
+    data[0] = 0xE9; // 0xE9 = JMP
+    memcpy(data + 1, &relativeAddress, sizeof(swgptr));
+    memset(data + 5, 0x90, overrideLength - 5); // 0x90 = NOP
+    return *this;
+}
+
+bool PatchTransaction::commit()
+{
+    if (committed || rejected)
+    {
+        return false;
+    }
+
+    committed = apply(patchedBytes, true);
+    return committed;
+}
+
+bool PatchTransaction::rollback()
+{
+    if (!committed)
+    {
+        return false;
+    }
+
+    committed = !apply(originalBytes, false);
+    return !committed;
+}
+
+bool PatchTransaction::apply(const std::vector<byte>& data, bool storeOriginal)
+{
+    struct ProtectedRegion
+    {
+        swgptr address;
+        size_t size;
+        DWORD oldProtect;
+    };
+
+    if (writes.empty())
+    {
+        return true;
+    }
+
+    // Merge the pages touched by all writes into contiguous ranges
+    const swgptr pageMask = ~(getPageSize() - 1);
+    std::vector<std::pair<swgptr, swgptr>> ranges;
+    for (const Write& write : writes)
+    {
+        ranges.emplace_back(write.address & pageMask, (write.address + write.length + getPageSize() - 1) & pageMask);
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    std::vector<std::pair<swgptr, swgptr>> mergedRanges;
+    for (const auto& range : ranges)
+    {
+        if (!mergedRanges.empty() && range.first <= mergedRanges.back().second)
+        {
+            mergedRanges.back().second = std::max(mergedRanges.back().second, range.second);
+        }
+        else
+        {
+            mergedRanges.emplace_back(range);
+        }
+    }
+
+    // Unprotect each range once, split by regions of equal protection so every page gets its own protection restored
+    bool success = true;
+    std::vector<ProtectedRegion> regions;
+    for (const auto& range : mergedRanges)
+    {
+        swgptr address = range.first;
+        while (success && address < range.second)
+        {
+            MEMORY_BASIC_INFORMATION info;
+            if (VirtualQuery((LPCVOID)address, &info, sizeof(info)) == 0)
+            {
+                success = false;
+                break;
+            }
+
+            const swgptr regionEnd = std::min((swgptr)info.BaseAddress + (swgptr)info.RegionSize, range.second);
+            ProtectedRegion region = { address, regionEnd - address, 0 };
+            if (!VirtualProtect((LPVOID)region.address, region.size, PAGE_EXECUTE_READWRITE, &region.oldProtect))
+            {
+                success = false;
+                break;
+            }
+
+            protectCallCount++;
+            regions.emplace_back(region);
+            address = regionEnd;
+        }
+    }
+
+    // Only write if every range could be unprotected, so the transaction is applied completely or not at all
+    if (success)
+    {
+        if (storeOriginal)
+        {
+            originalBytes.resize(patchedBytes.size());
+            for (const Write& write : writes)
+            {
+                memcpy(&originalBytes[write.dataOffset], (const void*)write.address, write.length);
+            }
+        }
+
+        for (const Write& write : writes)
+        {
+            memcpy((void*)write.address, &data[write.dataOffset], write.length);
+        }
+    }
+
+    for (auto it = regions.rbegin(); it != regions.rend(); ++it)
+    {
+        DWORD newProtect;
+        VirtualProtect((LPVOID)it->address, it->size, it->oldProtect, &newProtect);
+    }
+
+    if (success)
+    {
+        for (const auto& range : mergedRanges)
+        {
+            FlushInstructionCache(GetCurrentProcess(), (LPCVOID)range.first, range.second - range.first);
+        }
+    }
+
+    return success;
+}
+
+}
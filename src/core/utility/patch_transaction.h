@@ -0,0 +1,80 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+namespace memory
+{
+// Collects code/data writes and applies them together. Writes are grouped into page ranges so the protection of
+// each range is only changed once, and either every write is applied or none is. The original bytes are kept in
+// a single buffer so the whole transaction can be rolled back.
+class UTINNI_API PatchTransaction
+{
+public:
+    PatchTransaction() = default;
+    PatchTransaction(const PatchTransaction&) = delete;
+    PatchTransaction& operator=(const PatchTransaction&) = delete;
+
+    PatchTransaction& copy(swgptr address, const void* source, size_t length);
+    PatchTransaction& set(swgptr address, byte value, size_t length);
+    PatchTransaction& patchAddress(swgptr address, swgptr value);
+    PatchTransaction& nop(swgptr address, size_t length);
+    PatchTransaction& jmp(swgptr address, swgptr jumpToAddress, size_t overrideLength);
+
+    template<size_t n>
+    PatchTransaction& copy(swgptr address, const unsigned char(&buffer)[n])
+    {
+        return copy(address, buffer, n);
+    }
+
+    // Fails without writing anything when a queued write was rejected or a page couldn't be unprotected
+    bool commit();
+    bool rollback();
+
+    bool isCommitted() const { return committed; }
+    size_t getWriteCount() const { return writes.size(); }
+    size_t getProtectCallCount() const { return protectCallCount; }
+
+private:
+    struct Write
+    {
+        swgptr address;
+        size_t length;
+        size_t dataOffset;
+    };
+
+    std::vector<Write> writes;
+    std::vector<byte> patchedBytes;
+    std::vector<byte> originalBytes;
+    size_t protectCallCount = 0;
+    bool committed = false;
+    bool rejected = false;
+
+    byte* addWrite(swgptr address, size_t length);
+    bool apply(const std::vector<byte>& data, bool storeOriginal);
+};
+
+}
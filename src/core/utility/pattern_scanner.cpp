@@ -0,0 +1,343 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "pattern_scanner.h"
+#ifdef _WIN32
+#include <Psapi.h>
+#endif
+#include <emmintrin.h>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+
+namespace
+{
+// Rough frequency of byte values in x86 code, lower is rarer
+int getByteFrequencyScore(byte value)
+{
+    switch (value)
+    {
+    case 0x00:
+        return 100;
+    case 0xFF:
+    case 0xCC:
+    case 0x90:
+        return 80;
+    case 0x01:
+    case 0x04:
+    case 0x0F:
+    case 0x24:
+    case 0x44:
+    case 0x45:
+    case 0x50:
+    case 0x55:
+    case 0x83:
+    case 0x89:
+    case 0x8B:
+    case 0x8D:
+    case 0xC4:
+    case 0xE8:
+    case 0xEC:
+        return 50;
+    default:
+        return 10;
+    }
+}
+
+int hexDigitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    c = (char)tolower(c);
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+unsigned long countTrailingZeros(unsigned int value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#else
+    return __builtin_ctz(value);
+#endif
+}
+}
+
+namespace memory
+{
+
+Pattern::Pattern(const char* signature)
+{
+    const char* pos = signature;
+    while (*pos != '\0')
+    {
+        if (isspace((unsigned char)*pos))
+        {
+            pos++;
+            continue;
+        }
+
+        if (*pos == '?')
+        {
+            bytes.emplace_back(0);
+            mask.emplace_back(0x00);
+            pos++;
+            if (*pos == '?')
+            {
+                pos++;
+            }
+            continue;
+        }
+
+        const int high = hexDigitValue(pos[0]);
+        const int low = pos[1] != '\0' ? hexDigitValue(pos[1]) : -1;
+        if (high < 0 || low < 0)
+        {
+            // Malformed signature, leave the pattern invalid
+            bytes.clear();
+            mask.clear();
+            return;
+        }
+
+        bytes.emplace_back((byte)((high << 4) | low));
+        mask.emplace_back(0xFF);
+        pos += 2;
+    }
+
+    selectAnchor();
+}
+
+Pattern::Pattern(const char* pattern, const char* mask)
+{
+    const size_t length = strlen(mask);
+    bytes.resize(length);
+    this->mask.resize(length);
+    for (size_t i = 0; i < length; ++i)
+    {
+        // Placeholder bytes under a wildcard are zeroed, matches() compares against the masked memory
+        this->mask[i] = mask[i] == '?' ? 0x00 : 0xFF;
+        bytes[i] = (byte)pattern[i] & this->mask[i];
+    }
+
+    selectAnchor();
+}
+
+void Pattern::selectAnchor()
+{
+    anchor = bytes.size(); // Stays invalid if the pattern is wildcards only
+    int bestScore = INT_MAX;
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        if (mask[i] == 0x00)
+        {
+            continue;
+        }
+
+        const int score = getByteFrequencyScore(bytes[i]);
+        if (score < bestScore)
+        {
+            bestScore = score;
+            anchor = i;
+        }
+    }
+}
+
+bool Pattern::matches(const byte* address) const
+{
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        if ((address[i] & mask[i]) != bytes[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t PatternScanner::add(const Pattern& pattern)
+{
+    patterns.emplace_back(pattern);
+    return patterns.size() - 1;
+}
+
+std::vector<PatternScanner::Match> PatternScanner::scan(swgptr startAddress, size_t length, bool firstOnly) const
+{
+    std::vector<Match> matches;
+
+    // Bucket the patterns by their anchor byte, so every position in the range is only looked at once
+    std::vector<size_t> buckets[256];
+    std::vector<byte> anchorBytes;
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        if (!patterns[i].isValid())
+        {
+            continue;
+        }
+
+        const byte anchorByte = patterns[i].getAnchorByte();
+        if (buckets[anchorByte].empty())
+        {
+            anchorBytes.emplace_back(anchorByte);
+        }
+        buckets[anchorByte].emplace_back(i);
+    }
+
+    if (anchorBytes.empty() || length == 0)
+    {
+        return matches;
+    }
+
+    const byte* begin = (const byte*)(uintptr_t)startAddress;
+    const byte* end = begin + length;
+
+    std::vector<bool> found(patterns.size(), false);
+    size_t remaining = 0;
+    for (byte anchorByte : anchorBytes)
+    {
+        remaining += buckets[anchorByte].size();
+    }
+
+    // Verifies all patterns anchored at this position, returns false once every pattern has been found in firstOnly mode
+    const auto checkCandidate = [&](const byte* candidate) -> bool
+    {
+        for (size_t patternIndex : buckets[*candidate])
+        {
+            if (firstOnly && found[patternIndex])
+            {
+                continue;
+            }
+
+            const Pattern& pattern = patterns[patternIndex];
+            const byte* patternStart = candidate - pattern.getAnchor();
+            if (patternStart < begin || (size_t)(end - patternStart) < pattern.size() || !pattern.matches(patternStart))
+            {
+                continue;
+            }
+
+            matches.push_back({ patternIndex, (swgptr)(uintptr_t)patternStart });
+
+            if (firstOnly)
+            {
+                found[patternIndex] = true;
+                if (--remaining == 0)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    const byte* pos = begin;
+    bool searching = true;
+    if (anchorBytes.size() <= 4)
+    {
+        // Few distinct anchors, filter 16 bytes at a time with SSE2 compares
+        __m128i anchors[4];
+        for (size_t i = 0; i < 4; ++i)
+        {
+            anchors[i] = _mm_set1_epi8((char)anchorBytes[std::min(i, anchorBytes.size() - 1)]);
+        }
+
+        for (; searching && end - pos >= 16; pos += 16)
+        {
+            const __m128i block = _mm_loadu_si128((const __m128i*)pos);
+            const __m128i equal = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, anchors[0]), _mm_cmpeq_epi8(block, anchors[1])),
+                _mm_or_si128(_mm_cmpeq_epi8(block, anchors[2]), _mm_cmpeq_epi8(block, anchors[3])));
+
+            unsigned int candidates = (unsigned int)_mm_movemask_epi8(equal);
+            while (candidates != 0)
+            {
+                if (!checkCandidate(pos + countTrailingZeros(candidates)))
+                {
+                    searching = false;
+                    break;
+                }
+                candidates &= candidates - 1;
+            }
+        }
+    }
+
+    // Many distinct anchors (or the tail of the range), fall back to a table lookup per byte
+    bool isAnchor[256] = {};
+    for (byte anchorByte : anchorBytes)
+    {
+        isAnchor[anchorByte] = true;
+    }
+
+    for (; searching && pos < end; ++pos)
+    {
+        if (isAnchor[*pos] && !checkCandidate(pos))
+        {
+            searching = false;
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b)
+    {
+        return a.address != b.address ? a.address < b.address : a.patternIndex < b.patternIndex;
+    });
+
+    return matches;
+}
+
+std::vector<PatternScanner::Match> PatternScanner::scanModule(const char* moduleName, bool firstOnly) const
+{
+    swgptr startAddress;
+    size_t length;
+    if (!getModuleRange(moduleName, startAddress, length))
+    {
+        return std::vector<Match>();
+    }
+
+    return scan(startAddress, length, firstOnly);
+}
+
+bool getModuleRange([[maybe_unused]] const char* moduleName, [[maybe_unused]] swgptr& startAddress, [[maybe_unused]] size_t& length)
+{
+#ifdef _WIN32
+    const HMODULE moduleHandle = GetModuleHandle(moduleName);
+    MODULEINFO moduleInfo;
+    if (moduleHandle == nullptr || !GetModuleInformation(GetCurrentProcess(), moduleHandle, &moduleInfo, sizeof(MODULEINFO)))
+    {
+        return false;
+    }
+
+    startAddress = (swgptr)moduleHandle;
+    length = moduleInfo.SizeOfImage;
+    return true;
+#else
+    return false; // Only the scanning itself is built outside of Windows, for the micro benchmarks
+#endif
+}
+
+}
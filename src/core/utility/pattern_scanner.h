@@ -0,0 +1,80 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+namespace memory
+{
+// A byte signature with wildcards, either IDA-style ("C7 06 ?? ?? ?? ?? 89 86") or code-style (pattern + "xx????xx" mask)
+class UTINNI_API Pattern
+{
+public:
+    Pattern(const char* signature);
+    Pattern(const char* pattern, const char* mask);
+
+    bool isValid() const { return !bytes.empty() && anchor < bytes.size(); }
+    size_t size() const { return bytes.size(); }
+    size_t getAnchor() const { return anchor; }
+    byte getAnchorByte() const { return bytes[anchor]; }
+
+    bool matches(const byte* address) const;
+
+private:
+    std::vector<byte> bytes;
+    std::vector<byte> mask; // 0xFF = compare, 0x00 = wildcard
+    size_t anchor = 0; // Index of the least common concrete byte, used to filter candidates
+
+    void selectAnchor();
+};
+
+// Scans a memory range for any number of patterns in a single pass
+class UTINNI_API PatternScanner
+{
+public:
+    struct Match
+    {
+        size_t patternIndex;
+        swgptr address;
+    };
+
+    size_t add(const Pattern& pattern);
+    size_t add(const char* signature) { return add(Pattern(signature)); }
+    size_t add(const char* pattern, const char* mask) { return add(Pattern(pattern, mask)); }
+
+    size_t getPatternCount() const { return patterns.size(); }
+    const Pattern& getPatternAt(size_t i) const { return patterns[i]; }
+
+    // Returns every match of every pattern, ordered by address. If firstOnly is set, each pattern reports at most its first match
+    std::vector<Match> scan(swgptr startAddress, size_t length, bool firstOnly = false) const;
+    std::vector<Match> scanModule(const char* moduleName, bool firstOnly = false) const;
+
+private:
+    std::vector<Pattern> patterns;
+};
+
+UTINNI_API extern bool getModuleRange(const char* moduleName, swgptr& startAddress, size_t& length);
+
+}
@@ -0,0 +1,337 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "profiler.h"
+#include "string_utility.h"
+#include "imgui/imgui.h"
+#include <intrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+namespace
+{
+using utinni::profiler::ZoneEvent;
+
+constexpr uint32_t ringSize = 1 << 15;
+constexpr uint32_t ringMask = ringSize - 1;
+constexpr uint32_t ringReadMargin = 1024; // Oldest events that may be overwritten while being read
+
+struct ThreadBuffer
+{
+    uint32_t threadId = 0;
+    uint32_t depth = 0;
+    std::atomic<uint32_t> writeIndex{ 0 };
+    ZoneEvent events[ringSize];
+};
+
+bool enabled = false;
+
+std::mutex buffersMutex;
+std::vector<ThreadBuffer*> buffers;
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+ThreadBuffer* mainThreadBuffer = nullptr;
+uint64_t frameStart = 0;
+uint32_t frameStartIndex = 0;
+uint64_t lastFrameStart = 0;
+uint64_t lastFrameEnd = 0;
+uint32_t lastFrameStartIndex = 0;
+uint32_t lastFrameEndIndex = 0;
+
+uint64_t calibrationTsc = 0;
+LARGE_INTEGER calibrationQpc{};
+double ticksPerMs = 0;
+
+ThreadBuffer* getThreadBuffer()
+{
+    if (threadBuffer == nullptr)
+    {
+        threadBuffer = new ThreadBuffer(); // Lives as long as the process, the trace may still reference it after the thread exits
+        threadBuffer->threadId = GetCurrentThreadId();
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.emplace_back(threadBuffer);
+    }
+    return threadBuffer;
+}
+
+void calibrate(bool initial)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    QueryPerformanceFrequency(&frequency);
+
+    if (initial)
+    {
+        // Short busy wait for a first estimate, refined every frame from then on
+        QueryPerformanceCounter(&calibrationQpc);
+        calibrationTsc = __rdtsc();
+        do
+        {
+            QueryPerformanceCounter(&now);
+        } while ((now.QuadPart - calibrationQpc.QuadPart) * 1000 < frequency.QuadPart * 5);
+    }
+    else
+    {
+        QueryPerformanceCounter(&now);
+    }
+
+    const double elapsedMs = (double)(now.QuadPart - calibrationQpc.QuadPart) * 1000.0 / (double)frequency.QuadPart;
+    ticksPerMs = (double)(__rdtsc() - calibrationTsc) / elapsedMs;
+}
+
+void collectEvents(const ThreadBuffer* buffer, uint32_t fromIndex, uint32_t toIndex, std::vector<ZoneEvent>& zones)
+{
+    if (toIndex - fromIndex > ringSize - ringReadMargin)
+    {
+        fromIndex = toIndex - (ringSize - ringReadMargin);
+    }
+
+    for (uint32_t i = fromIndex; i != toIndex; ++i)
+    {
+        zones.emplace_back(buffer->events[i & ringMask]);
+    }
+}
+}
+
+namespace utinni::profiler
+{
+ScopedZone::ScopedZone(const char* name) : name(name), start(0), active(enabled)
+{
+    if (active)
+    {
+        getThreadBuffer()->depth++;
+        start = __rdtsc();
+    }
+}
+
+ScopedZone::~ScopedZone()
+{
+    if (active)
+    {
+        const uint64_t end = __rdtsc();
+        ThreadBuffer* buffer = threadBuffer;
+        const uint32_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+        buffer->events[index & ringMask] = { name, start, end, buffer->depth };
+        buffer->writeIndex.store(index + 1, std::memory_order_release);
+        buffer->depth--;
+    }
+}
+
+void enable(bool enable)
+{
+    if (enable && ticksPerMs == 0)
+    {
+        calibrate(true);
+    }
+    enabled = enable;
+}
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+void endFrame()
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    mainThreadBuffer = getThreadBuffer();
+
+    const uint64_t now = __rdtsc();
+    const uint32_t index = mainThreadBuffer->writeIndex.load(std::memory_order_acquire);
+    if (frameStart != 0)
+    {
+        lastFrameStart = frameStart;
+        lastFrameEnd = now;
+        lastFrameStartIndex = frameStartIndex;
+        lastFrameEndIndex = index;
+    }
+    frameStart = now;
+    frameStartIndex = index;
+
+    calibrate(false);
+}
+
+double ticksToMs(uint64_t ticks)
+{
+    if (ticksPerMs == 0)
+    {
+        calibrate(true);
+    }
+    return (double)ticks / ticksPerMs;
+}
+
+uint64_t msToTicks(double ms)
+{
+    if (ticksPerMs == 0)
+    {
+        calibrate(true);
+    }
+    return (uint64_t)(ms * ticksPerMs);
+}
+
+double getLastFrameMs()
+{
+    return ticksToMs(lastFrameEnd - lastFrameStart);
+}
+
+void getLastFrameZones(std::vector<ZoneEvent>& zones, uint64_t& start, uint64_t& end)
+{
+    zones.clear();
+    start = lastFrameStart;
+    end = lastFrameEnd;
+
+    if (mainThreadBuffer == nullptr || lastFrameEnd == 0)
+    {
+        return;
+    }
+
+    collectEvents(mainThreadBuffer, lastFrameStartIndex, lastFrameEndIndex, zones);
+    std::sort(zones.begin(), zones.end(), [](const ZoneEvent& a, const ZoneEvent& b) { return a.start < b.start; });
+}
+
+void drawUi()
+{
+    static std::vector<ZoneEvent> zones;
+    static uint64_t zonesStart = 0;
+    static uint64_t zonesEnd = 0;
+    static bool paused = false;
+
+    ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_NoCollapse);
+    {
+        bool isEnabled = enabled;
+        if (ImGui::Checkbox("Enabled", &isEnabled))
+        {
+            enable(isEnabled);
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Pause", &paused);
+        ImGui::SameLine();
+        if (ImGui::Button("Export Chrome trace"))
+        {
+            exportChromeTrace(getPath() + "profile.json");
+        }
+
+        if (!paused)
+        {
+            getLastFrameZones(zones, zonesStart, zonesEnd);
+        }
+
+        const double frameMs = ticksToMs(zonesEnd - zonesStart);
+        ImGui::Text("Frame: %.3f ms, %u zones", frameMs, (uint32_t)zones.size());
+
+        // Flame graph of the main thread, one row per depth
+        constexpr float rowHeight = 18.0f;
+        uint32_t maxDepth = 1;
+        for (const ZoneEvent& zone : zones)
+        {
+            maxDepth = std::max(maxDepth, zone.depth);
+        }
+
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const float width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+        const float height = rowHeight * maxDepth;
+        ImGui::InvisibleButton("FlameGraph", ImVec2(width, height));
+
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        const double scale = zonesEnd > zonesStart ? width / (double)(zonesEnd - zonesStart) : 0;
+        const ImVec2 mouse = ImGui::GetIO().MousePos;
+        for (const ZoneEvent& zone : zones)
+        {
+            const float x0 = origin.x + (float)((double)(zone.start - zonesStart) * scale);
+            const float x1 = std::max(x0 + 1.0f, origin.x + (float)((double)(zone.end - zonesStart) * scale));
+            const float y0 = origin.y + rowHeight * (zone.depth - 1);
+            const float y1 = y0 + rowHeight - 1.0f;
+
+            // Stable colour per zone name
+            const ImU32 colour = ImColor::HSV((float)(((swgptr)zone.name >> 4) % 97) / 97.0f, 0.5f, 0.7f);
+            drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), colour);
+            if (x1 - x0 > 30.0f)
+            {
+                drawList->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+                drawList->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32_WHITE, zone.name);
+                drawList->PopClipRect();
+            }
+
+            if (ImGui::IsItemHovered() && mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1)
+            {
+                ImGui::SetTooltip("%s\n%.3f ms", zone.name, ticksToMs(zone.end - zone.start));
+            }
+        }
+    }
+    ImGui::End();
+}
+
+bool exportChromeTrace(const std::string& filename)
+{
+    FILE* file = nullptr;
+    if (fopen_s(&file, filename.c_str(), "w") != 0 || file == nullptr)
+    {
+        return false;
+    }
+
+    std::vector<ZoneEvent> zones;
+    std::vector<ThreadBuffer*> threadBuffers;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        threadBuffers = buffers;
+    }
+
+    uint64_t baseTsc = UINT64_MAX;
+    for (const ThreadBuffer* buffer : threadBuffers)
+    {
+        const uint32_t writeIndex = buffer->writeIndex.load(std::memory_order_acquire);
+        const uint32_t count = std::min(writeIndex, ringSize - ringReadMargin);
+        for (uint32_t i = writeIndex - count; i != writeIndex; ++i)
+        {
+            baseTsc = std::min(baseTsc, buffer->events[i & ringMask].start);
+        }
+    }
+
+    fputs("{\"traceEvents\":[\n", file);
+    bool first = true;
+    for (const ThreadBuffer* buffer : threadBuffers)
+    {
+        zones.clear();
+        const uint32_t writeIndex = buffer->writeIndex.load(std::memory_order_acquire);
+        collectEvents(buffer, writeIndex - std::min(writeIndex, ringSize), writeIndex, zones);
+
+        for (const ZoneEvent& zone : zones)
+        {
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n",
+                stringUtility::toJsonEscaped(zone.name).c_str(), buffer->threadId, ticksToMs(zone.start - baseTsc) * 1000.0, ticksToMs(zone.end - zone.start) * 1000.0);
+            first = false;
+        }
+    }
+    fputs("\n]}\n", file);
+    fclose(file);
+    return true;
+}
+}
@@ -0,0 +1,76 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+// Low overhead hierarchical CPU profiler. Zones are timed with RDTSC and written to a ring buffer per thread,
+// the last frame can be viewed as a flame graph in ImGui and the buffers exported as a Chrome trace (chrome://tracing).
+namespace utinni::profiler
+{
+struct ZoneEvent
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    uint32_t depth;
+};
+
+class UTINNI_API ScopedZone
+{
+public:
+    explicit ScopedZone(const char* name);
+    ~ScopedZone();
+
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+    bool active;
+};
+
+UTINNI_API extern void enable(bool enable);
+UTINNI_API extern bool isEnabled();
+
+// Marks the frame boundary on the calling thread, called at the start of every Game::mainLoop
+UTINNI_API extern void endFrame();
+
+// Tick conversions, calibrated on first use when the profiler hasn't been enabled
+UTINNI_API extern double ticksToMs(uint64_t ticks);
+UTINNI_API extern uint64_t msToTicks(double ms);
+UTINNI_API extern double getLastFrameMs();
+
+// Copies the main thread's zones of the last completed frame, ordered by start
+UTINNI_API extern void getLastFrameZones(std::vector<ZoneEvent>& zones, uint64_t& frameStart, uint64_t& frameEnd);
+
+UTINNI_API extern void drawUi();
+UTINNI_API extern bool exportChromeTrace(const std::string& filename);
+}
+
+#define UTINNI_PROFILE_CONCAT_IMPL(a, b) a##b
+#define UTINNI_PROFILE_CONCAT(a, b) UTINNI_PROFILE_CONCAT_IMPL(a, b)
+#define UTINNI_PROFILE_ZONE(name) utinni::profiler::ScopedZone UTINNI_PROFILE_CONCAT(profileZone, __LINE__)(name)
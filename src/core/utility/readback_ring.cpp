@@ -0,0 +1,106 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "readback_ring.h"
+#include <algorithm>
+#include <cstring>
+
+namespace utinni::gpu
+{
+void ReadbackRing::configure(uint32_t newSlotCount, uint32_t newFrameLatency)
+{
+    reset();
+    slotCount = std::min(std::max(newSlotCount, 1u), maxSlots);
+    frameLatency = newFrameLatency;
+}
+
+int ReadbackRing::beginCapture(uint64_t frame)
+{
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        if (!slots[i].pending)
+        {
+            slots[i].frame = frame;
+            slots[i].pending = true;
+            capturedCount++;
+            return (int)i;
+        }
+    }
+
+    droppedCount++;
+    return -1;
+}
+
+int ReadbackRing::getReadySlot(uint64_t frame) const
+{
+    int oldest = -1;
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        const Slot& slot = slots[i];
+        if (slot.pending && frame >= slot.frame + frameLatency && (oldest < 0 || slot.frame < slots[oldest].frame))
+        {
+            oldest = (int)i;
+        }
+    }
+    return oldest;
+}
+
+void ReadbackRing::release(uint32_t slot)
+{
+    slots[slot].pending = false;
+}
+
+void ReadbackRing::reset()
+{
+    for (Slot& slot : slots)
+    {
+        slot.pending = false;
+    }
+}
+
+uint32_t ReadbackRing::getPendingCount() const
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        count += slots[i].pending ? 1 : 0;
+    }
+    return count;
+}
+
+void packRows(const void* source, uint32_t pitch, uint32_t rowBytes, uint32_t rows, uint8_t* destination)
+{
+    const auto bytes = static_cast<const uint8_t*>(source);
+    if (pitch == rowBytes)
+    {
+        memcpy(destination, bytes, (size_t)rowBytes * rows);
+        return;
+    }
+
+    for (uint32_t row = 0; row < rows; ++row)
+    {
+        memcpy(destination + (size_t)row * rowBytes, bytes + (size_t)row * pitch, rowBytes);
+    }
+}
+}
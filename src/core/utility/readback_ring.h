@@ -0,0 +1,75 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+// Bookkeeping for reading GPU surfaces back, kept free of any graphics API like gpu::QueryRing. A capture claims a free
+// slot and is only read once frameLatency frames have been presented since, by then the copy has finished and the lock
+// doesn't wait. A capture that finds every slot still in flight is dropped instead of stalling.
+namespace utinni::gpu
+{
+class UTINNI_API ReadbackRing
+{
+public:
+    static constexpr uint32_t maxSlots = 8;
+
+    // Slots are clamped to 1-maxSlots. A latency of 0 reads the capture in the frame it was made in
+    void configure(uint32_t slotCount, uint32_t frameLatency);
+    uint32_t getSlotCount() const { return slotCount; }
+    uint32_t getFrameLatency() const { return frameLatency; }
+
+    // The slot to copy into, -1 when every slot is pending
+    int beginCapture(uint64_t frame);
+
+    // Oldest pending slot captured at least frameLatency frames before frame, -1 if none
+    int getReadySlot(uint64_t frame) const;
+    uint64_t getCaptureFrame(uint32_t slot) const { return slots[slot].frame; }
+
+    // Frees the slot once it's read, or when its copy failed
+    void release(uint32_t slot);
+    void reset();
+
+    uint32_t getPendingCount() const;
+    uint64_t getCapturedCount() const { return capturedCount; }
+    uint64_t getDroppedCount() const { return droppedCount; }
+
+private:
+    struct Slot
+    {
+        uint64_t frame = 0;
+        bool pending = false;
+    };
+
+    Slot slots[maxSlots];
+    uint32_t slotCount = 3;
+    uint32_t frameLatency = 2;
+    uint64_t capturedCount = 0;
+    uint64_t droppedCount = 0;
+};
+
+// Copies rows of rowBytes out of a lock with the given pitch into a tightly packed buffer
+UTINNI_API void packRows(const void* source, uint32_t pitch, uint32_t rowBytes, uint32_t rows, uint8_t* destination);
+}
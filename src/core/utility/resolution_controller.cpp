@@ -0,0 +1,110 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "resolution_controller.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr float smoothing = 0.2f; // Of the frame time average
+}
+
+namespace utinni::gpu
+{
+void ResolutionController::setSettings(const Settings& newSettings)
+{
+    settings = newSettings;
+    settings.minScale = std::min(std::max(settings.minScale, settings.granularity), 1.0f);
+    settings.maxScale = std::min(std::max(settings.maxScale, settings.minScale), 1.0f);
+    scale = std::min(std::max(scale, settings.minScale), settings.maxScale);
+}
+
+float ResolutionController::update(float frameMs)
+{
+    if (frameMs <= 0)
+    {
+        return scale;
+    }
+
+    if (settleCount > 0)
+    {
+        settleCount--;
+        return scale;
+    }
+
+    averageMs = averageMs > 0 ? averageMs + (frameMs - averageMs) * smoothing : frameMs;
+
+    overCount = frameMs > settings.targetMs ? overCount + 1 : 0;
+    underCount = frameMs < settings.targetMs * settings.headroom ? underCount + 1 : 0;
+
+    // Aims between the headroom and the target, so a raise doesn't land right back over it
+    const float aimMs = settings.targetMs * (1 + settings.headroom) * 0.5f;
+    if (overCount >= settings.dropFrames && scale > settings.minScale)
+    {
+        change(scale * std::sqrt(aimMs / std::max(averageMs, frameMs)), false);
+    }
+    else if (underCount >= settings.raiseFrames && scale < settings.maxScale)
+    {
+        change(scale * std::sqrt(aimMs / averageMs), true);
+    }
+    return scale;
+}
+
+void ResolutionController::reset()
+{
+    scale = settings.maxScale;
+    averageMs = 0;
+    overCount = 0;
+    underCount = 0;
+    settleCount = 0;
+}
+
+void ResolutionController::change(float desired, bool raise)
+{
+    desired = std::min(std::max(desired, scale - settings.maxStep), scale + settings.maxStep);
+
+    // Rounded down either way, a drop moves at least one step so a frame time just over the target still gets one
+    const float granularity = settings.granularity;
+    desired = std::floor(desired / granularity + 0.001f) * granularity;
+    if (!raise)
+    {
+        desired = std::min(desired, scale - granularity);
+    }
+    desired = std::min(std::max(desired, settings.minScale), settings.maxScale);
+
+    overCount = 0;
+    underCount = 0;
+    if (std::abs(desired - scale) < granularity * 0.5f)
+    {
+        return;
+    }
+
+    // The average carries on from what the new pixel count should cost
+    averageMs *= (desired * desired) / (scale * scale);
+    scale = desired;
+    settleCount = settings.settleFrames;
+    changeCount++;
+}
+}
@@ -0,0 +1,75 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+
+// Picks the render scale of the 3D scene from frame times, kept free of any graphics API so recorded frame time traces can
+// be replayed through it. The scene's cost goes roughly with its pixel count, so the scale that would hit the target is the
+// current one times sqrt(target / frame time). Drops follow a few slow frames, raises wait for a long stretch of fast ones
+// and every change is followed by a settling period, so a single hitch doesn't make the resolution pump.
+namespace utinni::gpu
+{
+class UTINNI_API ResolutionController
+{
+public:
+    struct Settings
+    {
+        float targetMs = 1000.0f / 60.0f;
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+        float headroom = 0.85f;     // Raises only happen while frames are below this fraction of the target
+        float maxStep = 0.1f;       // Largest change of the scale in one adjustment
+        float granularity = 0.05f;  // Scales are multiples of this, so the resolution isn't nudged every frame
+        uint32_t dropFrames = 4;    // Consecutive frames over the target before dropping
+        uint32_t raiseFrames = 60;  // Consecutive frames below the headroom before raising
+        uint32_t settleFrames = 8;  // Frames ignored after a change, the timings lag the device by a few frames
+    };
+
+    void setSettings(const Settings& settings);
+    const Settings& getSettings() const { return settings; }
+
+    // Feeds the time of the last frame, returns the scale of the next. Times of zero or less are ignored
+    float update(float frameMs);
+
+    // Back to the max scale, with no frame history
+    void reset();
+
+    float getScale() const { return scale; }
+    float getAverageMs() const { return averageMs; }
+    uint64_t getChangeCount() const { return changeCount; }
+
+private:
+    void change(float desired, bool raise);
+
+    Settings settings;
+    float scale = 1;
+    float averageMs = 0;
+    uint32_t overCount = 0;
+    uint32_t underCount = 0;
+    uint32_t settleCount = 0;
+    uint64_t changeCount = 0;
+};
+}
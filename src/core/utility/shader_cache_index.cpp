@@ -0,0 +1,210 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "shader_cache_index.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+constexpr uint32_t fileMagic = 0x43535455; // UTSC
+constexpr uint32_t fileVersion = 1;
+
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+uint64_t hashString(const std::string& value, uint64_t seed)
+{
+    // The terminator keeps "ab" + "c" apart from "a" + "bc"
+    return utinni::shaderCache::hash(value.c_str(), value.size() + 1, seed);
+}
+}
+
+namespace utinni::shaderCache
+{
+uint64_t hash(const void* data, size_t size, uint64_t seed)
+{
+    const auto bytes = static_cast<const uint8_t*>(data);
+    uint64_t result = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        result ^= bytes[i];
+        result *= 1099511628211ull;
+    }
+    return result;
+}
+
+uint64_t makeKey(uint64_t sourceHash, const std::string& profile, const std::string& entry, std::vector<Define> defines)
+{
+    std::sort(defines.begin(), defines.end(), [](const Define& a, const Define& b) { return a.name < b.name || (a.name == b.name && a.value < b.value); });
+
+    uint64_t key = hash(&sourceHash, sizeof(sourceHash));
+    key = hashString(profile, key);
+    key = hashString(entry, key);
+    for (const Define& define : defines)
+    {
+        key = hashString(define.name, key);
+        key = hashString(define.value, key);
+    }
+    return key;
+}
+
+std::string getFileName(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.cso", (unsigned long long)key);
+    return name;
+}
+
+std::vector<uint8_t> pack(uint64_t key, const std::vector<uint8_t>& bytecode)
+{
+    const FileHeader header{ fileMagic, fileVersion, key, bytecode.size(), hash(bytecode.data(), bytecode.size()) };
+
+    std::vector<uint8_t> file(sizeof(header) + bytecode.size());
+    memcpy(file.data(), &header, sizeof(header));
+    if (!bytecode.empty())
+    {
+        memcpy(file.data() + sizeof(header), bytecode.data(), bytecode.size());
+    }
+    return file;
+}
+
+bool unpack(const std::vector<uint8_t>& file, uint64_t key, std::vector<uint8_t>& bytecode)
+{
+    FileHeader header;
+    if (file.size() < sizeof(header))
+    {
+        return false;
+    }
+
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != fileMagic || header.version != fileVersion || header.key != key || header.size != file.size() - sizeof(header))
+    {
+        return false;
+    }
+
+    const uint8_t* data = file.data() + sizeof(header);
+    if (hash(data, (size_t)header.size) != header.checksum)
+    {
+        return false;
+    }
+
+    bytecode.assign(data, data + header.size);
+    return true;
+}
+
+std::string Index::serialize() const
+{
+    std::ostringstream stream;
+    stream << "session " << session << "\n";
+    char line[64];
+    for (const auto& entry : entries)
+    {
+        snprintf(line, sizeof(line), "%016llx %llu %u\n", (unsigned long long)entry.first, (unsigned long long)entry.second.size, entry.second.lastUsed);
+        stream << line;
+    }
+    return stream.str();
+}
+
+void Index::deserialize(const std::string& text)
+{
+    entries.clear();
+    totalSize = 0;
+    session = 0;
+
+    std::istringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        std::istringstream fields(line);
+        uint64_t key = 0;
+        uint64_t size = 0;
+        uint32_t lastUsed = 0;
+        if (line.compare(0, 8, "session ") == 0)
+        {
+            fields.ignore(8);
+            fields >> session;
+        }
+        else if (fields >> std::hex >> key >> std::dec >> size >> lastUsed)
+        {
+            remove(key);
+            entries[key] = Entry{ size, lastUsed };
+            totalSize += size;
+        }
+    }
+}
+
+void Index::touch(uint64_t key, uint64_t size)
+{
+    remove(key);
+    entries[key] = Entry{ size, session };
+    totalSize += size;
+}
+
+void Index::remove(uint64_t key)
+{
+    const auto it = entries.find(key);
+    if (it != entries.end())
+    {
+        totalSize -= it->second.size;
+        entries.erase(it);
+    }
+}
+
+std::vector<uint64_t> Index::evict(uint64_t maxBytes)
+{
+    std::vector<uint64_t> evicted;
+    if (totalSize <= maxBytes)
+    {
+        return evicted;
+    }
+
+    std::vector<std::pair<uint32_t, uint64_t>> byAge;
+    byAge.reserve(entries.size());
+    for (const auto& entry : entries)
+    {
+        byAge.emplace_back(entry.second.lastUsed, entry.first);
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    for (const auto& entry : byAge)
+    {
+        if (totalSize <= maxBytes)
+        {
+            break;
+        }
+        remove(entry.second);
+        evicted.push_back(entry.second);
+    }
+    return evicted;
+}
+}
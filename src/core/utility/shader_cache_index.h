@@ -0,0 +1,89 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// The graphics API free half of the shader cache: cache keys, the cache file format and the size limited index.
+// A key covers the source, the profile, the entry point and the defines, so editing a shader or compiling another
+// variant of it simply misses. Included files aren't part of the key.
+namespace utinni::shaderCache
+{
+struct Define
+{
+    std::string name;
+    std::string value;
+};
+
+constexpr uint64_t hashSeed = 14695981039346656037ull;
+
+// 64 bit FNV-1a
+UTINNI_API uint64_t hash(const void* data, size_t size, uint64_t seed = hashSeed);
+
+// Defines are sorted first, the order they're passed in doesn't change the compiled shader
+UTINNI_API uint64_t makeKey(uint64_t sourceHash, const std::string& profile, const std::string& entry, std::vector<Define> defines);
+UTINNI_API std::string getFileName(uint64_t key);
+
+// Cache files are a header with the key, size and a checksum followed by the bytecode. A file for another key, a truncated
+// one or one with a bad checksum doesn't unpack and counts as a miss
+UTINNI_API std::vector<uint8_t> pack(uint64_t key, const std::vector<uint8_t>& bytecode);
+UTINNI_API bool unpack(const std::vector<uint8_t>& file, uint64_t key, std::vector<uint8_t>& bytecode);
+
+// Which cache files exist and when they were last used, the least recently used are evicted past the size limit
+class UTINNI_API Index
+{
+public:
+    struct Entry
+    {
+        uint64_t size;
+        uint32_t lastUsed; // Session
+    };
+
+    // Text, one "key size lastUsed" line per entry after a "session N" line. Unreadable lines are skipped
+    std::string serialize() const;
+    void deserialize(const std::string& text);
+
+    void beginSession() { session++; }
+    uint32_t getSession() const { return session; }
+
+    bool contains(uint64_t key) const { return entries.find(key) != entries.end(); }
+    void touch(uint64_t key, uint64_t size);
+    void remove(uint64_t key);
+
+    // Removes the least recently used entries until the total fits, returns the removed keys so their files can be deleted
+    std::vector<uint64_t> evict(uint64_t maxBytes);
+
+    uint64_t getTotalSize() const { return totalSize; }
+    size_t getCount() const { return entries.size(); }
+
+private:
+    std::map<uint64_t, Entry> entries;
+    uint64_t totalSize = 0;
+    uint32_t session = 0;
+};
+}
@@ -0,0 +1,687 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "software_fx.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <emmintrin.h>
+
+namespace
+{
+using namespace utinni::softwareFx;
+
+constexpr uint32_t bandRows = 32;
+constexpr uint32_t standaloneStages = Stage_Ascii | Stage_8Bit;
+
+// Runs function(firstRow, endRow) over bands of rows, spread over up to threadCount threads including the calling one
+template <typename Function>
+void forEachBand(uint32_t height, uint32_t threadCount, const Function& function)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    const uint32_t bandCount = (height + bandRows - 1) / bandRows;
+    threadCount = std::min(threadCount, bandCount);
+
+    std::atomic<uint32_t> nextBand(0);
+    const auto worker = [&]()
+    {
+        for (uint32_t band = nextBand++; band < bandCount; band = nextBand++)
+        {
+            const uint32_t firstRow = band * bandRows;
+            function(firstRow, std::min(firstRow + bandRows, height));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+uint8_t quantize(float value)
+{
+    return (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+__m128 loadPixel(const uint8_t* pixel)
+{
+    int32_t packed;
+    std::memcpy(&packed, pixel, sizeof(packed));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    return _mm_mul_ps(_mm_cvtepi32_ps(channels), _mm_set1_ps(1.0f / 255.0f));
+}
+
+__m128 saturate(__m128 colour)
+{
+    return _mm_min_ps(_mm_max_ps(colour, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+// Saturates and rounds to nearest like a write to an 8 bit target
+void storePixel(uint8_t* pixel, __m128 colour)
+{
+    const __m128 scaled = _mm_add_ps(_mm_mul_ps(saturate(colour), _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+    __m128i packed = _mm_cvttps_epi32(scaled);
+    packed = _mm_packs_epi32(packed, packed);
+    packed = _mm_packus_epi16(packed, packed);
+    const int32_t value = _mm_cvtsi128_si32(packed);
+    std::memcpy(pixel, &value, sizeof(value));
+}
+
+__m128 lerp(__m128 a, __m128 b, __m128 t)
+{
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+// SSE2 has no floor, truncating and stepping down negative fractions does the same in the 32 bit integer range
+__m128 floor4(__m128 value)
+{
+    const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+}
+
+__m128 alphaMask()
+{
+    return _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+}
+
+// Colour channels from colour and alpha from alpha
+__m128 withAlpha(__m128 colour, __m128 alpha)
+{
+    const __m128 mask = alphaMask();
+    return _mm_or_ps(_mm_and_ps(mask, alpha), _mm_andnot_ps(mask, colour));
+}
+
+__m128 withOpaqueAlpha(__m128 colour)
+{
+    return withAlpha(colour, _mm_set1_ps(1.0f));
+}
+
+int32_t addressTexel(int32_t texel, int32_t size, Address address)
+{
+    if (address == Address::clamp)
+    {
+        return std::min(std::max(texel, 0), size - 1);
+    }
+
+    texel %= size;
+    return texel < 0 ? texel + size : texel;
+}
+
+// Samples a texture at normalized coordinates the way the hardware does, fetch(x, y) returns a texel
+template <typename Fetch>
+__m128 sampleTexture(float u, float v, int32_t width, int32_t height, const Sampler& sampler, const Fetch& fetch)
+{
+    if (sampler.filter == Filter::point)
+    {
+        const int32_t x = addressTexel((int32_t)std::floor(u * (float)width), width, sampler.address);
+        const int32_t y = addressTexel((int32_t)std::floor(v * (float)height), height, sampler.address);
+        return fetch(x, y);
+    }
+
+    const float x = u * (float)width - 0.5f;
+    const float y = v * (float)height - 0.5f;
+    const float x0 = std::floor(x);
+    const float y0 = std::floor(y);
+    const int32_t left = addressTexel((int32_t)x0, width, sampler.address);
+    const int32_t right = addressTexel((int32_t)x0 + 1, width, sampler.address);
+    const int32_t top = addressTexel((int32_t)y0, height, sampler.address);
+    const int32_t bottom = addressTexel((int32_t)y0 + 1, height, sampler.address);
+
+    const __m128 fractionX = _mm_set1_ps(x - x0);
+    const __m128 topRow = lerp(fetch(left, top), fetch(right, top), fractionX);
+    const __m128 bottomRow = lerp(fetch(left, bottom), fetch(right, bottom), fractionX);
+    return lerp(topRow, bottomRow, _mm_set1_ps(y - y0));
+}
+
+// sampleAs3DTexture from grading.ps. Its texel coordinates split into a part per channel, so they're worked out once for
+// every 8 bit value and grading a pixel comes down to eight LUT fetches. The coordinates never leave the texel centres of
+// the slice, so the addressing mode doesn't matter
+class LutLookup
+{
+public:
+    LutLookup(const Lut& lut, const Sampler& sampler) : lut(lut)
+    {
+        const int32_t size = (int32_t)lut.getSize();
+        const float width = (float)size;
+
+        for (uint32_t value = 0; value < 256; ++value)
+        {
+            const float texel = (float)value * (1.0f / 255.0f) * (width - 1.0f);
+
+            const float zSlice0 = std::min(std::floor(texel), width - 1.0f);
+            const float zSlice1 = std::min(zSlice0 + 1.0f, width - 1.0f);
+            slices[value] = { (int32_t)zSlice0 * size, (int32_t)zSlice1 * size, texel - zSlice0 };
+
+            if (sampler.filter == Filter::linear)
+            {
+                const float texel0 = std::floor(texel);
+                axes[value] = { (int32_t)texel0, std::min((int32_t)texel0 + 1, size - 1), texel - texel0 };
+            }
+            else
+            {
+                const int32_t nearest = std::min((int32_t)std::floor(texel + 0.5f), size - 1);
+                axes[value] = { nearest, nearest, 0.0f };
+            }
+        }
+    }
+
+    __m128 sample(const uint8_t* pixel) const
+    {
+        const Axis& x = axes[pixel[0]];
+        const Axis& y = axes[pixel[1]];
+        const Axis& z = slices[pixel[2]];
+        const __m128 fractionX = _mm_set1_ps(x.fraction);
+        const __m128 fractionY = _mm_set1_ps(y.fraction);
+        const __m128 slice0Colour = sampleSlice(z.index0, x, y, fractionX, fractionY);
+        const __m128 slice1Colour = sampleSlice(z.index1, x, y, fractionX, fractionY);
+        return lerp(slice0Colour, slice1Colour, _mm_set1_ps(z.fraction));
+    }
+
+private:
+    struct Axis
+    {
+        int32_t index0;
+        int32_t index1;
+        float fraction;
+    };
+
+    __m128 sampleSlice(int32_t slice, const Axis& x, const Axis& y, __m128 fractionX, __m128 fractionY) const
+    {
+        const __m128 top = lerp(_mm_loadu_ps(lut.getTexel(slice + x.index0, y.index0)), _mm_loadu_ps(lut.getTexel(slice + x.index1, y.index0)), fractionX);
+        const __m128 bottom = lerp(_mm_loadu_ps(lut.getTexel(slice + x.index0, y.index1)), _mm_loadu_ps(lut.getTexel(slice + x.index1, y.index1)), fractionX);
+        return lerp(top, bottom, fractionY);
+    }
+
+    const Lut& lut;
+    Axis axes[256]; // Red across a slice and green down it
+    Axis slices[256]; // Texel offset of the slice
+};
+
+void prepare(const Image& src, Image& dst)
+{
+    if (dst.width != src.width || dst.height != src.height || dst.pixels.size() != src.pixels.size())
+    {
+        dst = Image(src.width, src.height);
+    }
+}
+
+// Stages that map every channel on its own from an 8 bit value are a table lookup, alpha is passed through
+void applyTables(const Image& src, Image& dst, const uint8_t (&tables)[3][256], const Settings& settings)
+{
+    prepare(src, dst);
+    forEachBand(src.height, settings.threadCount, [&](uint32_t firstRow, uint32_t endRow)
+    {
+        for (uint32_t y = firstRow; y < endRow; ++y)
+        {
+            const uint8_t* in = src.getRow(y);
+            uint8_t* out = dst.getRow(y);
+            for (uint32_t x = 0; x < src.width; ++x, in += 4, out += 4)
+            {
+                out[0] = tables[0][in[0]];
+                out[1] = tables[1][in[1]];
+                out[2] = tables[2][in[2]];
+                out[3] = in[3];
+            }
+        }
+    });
+}
+
+// colour() from fused.ps, lutLookup is only set for grading
+__m128 applyColour(const uint8_t* pixel, uint32_t stages, __m128 tone, const LutLookup* lutLookup)
+{
+    if (lutLookup != nullptr)
+    {
+        return saturate(lutLookup->sample(pixel));
+    }
+
+    const __m128 colour = loadPixel(pixel);
+    return (stages & Stage_Hue) ? saturate(_mm_mul_ps(colour, tone)) : colour;
+}
+
+// Indexed by the value scaled to 16 bits, close enough that the 8 bit result is at most one step off a real pow
+std::vector<uint8_t> makeFineGammaTable(float gamma)
+{
+    std::vector<uint8_t> table(65536);
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        table[i] = quantize(std::pow((float)i / 65535.0f, 1.0f / gamma));
+    }
+    return table;
+}
+
+const int32_t asciiCharacters[16] = { 0, 4194304, 131200, 324, 330, 283712, 12650880, 4532768, 13191552, 10648704, 11195936,
+                                      15218734, 15255086, 15252014, 15324974, 11512810 };
+
+const float ditherTable[4][4] = {
+    { -4.0f, 0.0f, -3.0f, 1.0f },
+    { 2.0f, -2.0f, 3.0f, -1.0f },
+    { -3.0f, 1.0f, -4.0f, 0.0f },
+    { 3.0f, -1.0f, 2.0f, -2.0f },
+};
+}
+
+namespace utinni::softwareFx
+{
+void swapRedBlue(Image& image)
+{
+    for (size_t i = 0; i + 3 < image.pixels.size(); i += 4)
+    {
+        std::swap(image.pixels[i], image.pixels[i + 2]);
+    }
+}
+
+bool Lut::load(const Image& strip)
+{
+    if (strip.height == 0 || strip.width != strip.height * strip.height || strip.pixels.size() != (size_t)strip.width * strip.height * 4)
+    {
+        return false;
+    }
+
+    size = strip.height;
+    texels.resize(strip.pixels.size());
+    for (size_t i = 0; i < texels.size(); ++i)
+    {
+        texels[i] = (float)strip.pixels[i] / 255.0f;
+    }
+    return true;
+}
+
+void hue(const Image& src, Image& dst, const Settings& settings)
+{
+    uint8_t tables[3][256];
+    for (uint32_t channel = 0; channel < 3; ++channel)
+    {
+        for (uint32_t value = 0; value < 256; ++value)
+        {
+            tables[channel][value] = quantize((float)value / 255.0f * settings.tone[channel]);
+        }
+    }
+    applyTables(src, dst, tables, settings);
+}
+
+void grading(const Image& src, Image& dst, const Settings& settings)
+{
+    if (settings.lut == nullptr || settings.lut->getSize() == 0)
+    {
+        dst = src;
+        return;
+    }
+
+    prepare(src, dst);
+    const LutLookup lutLookup(*settings.lut, settings.lutSampler);
+    forEachBand(src.height, settings.threadCount, [&](uint32_t firstRow, uint32_t endRow)
+    {
+        for (uint32_t y = firstRow; y < endRow; ++y)
+        {
+            const uint8_t* in = src.getRow(y);
+            uint8_t* out = dst.getRow(y);
+            for (uint32_t x = 0; x < src.width; ++x, in += 4, out += 4)
+            {
+                storePixel(out, withAlpha(lutLookup.sample(in), loadPixel(in)));
+            }
+        }
+    });
+}
+
+void sharpen(const Image& src, Image& dst, const Settings& settings)
+{
+    prepare(src, dst);
+    const int32_t width = (int32_t)src.width;
+    const int32_t height = (int32_t)src.height;
+    const Address address = settings.sampler.address;
+    const __m128 amount = _mm_set1_ps(settings.sharpenAmount);
+    const __m128 four = _mm_set1_ps(4.0f);
+
+    forEachBand(src.height, settings.threadCount, [&](uint32_t firstRow, uint32_t endRow)
+    {
+        for (uint32_t y = firstRow; y < endRow; ++y)
+        {
+            const uint8_t* row = src.getRow(y);
+            const uint8_t* rowAbove = src.getRow(addressTexel((int32_t)y - 1, height, address));
+            const uint8_t* rowBelow = src.getRow(addressTexel((int32_t)y + 1, height, address));
+            uint8_t* out = dst.getRow(y);
+            __m128 left = loadPixel(row + addressTexel(-1, width, address) * 4);
+            __m128 center = loadPixel(row);
+            for (int32_t x = 0; x < width; ++x, out += 4)
+            {
+                const __m128 top = loadPixel(rowAbove + x * 4);
+                const __m128 bottom = loadPixel(rowBelow + x * 4);
+                const __m128 right = loadPixel(row + (x + 1 < width ? x + 1 : addressTexel(x + 1, width, address)) * 4);
+
+                const __m128 edges = _mm_add_ps(_mm_add_ps(top, bottom), _mm_add_ps(left, right));
+                const __m128 sharp = _mm_add_ps(center, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(four, center), edges), amount));
+                storePixel(out, withOpaqueAlpha(sharp));
+
+                left = center;
+                center = right;
+            }
+        }
+    });
+}
+
+void gamma(const Image& src, Image& dst, const Settings& settings)
+{
+    uint8_t tables[3][256];
+    for (uint32_t value = 0; value < 256; ++value)
+    {
+        tables[0][value] = quantize(std::pow((float)value / 255.0f, 1.0f / settings.gamma));
+    }
+    std::memcpy(tables[1], tables[0], sizeof(tables[0]));
+    std::memcpy(tables[2], tables[0], sizeof(tables[0]));
+    applyTables(src, dst, tables, settings);
+}
+
+void eightBit(const Image& src, Image& dst, const Settings& settings)
+{
+    prepare(src, dst);
+    const int32_t width = (int32_t)src.width;
+    const int32_t height = (int32_t)src.height;
+    const float sizeX = settings.pixelFactor;
+    const float sizeY = settings.pixelFactor * (float)height / (float)width;
+    const __m128 colourFactor = _mm_set1_ps(settings.colourFactor);
+    const __m128 inverseColourFactor = _mm_set1_ps(1.0f / settings.colourFactor);
+    const auto fetch = [&src](int32_t x, int32_t y) { return loadPixel(src.getRow(y) + x * 4); };
+
+    forEachBand(src.height, settings.threadCount, [&](uint32_t firstRow, uint32_t endRow)
+    {
+        // Every pixel in a block has the same colour and every row in a block is the same, so only the first of each is worked out
+        float previousCoorY = -1.0f;
+        for (uint32_t y = firstRow; y < endRow; ++y)
+        {
+            const float coorY = std::floor((float)y / (float)height * sizeY);
+            uint8_t* out = dst.getRow(y);
+            if (coorY == previousCoorY)
+            {
+                std::memcpy(out, dst.getRow(y - 1), (size_t)width * 4);
+                continue;
+            }
+            previousCoorY = coorY;
+
+            float previousCoorX = -1.0f;
+            uint8_t block[4] = {};
+            for (int32_t x = 0; x < width; ++x, out += 4)
+            {
+                const float coorX = std::floor((float)x / (float)width * sizeX);
+                if (coorX != previousCoorX)
+                {
+                    previousCoorX = coorX;
+                    __m128 colour = sampleTexture(coorX / sizeX, coorY / sizeY, width, height, settings.sampler, fetch);
+
+                    const float dither = ditherTable[(int32_t)coorX % 4][(int32_t)coorY % 4] * 0.005f;
+                    colour = _mm_add_ps(colour, _mm_set1_ps(dither));
+                    colour = _mm_mul_ps(floor4(_mm_mul_ps(colour, colourFactor)), inverseColourFactor);
+                    storePixel(block, withOpaqueAlpha(colour));
+                }
+                std::memcpy(out, block, sizeof(block));
+            }
+        }
+    });
+}
+
+void ascii(const Image& src, Image& dst, const Settings& settings)
+{
+    prepare(src, dst);
+    forEachBand(src.height, settings.threadCount, [&](uint32_t firstRow, uint32_t endRow)
+    {
+        for (uint32_t y = firstRow; y < endRow; ++y)
+        {
+            const uint8_t* in = src.getRow(y);
+            uint8_t* out = dst.getRow(y);
+
+            // A 5x5 glyph in every 8x8 cell, everything around the glyphs is black whatever the colour
+            std::memset(out, 0, (size_t)src.width * 4);
+            for (uint32_t x = 0; x < src.width; ++x)
+            {
+                out[x * 4 + 3] = 255;
+            }
+
+            const int32_t cellY = 5 - (int32_t)(y % 8);
+            if (cellY < 0 || cellY > 4)
+            {
+                continue;
+            }
+
+            for (uint32_t x = 3; x < src.width; x += (x % 8) == 7 ? 4 : 1)
+            {
+                const uint8_t* pixel = in + x * 4;
+                float r = (float)pixel[0] / 255.0f;
+                float g = (float)pixel[1] / 255.0f;
+                float b = (float)pixel[2] / 255.0f;
+
+                // Greenscreen
+                const float diffR = r;
+                const float diffG = g - 1.0f;
+                const float diffB = b;
+                const float distance = 0.28f * std::sqrt(diffR * diffR * (0.5f * diffR + 2.0f) + diffG * diffG * 4.0f + diffB * diffB * (-0.5f * diffR + 3.0f));
+                if (!(distance > 0.35f))
+                {
+                    continue;
+                }
+
+                const float luma = std::min(std::max(r * 0.2126f + g * 0.7152f + b * 0.0722f, 0.0f), 1.0f);
+                const float gray = luma * luma * (3.0f - 2.0f * luma);
+
+                // The shader compares against every n / 16, scaling by 16 is exact so this picks the same character
+                const uint32_t character = std::min((uint32_t)(gray * 16.0f), 15u);
+
+                // Bit 5 * row + column of the character
+                const int32_t cellX = (int32_t)(x % 8) - 3;
+                if ((asciiCharacters[character] >> (5 * cellY + cellX)) & 1)
+                {
+                    out[x * 4] = pixel[0];
+                    out[x * 4 + 1] = pixel[1];
+                    out[x * 4 + 2] = pixel[2];
+                }
+            }
+        }
+    });
+}
+
+void fused(const Image& src, Image& dst, uint32_t stages, const Settings& settings)
+{
+    prepare(src, dst);
+    const int32_t width = (int32_t)src.width;
+    const int32_t height = (int32_t)src.height;
+    const Address address = settings.sampler.address;
+    const bool sharpening = (stages & Stage_Sharpen) != 0;
+    const __m128 tone = _mm_setr_ps(settings.tone[0], settings.tone[1], settings.tone[2], 1.0f);
+    const __m128 amount = _mm_set1_ps(settings.sharpenAmount);
+    const __m128 four = _mm_set1_ps(4.0f);
+
+    std::unique_ptr<LutLookup> lutLookup;
+    if ((stages & Stage_Grading) && !(stages & Stage_Hue) && settings.lut != nullptr && settings.lut->getSize() != 0)
+    {
+        lutLookup = std::make_unique<LutLookup>(*settings.lut, settings.lutSampler);
+    }
+
+    std::vector<uint8_t> gammaTable;
+    if (stages & Stage_Gamma)
+    {
+        gammaTable = makeFineGammaTable(settings.gamma);
+    }
+
+    forEachBand(src.height, settings.threadCount, [&](uint32_t firstRow, uint32_t endRow)
+    {
+        // The coloured rows of the band plus one above and below for sharpen, so every tap is only coloured once
+        const int32_t halo = sharpening ? 1 : 0;
+        const int32_t bufferRows = (int32_t)(endRow - firstRow) + halo * 2;
+        std::vector<float> coloured((size_t)bufferRows * width * 4);
+        for (int32_t row = 0; row < bufferRows; ++row)
+        {
+            const uint8_t* in = src.getRow(addressTexel((int32_t)firstRow - halo + row, height, address));
+            float* out = coloured.data() + (size_t)row * width * 4;
+            for (int32_t x = 0; x < width; ++x)
+            {
+                _mm_storeu_ps(out + x * 4, applyColour(in + x * 4, stages, tone, lutLookup.get()));
+            }
+        }
+
+        for (uint32_t y = firstRow; y < endRow; ++y)
+        {
+            const float* row = coloured.data() + (size_t)(y - firstRow + halo) * width * 4;
+            const float* rowAbove = row - (sharpening ? width * 4 : 0);
+            const float* rowBelow = row + (sharpening ? width * 4 : 0);
+            uint8_t* out = dst.getRow(y);
+            for (int32_t x = 0; x < width; ++x, out += 4)
+            {
+                __m128 colour = _mm_loadu_ps(row + x * 4);
+                if (sharpening)
+                {
+                    const __m128 top = _mm_loadu_ps(rowAbove + x * 4);
+                    const __m128 bottom = _mm_loadu_ps(rowBelow + x * 4);
+                    const __m128 left = _mm_loadu_ps(row + (x > 0 ? x - 1 : addressTexel(x - 1, width, address)) * 4);
+                    const __m128 right = _mm_loadu_ps(row + (x + 1 < width ? x + 1 : addressTexel(x + 1, width, address)) * 4);
+                    const __m128 edges = _mm_add_ps(_mm_add_ps(top, bottom), _mm_add_ps(left, right));
+                    colour = saturate(_mm_add_ps(colour, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(four, colour), edges), amount)));
+                }
+
+                if (gammaTable.empty())
+                {
+                    storePixel(out, withOpaqueAlpha(colour));
+                }
+                else
+                {
+                    int32_t indices[4];
+                    _mm_storeu_si128((__m128i*)indices, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(colour, _mm_set1_ps(65535.0f)), _mm_set1_ps(0.5f))));
+                    out[0] = gammaTable[indices[0]];
+                    out[1] = gammaTable[indices[1]];
+                    out[2] = gammaTable[indices[2]];
+                    out[3] = 255;
+                }
+            }
+        }
+    });
+}
+
+void process(const Image& src, Image& dst, uint32_t stages, const Settings& settings, bool fuse)
+{
+    std::vector<uint32_t> chain;
+    if (stages & Stage_Hue)
+    {
+        chain.push_back(Stage_Hue);
+    }
+    else if ((stages & Stage_Grading) && settings.lut != nullptr)
+    {
+        chain.push_back(Stage_Grading);
+    }
+
+    if (stages & Stage_Ascii)
+    {
+        chain.push_back(Stage_Ascii);
+    }
+    else if (stages & Stage_8Bit)
+    {
+        chain.push_back(Stage_8Bit);
+    }
+    else if (stages & Stage_Sharpen)
+    {
+        chain.push_back(Stage_Sharpen);
+    }
+
+    if (stages & Stage_Gamma)
+    {
+        chain.push_back(Stage_Gamma);
+    }
+
+    std::vector<uint32_t> passes;
+    uint32_t fusedStages = 0;
+    for (const uint32_t stage : chain)
+    {
+        if (!fuse || (stage & standaloneStages) != 0)
+        {
+            if (fusedStages != 0)
+            {
+                passes.push_back(fusedStages);
+                fusedStages = 0;
+            }
+            passes.push_back(stage);
+        }
+        else
+        {
+            fusedStages |= stage;
+        }
+    }
+
+    if (fusedStages != 0)
+    {
+        passes.push_back(fusedStages);
+    }
+
+    if (passes.empty())
+    {
+        dst = src;
+        return;
+    }
+
+    Image scratch[2];
+    const Image* input = &src;
+    for (size_t i = 0; i < passes.size(); ++i)
+    {
+        Image& output = i + 1 == passes.size() ? dst : scratch[i % 2];
+        if (fuse && (passes[i] & standaloneStages) == 0)
+        {
+            fused(*input, output, passes[i], settings);
+        }
+        else if (passes[i] == Stage_Hue)
+        {
+            hue(*input, output, settings);
+        }
+        else if (passes[i] == Stage_Grading)
+        {
+            grading(*input, output, settings);
+        }
+        else if (passes[i] == Stage_Sharpen)
+        {
+            sharpen(*input, output, settings);
+        }
+        else if (passes[i] == Stage_Gamma)
+        {
+            gamma(*input, output, settings);
+        }
+        else if (passes[i] == Stage_Ascii)
+        {
+            ascii(*input, output, settings);
+        }
+        else
+        {
+            eightBit(*input, output, settings);
+        }
+        input = &output;
+    }
+}
+}
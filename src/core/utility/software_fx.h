@@ -0,0 +1,124 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include "utinni.h"
+#include <vector>
+
+// CPU versions of the SytnersFX post process shaders in data/shaders, for checking the shaders against, grading
+// screenshots offline and as a fallback when the shaders can't be used. Images are RGBA8 and every stage follows the
+// sampling and 8 bit rounding of its shader. They haven't been compared against GPU captures, expect differences from the
+// GPU's lower LUT filtering precision at least. Rows are split over threads and each pixel is processed with SSE2.
+namespace utinni::softwareFx
+{
+struct Image
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels; // RGBA, rows tightly packed
+
+    Image() = default;
+    Image(uint32_t width, uint32_t height) : width(width), height(height), pixels((size_t)width * height * 4) {}
+
+    uint8_t* getRow(uint32_t y) { return pixels.data() + (size_t)y * width * 4; }
+    const uint8_t* getRow(uint32_t y) const { return pixels.data() + (size_t)y * width * 4; }
+};
+
+// Read back D3DFMT_A8R8G8B8 surfaces are BGRA in memory
+UTINNI_API void swapRedBlue(Image& image);
+
+// The texture sampler state the shaders run with, the client leaves it to whatever it set last
+enum class Filter
+{
+    point,
+    linear
+};
+
+enum class Address
+{
+    wrap,
+    clamp
+};
+
+struct Sampler
+{
+    Filter filter = Filter::linear;
+    Address address = Address::clamp;
+};
+
+// The grading LUT as grading.ps samples it, a strip of size slices of size x size texels side by side
+class UTINNI_API Lut
+{
+public:
+    // Returns false unless the strip is size * size wide and size high
+    bool load(const Image& strip);
+
+    uint32_t getSize() const { return size; }
+    const float* getTexel(uint32_t x, uint32_t y) const { return texels.data() + ((size_t)y * size * size + x) * 4; }
+
+private:
+    uint32_t size = 0;
+    std::vector<float> texels; // RGBA 0-1
+};
+
+// Same bits as the SytnersFX stages
+enum Stage : uint32_t
+{
+    Stage_Hue = 1 << 0,
+    Stage_Grading = 1 << 1,
+    Stage_Sharpen = 1 << 2,
+    Stage_Gamma = 1 << 3,
+    Stage_Ascii = 1 << 4,
+    Stage_8Bit = 1 << 5,
+};
+
+struct Settings
+{
+    float tone[3] = { 1, 1, 1 };   // hue.ps
+    const Lut* lut = nullptr;      // grading.ps, the stage is skipped without one
+    float sharpenAmount = 0;       // sharpen.ps
+    float gamma = 1;               // gamma.ps
+    float pixelFactor = 200;       // 8bit.ps
+    float colourFactor = 8;        // 8bit.ps
+    Sampler sampler;               // gbuffer0
+    Sampler lutSampler;            // lut
+    uint32_t threadCount = 0;      // 0 uses every hardware thread
+};
+
+// A single shader pass each. src and dst can't be the same image, dst is resized to match src
+UTINNI_API void hue(const Image& src, Image& dst, const Settings& settings);
+UTINNI_API void grading(const Image& src, Image& dst, const Settings& settings);
+UTINNI_API void sharpen(const Image& src, Image& dst, const Settings& settings);
+UTINNI_API void gamma(const Image& src, Image& dst, const Settings& settings);
+UTINNI_API void eightBit(const Image& src, Image& dst, const Settings& settings);
+UTINNI_API void ascii(const Image& src, Image& dst, const Settings& settings);
+
+// fused.ps, stages is any mix of Stage_Hue or Stage_Grading, Stage_Sharpen and Stage_Gamma
+UTINNI_API void fused(const Image& src, Image& dst, uint32_t stages, const Settings& settings);
+
+// The whole SytnersFX chain for the given stages in the order the plugin runs them: colour (hue or grading), then ascii,
+// 8-bit or sharpen, then gamma. fuse runs the per pixel stages through fused() like the plugin's fused passes do
+UTINNI_API void process(const Image& src, Image& dst, uint32_t stages, const Settings& settings, bool fuse);
+}
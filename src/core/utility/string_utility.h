@@ -27,6 +27,7 @@
 #include "utinni.h"
 #include <sstream>
 #include <iomanip>
+#include <cstdio>
 
 constexpr static const char* trimableChars = " \t\n\r\f\v";
 
@@ -101,6 +102,63 @@ inline std::string trimEnd_copy(std::string input, const char* trimChars = trima
     return trim(input, trimChars);
 }
 
+// Escapes quotes, backslashes and control characters so the result can be placed inside a JSON string literal
+inline std::string toJsonEscaped(const char* input)
+{
+    std::string result;
+    if (input == nullptr)
+    {
+        return result;
+    }
+
+    for (const char* c = input; *c != 0; ++c)
+    {
+        switch (*c)
+        {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if ((unsigned char)*c < 0x20)
+            {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned int)(unsigned char)*c);
+                result += buffer;
+            }
+            else
+            {
+                result += *c;
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+// Doubles quotes so the result can be placed inside a quoted CSV field
+inline std::string toCsvEscaped(const char* input)
+{
+    std::string result;
+    if (input == nullptr)
+    {
+        return result;
+    }
+
+    for (const char* c = input; *c != 0; ++c)
+    {
+        if (*c == '"')
+        {
+            result += '"';
+        }
+        result += *c;
+    }
+
+    return result;
+}
+
 }
 
 namespace constCharUtility
@@ -27,10 +27,13 @@
 #include "plugin_framework/plugin_manager.h"
 #include "swg/appearance/skeleton.h"
 #include "swg/camera/debug_camera.h"
+#include "swg/camera/flythrough_benchmark.h"
 #include "swg/client/client.h"
 #include "swg/game/game.h"
 #include "swg/graphics/graphics.h"
+#include "swg/misc/allocation_tracker.h"
 #include "swg/misc/config.h"
+#include "swg/misc/frame_telemetry.h"
 #include "swg/misc/tree_file.h"
 #include "swg/object/creature_object.h"
 #include "swg/scene/client_world.h"
@@ -44,9 +47,22 @@
 #include "swg/ui/cui_misc.h"
 #include "swg/ui/cui_io.h"
 #include "swg/graphics/directx9.h"
+#include "swg/graphics/draw_stats.h"
+#include "swg/graphics/gpu_profiler.h"
+#include "swg/graphics/render_target_pool.h"
+#include "swg/graphics/readback.h"
+#include "swg/graphics/depth_pyramid.h"
+#include "swg/graphics/dynamic_resolution.h"
+#include "swg/graphics/shader_cache.h"
+#include "swg/graphics/state_cache.h"
 #include "swg/graphics/shader.h"
 #include "swg/graphics/post_processing.h"
 #include "swg/scene/render_world.h"
+#include "utility/address_resolver.h"
+#include "utility/callback_list.h"
+#include "utility/event_log.h"
+#include "utility/patch_transaction.h"
+#include "utility/profiler.h"
 #include "utility/log.h"
 #include "ini.h"
 
@@ -95,8 +111,15 @@ void createPatches()
 {
     utinni::log::info("Creating patches");
 
-    utinni::cuiMisc::patch();
-    utinni::debugCamera::patch();
+    // Collected into one transaction, so each touched page range only has its protection changed once
+    memory::PatchTransaction patches;
+    utinni::cuiMisc::patch(patches);
+    utinni::debugCamera::patch(patches);
+
+    if (!patches.commit())
+    {
+        utinni::log::error("Failed to apply patches");
+    }
 }
 
 void dllMain()
@@ -114,6 +137,26 @@ void dllMain()
     ini.load(path + "ut.ini");
 
     imgui_impl::enableInternalUi(ini.getBool("UtinniCore", "enableInternalUi"));
+    utinni::allocationTracker::enable(ini.getBool("AllocationTracking", "enabled"), ini.getInt("AllocationTracking", "sampleRate"));
+    utinni::profiler::enable(ini.getBool("Profiler", "enabled"));
+    utinni::callbackBudget::setBudgetMs(ini.getFloat("Profiler", "callbackBudgetMs"));
+    utinni::gpuProfiler::enable(ini.getBool("Profiler", "gpuTimings"));
+    utinni::drawStats::enable(ini.getBool("DrawStats", "enabled"));
+    utinni::drawStats::enableFileLog(utinni::drawStats::isEnabled() && ini.getBool("DrawStats", "logToFile"));
+    utinni::shaderCache::init(ini.getBool("ShaderCache", "enabled"), (uint64_t)ini.getInt("ShaderCache", "maxSizeMb") * 1024 * 1024);
+    utinni::stateCache::enableFiltering(ini.getBool("StateCache", "filterRedundant"));
+    utinni::renderTargetPool::setBudget((uint64_t)ini.getInt("RenderTargetPool", "budgetMb") * 1024 * 1024);
+    utinni::readback::configure((uint32_t)ini.getInt("Readback", "depth"));
+    utinni::depthPyramid::enable(ini.getBool("DepthPyramid", "enabled"));
+    utinni::dynamicResolution::configure(ini.getFloat("DynamicResolution", "targetFps"), ini.getFloat("DynamicResolution", "minScale"),
+                                         ini.getFloat("DynamicResolution", "sharpness"));
+    utinni::dynamicResolution::enable(ini.getBool("DynamicResolution", "enabled"));
+    utinni::eventLog::enable(ini.getBool("EventLog", "enabled"));
+    utinni::frameTelemetry::enable(ini.getBool("Telemetry", "enabled"));
+    utinni::flythroughBenchmark::enableAutoRun(ini.getBool("Benchmark", "autoRun"));
+
+    // Resolves the signature declared client addresses in one pass, or from the cache on a warm start
+    memory::ResolvedAddress::resolveAll();
 
     // Adds hooks to functions inside the game
     createDetours();
@@ -129,6 +172,13 @@ void dllMain()
 
 void detatch()
 {
+    if (utinni::frameTelemetry::isEnabled() && ini.getBool("Telemetry", "writeSessionReport"))
+    {
+        utinni::frameTelemetry::writeReport();
+    }
+    utinni::drawStats::enableFileLog(false);
+    utinni::shaderCache::shutdown();
+    utinni::log::flush();
 }
 
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
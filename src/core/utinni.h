@@ -35,7 +35,11 @@
 using swgptr = uint32_t;
 using byte = uint8_t;
 
-#ifdef BUILDING_CORE
+#if defined(UTINNI_STATIC)
+// Core sources compiled straight into a tool, see tools/micro_benchmarks
+#define UTINNI_API
+#define IMGUI_API
+#elif defined(BUILDING_CORE)
 #define UTINNI_API __declspec(dllexport)
 #define IMGUI_API  __declspec(dllexport)
 #else
@@ -46,7 +50,9 @@ using byte = uint8_t;
 #include <string>
 #include <vector>
 
+#ifdef _WIN32
 #include "DetourXS/detourxs.h"
+#endif
 
 namespace utinni
 {
@@ -26,7 +26,10 @@
 #include "swg/camera/camera.h"
 #include "swg/game/game.h"
 #include "swg/graphics/directx9.h"
+#include "swg/graphics/gpu_profiler.h"
 #include "swg/graphics/graphics.h"
+#include "swg/graphics/render_target_pool.h"
+#include "swg/graphics/shader_cache.h"
 #include "swg/misc/repository.h"
 #include "swg/misc/swg_math.h"
 #include "swg/object/player_object.h"
@@ -40,7 +43,16 @@
 #include <DirectXMath.h>
 #include "d3dx9.h"
 #include "swg/graphics/texture_resolver.h"
+#include "utility/colour_lut.h"
+#include "utility/depth_fx.h"
 #include "utility/log.h"
+#include "utility/profiler.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
 
 using namespace utinni;
 using namespace DirectX;
@@ -58,16 +70,24 @@ int getHeight()
 class SytnersFX : public UtinniPlugin
 {
 public:
+    ~SytnersFX() override
+    {
+        m_draw_ui_callback.remove();
+        m_resolve_callback.remove();
+    }
+
     void init() override
     {
-        imgui_impl::addRenderCallback([this]() {
+        m_draw_ui_callback = imgui_impl::addRenderCallback([this]() {
             this->drawUI();
-            });
+            }, "Sytner's FX", "drawUI");
 
         auto resolver = directX::getTextureResolver();
-        resolver->addCallback([this](IDirect3DDevice9* device, IDirect3DTexture9* depth, IDirect3DTexture9* color) {
+        m_resolve_callback = resolver->addCallback([this](IDirect3DDevice9* device, IDirect3DTexture9* depth, IDirect3DTexture9* color) {
             onCallback(device, depth, color);
-            });
+            }, "Sytner's FX", "postProcess");
+
+        requestShaders();
     }
 
     void drawUI()
@@ -77,6 +97,13 @@ public:
         ImGui::Begin("Sytner's FX", 0, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse); // ImVec2(250, 300), 0.9f,  ImGuiWindowFlags_NoResize |
         {
             ImGui::Checkbox("Enabled", &m_enabled);
+            ImGui::Checkbox("Fuse passes", &m_fuse_passes);
+            if (m_fuse_passes)
+            {
+                // A fused variant that is still compiling or failed to compile (see the log) falls back to the separate passes
+                ImGui::SameLine();
+                ImGui::TextDisabled(m_fused_pass_count >= 0 ? "(fused, %d pass(es))" : "(separate passes)", m_fused_pass_count);
+            }
             ImGui::CollapsingHeader("Fun", ImGuiTreeNodeFlags_DefaultOpen);
             ImGui::Checkbox("ASCII mode", &m_ascii_enabled);
             ImGui::Checkbox("8-bit mode", &m_8bit_enabled);
@@ -101,14 +128,82 @@ public:
                     m_color.z = col[2];
                 }
             }
-            if (m_colouring_mode == 2 && m_luts[m_lut_index] != nullptr)
+            if (m_colouring_mode == 2 && getSelectedLut() != nullptr)
             {
-                ImGui::Combo("LUT", &m_lut_index, "Default\0Sepia\0Mono\0Coronet\0Saturated");
+                ImGui::Combo("LUT", &m_lut_index, m_lut_names.data(), (int)m_lut_names.size());
 
                 D3DSURFACE_DESC lutDesc;
-                m_luts[m_lut_index]->GetLevelDesc(0, &lutDesc);
+                getSelectedLut()->GetLevelDesc(0, &lutDesc);
                 const ImVec2 size((float)lutDesc.Width, (float)lutDesc.Height);
-                ImGui::Image((void*)m_luts[m_lut_index], size);
+                ImGui::Image((void*)getSelectedLut(), size);
+            }
+
+            ImGui::Checkbox("Bake into one LUT", &m_bake_colour);
+            if (m_bake_colour)
+            {
+                ImGui::SliderFloat("Saturation", &m_saturation, 0, 2);
+                if (m_colouring_mode == 2 && !m_luts.empty())
+                {
+                    ImGui::Combo("Blend with", &m_blend_lut_index, m_lut_names.data(), (int)m_lut_names.size());
+                    ImGui::Checkbox("Blend by time of day", &m_blend_by_time);
+                    if (!m_blend_by_time)
+                    {
+                        ImGui::SliderFloat("Blend", &m_blend_amount, 0, 1);
+                    }
+                }
+
+                if (m_baked_lut != nullptr && m_baked_active)
+                {
+                    ImGui::Text(m_baked_gamma ? "Baked with gamma" : "Baked, gamma runs after sharpening");
+                    ImGui::Image((void*)m_baked_lut, ImVec2((float)(bakedLutSize * bakedLutSize) / 2, (float)bakedLutSize / 2));
+                }
+            }
+
+            drawDepthUi();
+        }
+    }
+
+    void drawDepthUi()
+    {
+        ImGui::CollapsingHeader("Depth", ImGuiTreeNodeFlags_DefaultOpen);
+        ImGui::Checkbox("Ambient occlusion", &m_ssao_enabled);
+        if (m_ssao_enabled)
+        {
+            if (ImGui::Combo("AO quality", &m_ssao_quality, depthFx::qualityNames, 4))
+            {
+                depthFx::applyPreset((depthFx::Quality)m_ssao_quality, m_ssao);
+            }
+            ImGui::SliderFloat("AO radius", &m_ssao.radius, 0.25f, 5);
+            ImGui::SliderFloat("AO intensity", &m_ssao.intensity, 0, 3);
+            ImGui::SliderFloat("AO strength", &m_ssao.strength, 0, 1);
+        }
+
+        ImGui::Checkbox("Depth of field", &m_dof_enabled);
+        if (m_dof_enabled)
+        {
+            if (ImGui::Combo("DOF quality", &m_dof_quality, depthFx::qualityNames, 4))
+            {
+                depthFx::applyPreset((depthFx::Quality)m_dof_quality, m_dof);
+            }
+            ImGui::Checkbox("Focus on the player", &m_dof_focus_player);
+            if (!m_dof_focus_player)
+            {
+                ImGui::SliderFloat("Focus distance", &m_dof.focusDistance, 1, 500);
+            }
+            ImGui::SliderFloat("Focus range", &m_dof.focusRange, 0, 50);
+            ImGui::SliderFloat("Blur range", &m_dof.blurRange, 1, 200);
+            ImGui::SliderFloat("Max blur", &m_dof.maxBlur, 1, 32);
+        }
+
+        // The passes' GPU times, the profiler only has them while GPU timings are on
+        if ((m_ssao_enabled || m_dof_enabled) && gpuProfiler::isEnabled())
+        {
+            for (const gpu::ZoneStats& zone : gpuProfiler::getAggregator().getZones())
+            {
+                if (strncmp(zone.name, "FX SSAO", 7) == 0 || strncmp(zone.name, "FX DOF", 6) == 0)
+                {
+                    ImGui::Text("%s: %.3f ms", zone.name, zone.averageMs);
+                }
             }
         }
     }
@@ -119,48 +214,138 @@ public:
         XMFLOAT2 uv;
     };
 
-    void loadShaderVS(IDirect3DDevice9* device, IDirect3DVertexShader9** ps, const char* name, const char* entry = "main")
-    {        
-        LPD3DXBUFFER dxShaderCode;
-        LPD3DXBUFFER errors = nullptr;
-        if (FAILED(D3DXCompileShaderFromFile((getPath() + "/shaders/" + std::string(name)).c_str(), nullptr, nullptr, entry,
-            "vs_3_0", 0, &dxShaderCode, &errors, nullptr))) {
-            log::error((const char*)errors->GetBufferPointer());
-            errors->Release();
+    // Compiled through the shader cache, a miss compiles in the background and the shader is created once it's ready. The
+    // requests are made in init, so by the first frame they're usually done
+    void requestShaders()
+    {
+        m_bin_grading = shaderCache::request("shaders/grading.ps", "ps_3_0");
+        m_bin_hue = shaderCache::request("shaders/hue.ps", "ps_3_0");
+        m_bin_gamma = shaderCache::request("shaders/gamma.ps", "ps_3_0");
+        m_bin_sharpen = shaderCache::request("shaders/sharpen.ps", "ps_3_0");
+        m_bin_ascii = shaderCache::request("shaders/ascii.ps", "ps_3_0");
+        m_bin_8bit = shaderCache::request("shaders/8bit.ps", "ps_3_0");
+        m_bin_fs_tri = shaderCache::request("shaders/fs_posn_uv.vs", "vs_3_0");
+
+        // Every variant the depth presets use
+        for (int quality = 0; quality < 4; ++quality)
+        {
+            depthFx::SsaoSettings ssao;
+            depthFx::DofSettings dof;
+            depthFx::applyPreset((depthFx::Quality)quality, ssao);
+            depthFx::applyPreset((depthFx::Quality)quality, dof);
+            requestDepthFxShader("ssao", { { "SAMPLES", std::to_string(ssao.sampleCount) } });
+            requestDepthFxShader("ssaoBlur", { { "RADIUS", std::to_string(ssao.blurRadius) } });
+            requestDepthFxShader("dofDownsample", { { "DIVISOR", std::to_string(dof.divisor) } });
+            requestDepthFxShader("dofBlur", { { "SAMPLES", std::to_string(dof.sampleCount) }, { "DIVISOR", std::to_string(dof.divisor) } });
+            requestDepthFxShader("dofCompose", { { "DIVISOR", std::to_string(dof.divisor) } });
+        }
+        requestDepthFxShader("ssaoApply", {});
+
+        // Every fused variant, so changing a setting doesn't wait on a compile
+        const uint32_t colourStages[] = { 0, Stage_Hue, Stage_Grading };
+        const uint32_t sharpenStages[] = { 0, Stage_Sharpen };
+        for (const uint32_t colour : colourStages)
+        {
+            for (const uint32_t sharpen : sharpenStages)
+            {
+                requestFusedShader(colour | sharpen);
+                requestFusedShader(colour | sharpen | Stage_Gamma);
+            }
         }
-        device->CreateVertexShader((DWORD*)dxShaderCode->GetBufferPointer(), ps);
-        dxShaderCode->Release();
     }
 
-    void loadShaderPS(IDirect3DDevice9* device, IDirect3DPixelShader9** ps, const char* name, const char* entry = "main")
+    void requestFusedShader(uint32_t stages)
     {
-        LPD3DXBUFFER dxShaderCode;
-        LPD3DXBUFFER errors = nullptr;
-        if (FAILED(D3DXCompileShaderFromFile((getPath() + "/shaders/" + std::string(name)).c_str(), nullptr, nullptr, entry,
-            "ps_3_0", 0, &dxShaderCode, &errors, nullptr))) {
-            log::error((const char*)errors->GetBufferPointer());
-            errors->Release();
+        if (stages == 0 || m_ps_fused.find(stages) != m_ps_fused.end())
+        {
+            return;
         }
-        device->CreatePixelShader((DWORD*)dxShaderCode->GetBufferPointer(), ps);
-        dxShaderCode->Release();
+
+        std::vector<shaderCache::Define> defines;
+        if (stages & Stage_Hue) { defines.push_back({ "HUE", "1" }); }
+        if (stages & Stage_Grading) { defines.push_back({ "GRADING", "1" }); }
+        if (stages & Stage_Sharpen) { defines.push_back({ "SHARPEN", "1" }); }
+        if (stages & Stage_Gamma) { defines.push_back({ "GAMMA", "1" }); }
+        m_ps_fused[stages].binary = shaderCache::request("shaders/fused.ps", "ps_3_0", "main", defines);
     }
 
+    CachedShader& requestDepthFxShader(const char* entry, const std::vector<shaderCache::Define>& defines)
+    {
+        std::string key = entry;
+        for (const shaderCache::Define& define : defines)
+        {
+            key += " " + define.name + "=" + define.value;
+        }
+
+        const auto it = m_ps_depth_fx.find(key);
+        if (it != m_ps_depth_fx.end())
+        {
+            return it->second;
+        }
+
+        CachedShader& shader = m_ps_depth_fx[key];
+        shader.binary = shaderCache::request("shaders/depth_fx.ps", "ps_3_0", entry, defines);
+        return shader;
+    }
+
+    IDirect3DPixelShader9* getDepthFxShader(IDirect3DDevice9* device, const char* entry, const std::vector<shaderCache::Define>& defines)
+    {
+        CachedShader& cached = requestDepthFxShader(entry, defines);
+        createShader(device, cached.binary, &cached.shader);
+        return cached.shader;
+    }
+
+    bool createShader(IDirect3DDevice9* device, shaderCache::BinaryPtr& binary, IDirect3DVertexShader9** shader)
+    {
+        if (*shader == nullptr && binary != nullptr && binary->isCompiled())
+        {
+            device->CreateVertexShader((const DWORD*)binary->bytecode.data(), shader);
+            binary.reset();
+        }
+        return *shader != nullptr;
+    }
+
+    bool createShader(IDirect3DDevice9* device, shaderCache::BinaryPtr& binary, IDirect3DPixelShader9** shader)
+    {
+        if (*shader == nullptr && binary != nullptr && binary->isCompiled())
+        {
+            device->CreatePixelShader((const DWORD*)binary->bytecode.data(), shader);
+            binary.reset();
+        }
+        return *shader != nullptr;
+    }
+
+    // Whether all the shaders of the separate passes exist
+    bool createShaders(IDirect3DDevice9* device)
+    {
+        bool ready = createShader(device, m_bin_fs_tri, &m_vs_fs_tri);
+        ready &= createShader(device, m_bin_grading, &m_ps_grading);
+        ready &= createShader(device, m_bin_hue, &m_ps_hue);
+        ready &= createShader(device, m_bin_gamma, &m_ps_gamma);
+        ready &= createShader(device, m_bin_sharpen, &m_ps_sharpen);
+        ready &= createShader(device, m_bin_ascii, &m_ps_ascii);
+        ready &= createShader(device, m_bin_8bit, &m_ps_8bit);
+        return ready;
+    }
+
+    // The intermediate targets are leased from the core pool per frame, so a resize only changes the size and everything
+    // created here lives through resets (managed pool) and is created once
     void createResources(IDirect3DDevice9* device)
     {
         auto w = getWidth();
         auto h = getHeight();
-        if ((w != m_width || h != m_height) && w > 0 && h > 0)
+        if (w > 0 && h > 0)
         {
             m_width = (UINT)w;
             m_height = (UINT)h;
-            device->CreateTexture(m_width, m_height, 1, D3DUSAGE_RENDERTARGET, D3DFMT_X8R8G8B8, D3DPOOL_DEFAULT, &m_swap0, nullptr);
-            device->CreateTexture(m_width, m_height, 1, D3DUSAGE_RENDERTARGET, D3DFMT_X8R8G8B8, D3DPOOL_DEFAULT, &m_swap1, nullptr);
-            
-            D3DXCreateTextureFromFile(device, (getPath() + "/shaders/luts/lut_default.png").c_str(), &m_luts[0]);
-            D3DXCreateTextureFromFile(device, (getPath() + "/shaders/luts/lut_sepia.png").c_str(), &m_luts[1]);
-            D3DXCreateTextureFromFile(device, (getPath() + "/shaders/luts/lut_mono.png").c_str(), &m_luts[2]);
-            D3DXCreateTextureFromFile(device, (getPath() + "/shaders/luts/lut_coro.png").c_str(), &m_luts[3]);
-            D3DXCreateTextureFromFile(device, (getPath() + "/shaders/luts/lut_saturated.png").c_str(), &m_luts[4]);
+        }
+
+        if (m_vb_fs_tri == nullptr && w > 0 && h > 0)
+        {
+            if (m_luts.empty())
+            {
+                loadLuts(device);
+            }
             D3DVERTEXELEMENT9 simple_decl[] =
             {
                 {0,  0, D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0},
@@ -176,23 +361,393 @@ public:
                 fsTriangle[i].position = XMFLOAT4(fsTriangle[i].uv.x * 2.0f - 1.0f, fsTriangle[i].uv.y * -2.0f + 1.0f, 0.0f, 1.0f);
             }
 
-            loadShaderPS(device, &m_ps_grading, "grading.ps");
-            loadShaderPS(device, &m_ps_hue, "hue.ps");
-            loadShaderPS(device, &m_ps_gamma, "gamma.ps");
-            loadShaderPS(device, &m_ps_sharpen, "sharpen.ps");
-            loadShaderPS(device, &m_ps_ascii, "ascii.ps");
-            loadShaderPS(device, &m_ps_8bit, "8bit.ps");
-            loadShaderVS(device, &m_vs_fs_tri, "fs_posn_uv.vs");
-
-            device->CreateVertexBuffer(3 * sizeof(UVPosW), D3DUSAGE_WRITEONLY, 0, D3DPOOL_DEFAULT, &m_vb_fs_tri, nullptr);
-            HRESULT hr;
+            if (FAILED(device->CreateVertexBuffer(3 * sizeof(UVPosW), D3DUSAGE_WRITEONLY, 0, D3DPOOL_MANAGED, &m_vb_fs_tri, nullptr)))
+            {
+                m_vb_fs_tri = nullptr;
+                return;
+            }
             void* vb_vertices;
-            hr = m_vb_fs_tri->Lock(0, 0, &vb_vertices, 0);
+            m_vb_fs_tri->Lock(0, 0, &vb_vertices, 0);
             memcpy(vb_vertices, fsTriangle, 3 * sizeof(UVPosW));
             m_vb_fs_tri->Unlock();
         }
     }
 
+    struct Lut
+    {
+        std::string name;
+        IDirect3DTexture9* texture = nullptr;
+        colourLut::Cube cube; // Empty when the texture couldn't be read back
+    };
+
+    static constexpr uint32_t bakedLutSize = 32;
+    static constexpr uint32_t timeOfDaySteps = 24;
+
+    // The bundled strips, then every .cube file in shaders/luts
+    void loadLuts(IDirect3DDevice9* device)
+    {
+        static const char* bundled[][2] = {
+            { "Default", "lut_default.png" }, { "Sepia", "lut_sepia.png" }, { "Mono", "lut_mono.png" }, { "Coronet", "lut_coro.png" }, { "Saturated", "lut_saturated.png" }
+        };
+
+        const std::string directory = getPath() + "/shaders/luts/";
+        for (const auto& file : bundled)
+        {
+            Lut lut;
+            lut.name = file[0];
+            if (SUCCEEDED(D3DXCreateTextureFromFile(device, (directory + file[1]).c_str(), &lut.texture)))
+            {
+                softwareFx::Image strip;
+                if (readStrip(lut.texture, strip))
+                {
+                    lut.cube.fromStrip(strip);
+                }
+            }
+            m_luts.emplace_back(std::move(lut));
+        }
+
+        std::error_code errorCode;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, errorCode))
+        {
+            if (entry.path().extension() != ".cube")
+            {
+                continue;
+            }
+
+            std::ifstream file(entry.path());
+            std::stringstream text;
+            text << file.rdbuf();
+
+            Lut lut;
+            lut.name = entry.path().stem().string();
+            std::string error;
+            if (!lut.cube.loadCube(text.str(), error))
+            {
+                char message[512];
+                snprintf(message, sizeof(message), "SytnersFX couldn't load %s: %s", entry.path().filename().string().c_str(), error.c_str());
+                log::warning(message);
+                continue;
+            }
+
+            // Strips wider than the texture limit are resampled to the size the baked LUTs use
+            if (lut.cube.getSize() > 64)
+            {
+                lut.cube = colourLut::blend(colourLut::Cube(bakedLutSize), lut.cube, 1.0f);
+            }
+
+            if (uploadStrip(device, lut.cube.toStrip(), &lut.texture))
+            {
+                m_luts.emplace_back(std::move(lut));
+            }
+        }
+
+        for (const Lut& lut : m_luts)
+        {
+            m_lut_names.push_back(lut.name.c_str());
+        }
+    }
+
+    IDirect3DTexture9* getSelectedLut() const
+    {
+        return m_lut_index < (int)m_luts.size() ? m_luts[m_lut_index].texture : nullptr;
+    }
+
+    // The LUT the grading stage uses, the baked one holds the whole colour chain
+    IDirect3DTexture9* getGradingLut() const
+    {
+        return m_bake_colour && m_baked_active ? m_baked_lut : getSelectedLut();
+    }
+
+    bool isGrading() const
+    {
+        return m_bake_colour ? m_baked_active : m_colouring_mode == 2 && getSelectedLut() != nullptr;
+    }
+
+    // RGBA from a lockable X8R8G8B8 or A8R8G8B8 texture
+    static bool readStrip(IDirect3DTexture9* texture, softwareFx::Image& strip)
+    {
+        D3DSURFACE_DESC desc;
+        texture->GetLevelDesc(0, &desc);
+        if (desc.Format != D3DFMT_X8R8G8B8 && desc.Format != D3DFMT_A8R8G8B8)
+        {
+            return false;
+        }
+
+        D3DLOCKED_RECT rect;
+        if (FAILED(texture->LockRect(0, &rect, nullptr, D3DLOCK_READONLY)))
+        {
+            return false;
+        }
+
+        strip = softwareFx::Image(desc.Width, desc.Height);
+        for (UINT y = 0; y < desc.Height; ++y)
+        {
+            memcpy(strip.getRow(y), (const uint8_t*)rect.pBits + y * rect.Pitch, desc.Width * 4);
+        }
+        texture->UnlockRect(0);
+        softwareFx::swapRedBlue(strip);
+        return true;
+    }
+
+    // Managed, so it survives resets. An existing texture of the same size is refilled
+    static bool uploadStrip(IDirect3DDevice9* device, softwareFx::Image strip, IDirect3DTexture9** texture)
+    {
+        if (*texture != nullptr)
+        {
+            D3DSURFACE_DESC desc;
+            (*texture)->GetLevelDesc(0, &desc);
+            if (desc.Width != strip.width || desc.Height != strip.height)
+            {
+                (*texture)->Release();
+                *texture = nullptr;
+            }
+        }
+
+        if (*texture == nullptr && FAILED(device->CreateTexture(strip.width, strip.height, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, texture, nullptr)))
+        {
+            *texture = nullptr;
+            return false;
+        }
+
+        D3DLOCKED_RECT rect;
+        if (FAILED((*texture)->LockRect(0, &rect, nullptr, 0)))
+        {
+            return false;
+        }
+
+        softwareFx::swapRedBlue(strip);
+        for (uint32_t y = 0; y < strip.height; ++y)
+        {
+            memcpy((uint8_t*)rect.pBits + y * rect.Pitch, strip.getRow(y), strip.width * 4);
+        }
+        (*texture)->UnlockRect(0);
+        return true;
+    }
+
+    // Folds hue, the LUT (blended with another by hand or by the time of day), saturation and, when nothing runs between
+    // them, gamma into one LUT. Blends over the day are precomputed when the LUTs change, the bake itself only reruns when a
+    // setting or the time of day step changes
+    void updateBakedLut(IDirect3DDevice9* device)
+    {
+        if (!m_bake_colour)
+        {
+            return;
+        }
+
+        const bool grading = m_colouring_mode == 2 && m_lut_index < (int)m_luts.size() && m_luts[m_lut_index].cube.isValid();
+        const bool blending = grading && m_blend_lut_index < (int)m_luts.size() && m_luts[m_blend_lut_index].cube.isValid() && m_blend_lut_index != m_lut_index;
+        const bool gammaLast = !m_ascii_enabled && !m_8bit_enabled && !(m_sharpening && m_sharpening_amount > 0);
+
+        if (blending && m_blend_by_time)
+        {
+            const std::vector<float> timelineKey = { (float)m_lut_index, (float)m_blend_lut_index };
+            if (timelineKey != m_timeline_key)
+            {
+                // Day at noon, night at midnight, the time of day is 0 at 06:00
+                m_timeline.setKeys({ { 0.25f, &m_luts[m_lut_index].cube }, { 0.75f, &m_luts[m_blend_lut_index].cube } }, timeOfDaySteps);
+                m_timeline_key = timelineKey;
+            }
+        }
+
+        uint32_t step = 0;
+        if (blending && m_blend_by_time)
+        {
+            Terrain* terrain = Terrain::get();
+            step = m_timeline.getStep(terrain != nullptr ? terrain->getTimeOfDay() : 0.25f);
+        }
+
+        const std::vector<float> key = { (float)m_colouring_mode, m_color.x, m_color.y, m_color.z, (float)m_lut_index, blending ? (float)m_blend_lut_index : -1.0f,
+                                         m_blend_by_time ? -1.0f : m_blend_amount, (float)step, m_saturation, gammaLast ? m_gamma : 1.0f };
+        if (key == m_baked_key)
+        {
+            return;
+        }
+        m_baked_key = key;
+
+        colourLut::Cube blended;
+        std::vector<colourLut::Operation> operations;
+        if (m_colouring_mode == 1)
+        {
+            operations.push_back({ colourLut::Operation::ot_tone, { m_color.x, m_color.y, m_color.z }, nullptr });
+        }
+        else if (grading)
+        {
+            const colourLut::Cube* cube = &m_luts[m_lut_index].cube;
+            if (blending && m_blend_by_time)
+            {
+                cube = &m_timeline.getCube(step);
+            }
+            else if (blending && m_blend_amount > 0)
+            {
+                blended = colourLut::blend(*cube, m_luts[m_blend_lut_index].cube, m_blend_amount);
+                cube = &blended;
+            }
+            operations.push_back({ colourLut::Operation::ot_lut, { 1 }, cube });
+        }
+
+        if (m_saturation != 1.0f)
+        {
+            operations.push_back({ colourLut::Operation::ot_saturation, { m_saturation }, nullptr });
+        }
+
+        m_baked_gamma = gammaLast && m_gamma != 1.0f;
+        if (m_baked_gamma)
+        {
+            operations.push_back({ colourLut::Operation::ot_gamma, { m_gamma }, nullptr });
+        }
+
+        m_baked_active = !operations.empty() && uploadStrip(device, colourLut::bake(operations, bakedLutSize).toStrip(), &m_baked_lut);
+        m_baked_gamma &= m_baked_active;
+    }
+
+    // Per pixel stages are fused into one pass. Sharpen samples its neighbours but recomputes the colour stage for every tap,
+    // so only ascii and 8-bit, which sample the image at other positions through their own shaders, get a pass to themselves.
+    enum Stage : uint32_t
+    {
+        Stage_Hue = 1 << 0,
+        Stage_Grading = 1 << 1,
+        Stage_Sharpen = 1 << 2,
+        Stage_Gamma = 1 << 3,
+        Stage_Ascii = 1 << 4,
+        Stage_8Bit = 1 << 5,
+    };
+
+    static constexpr uint32_t standaloneStages = Stage_Ascii | Stage_8Bit;
+
+    void buildPasses(std::vector<uint32_t>& passes) const
+    {
+        std::vector<Stage> chain;
+        if (isGrading())
+        {
+            chain.push_back(Stage_Grading);
+        }
+        else if (!m_bake_colour && m_colouring_mode == 1 && (m_color.x != 1 || m_color.y != 1 || m_color.z != 1))
+        {
+            chain.push_back(Stage_Hue);
+        }
+
+        if (m_ascii_enabled)
+        {
+            chain.push_back(Stage_Ascii);
+        }
+        else if (m_8bit_enabled)
+        {
+            chain.push_back(Stage_8Bit);
+        }
+        else if (m_sharpening && m_sharpening_amount > 0)
+        {
+            chain.push_back(Stage_Sharpen);
+        }
+
+        if (m_gamma != 1.0f && !(m_bake_colour && m_baked_gamma))
+        {
+            chain.push_back(Stage_Gamma);
+        }
+
+        uint32_t fused = 0;
+        for (const Stage stage : chain)
+        {
+            if ((stage & standaloneStages) != 0)
+            {
+                if (fused != 0)
+                {
+                    passes.push_back(fused);
+                    fused = 0;
+                }
+                passes.push_back(stage);
+            }
+            else
+            {
+                fused |= stage;
+            }
+        }
+
+        if (fused != 0)
+        {
+            passes.push_back(fused);
+        }
+    }
+
+    // Null while the variant is still compiling or when it failed, postProcess then falls back to the separate passes
+    IDirect3DPixelShader9* getFusedShader(IDirect3DDevice9* device, uint32_t stages)
+    {
+        requestFusedShader(stages);
+        CachedShader& fused = m_ps_fused[stages];
+        createShader(device, fused.binary, &fused.shader);
+        return fused.shader;
+    }
+
+    void postProcessFused(IDirect3DDevice9* device, IDirect3DTexture9* color, const std::vector<uint32_t>& passes)
+    {
+        static const char* passNames[] = { "FX pass 0", "FX pass 1", "FX pass 2" };
+
+        renderTargetPool::Lease swap[2];
+        for (size_t i = 0; i + 1 < passes.size() && i < 2; ++i)
+        {
+            swap[i] = renderTargetPool::acquire(device, m_width, m_height, D3DFMT_X8R8G8B8);
+            if (!swap[i].isValid())
+            {
+                return;
+            }
+        }
+
+        IDirect3DSurface9* surface;
+        device->GetRenderTarget(0, &surface);
+
+        device->SetStreamSource(0, m_vb_fs_tri, 0, sizeof(UVPosW));
+        device->SetVertexShader(m_vs_fs_tri);
+        device->SetVertexDeclaration(m_fs_vertex_decl);
+
+        IDirect3DTexture9* input = color;
+        for (size_t i = 0; i < passes.size(); ++i)
+        {
+            UTINNI_GPU_ZONE(passNames[i]);
+
+            const bool isLast = i + 1 == passes.size();
+            const renderTargetPool::Lease& output = swap[i % 2];
+            device->SetRenderTarget(0, isLast ? surface : output.getSurface());
+
+            const uint32_t stages = passes[i];
+            if (stages == Stage_Ascii)
+            {
+                XMFLOAT4 texelInfo{ 0.5f / (float)m_width, 0.5f / (float)m_height, (float)m_width, (float)m_height };
+                device->SetPixelShader(m_ps_ascii);
+                device->SetPixelShaderConstantF(85, &texelInfo.x, 1);
+            }
+            else if (stages == Stage_8Bit)
+            {
+                XMFLOAT4 texelInfo{ 0.5f / (float)m_width, 0.5f / (float)m_height, (float)m_width, (float)m_height };
+                device->SetPixelShader(m_ps_8bit);
+                device->SetPixelShaderConstantF(85, &texelInfo.x, 1);
+                device->SetPixelShaderConstantF(86, &m_8bit_settings.x, 1);
+            }
+            else
+            {
+                XMFLOAT4 texelInfo{ 0.5f / (float)m_width, 0.5f / (float)m_height, m_sharpening_amount, m_gamma };
+                device->SetPixelShader(getFusedShader(device, stages));
+                device->SetPixelShaderConstantF(85, &texelInfo.x, 1);
+                if (stages & Stage_Hue)
+                {
+                    device->SetPixelShaderConstantF(86, &m_color.x, 1);
+                }
+                if (stages & Stage_Grading)
+                {
+                    D3DSURFACE_DESC lutDesc;
+                    getGradingLut()->GetLevelDesc(0, &lutDesc);
+                    XMFLOAT4 lutInfo{ (float)lutDesc.Width, (float)lutDesc.Height, 0, 0 };
+                    device->SetPixelShaderConstantF(87, &lutInfo.x, 1);
+                    device->SetTexture(1, getGradingLut());
+                }
+            }
+
+            device->SetTexture(0, input);
+            device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 1);
+            input = output.getTexture();
+        }
+
+        surface->Release();
+    }
+
     void postProcess(IDirect3DDevice9* device, IDirect3DTexture9* depth, IDirect3DTexture9* color)
     {
         if (m_vb_fs_tri == nullptr)
@@ -200,17 +755,287 @@ public:
             return;
         }
 
+        updateBakedLut(device);
+
+        const bool separateReady = createShaders(device);
+
+        // The depth effects work on the scene, so they go ahead of the colour stages
+        renderTargetPool::Lease depthFxOutput;
+        IDirect3DTexture9* scene = applyDepthEffects(device, depth, color, depthFxOutput);
+
+        if (m_fuse_passes && m_vs_fs_tri != nullptr)
+        {
+            std::vector<uint32_t> passes;
+            buildPasses(passes);
+            if (passes.empty() && depthFxOutput.isValid())
+            {
+                IDirect3DSurface9* surface;
+                device->GetRenderTarget(0, &surface);
+                device->StretchRect(depthFxOutput.getSurface(), nullptr, surface, nullptr, D3DTEXF_NONE);
+                surface->Release();
+                m_fused_pass_count = 0;
+                return;
+            }
+
+            bool canFuse = true;
+            for (const uint32_t stages : passes)
+            {
+                canFuse &= stages == Stage_Ascii ? m_ps_ascii != nullptr : stages == Stage_8Bit ? m_ps_8bit != nullptr : getFusedShader(device, stages) != nullptr;
+            }
+
+            if (canFuse)
+            {
+                m_fused_pass_count = (int)passes.size();
+                postProcessFused(device, scene, passes);
+                return;
+            }
+        }
+
+        m_fused_pass_count = -1;
+
+        if (separateReady)
+        {
+            postProcessSeparate(device, depth, scene);
+        }
+    }
+
+    static void setSizeConstant(IDirect3DDevice9* device, UINT constant, UINT width, UINT height)
+    {
+        const float size[4] = { 1.0f / (float)width, 1.0f / (float)height, (float)width, (float)height };
+        device->SetPixelShaderConstantF(constant, size, 1);
+    }
+
+    static void setSampler(IDirect3DDevice9* device, DWORD sampler, D3DTEXTUREFILTERTYPE filter)
+    {
+        device->SetSamplerState(sampler, D3DSAMP_MINFILTER, filter);
+        device->SetSamplerState(sampler, D3DSAMP_MAGFILTER, filter);
+        device->SetSamplerState(sampler, D3DSAMP_MIPFILTER, D3DTEXF_NONE);
+        device->SetSamplerState(sampler, D3DSAMP_ADDRESSU, D3DTADDRESS_CLAMP);
+        device->SetSamplerState(sampler, D3DSAMP_ADDRESSV, D3DTADDRESS_CLAMP);
+    }
+
+    void drawDepthFxPass(IDirect3DDevice9* device, IDirect3DPixelShader9* shader, const renderTargetPool::Lease& target)
+    {
+        D3DSURFACE_DESC desc;
+        target.getTexture()->GetLevelDesc(0, &desc);
+        setSizeConstant(device, 1, desc.Width, desc.Height);
+        device->SetRenderTarget(0, target.getSurface());
+        device->SetPixelShader(shader);
+        device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 1);
+    }
+
+    // SSAO then DOF, see data/shaders/depth_fx.ps. Returns the texture the colour stages read, which output holds, or the
+    // colour when neither ran. The sampler states, constants and pixel shader are put back, the colour stages run with the
+    // ones the client left
+    IDirect3DTexture9* applyDepthEffects(IDirect3DDevice9* device, IDirect3DTexture9* depth, IDirect3DTexture9* color, renderTargetPool::Lease& output)
+    {
+        Camera* camera = Game::getCamera();
+        if ((!m_ssao_enabled && !m_dof_enabled) || depth == nullptr || camera == nullptr || m_vs_fs_tri == nullptr)
+        {
+            return color;
+        }
+
+        // Only what the passes below change is saved, a pixel state block per frame costs more than the few Get calls
+        static constexpr D3DSAMPLERSTATETYPE samplerStates[] = { D3DSAMP_MINFILTER, D3DSAMP_MAGFILTER, D3DSAMP_MIPFILTER, D3DSAMP_ADDRESSU, D3DSAMP_ADDRESSV };
+        DWORD previousSamplers[3][std::size(samplerStates)];
+        for (DWORD sampler = 0; sampler < 3; ++sampler)
+        {
+            for (size_t i = 0; i < std::size(samplerStates); ++i)
+            {
+                device->GetSamplerState(sampler, samplerStates[i], &previousSamplers[sampler][i]);
+            }
+        }
+        float previousConstants[7][4]; // c0 to c6, see data/shaders/depth_fx.ps
+        device->GetPixelShaderConstantF(0, previousConstants[0], 7);
+        IDirect3DPixelShader9* previousShader = nullptr;
+        device->GetPixelShader(&previousShader);
+
         IDirect3DSurface9* surface;
         device->GetRenderTarget(0, &surface);
 
-        IDirect3DSurface9* swap0surface;
-        m_swap0->GetSurfaceLevel(0, &swap0surface);
-        IDirect3DSurface9* swap1surface;
-        m_swap1->GetSurfaceLevel(0, &swap1surface);
+        const float projection[4] = { camera->nearPlane, camera->farPlane, camera->tanOfHalfHorizontalFov, camera->tanOfHalfVerticalFov };
+        D3DSURFACE_DESC depthDesc;
+        depth->GetLevelDesc(0, &depthDesc);
+
+        device->SetStreamSource(0, m_vb_fs_tri, 0, sizeof(UVPosW));
+        device->SetVertexShader(m_vs_fs_tri);
+        device->SetVertexDeclaration(m_fs_vertex_decl);
+        device->SetPixelShaderConstantF(0, projection, 1);
+        setSizeConstant(device, 2, depthDesc.Width, depthDesc.Height);
+        setSampler(device, 0, D3DTEXF_LINEAR);
+        setSampler(device, 1, D3DTEXF_POINT);
+        device->SetTexture(1, depth);
+
+        IDirect3DTexture9* scene = color;
+        renderTargetPool::Lease ssaoOutput;
+        if (m_ssao_enabled && applySsao(device, scene, ssaoOutput))
+        {
+            scene = ssaoOutput.getTexture();
+        }
+
+        renderTargetPool::Lease dofOutput;
+        if (m_dof_enabled && applyDof(device, scene, dofOutput))
+        {
+            scene = dofOutput.getTexture();
+        }
+        output = dofOutput.isValid() ? dofOutput : ssaoOutput;
+
+        device->SetTexture(1, nullptr);
+        device->SetTexture(2, nullptr);
+        device->SetRenderTarget(0, surface);
+        surface->Release();
+
+        for (DWORD sampler = 0; sampler < 3; ++sampler)
+        {
+            for (size_t i = 0; i < std::size(samplerStates); ++i)
+            {
+                device->SetSamplerState(sampler, samplerStates[i], previousSamplers[sampler][i]);
+            }
+        }
+        device->SetPixelShaderConstantF(0, previousConstants[0], 7);
+        device->SetPixelShader(previousShader);
+        if (previousShader != nullptr)
+        {
+            previousShader->Release();
+        }
+        return scene;
+    }
+
+    bool applySsao(IDirect3DDevice9* device, IDirect3DTexture9* scene, renderTargetPool::Lease& output)
+    {
+        const bool blur = m_ssao.blurRadius > 0;
+        IDirect3DPixelShader9* ssao = getDepthFxShader(device, "ssao", { { "SAMPLES", std::to_string(m_ssao.sampleCount) } });
+        IDirect3DPixelShader9* ssaoBlur = blur ? getDepthFxShader(device, "ssaoBlur", { { "RADIUS", std::to_string(m_ssao.blurRadius) } }) : nullptr;
+        IDirect3DPixelShader9* ssaoApply = getDepthFxShader(device, "ssaoApply", {});
+        if (ssao == nullptr || ssaoApply == nullptr || (blur && ssaoBlur == nullptr))
+        {
+            return false;
+        }
+
+        // Occlusion in r and linear depth in g for the depth aware blur and upsample
+        const UINT width = depthFx::getReducedSize(m_width, m_ssao.divisor);
+        const UINT height = depthFx::getReducedSize(m_height, m_ssao.divisor);
+        const renderTargetPool::Lease occlusion = renderTargetPool::acquire(device, width, height, D3DFMT_G16R16F);
+        const renderTargetPool::Lease blurred = blur ? renderTargetPool::acquire(device, width, height, D3DFMT_G16R16F) : renderTargetPool::Lease();
+        const renderTargetPool::Lease result = renderTargetPool::acquire(device, m_width, m_height, D3DFMT_X8R8G8B8);
+        if (!occlusion.isValid() || !result.isValid() || (blur && !blurred.isValid()))
+        {
+            return false;
+        }
+
+        const float info[4] = { m_ssao.radius, m_ssao.intensity, m_ssao.bias, m_ssao.strength };
+        device->SetPixelShaderConstantF(4, info, 1);
+        setSampler(device, 2, D3DTEXF_POINT);
+        {
+            UTINNI_GPU_ZONE("FX SSAO");
+            drawDepthFxPass(device, ssao, occlusion);
+        }
+
+        if (blur)
+        {
+            UTINNI_GPU_ZONE("FX SSAO blur");
+            const float horizontal[4] = { 1.0f / (float)width, 0, 0, 0 };
+            const float vertical[4] = { 0, 1.0f / (float)height, 0, 0 };
+            device->SetPixelShaderConstantF(5, horizontal, 1);
+            device->SetTexture(2, occlusion.getTexture());
+            drawDepthFxPass(device, ssaoBlur, blurred);
+            device->SetPixelShaderConstantF(5, vertical, 1);
+            device->SetTexture(2, blurred.getTexture());
+            drawDepthFxPass(device, ssaoBlur, occlusion);
+        }
+
+        UTINNI_GPU_ZONE("FX SSAO apply");
+        setSizeConstant(device, 3, width, height);
+        device->SetTexture(0, scene);
+        device->SetTexture(2, occlusion.getTexture());
+        drawDepthFxPass(device, ssaoApply, result);
+        output = result;
+        return true;
+    }
+
+    bool applyDof(IDirect3DDevice9* device, IDirect3DTexture9* scene, renderTargetPool::Lease& output)
+    {
+        const std::string divisor = std::to_string(m_dof.divisor);
+        IDirect3DPixelShader9* downsample = getDepthFxShader(device, "dofDownsample", { { "DIVISOR", divisor } });
+        IDirect3DPixelShader9* blur = getDepthFxShader(device, "dofBlur", { { "SAMPLES", std::to_string(m_dof.sampleCount) }, { "DIVISOR", divisor } });
+        IDirect3DPixelShader9* compose = getDepthFxShader(device, "dofCompose", { { "DIVISOR", divisor } });
+        if (downsample == nullptr || blur == nullptr || compose == nullptr)
+        {
+            return false;
+        }
+
+        const UINT width = depthFx::getReducedSize(m_width, m_dof.divisor);
+        const UINT height = depthFx::getReducedSize(m_height, m_dof.divisor);
+        const renderTargetPool::Lease reduced = renderTargetPool::acquire(device, width, height, D3DFMT_A8R8G8B8);
+        const renderTargetPool::Lease blurred = renderTargetPool::acquire(device, width, height, D3DFMT_A8R8G8B8);
+        const renderTargetPool::Lease result = renderTargetPool::acquire(device, m_width, m_height, D3DFMT_X8R8G8B8);
+        if (!reduced.isValid() || !blurred.isValid() || !result.isValid())
+        {
+            return false;
+        }
+
+        Camera* camera = Game::getCamera();
+        Object* player = Game::getPlayer();
+        if (m_dof_focus_player && player != nullptr)
+        {
+            const swg::math::Vector cameraPosition = camera->getTransform()->getPosition();
+            const swg::math::Vector playerPosition = player->getTransform()->getPosition();
+            const float x = playerPosition.X - cameraPosition.X;
+            const float y = playerPosition.Y - cameraPosition.Y;
+            const float z = playerPosition.Z - cameraPosition.Z;
+            m_dof.focusDistance = sqrtf(x * x + y * y + z * z);
+        }
+
+        const float info[4] = { m_dof.focusDistance, m_dof.focusRange, m_dof.blurRange, m_dof.maxBlur };
+        device->SetPixelShaderConstantF(6, info, 1);
+        {
+            UTINNI_GPU_ZONE("FX DOF downsample");
+            device->SetTexture(0, scene);
+            drawDepthFxPass(device, downsample, reduced);
+        }
+
+        {
+            UTINNI_GPU_ZONE("FX DOF blur");
+            setSampler(device, 2, D3DTEXF_POINT);
+            device->SetTexture(2, reduced.getTexture());
+            drawDepthFxPass(device, blur, blurred);
+        }
+
+        UTINNI_GPU_ZONE("FX DOF compose");
+        setSampler(device, 2, D3DTEXF_LINEAR);
+        setSizeConstant(device, 3, width, height);
+        device->SetTexture(2, blurred.getTexture());
+        drawDepthFxPass(device, compose, result);
+        output = result;
+        return true;
+    }
+
+    // The original three passes, kept to compare against the fused passes
+    void postProcessSeparate(IDirect3DDevice9* device, IDirect3DTexture9* depth, IDirect3DTexture9* color)
+    {
+        if (m_vb_fs_tri == nullptr)
+        {
+            return;
+        }
+
+        const renderTargetPool::Lease swap0 = renderTargetPool::acquire(device, m_width, m_height, D3DFMT_X8R8G8B8);
+        const renderTargetPool::Lease swap1 = renderTargetPool::acquire(device, m_width, m_height, D3DFMT_X8R8G8B8);
+        if (!swap0.isValid() || !swap1.isValid())
+        {
+            return;
+        }
+        IDirect3DSurface9* swap0surface = swap0.getSurface();
+        IDirect3DSurface9* swap1surface = swap1.getSurface();
 
+        IDirect3DSurface9* surface;
+        device->GetRenderTarget(0, &surface);
+
+        const bool grading = isGrading();
+        const bool hue = !grading && !m_bake_colour && m_colouring_mode == 1;
+        gpuProfiler::beginZone(hue ? "FX hue" : grading ? "FX colour grading" : "FX copy");
         device->SetRenderTarget(0, swap0surface);
         device->Clear(0, nullptr, D3DCLEAR_TARGET, 0x00000000, 1.0f, 0);
-        if (m_colouring_mode == 1)
+        if (hue)
         {
             XMFLOAT4 texelInfo{ 0.5f / (float)m_width, 0.5f / (float)m_height, 0,0 };
             device->SetStreamSource(0, m_vb_fs_tri, 0, sizeof(UVPosW));
@@ -223,10 +1048,10 @@ public:
 
             device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 1);
         }
-        else if (m_colouring_mode == 2)
+        else if (grading)
         {
             D3DSURFACE_DESC lutDesc;
-            m_luts[m_lut_index]->GetLevelDesc(0, &lutDesc);
+            getGradingLut()->GetLevelDesc(0, &lutDesc);
             XMFLOAT4 lutInfo{ (float)lutDesc.Width, (float)lutDesc.Height, 0, 0 };
 
             XMFLOAT4 texelInfo{ 0.5f / (float)m_width, 0.5f / (float)m_height, 0,0 };
@@ -237,7 +1062,7 @@ public:
             device->SetPixelShaderConstantF(87, &lutInfo.x, 1);
             device->SetVertexDeclaration(m_fs_vertex_decl);
             device->SetTexture(0, color);
-            device->SetTexture(1, m_luts[m_lut_index]);
+            device->SetTexture(1, getGradingLut());
 
             device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 1);
         }
@@ -254,7 +1079,9 @@ public:
 
             device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 1);
         }
+        gpuProfiler::endZone();
 
+        gpuProfiler::beginZone(m_ascii_enabled ? "FX ascii" : m_8bit_enabled ? "FX 8-bit" : "FX sharpen");
         device->SetRenderTarget(0, swap1surface);
         device->Clear(0, nullptr, D3DCLEAR_TARGET, 0x00000000, 1.0f, 0);
         device->SetStreamSource(0, m_vb_fs_tri, 0, sizeof(UVPosW));
@@ -281,9 +1108,11 @@ public:
             device->SetPixelShaderConstantF(85, &texelInfo.x, 1);
         }
         device->SetVertexDeclaration(m_fs_vertex_decl);
-        device->SetTexture(0, m_swap0);
+        device->SetTexture(0, swap0.getTexture());
         device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 1);
+        gpuProfiler::endZone();
 
+        UTINNI_GPU_ZONE("FX gamma");
         device->SetRenderTarget(0, surface);
 
         //D3DVIEWPORT9 vp;
@@ -297,12 +1126,14 @@ public:
 
         device->SetStreamSource(0, m_vb_fs_tri, 0, sizeof(UVPosW));
         device->SetVertexShader(m_vs_fs_tri);
-        XMFLOAT4 texelInfo{ 0.5f / (float)m_width, 0.5f / (float)m_height, m_gamma, 0 };
+        XMFLOAT4 texelInfo{ 0.5f / (float)m_width, 0.5f / (float)m_height, m_bake_colour && m_baked_gamma ? 1.0f : m_gamma, 0 };
         device->SetPixelShader(m_ps_gamma);
         device->SetPixelShaderConstantF(85, &texelInfo.x, 1);
         device->SetVertexDeclaration(m_fs_vertex_decl);
-        device->SetTexture(0, m_swap1);
+        device->SetTexture(0, swap1.getTexture());
         device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 1);
+
+        surface->Release();
     }
 
     void postProcessSimple(IDirect3DDevice9* device, IDirect3DTexture9* depth, IDirect3DTexture9* color)
@@ -358,6 +1189,8 @@ public:
         // Do postprocess
         if (m_enabled)
         {
+            UTINNI_PROFILE_ZONE("SytnersFX::postProcess");
+            UTINNI_GPU_ZONE("SytnersFX::postProcess");
             postProcess(device, depth, color);
         }
 
@@ -406,16 +1239,40 @@ public:
     }
 
 private:
-    UINT m_width;
-    UINT m_height;
+    CallbackHandle m_draw_ui_callback;
+    CallbackHandle m_resolve_callback;
+
+    UINT m_width = 0;
+    UINT m_height = 0;
     bool m_enabled = true;
+    bool m_fuse_passes = true;
+    int m_fused_pass_count = -1; // Passes the last frame took on the fused path, -1 when it used the separate passes
     int m_colouring_mode = 1;
     XMFLOAT4 m_color = { 1,1,1,1 };
-    IDirect3DTexture9* m_swap0 = nullptr;
-    IDirect3DTexture9* m_swap1 = nullptr;
 
     int m_lut_index = 1;
-    IDirect3DTexture9* m_luts[5] = {};
+    std::vector<Lut> m_luts;
+    std::vector<const char*> m_lut_names;
+
+    bool m_bake_colour = false;
+    float m_saturation = 1.0f;
+    int m_blend_lut_index = 0;
+    float m_blend_amount = 0.0f;
+    bool m_blend_by_time = false;
+    IDirect3DTexture9* m_baked_lut = nullptr;
+    bool m_baked_active = false;
+    bool m_baked_gamma = false; // Gamma is in the baked LUT and the gamma stage is skipped
+    std::vector<float> m_baked_key;
+    colourLut::Timeline m_timeline;
+    std::vector<float> m_timeline_key;
+
+    bool m_ssao_enabled = false;
+    int m_ssao_quality = (int)depthFx::Quality::medium;
+    depthFx::SsaoSettings m_ssao;
+    bool m_dof_enabled = false;
+    int m_dof_quality = (int)depthFx::Quality::medium;
+    bool m_dof_focus_player = true;
+    depthFx::DofSettings m_dof;
 
     bool m_ascii_enabled = false;
     bool m_8bit_enabled = false;
@@ -432,6 +1289,22 @@ private:
     IDirect3DPixelShader9* m_ps_ascii = nullptr;
     IDirect3DPixelShader9* m_ps_8bit = nullptr;
     IDirect3DPixelShader9* m_ps_gamma = nullptr;
+
+    struct CachedShader
+    {
+        shaderCache::BinaryPtr binary;
+        IDirect3DPixelShader9* shader = nullptr;
+    };
+    std::map<uint32_t, CachedShader> m_ps_fused;
+    std::map<std::string, CachedShader> m_ps_depth_fx; // Keyed by the entry point and the defines
+
+    shaderCache::BinaryPtr m_bin_fs_tri;
+    shaderCache::BinaryPtr m_bin_grading;
+    shaderCache::BinaryPtr m_bin_hue;
+    shaderCache::BinaryPtr m_bin_sharpen;
+    shaderCache::BinaryPtr m_bin_ascii;
+    shaderCache::BinaryPtr m_bin_8bit;
+    shaderCache::BinaryPtr m_bin_gamma;
     IDirect3DVertexDeclaration9* m_fs_vertex_decl = nullptr;
 };
 
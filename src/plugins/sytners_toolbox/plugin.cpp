@@ -24,9 +24,14 @@
 **/
 
 #include "swg/camera/camera.h"
+#include "swg/camera/flythrough_benchmark.h"
 #include "swg/game/game.h"
 #include "swg/graphics/directx9.h"
+#include "swg/graphics/draw_stats.h"
+#include "swg/graphics/gpu_profiler.h"
 #include "swg/graphics/graphics.h"
+#include "swg/misc/allocation_tracker.h"
+#include "swg/misc/frame_telemetry.h"
 #include "swg/misc/repository.h"
 #include "swg/misc/swg_math.h"
 #include "swg/object/player_object.h"
@@ -38,6 +43,10 @@
 #include "imGuIZMO.quat/imGuIZMOquat.h"
 #include "imgui/imgui.h"
 #include "plugin_framework/utinni_plugin.h"
+#include "utility/callback_list.h"
+#include "utility/event_log.h"
+#include "utility/frame_allocator.h"
+#include "utility/profiler.h"
 #include <DirectXMath.h>
 
 using namespace utinni;
@@ -111,17 +120,27 @@ inline bool ends_with(std::string const& value, std::string const& ending)
 class SytnersToolboxPlugin : public UtinniPlugin
 {
 public:
+    ~SytnersToolboxPlugin() override
+    {
+        drawUiCallback.remove();
+    }
+
     void init() override
     {
-        imgui_impl::addRenderCallback([this]() {
+        drawUiCallback = imgui_impl::addRenderCallback([this]() {
                 this->drawUI();
-            });
+            }, "Sytner's Toolbox", "drawUI");
     }
 
     void drawUI()
     {
         static bool showDepthWindow = false;
         static bool showColorWindow = false;
+        static bool showProfilerWindow = false;
+        static bool showTelemetryWindow = false;
+        static bool showDrawStatsWindow = false;
+        static bool showBenchmarkWindow = false;
+        static bool showGpuProfilerWindow = false;
 
         ImGui::GetStyle().Colors[ImGuiCol_WindowBg].w = 0.6f;
 
@@ -232,20 +251,21 @@ public:
 
                 auto terrain = Terrain::get();
                 auto repo = Game::getRepository();
-                if (repo != nullptr && terrain != nullptr)
+                auto terrains = repo != nullptr ? repo->getDirectoryInfo("terrain") : nullptr;
+                if (terrains != nullptr && terrain != nullptr)
                 {
-                    auto terrains = repo->getDirectoryFilenames("terrain");
-                    auto currTerrainName = std::string(terrain->getFilename());
+                    const auto& filenames = *repo->getAllFilenames();
+                    const char* currTerrainName = terrain->getFilename();
 
                     static int currTerrain = 0;
-                    std::vector<const char*> cstrings;
-                    for (size_t i = 0; i < terrains.size(); ++i)
+                    FrameVector<const char*> cstrings;
+                    for (int i = terrains->startIndex; i < terrains->startIndex + terrains->size; ++i)
                     {
-                        if (ends_with(terrains[i], ".trn"))
+                        if (ends_with(filenames[i], ".trn"))
                         {
-                            cstrings.push_back(terrains[i].c_str());
+                            cstrings.push_back(filenames[i].c_str());
                             // stupid search because terrain name has extra stuff on it potentially
-                            if (currTerrainName.find(terrains[i]) != std::string::npos)
+                            if (strstr(currTerrainName, filenames[i].c_str()) != nullptr)
                             {
                                 currTerrain = cstrings.size() - 1;
                             }
@@ -276,15 +296,16 @@ public:
                 {
                     WorldSnapshot::reload();
                 }
-                if (repo != nullptr && terrain != nullptr)
+                auto snapshots = repo != nullptr ? repo->getDirectoryInfo("snapshot") : nullptr;
+                if (snapshots != nullptr && terrain != nullptr)
                 {
-                    auto snapshots = repo->getDirectoryFilenames("snapshot");
+                    const auto& filenames = *repo->getAllFilenames();
 
                     static int currSnapshot = 0;
-                    std::vector<const char*> cstrings(snapshots.size());
-                    for (size_t i = 0; i < snapshots.size(); ++i)
+                    FrameVector<const char*> cstrings(snapshots->size);
+                    for (int i = 0; i < snapshots->size; ++i)
                     {
-                        cstrings[i] = snapshots[i].c_str();
+                        cstrings[i] = filenames[snapshots->startIndex + i].c_str();
                     }
 
                     if (ImGui::Combo("Snapshot", &currSnapshot, cstrings.data(), (int)cstrings.size()))
@@ -315,6 +336,39 @@ public:
             {
                 cuiMisc::reloadUi();
             }
+
+            if (allocationTracker::isEnabled())
+            {
+                ImGui::CollapsingHeader("Allocations", ImGuiTreeNodeFlags_DefaultOpen);
+                if (ImGui::Button("Log allocation report"))
+                {
+                    allocationTracker::logReport();
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Export allocation rates"))
+                {
+                    allocationTracker::exportFrameRates(getPath() + "allocation_rates.csv");
+                }
+            }
+
+            ImGui::CollapsingHeader("Profiler", ImGuiTreeNodeFlags_DefaultOpen);
+            if (ImGui::Checkbox("Show Profiler Window", &showProfilerWindow)) {}
+            if (ImGui::Checkbox("Show GPU Profiler", &showGpuProfilerWindow)) {}
+            if (ImGui::Checkbox("Show Draw Stats", &showDrawStatsWindow)) {}
+            if (ImGui::Checkbox("Show Frame Telemetry", &showTelemetryWindow)) {}
+            if (ImGui::Checkbox("Show Flythrough Benchmark", &showBenchmarkWindow)) {}
+            if (ImGui::Button("Log callback budget report"))
+            {
+                callbackBudget::logReport();
+            }
+            if (eventLog::isEnabled())
+            {
+                ImGui::SameLine();
+                if (ImGui::Button("Dump event log"))
+                {
+                    eventLog::dump(getPath() + "utinni_events.utev", 30.0);
+                }
+            }
         }
 
         if (showDepthWindow)
@@ -326,6 +380,31 @@ public:
         {
             DrawColorWindow();
         }
+
+        if (showProfilerWindow)
+        {
+            profiler::drawUi();
+        }
+
+        if (showGpuProfilerWindow)
+        {
+            gpuProfiler::drawUi();
+        }
+
+        if (showDrawStatsWindow)
+        {
+            drawStats::drawUi();
+        }
+
+        if (showTelemetryWindow)
+        {
+            frameTelemetry::drawUi();
+        }
+
+        if (showBenchmarkWindow)
+        {
+            flythroughBenchmark::drawUi();
+        }
     }
 
     const Information& getInformation() const override
@@ -337,6 +416,9 @@ public:
         };
         return info;
     }
+
+private:
+    CallbackHandle drawUiCallback;
 };
 
 extern "C"
@@ -0,0 +1,444 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+// Decodes the binary event logs written by utinni::eventLog::dump back into text or CSV.
+// Portable on purpose so crash dumps can be read on any machine:
+//
+//     g++ -std=c++17 -O2 main.cpp -o event_log_decoder
+//     event_log_decoder <file.utev> [--csv <output.csv>]
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+enum ArgType : uint8_t
+{
+    at_int32 = 1,
+    at_uint32,
+    at_int64,
+    at_uint64,
+    at_double,
+    at_pointer,
+    at_string
+};
+
+struct Format
+{
+    uint32_t line = 0;
+    std::vector<uint8_t> argTypes;
+    std::string format;
+    std::string file;
+};
+
+struct Event
+{
+    uint64_t tsc;
+    uint32_t threadId;
+    uint32_t id;
+    std::vector<uint8_t> payload;
+};
+
+struct EventFile
+{
+    double ticksPerSecond = 0;
+    uint64_t dumpTsc = 0;
+    uint64_t dumpFileTime = 0;
+    std::unordered_map<uint32_t, Format> formats;
+    std::vector<Event> events;
+};
+
+class Reader
+{
+public:
+    explicit Reader(const std::vector<uint8_t>& data) : data(data) { }
+
+    template<typename T>
+    bool read(T& value)
+    {
+        if (position + sizeof(T) > data.size())
+        {
+            return false;
+        }
+        memcpy(&value, data.data() + position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+
+    bool readBytes(std::vector<uint8_t>& bytes, size_t count)
+    {
+        if (position + count > data.size())
+        {
+            return false;
+        }
+        bytes.assign(data.begin() + position, data.begin() + position + count);
+        position += count;
+        return true;
+    }
+
+    bool readString(std::string& text)
+    {
+        uint16_t length;
+        if (!read(length) || position + length > data.size())
+        {
+            return false;
+        }
+        text.assign((const char*)data.data() + position, length);
+        position += length;
+        return true;
+    }
+
+private:
+    const std::vector<uint8_t>& data;
+    size_t position = 0;
+};
+
+bool load(const char* filename, EventFile& eventFile)
+{
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream)
+    {
+        fprintf(stderr, "Couldn't open %s\n", filename);
+        return false;
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    Reader reader(data);
+    char magic[4];
+    uint32_t version;
+    uint64_t ticksPerSecond;
+    if (!reader.read(magic) || memcmp(magic, "UTEV", 4) != 0 || !reader.read(version) || version != 1)
+    {
+        fprintf(stderr, "%s is not a version 1 event log\n", filename);
+        return false;
+    }
+
+    uint32_t formatCount;
+    if (!reader.read(ticksPerSecond) || !reader.read(eventFile.dumpTsc) || !reader.read(eventFile.dumpFileTime) || !reader.read(formatCount))
+    {
+        fprintf(stderr, "Truncated header\n");
+        return false;
+    }
+    eventFile.ticksPerSecond = (double)ticksPerSecond;
+
+    for (uint32_t i = 0; i < formatCount; ++i)
+    {
+        uint32_t id;
+        uint8_t argCount;
+        Format format;
+        if (!reader.read(id) || !reader.read(format.line) || !reader.read(argCount) || !reader.readBytes(format.argTypes, argCount) ||
+            !reader.readString(format.format) || !reader.readString(format.file))
+        {
+            fprintf(stderr, "Truncated format table\n");
+            return false;
+        }
+        eventFile.formats.emplace(id, std::move(format));
+    }
+
+    uint32_t threadCount;
+    if (!reader.read(threadCount))
+    {
+        fprintf(stderr, "Truncated thread table\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        uint32_t threadId;
+        uint32_t recordCount;
+        if (!reader.read(threadId) || !reader.read(recordCount))
+        {
+            fprintf(stderr, "Truncated thread %u\n", i);
+            return false;
+        }
+
+        for (uint32_t j = 0; j < recordCount; ++j)
+        {
+            Event event;
+            uint8_t size;
+            event.threadId = threadId;
+            if (!reader.read(event.tsc) || !reader.read(event.id) || !reader.read(size) || !reader.readBytes(event.payload, size))
+            {
+                fprintf(stderr, "Truncated records of thread %u\n", threadId);
+                return false;
+            }
+            eventFile.events.emplace_back(std::move(event));
+        }
+    }
+
+    std::stable_sort(eventFile.events.begin(), eventFile.events.end(), [](const Event& a, const Event& b) { return a.tsc < b.tsc; });
+    return true;
+}
+
+// Formats a single printf conversion, the length modifier in the spec is replaced by the one matching the recorded type
+void appendArgument(std::string& out, std::string spec, uint8_t type, const uint8_t* payload, size_t size, size_t& position)
+{
+    const char conversion = spec.back();
+    spec.pop_back();
+    spec.erase(std::remove_if(spec.begin(), spec.end(), [](char c) { return c == 'h' || c == 'l' || c == 'j' || c == 'z' || c == 't' || c == 'L' || c == 'I'; }), spec.end());
+
+    char buffer[512];
+    auto readRaw = [&](auto& value) -> bool
+    {
+        if (position + sizeof(value) > size)
+        {
+            return false;
+        }
+        memcpy(&value, payload + position, sizeof(value));
+        position += sizeof(value);
+        return true;
+    };
+
+    switch (type)
+    {
+    case at_int32:
+    case at_uint32:
+    {
+        uint32_t value;
+        if (!readRaw(value))
+        {
+            out += "<truncated>";
+            return;
+        }
+        const char* integerConversions = "diouxXc";
+        const char used = strchr(integerConversions, conversion) != nullptr ? conversion : (type == at_int32 ? 'd' : 'u');
+        snprintf(buffer, sizeof(buffer), (spec + used).c_str(), value);
+        break;
+    }
+    case at_int64:
+    case at_uint64:
+    {
+        uint64_t value;
+        if (!readRaw(value))
+        {
+            out += "<truncated>";
+            return;
+        }
+        const char* integerConversions = "diouxX";
+        const char used = strchr(integerConversions, conversion) != nullptr ? conversion : (type == at_int64 ? 'd' : 'u');
+        snprintf(buffer, sizeof(buffer), (spec + "ll" + used).c_str(), (unsigned long long)value);
+        break;
+    }
+    case at_double:
+    {
+        double value;
+        if (!readRaw(value))
+        {
+            out += "<truncated>";
+            return;
+        }
+        const char* floatConversions = "fFeEgGaA";
+        const char used = strchr(floatConversions, conversion) != nullptr ? conversion : 'f';
+        snprintf(buffer, sizeof(buffer), (spec + used).c_str(), value);
+        break;
+    }
+    case at_pointer:
+    {
+        uint64_t value;
+        if (!readRaw(value))
+        {
+            out += "<truncated>";
+            return;
+        }
+        snprintf(buffer, sizeof(buffer), "0x%08llx", (unsigned long long)value);
+        break;
+    }
+    case at_string:
+    {
+        if (position >= size || position + 1 + payload[position] > size)
+        {
+            out += "<truncated>";
+            return;
+        }
+        const std::string text((const char*)payload + position + 1, payload[position]);
+        position += 1 + payload[position];
+        snprintf(buffer, sizeof(buffer), (spec + 's').c_str(), text.c_str());
+        break;
+    }
+    default:
+        out += "<unknown type>";
+        return;
+    }
+
+    out += buffer;
+}
+
+std::string formatMessage(const Format& format, const std::vector<uint8_t>& payload)
+{
+    std::string out;
+    size_t position = 0;
+    size_t arg = 0;
+    const std::string& text = format.format;
+
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] != '%')
+        {
+            out += text[i];
+            continue;
+        }
+        if (i + 1 < text.size() && text[i + 1] == '%')
+        {
+            out += '%';
+            ++i;
+            continue;
+        }
+
+        // Flags, width, precision and length up to the conversion character
+        size_t end = i + 1;
+        while (end < text.size() && strchr("diouxXcfFeEgGaAspn", text[end]) == nullptr)
+        {
+            ++end;
+        }
+        if (end == text.size())
+        {
+            out += text.substr(i);
+            break;
+        }
+
+        if (arg < format.argTypes.size())
+        {
+            appendArgument(out, text.substr(i, end - i + 1), format.argTypes[arg++], payload.data(), payload.size(), position);
+        }
+        else
+        {
+            out += "<missing>";
+        }
+        i = end;
+    }
+    return out;
+}
+
+std::string formatWallClock(const EventFile& eventFile, uint64_t tsc)
+{
+    // FILETIME counts 100 ns intervals since 1601, shifted to the unix epoch
+    const double secondsBeforeDump = (double)(int64_t)(eventFile.dumpTsc - tsc) / eventFile.ticksPerSecond;
+    const double unixSeconds = (double)eventFile.dumpFileTime / 1e7 - 11644473600.0 - secondsBeforeDump;
+    const time_t wholeSeconds = (time_t)unixSeconds;
+    const int milliseconds = (int)((unixSeconds - (double)wholeSeconds) * 1000.0);
+
+    tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &wholeSeconds);
+#else
+    gmtime_r(&wholeSeconds, &utc);
+#endif
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d.%03d", utc.tm_hour, utc.tm_min, utc.tm_sec, milliseconds);
+    return buffer;
+}
+
+std::string escapeCsv(const std::string& text)
+{
+    std::string out = "\"";
+    for (const char c : text)
+    {
+        if (c == '"')
+        {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2 && !(argc == 4 && strcmp(argv[2], "--csv") == 0))
+    {
+        fprintf(stderr, "Usage: %s <file.utev> [--csv <output.csv>]\n", argv[0]);
+        return 1;
+    }
+
+    EventFile eventFile;
+    if (!load(argv[1], eventFile))
+    {
+        return 1;
+    }
+
+    FILE* csv = nullptr;
+    if (argc == 4)
+    {
+        csv = fopen(argv[3], "w");
+        if (csv == nullptr)
+        {
+            fprintf(stderr, "Couldn't create %s\n", argv[3]);
+            return 1;
+        }
+        fprintf(csv, "seconds_before_dump,utc_time,thread,file,line,message\n");
+    }
+
+    for (const Event& event : eventFile.events)
+    {
+        const double secondsBeforeDump = (double)(int64_t)(eventFile.dumpTsc - event.tsc) / eventFile.ticksPerSecond;
+        const auto it = eventFile.formats.find(event.id);
+
+        std::string message;
+        std::string file = "?";
+        uint32_t line = 0;
+        if (it != eventFile.formats.end())
+        {
+            message = formatMessage(it->second, event.payload);
+            file = it->second.file.substr(it->second.file.find_last_of("\\/") + 1);
+            line = it->second.line;
+        }
+        else
+        {
+            char buffer[48];
+            snprintf(buffer, sizeof(buffer), "<unregistered event %08x>", event.id);
+            message = buffer;
+        }
+
+        const std::string wallClock = formatWallClock(eventFile, event.tsc);
+        if (csv != nullptr)
+        {
+            fprintf(csv, "%.6f,%s,%u,%s,%u,%s\n", -secondsBeforeDump, wallClock.c_str(), event.threadId, escapeCsv(file).c_str(), line, escapeCsv(message).c_str());
+        }
+        else
+        {
+            printf("[%s] [%+10.6f s] [%5u] %s (%s:%u)\n", wallClock.c_str(), -secondsBeforeDump, event.threadId, message.c_str(), file.c_str(), line);
+        }
+    }
+
+    if (csv != nullptr)
+    {
+        fclose(csv);
+        printf("%u events written to %s\n", (uint32_t)eventFile.events.size(), argv[3]);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "swg/misc/allocation_tracker.h"
+#include <cstdlib>
+
+namespace
+{
+constexpr int batchSize = 64;
+
+// Mixed small sizes, most of the client's allocations are strings and small objects
+constexpr size_t sizes[8] = { 16, 24, 40, 64, 96, 160, 256, 512 };
+
+// The wrappers in swg_memory.cpp, over malloc instead of the client's allocator
+void* allocate(size_t size)
+{
+    void* result = malloc(size);
+    if (utinni::allocationTracker::isEnabled())
+    {
+        utinni::allocationTracker::onAllocate(result, size);
+    }
+    return result;
+}
+
+void deallocate(void* address, size_t size)
+{
+    if (utinni::allocationTracker::isEnabled())
+    {
+        utinni::allocationTracker::onDeallocate(address, size);
+    }
+    free(address);
+}
+
+// One iteration allocates a batch and frees it again
+void allocateAndFree(uint64_t iterations)
+{
+    void* blocks[batchSize];
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (int j = 0; j < batchSize; ++j)
+        {
+            blocks[j] = allocate(sizes[(i + j) & 7]);
+        }
+        bench::doNotOptimize(blocks);
+        for (int j = 0; j < batchSize; ++j)
+        {
+            deallocate(blocks[j], sizes[(i + j) & 7]);
+        }
+    }
+}
+}
+
+BENCHMARK("allocations/untracked_64")
+{
+    utinni::allocationTracker::enable(false);
+    allocateAndFree(iterations);
+}
+
+BENCHMARK("allocations/tracked_counting_64")
+{
+    utinni::allocationTracker::enable(true, 0);
+    allocateAndFree(iterations);
+    utinni::allocationTracker::enable(false);
+}
+
+BENCHMARK("allocations/tracked_sampled_64")
+{
+    // The default sample rate, every 64th allocation records its callstack
+    utinni::allocationTracker::enable(true, 64);
+    allocateAndFree(iterations);
+    utinni::allocationTracker::enable(false);
+}
@@ -0,0 +1,79 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Minimal benchmark harness. Every benchmark runs its body `iterations` times, the runner picks the iteration count so a
+// sample takes a few milliseconds and reports the median of the samples in nanoseconds per iteration.
+namespace bench
+{
+using Function = void (*)(uint64_t iterations);
+
+struct Benchmark
+{
+    const char* name;
+    Function function;
+};
+
+std::vector<Benchmark>& getBenchmarks();
+
+struct Registration
+{
+    Registration(const char* name, Function function)
+    {
+        getBenchmarks().push_back({ name, function });
+    }
+};
+
+// Keeps the compiler from throwing away a result that is otherwise unused
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#ifdef _MSC_VER
+    static volatile const void* sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r"(&value) : "memory");
+#endif
+}
+}
+
+#define BENCHMARK_CONCAT_INNER(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_INNER(a, b)
+
+// BENCHMARK("group/name") { for (uint64_t i = 0; i < iterations; ++i) { ... } }
+#define BENCHMARK(name) BENCHMARK_IMPL(name, BENCHMARK_CONCAT(benchmark_, __LINE__))
+#define BENCHMARK_IMPL(name, function) \
+    static void function(uint64_t iterations); \
+    static bench::Registration BENCHMARK_CONCAT(function, _registration)(name, function); \
+    static void function(uint64_t iterations)
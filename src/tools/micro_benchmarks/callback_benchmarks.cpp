@@ -0,0 +1,116 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/callback_list.h"
+#include <functional>
+
+namespace
+{
+constexpr int callbackCount = 8; // About what the busiest game callback lists carry with both plugins loaded
+
+// The storage the lists used before the delegate registry: a plain vector, every call through std::function
+std::vector<std::function<void(uint32_t)>>& getFunctionList()
+{
+    static std::vector<std::function<void(uint32_t)>> list;
+    static uint64_t counters[callbackCount] = {};
+    if (list.empty())
+    {
+        for (int i = 0; i < callbackCount; ++i)
+        {
+            uint64_t* counter = &counters[i];
+            list.emplace_back([counter](uint32_t value) { *counter += value; });
+        }
+    }
+    return list;
+}
+
+utinni::CallbackList<void(uint32_t)>& getCallbackList()
+{
+    static utinni::CallbackList<void(uint32_t)> list("benchmark");
+    static uint64_t counters[callbackCount] = {};
+    if (list.empty())
+    {
+        for (int i = 0; i < callbackCount; ++i)
+        {
+            uint64_t* counter = &counters[i];
+            list.add([counter](uint32_t value) { *counter += value; }, "micro_benchmarks", "counter", i);
+        }
+    }
+    return list;
+}
+}
+
+BENCHMARK("callbacks/dispatch_std_function")
+{
+    auto& list = getFunctionList();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        for (const auto& function : list)
+        {
+            function((uint32_t)i);
+        }
+        bench::doNotOptimize(list);
+    }
+}
+
+BENCHMARK("callbacks/dispatch")
+{
+    // Neither a budget nor the profiler, 15 of 16 frames skip the per callback accounting
+    auto& list = getCallbackList();
+    utinni::callbackBudget::setBudgetMs(0);
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        list.invoke((uint32_t)i);
+        bench::doNotOptimize(list);
+    }
+}
+
+BENCHMARK("callbacks/dispatch_accounted")
+{
+    // Accounting frames, every callback timed and given a profiler zone
+    auto& list = getCallbackList();
+    utinni::callbackBudget::setBudgetMs(1.0);
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        list.invoke((uint32_t)i);
+        bench::doNotOptimize(list);
+    }
+    utinni::callbackBudget::setBudgetMs(0);
+}
+
+BENCHMARK("callbacks/add_remove_collect")
+{
+    // Plugin churn, the stats and the slot of a removed callback have to be given back at the frame end
+    utinni::CallbackList<void(uint32_t)> list("churn");
+    uint64_t counter = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        utinni::CallbackHandle handle = list.add([&counter](uint32_t value) { counter += value; }, "micro_benchmarks", "churn");
+        handle.remove();
+        list.collect();
+    }
+    bench::doNotOptimize(list.getStats().size());
+    bench::doNotOptimize(counter);
+}
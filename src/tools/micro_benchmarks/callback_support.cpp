@@ -0,0 +1,86 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+// Stand-ins for the out of line parts of the callback lists. The real ones live in callback_list.cpp and profiler.cpp,
+// which pull in the log, the event log and ImGui. invoke() itself is all in the header, so the dispatch benchmarks still
+// measure the real code; the profiler zones behave like a disabled profiler, the same out of line check and nothing else.
+// setBudgetMs only switches the accounting, like a budget set in the ini does.
+
+#include "utility/callback_list.h"
+
+namespace
+{
+bool profilerEnabled = false;
+bool accountingFrame = false;
+}
+
+namespace utinni
+{
+CallbackListBase::CallbackListBase(const char* name) : name(name) { }
+
+CallbackListBase::~CallbackListBase() = default;
+
+bool CallbackListBase::isAccountingFrame()
+{
+    return accountingFrame;
+}
+
+CallbackStats* CallbackListBase::createStats(const char* owner, const char* callbackName, int priority)
+{
+    auto callbackStats = std::make_unique<CallbackStats>();
+    callbackStats->listName = name;
+    callbackStats->owner = owner;
+    callbackStats->name = callbackName;
+    callbackStats->zoneName = callbackName; // The benchmarks only pass literals
+    callbackStats->priority = priority;
+
+    stats.emplace_back(std::move(callbackStats));
+    return stats.back().get();
+}
+
+void CallbackListBase::releaseStats(CallbackStats* callbackStats)
+{
+    const auto it = std::find_if(stats.begin(), stats.end(), [callbackStats](const std::unique_ptr<CallbackStats>& entry) { return entry.get() == callbackStats; });
+    if (it != stats.end())
+    {
+        std::swap(*it, stats.back());
+        stats.pop_back();
+    }
+}
+}
+
+namespace utinni::callbackBudget
+{
+void setBudgetMs(double budgetMs)
+{
+    accountingFrame = budgetMs > 0;
+}
+}
+
+namespace utinni::profiler
+{
+ScopedZone::ScopedZone(const char* name) : name(name), start(0), active(profilerEnabled) { }
+
+ScopedZone::~ScopedZone() { }
+}
@@ -0,0 +1,98 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/colour_lut.h"
+
+namespace
+{
+using namespace utinni::colourLut;
+
+// A 33 point .cube, the size most grading tools export
+const std::string& getCubeText()
+{
+    static std::string text;
+    if (text.empty())
+    {
+        text = "TITLE \"Benchmark\"\nLUT_3D_SIZE 33\n";
+        char line[64];
+        for (int b = 0; b < 33; ++b)
+        {
+            for (int g = 0; g < 33; ++g)
+            {
+                for (int r = 0; r < 33; ++r)
+                {
+                    snprintf(line, sizeof(line), "%.6f %.6f %.6f\n", g / 32.0f, b / 32.0f, r / 32.0f);
+                    text += line;
+                }
+            }
+        }
+    }
+    return text;
+}
+}
+
+BENCHMARK("colour_lut/load_cube_33")
+{
+    std::string error;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        Cube cube;
+        bench::doNotOptimize(cube.loadCube(getCubeText(), error));
+    }
+}
+
+BENCHMARK("colour_lut/bake_chain_32")
+{
+    // What SytnersFX bakes: a LUT blended with another, saturation and gamma
+    static const Cube blended = []()
+    {
+        Cube loaded;
+        std::string error;
+        loaded.loadCube(getCubeText(), error);
+        return blend(Cube(16), loaded, 0.5f);
+    }();
+    const std::vector<Operation> operations = {
+        { Operation::ot_lut, { 1 }, &blended },
+        { Operation::ot_saturation, { 1.2f }, nullptr },
+        { Operation::ot_gamma, { 1.2f }, nullptr },
+    };
+
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        bench::doNotOptimize(bake(operations, 32).toStrip().pixels[0]);
+    }
+}
+
+BENCHMARK("colour_lut/timeline_24_steps")
+{
+    const Cube day(16);
+    const Cube night = bake({ { Operation::ot_saturation, { 0.3f }, nullptr } }, 16);
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        Timeline timeline;
+        timeline.setKeys({ { 0.25f, &day }, { 0.75f, &night } }, 24);
+        bench::doNotOptimize(timeline.getStepCount());
+    }
+}
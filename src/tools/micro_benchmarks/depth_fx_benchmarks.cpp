@@ -0,0 +1,121 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/depth_fx.h"
+#include <algorithm>
+
+namespace
+{
+using namespace utinni::depthFx;
+
+const Projection projection{ 1, 1000, 1, 0.5625f };
+
+// A 1080p floor running off into the distance with a row of boxes on it, so both effects have edges to work on
+const FloatImage& getDepth()
+{
+    static FloatImage depth;
+    if (depth.values.empty())
+    {
+        depth = FloatImage(1920, 1080);
+        for (uint32_t y = 0; y < depth.height; ++y)
+        {
+            const float v = 1 - 2 * ((float)y + 0.5f) / (float)depth.height;
+            for (uint32_t x = 0; x < depth.width; ++x)
+            {
+                // Camera 2 units above the floor, boxes 8 units away
+                float linearDepth = v < -0.002f ? std::min(2 / (-v * projection.tanHalfFovY), projection.farPlane) : projection.farPlane;
+                if ((x / 160) % 2 == 0 && v < 0.15f && linearDepth > 8)
+                {
+                    linearDepth = 8;
+                }
+                depth.getRow(y)[x] = projection.farPlane * (linearDepth - projection.nearPlane) / (linearDepth * (projection.farPlane - projection.nearPlane));
+            }
+        }
+    }
+    return depth;
+}
+
+const utinni::softwareFx::Image& getColour()
+{
+    static utinni::softwareFx::Image colour;
+    if (colour.pixels.empty())
+    {
+        colour = utinni::softwareFx::Image(1920, 1080);
+        uint32_t state = 0x12345678;
+        for (uint8_t& value : colour.pixels)
+        {
+            state = state * 1664525u + 1013904223u;
+            value = (uint8_t)(state >> 24);
+        }
+    }
+    return colour;
+}
+
+template <typename Settings>
+void runEffect(uint64_t iterations, Quality quality, void (*effect)(const utinni::softwareFx::Image&, const FloatImage&, const Projection&, const Settings&, utinni::softwareFx::Image&))
+{
+    Settings settings;
+    applyPreset(quality, settings);
+    utinni::softwareFx::Image output;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        effect(getColour(), getDepth(), projection, settings, output);
+        bench::doNotOptimize(output.pixels.data());
+    }
+}
+}
+
+BENCHMARK("depth_fx/ssao_1080p_low")
+{
+    runEffect<SsaoSettings>(iterations, Quality::low, ssao);
+}
+
+BENCHMARK("depth_fx/ssao_1080p_high")
+{
+    runEffect<SsaoSettings>(iterations, Quality::high, ssao);
+}
+
+BENCHMARK("depth_fx/ssao_occlusion_quarter")
+{
+    // The occlusion pass on its own, the part the sample count scales
+    SsaoSettings settings;
+    FloatImage occlusion;
+    FloatImage occlusionDepth;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        computeOcclusion(getDepth(), projection, settings, occlusion, occlusionDepth);
+        bench::doNotOptimize(occlusion.values.data());
+    }
+}
+
+BENCHMARK("depth_fx/dof_1080p_low")
+{
+    runEffect<DofSettings>(iterations, Quality::low, depthOfField);
+}
+
+BENCHMARK("depth_fx/dof_1080p_high")
+{
+    runEffect<DofSettings>(iterations, Quality::high, depthOfField);
+}
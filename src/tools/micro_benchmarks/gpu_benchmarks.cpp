@@ -0,0 +1,193 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/gpu_query_ring.h"
+#include "utility/readback_ring.h"
+#include "utility/depth_pyramid.h"
+#include <cmath>
+#include <vector>
+
+namespace
+{
+const char* const passNames[] = { "FX hue", "FX sharpen", "FX gamma" };
+const char* const phaseNames[] = { "Draw phase 0", "Draw phase 1", "Draw phase 2", "Draw phase 3", "Draw phase 4", "Draw phase 5" };
+
+using SlotTimestamps = uint64_t[utinni::gpu::QueryRing::slotCount][utinni::gpu::QueryRing::maxQueries];
+
+// A frame shaped like the client's: the draw phase marks, and the post processing zones nested in the depth resolve
+void recordFrame(utinni::gpu::QueryRing& ring, SlotTimestamps& slotTimestamps, uint64_t& clock)
+{
+    uint64_t* timestamps = slotTimestamps[ring.beginFrame()];
+    timestamps[utinni::gpu::QueryRing::frameBeginQuery] = clock;
+
+    for (const char* phase : phaseNames)
+    {
+        timestamps[ring.mark(phase)] = clock += 1000;
+    }
+
+    timestamps[ring.beginZone("TextureResolver::resolveDepth")] = clock += 10;
+    for (const char* pass : passNames)
+    {
+        timestamps[ring.beginZone(pass)] = clock += 5;
+        timestamps[ring.endZone()] = clock += 200;
+    }
+    timestamps[ring.endZone()] = clock += 5;
+
+    timestamps[ring.endFrame()] = clock += 50;
+}
+}
+
+BENCHMARK("gpu/query_ring_record_frame")
+{
+    utinni::gpu::QueryRing ring;
+    static SlotTimestamps timestamps;
+    uint64_t clock = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        recordFrame(ring, timestamps, clock);
+        bench::doNotOptimize(ring);
+    }
+}
+
+BENCHMARK("gpu/query_ring_aggregate_frame")
+{
+    // Slots are read back once the ring hands them out, like the D3D9 queries would be
+    utinni::gpu::QueryRing ring;
+    utinni::gpu::Aggregator aggregator;
+    static SlotTimestamps timestamps;
+    uint64_t clock = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        recordFrame(ring, timestamps, clock);
+        for (int slot = ring.getReadySlot(); slot >= 0; slot = ring.getReadySlot())
+        {
+            aggregator.addFrame(ring.getFrame((uint32_t)slot), timestamps[slot], 1000000000);
+            ring.release((uint32_t)slot);
+        }
+    }
+    bench::doNotOptimize(aggregator);
+}
+
+BENCHMARK("gpu/readback_pack_1080p_rgba")
+{
+    // D3D9 pads the pitch of a system memory surface, 1920 * 4 bytes rounded up like a driver would
+    constexpr uint32_t width = 1920;
+    constexpr uint32_t height = 1080;
+    constexpr uint32_t pitch = width * 4 + 64;
+    static std::vector<uint8_t> locked(pitch * height, 0x7f);
+    static std::vector<uint8_t> packed(width * 4 * height);
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        utinni::gpu::packRows(locked.data(), pitch, width * 4, height, packed.data());
+        bench::doNotOptimize(packed);
+    }
+}
+
+BENCHMARK("gpu/readback_ring_cycle")
+{
+    utinni::gpu::ReadbackRing ring;
+    ring.configure(3, 2);
+    for (uint64_t frame = 0; frame < iterations; ++frame)
+    {
+        ring.beginCapture(frame);
+        for (int slot = ring.getReadySlot(frame); slot >= 0; slot = ring.getReadySlot(frame))
+        {
+            ring.release((uint32_t)slot);
+        }
+    }
+    bench::doNotOptimize(ring);
+}
+
+namespace
+{
+// A 1080p depth buffer with a horizon, so the coarse levels have real ranges
+const std::vector<float>& getDepth1080p()
+{
+    static const std::vector<float> depth = [] {
+        std::vector<float> values(1920 * 1080);
+        for (uint32_t y = 0; y < 1080; ++y)
+        {
+            for (uint32_t x = 0; x < 1920; ++x)
+            {
+                values[y * 1920 + x] = y < 400 ? 1.0f : 0.9f + 0.1f * std::sin((float)x * 0.01f) * (1080.0f - (float)y) / 680.0f;
+            }
+        }
+        return values;
+    }();
+    return depth;
+}
+}
+
+BENCHMARK("gpu/depth_pyramid_build_1080p")
+{
+    utinni::gpu::DepthPyramid pyramid;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        pyramid.build(getDepth1080p().data(), 1920, 1080);
+        bench::doNotOptimize(pyramid);
+    }
+}
+
+BENCHMARK("gpu/depth_pyramid_build_from_readback")
+{
+    // The level the GPU pyramid reads back at 1080p, 240x135 min/max pairs
+    static utinni::gpu::DepthPyramid source;
+    static std::vector<float> ranges;
+    if (ranges.empty())
+    {
+        source.build(getDepth1080p().data(), 1920, 1080);
+        for (uint32_t i = 0; i < source.getLevelWidth(3) * source.getLevelHeight(3); ++i)
+        {
+            ranges.push_back(source.getLevel(3)[i].min);
+            ranges.push_back(source.getLevel(3)[i].max);
+        }
+    }
+
+    utinni::gpu::DepthPyramid pyramid;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        pyramid.buildFromRanges(ranges.data(), source.getLevelWidth(3), source.getLevelHeight(3), 3, 1920, 1080);
+        bench::doNotOptimize(pyramid);
+    }
+}
+
+BENCHMARK("gpu/depth_pyramid_occlusion_test")
+{
+    static utinni::gpu::DepthPyramid pyramid;
+    if (pyramid.isEmpty())
+    {
+        pyramid.build(getDepth1080p().data(), 1920, 1080);
+    }
+
+    uint32_t occluded = 0;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const int x = (int)(i * 37 % 1800);
+        const int y = (int)(i * 53 % 1000);
+        const int size = 8 + (int)(i % 120);
+        occluded += pyramid.isOccluded(x, y, x + size, y + size, 0.95f) ? 1 : 0;
+    }
+    bench::doNotOptimize(occluded);
+}
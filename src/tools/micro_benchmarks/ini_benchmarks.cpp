@@ -0,0 +1,155 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "ini.h"
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+constexpr const char* iniFilename = "micro_benchmarks_ut.ini";
+
+// LeksysINI rewrites every '/' in a path to '\\', so outside of Windows it can only open files in the working directory.
+// The ini is accessed by its bare name from inside the temp directory instead.
+class ScopedWorkingDirectory
+{
+public:
+    explicit ScopedWorkingDirectory(const std::filesystem::path& directory) : previous(std::filesystem::current_path())
+    {
+        std::filesystem::current_path(directory);
+    }
+
+    ~ScopedWorkingDirectory()
+    {
+        std::filesystem::current_path(previous);
+    }
+
+    ScopedWorkingDirectory(const ScopedWorkingDirectory&) = delete;
+    ScopedWorkingDirectory& operator=(const ScopedWorkingDirectory&) = delete;
+
+private:
+    std::filesystem::path previous;
+};
+
+// A ut.ini with the default settings in the system temp directory, deleted again when the benchmarks exit
+class TemporaryIni
+{
+public:
+    TemporaryIni() : directory(std::filesystem::temp_directory_path())
+    {
+        const ScopedWorkingDirectory scope(directory);
+        std::remove(iniFilename);
+
+        utinni::IniConfig config;
+        config.createUtinniSettings();
+        config.load(iniFilename);
+    }
+
+    ~TemporaryIni()
+    {
+        std::error_code error;
+        std::filesystem::remove(directory / iniFilename, error);
+    }
+
+    TemporaryIni(const TemporaryIni&) = delete;
+    TemporaryIni& operator=(const TemporaryIni&) = delete;
+
+    const std::filesystem::path& getDirectory() const { return directory; }
+
+private:
+    std::filesystem::path directory;
+};
+
+const TemporaryIni& getTemporaryIni()
+{
+    static TemporaryIni ini;
+    return ini;
+}
+
+utinni::IniConfig& getLoadedConfig()
+{
+    static utinni::IniConfig* config = nullptr;
+    if (config == nullptr)
+    {
+        const ScopedWorkingDirectory scope(getTemporaryIni().getDirectory());
+        config = new utinni::IniConfig();
+        config->createUtinniSettings();
+        config->load(iniFilename);
+    }
+    return *config;
+}
+}
+
+BENCHMARK("ini/load")
+{
+    const ScopedWorkingDirectory scope(getTemporaryIni().getDirectory());
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        utinni::IniConfig config;
+        config.createUtinniSettings();
+        config.load(iniFilename);
+        bench::doNotOptimize(config);
+    }
+}
+
+BENCHMARK("ini/get_bool")
+{
+    utinni::IniConfig& config = getLoadedConfig();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const bool result = config.getBool("Profiler", "enabled");
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("ini/get_int")
+{
+    utinni::IniConfig& config = getLoadedConfig();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const int result = config.getInt("AllocationTracking", "sampleRate");
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("ini/get_float")
+{
+    utinni::IniConfig& config = getLoadedConfig();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const float result = config.getFloat("Profiler", "callbackBudgetMs");
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("ini/get_string")
+{
+    utinni::IniConfig& config = getLoadedConfig();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const std::string result = config.getString("Benchmark", "path");
+        bench::doNotOptimize(result);
+    }
+}
@@ -0,0 +1,307 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+// Micro benchmarks for the parts of the core that don't need the client: swg::math, the pattern scanner, the string
+// utilities, IniConfig, the callback list dispatch, the allocation tracker, the GPU query and readback rings, the depth
+// pyramid, the shader cache index, the software post processing, the colour LUTs, the SSAO and depth of field references
+// and the dynamic resolution controller.
+// Built from the core sources with UTINNI_STATIC, so it also runs on Linux:
+//
+//     g++ -std=c++17 -O2 -pthread -DUTINNI_STATIC -DDEFAULT_PLUGINS=\"\" -I../../core -I../../../external -o micro_benchmarks
+//         *.cpp ../../core/swg/misc/swg_math.cpp ../../core/swg/misc/allocation_tracker.cpp
+//         ../../core/utility/pattern_scanner.cpp ../../core/utility/gpu_query_ring.cpp
+//         ../../core/utility/shader_cache_index.cpp ../../core/utility/software_fx.cpp ../../core/utility/colour_lut.cpp
+//         ../../core/utility/readback_ring.cpp ../../core/utility/depth_pyramid.cpp ../../core/utility/depth_fx.cpp
+//         ../../core/utility/resolution_controller.cpp
+//
+//     micro_benchmarks [--filter <text>] [--samples <n>] [--json <output.json>]
+//     micro_benchmarks --compare <baseline.json> <current.json> [--threshold <percent>]
+//
+// Compare mode exits with 2 when any benchmark got slower than the threshold (default 5%).
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+
+namespace
+{
+struct Result
+{
+    std::string name;
+    uint64_t iterations = 0;
+    uint32_t samples = 0;
+    double medianNs = 0;
+    double minNs = 0;
+    double maxNs = 0;
+};
+
+constexpr double minSampleSeconds = 0.025;
+
+double runSample(bench::Function function, uint64_t iterations)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function(iterations);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+Result run(const bench::Benchmark& benchmark, uint32_t samples)
+{
+    // Warm up, so lazily built fixtures aren't part of the calibration
+    runSample(benchmark.function, 1);
+
+    // Grows the iterations until a sample is long enough for the clock resolution not to matter
+    uint64_t iterations = 1;
+    double seconds = runSample(benchmark.function, iterations);
+    while (seconds < minSampleSeconds && iterations < (1ull << 40))
+    {
+        const double scale = seconds > 0 ? std::min(minSampleSeconds * 1.2 / seconds, 10.0) : 10.0;
+        iterations = std::max(iterations + 1, (uint64_t)(iterations * scale));
+        seconds = runSample(benchmark.function, iterations);
+    }
+
+    std::vector<double> nsPerIteration(samples);
+    for (double& ns : nsPerIteration)
+    {
+        ns = runSample(benchmark.function, iterations) * 1.0e9 / (double)iterations;
+    }
+    std::sort(nsPerIteration.begin(), nsPerIteration.end());
+
+    Result result;
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.samples = samples;
+    result.medianNs = nsPerIteration[samples / 2];
+    result.minNs = nsPerIteration.front();
+    result.maxNs = nsPerIteration.back();
+    return result;
+}
+
+// One benchmark per line, so compare mode can read it back without a JSON library
+bool writeJson(const char* filename, const std::vector<Result>& results)
+{
+    FILE* file = fopen(filename, "w");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Couldn't create %s\n", filename);
+        return false;
+    }
+
+    const time_t now = time(nullptr);
+    fprintf(file, "{\n  \"version\": 1,\n  \"build\": \"%s %s\",\n  \"time\": %lld,\n  \"benchmarks\": [\n", __DATE__, __TIME__, (long long)now);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        fprintf(file, "    { \"name\": \"%s\", \"nsPerOp\": %.4f, \"minNsPerOp\": %.4f, \"maxNsPerOp\": %.4f, \"iterations\": %llu, \"samples\": %u }%s\n",
+                result.name.c_str(), result.medianNs, result.minNs, result.maxNs, (unsigned long long)result.iterations, result.samples,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+bool readJson(const char* filename, std::map<std::string, Result>& results)
+{
+    FILE* file = fopen(filename, "r");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Couldn't open %s\n", filename);
+        return false;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        const char* name = strstr(line, "\"name\": \"");
+        const char* ns = strstr(line, "\"nsPerOp\": ");
+        const char* minNs = strstr(line, "\"minNsPerOp\": ");
+        if (name == nullptr || ns == nullptr || minNs == nullptr)
+        {
+            continue;
+        }
+
+        name += strlen("\"name\": \"");
+        const char* nameEnd = strchr(name, '"');
+        if (nameEnd == nullptr)
+        {
+            continue;
+        }
+
+        Result result;
+        result.name.assign(name, nameEnd);
+        result.medianNs = atof(ns + strlen("\"nsPerOp\": "));
+        result.minNs = atof(minNs + strlen("\"minNsPerOp\": "));
+        results[result.name] = result;
+    }
+    fclose(file);
+
+    if (results.empty())
+    {
+        fprintf(stderr, "No benchmarks in %s\n", filename);
+        return false;
+    }
+    return true;
+}
+
+int compare(const char* baselineFilename, const char* currentFilename, double thresholdPercent)
+{
+    std::map<std::string, Result> baseline;
+    std::map<std::string, Result> current;
+    if (!readJson(baselineFilename, baseline) || !readJson(currentFilename, current))
+    {
+        return 1;
+    }
+
+    printf("%-40s %14s %14s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+
+    int regressions = 0;
+    for (const auto& [name, result] : current)
+    {
+        const auto it = baseline.find(name);
+        if (it == baseline.end())
+        {
+            printf("%-40s %14s %14.2f %9s\n", name.c_str(), "-", result.medianNs, "new");
+            continue;
+        }
+
+        const double change = (result.medianNs / it->second.medianNs - 1.0) * 100.0;
+
+        // Both the median and the fastest sample have to be slower, a single noisy run isn't flagged
+        const double minChange = (result.minNs / it->second.minNs - 1.0) * 100.0;
+        const bool regressed = change > thresholdPercent && minChange > thresholdPercent;
+        regressions += regressed ? 1 : 0;
+
+        printf("%-40s %14.2f %14.2f %+8.1f%%%s\n", name.c_str(), it->second.medianNs, result.medianNs, change, regressed ? "  REGRESSION" : "");
+    }
+
+    for (const auto& [name, result] : baseline)
+    {
+        if (current.find(name) == current.end())
+        {
+            printf("%-40s %14.2f %14s %9s\n", name.c_str(), result.medianNs, "-", "removed");
+        }
+    }
+
+    if (regressions > 0)
+    {
+        printf("%d benchmark(s) regressed by more than %.1f%%\n", regressions, thresholdPercent);
+        return 2;
+    }
+    return 0;
+}
+
+void printUsage(const char* program)
+{
+    fprintf(stderr, "Usage: %s [--filter <text>] [--samples <n>] [--json <output.json>]\n", program);
+    fprintf(stderr, "       %s --compare <baseline.json> <current.json> [--threshold <percent>]\n", program);
+}
+}
+
+namespace bench
+{
+std::vector<Benchmark>& getBenchmarks()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    const char* jsonFilename = nullptr;
+    const char* compareFilenames[2] = {};
+    uint32_t samples = 15;
+    double thresholdPercent = 5.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--filter") == 0 && hasValue)
+        {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && hasValue)
+        {
+            samples = (uint32_t)std::max(atoi(argv[++i]), 1);
+        }
+        else if (strcmp(argv[i], "--json") == 0 && hasValue)
+        {
+            jsonFilename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--compare") == 0 && i + 2 < argc)
+        {
+            compareFilenames[0] = argv[++i];
+            compareFilenames[1] = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threshold") == 0 && hasValue)
+        {
+            thresholdPercent = atof(argv[++i]);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (compareFilenames[0] != nullptr)
+    {
+        return compare(compareFilenames[0], compareFilenames[1], thresholdPercent);
+    }
+
+    std::vector<bench::Benchmark> benchmarks = bench::getBenchmarks();
+    std::sort(benchmarks.begin(), benchmarks.end(), [](const bench::Benchmark& a, const bench::Benchmark& b) { return strcmp(a.name, b.name) < 0; });
+
+    std::vector<Result> results;
+    printf("%-40s %14s %14s %14s\n", "benchmark", "median ns", "min ns", "iterations");
+    for (const bench::Benchmark& benchmark : benchmarks)
+    {
+        if (filter != nullptr && strstr(benchmark.name, filter) == nullptr)
+        {
+            continue;
+        }
+
+        const Result result = run(benchmark, samples);
+        printf("%-40s %14.2f %14.2f %14llu\n", result.name.c_str(), result.medianNs, result.minNs, (unsigned long long)result.iterations);
+        fflush(stdout);
+        results.emplace_back(result);
+    }
+
+    if (jsonFilename != nullptr && !writeJson(jsonFilename, results))
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "swg/misc/swg_math.h"
+
+namespace
+{
+swg::math::Transform makeTransform(float yaw, float pitch, float x, float y, float z)
+{
+    swg::math::Transform transform;
+    transform.yaw(yaw);
+    transform.pitch(pitch);
+    transform.setPosition(x, y, z);
+    return transform;
+}
+}
+
+BENCHMARK("math/transform_multiply")
+{
+    const swg::math::Transform left = makeTransform(30, 10, 100, 5, -40);
+    const swg::math::Transform right = makeTransform(-75, 4, 1, 2, 3);
+    swg::math::Transform result;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        result.multiply(left, right);
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("math/transform_invert")
+{
+    const swg::math::Transform transform = makeTransform(30, 10, 100, 5, -40);
+    swg::math::Transform result;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        result.invert(transform);
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("math/transform_yaw_pitch")
+{
+    swg::math::Transform transform;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        transform.yaw(1.5f);
+        transform.pitch(-0.5f);
+        bench::doNotOptimize(transform);
+    }
+}
+
+BENCHMARK("math/transform_rotate_translate_l2p")
+{
+    swg::math::Transform transform = makeTransform(30, 10, 100, 5, -40);
+    swg::math::Vector vector(1, 2, 3);
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        vector = transform.rotateTranslate_l2p(vector) * 0.5f;
+        bench::doNotOptimize(vector);
+    }
+}
+
+BENCHMARK("math/quaternion_from_transform")
+{
+    const swg::math::Transform transform = makeTransform(30, 10, 100, 5, -40);
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const swg::math::Quaternion quaternion(transform);
+        bench::doNotOptimize(quaternion);
+    }
+}
+
+BENCHMARK("math/matrix4x4_from_transform")
+{
+    const swg::math::Transform transform = makeTransform(30, 10, 100, 5, -40);
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const swg::math::Matrix4x4 matrix(transform);
+        bench::doNotOptimize(matrix);
+    }
+}
+
+BENCHMARK("math/vector_normalize")
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        swg::math::Vector vector(3.0f, (float)(i & 15), 4.0f);
+        vector.normalize();
+        bench::doNotOptimize(vector);
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/pattern_scanner.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+constexpr size_t bufferSize = 30 * 1024 * 1024; // About the size of the client image
+
+// Code-like bytes from a fixed seed, with the searched signatures planted near the end so a scan covers the whole buffer
+const byte* getBuffer()
+{
+    static byte* buffer = nullptr;
+    if (buffer != nullptr)
+    {
+        return buffer;
+    }
+
+#ifdef _WIN32
+    buffer = new byte[bufferSize];
+#else
+    // swgptr is 32 bit, so the buffer has to live in the low 4 GB on a 64 bit host
+    void* memory = mmap(nullptr, bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    buffer = (byte*)memory;
+#endif
+
+    // Biased towards the common x86 bytes, like the scanner's anchor heuristic expects
+    static const byte common[] = { 0x00, 0x8B, 0xFF, 0x89, 0x48, 0xE8, 0x83, 0x0F, 0x45, 0x24, 0xC7, 0x85, 0x74, 0x75, 0xC3, 0xCC };
+    uint32_t state = 0x12345678;
+    for (size_t i = 0; i < bufferSize; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        buffer[i] = (state & 0x300) != 0 ? common[state & 15] : (byte)(state >> 24);
+    }
+
+    static const byte planted[] = { 0x55, 0x8B, 0xEC, 0x6A, 0xFF, 0x68, 0x3C, 0x9A, 0x12, 0x01, 0x64, 0xA1, 0x00, 0x00, 0x00, 0x00 };
+    memcpy(buffer + bufferSize - 4096, planted, sizeof(planted));
+    return buffer;
+}
+
+swgptr getBufferAddress()
+{
+    return (swgptr)(uintptr_t)getBuffer();
+}
+}
+
+BENCHMARK("pattern/parse_signature")
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const memory::Pattern pattern("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1 00 00 00 00 50 83 EC ?? 53 56 57");
+        bench::doNotOptimize(pattern);
+    }
+}
+
+BENCHMARK("pattern/scan_30mb_single")
+{
+    if (getBuffer() == nullptr)
+    {
+        return;
+    }
+
+    memory::PatternScanner scanner;
+    scanner.add("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1");
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const auto matches = scanner.scan(getBufferAddress(), bufferSize);
+        bench::doNotOptimize(matches);
+    }
+}
+
+BENCHMARK("pattern/scan_30mb_many_anchors")
+{
+    if (getBuffer() == nullptr)
+    {
+        return;
+    }
+
+    // More distinct anchor bytes than the SSE2 filter takes, goes through the scalar path
+    memory::PatternScanner scanner;
+    scanner.add("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1");
+    scanner.add("6A 13 37 ?? 9F 5E");
+    scanner.add("A1 ?? ?? ?? ?? 3D 42 42 77 01");
+    scanner.add("B9 ?? ?? ?? ?? E8 ?? ?? ?? ?? 5B 1C 2D");
+    scanner.add("D9 EE D8 D1 DF E0 F6 C4 41");
+    scanner.add("81 EC 1C 04 00 00 A1 ?? ?? ?? ?? 33 C4");
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const auto matches = scanner.scan(getBufferAddress(), bufferSize);
+        bench::doNotOptimize(matches);
+    }
+}
+
+BENCHMARK("pattern/scan_30mb_first_only")
+{
+    if (getBuffer() == nullptr)
+    {
+        return;
+    }
+
+    memory::PatternScanner scanner;
+    scanner.add("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1");
+    scanner.add("6A FF 68 ?? ?? ?? ?? 64");
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const auto matches = scanner.scan(getBufferAddress(), bufferSize, true);
+        bench::doNotOptimize(matches);
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/resolution_controller.h"
+#include <vector>
+
+namespace
+{
+using utinni::gpu::ResolutionController;
+
+// A minute at 60 FPS of a GPU bound client: 3 ms of CPU, a scene costing 12 ms at the full size that doubles while a
+// crowd is on screen, a few ms of noise and a streaming hitch every few seconds. Frame times are generated from the scale
+// the controller picked for the frame before, as a recorded session would have them
+struct Trace
+{
+    std::vector<float> sceneMs;
+    std::vector<float> otherMs;
+};
+
+const Trace& getTrace()
+{
+    static Trace trace;
+    if (trace.sceneMs.empty())
+    {
+        uint32_t state = 0x12345678;
+        for (uint32_t frame = 0; frame < 3600; ++frame)
+        {
+            state = state * 1664525u + 1013904223u;
+            const float noise = (float)(state >> 16) / 65535.0f * 2.0f;
+            trace.sceneMs.push_back(frame >= 1200 && frame < 2400 ? 24.0f : 12.0f);
+            trace.otherMs.push_back(3.0f + noise + (frame % 250 == 0 ? 30.0f : 0.0f));
+        }
+    }
+    return trace;
+}
+}
+
+BENCHMARK("resolution/controller_update")
+{
+    ResolutionController controller;
+    float frameMs = 15;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        frameMs = frameMs > 18 ? 12.0f : frameMs + 0.01f;
+        bench::doNotOptimize(controller.update(frameMs));
+    }
+}
+
+BENCHMARK("resolution/replay_minute_trace")
+{
+    const Trace& trace = getTrace();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        ResolutionController controller;
+        float scale = 1;
+        for (size_t frame = 0; frame < trace.sceneMs.size(); ++frame)
+        {
+            scale = controller.update(trace.otherMs[frame] + trace.sceneMs[frame] * scale * scale);
+        }
+        bench::doNotOptimize(scale);
+        bench::doNotOptimize(controller.getChangeCount());
+    }
+}
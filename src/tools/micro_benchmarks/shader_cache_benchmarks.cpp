@@ -0,0 +1,70 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/shader_cache_index.h"
+
+namespace
+{
+// The defines of a fused SytnersFX variant
+const std::vector<utinni::shaderCache::Define> defines = { { "HUE", "1" }, { "SHARPEN", "1" }, { "GAMMA", "1" } };
+}
+
+BENCHMARK("shader_cache/make_key")
+{
+    static const std::string source(4096, 'x');
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const uint64_t sourceHash = utinni::shaderCache::hash(source.data(), source.size());
+        bench::doNotOptimize(utinni::shaderCache::makeKey(sourceHash, "ps_3_0", "main", defines));
+    }
+}
+
+BENCHMARK("shader_cache/unpack_16k")
+{
+    const std::vector<uint8_t> bytecode(16 * 1024, 0x5A);
+    const std::vector<uint8_t> file = utinni::shaderCache::pack(42, bytecode);
+    std::vector<uint8_t> unpacked;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        bench::doNotOptimize(utinni::shaderCache::unpack(file, 42, unpacked));
+    }
+}
+
+BENCHMARK("shader_cache/index_round_trip")
+{
+    // A cache the size of a session with every fused variant and the client's vertex shaders
+    utinni::shaderCache::Index index;
+    for (uint64_t key = 0; key < 512; ++key)
+    {
+        index.touch(key * 0x9E3779B97F4A7C15ull, 2048 + key);
+    }
+
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        utinni::shaderCache::Index loaded;
+        loaded.deserialize(index.serialize());
+        bench::doNotOptimize(loaded.getTotalSize());
+    }
+}
@@ -0,0 +1,138 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/software_fx.h"
+
+namespace
+{
+using namespace utinni::softwareFx;
+
+// A 1080p frame of noise, and a LUT that isn't an identity so every fetch lands somewhere different
+const Image& getFrame()
+{
+    static Image frame;
+    if (frame.pixels.empty())
+    {
+        frame = Image(1920, 1080);
+        uint32_t state = 0x12345678;
+        for (uint8_t& value : frame.pixels)
+        {
+            state = state * 1664525u + 1013904223u;
+            value = (uint8_t)(state >> 24);
+        }
+    }
+    return frame;
+}
+
+const Lut& getLut()
+{
+    static Lut lut;
+    if (lut.getSize() == 0)
+    {
+        Image strip(256, 16);
+        for (size_t i = 0; i < strip.pixels.size(); ++i)
+        {
+            strip.pixels[i] = (uint8_t)(i * 7);
+        }
+        lut.load(strip);
+    }
+    return lut;
+}
+
+Settings getSettings()
+{
+    Settings settings;
+    settings.tone[0] = 1.1f;
+    settings.tone[1] = 0.9f;
+    settings.tone[2] = 0.8f;
+    settings.lut = &getLut();
+    settings.sharpenAmount = 0.5f;
+    settings.gamma = 1.2f;
+    return settings;
+}
+
+void runStage(uint64_t iterations, void (*stage)(const Image&, Image&, const Settings&))
+{
+    const Settings settings = getSettings();
+    Image output;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        stage(getFrame(), output, settings);
+        bench::doNotOptimize(output.pixels[0]);
+    }
+}
+}
+
+BENCHMARK("software_fx/hue_1080p")
+{
+    runStage(iterations, hue);
+}
+
+BENCHMARK("software_fx/grading_1080p")
+{
+    runStage(iterations, grading);
+}
+
+BENCHMARK("software_fx/sharpen_1080p")
+{
+    runStage(iterations, sharpen);
+}
+
+BENCHMARK("software_fx/gamma_1080p")
+{
+    runStage(iterations, gamma);
+}
+
+BENCHMARK("software_fx/8bit_1080p")
+{
+    runStage(iterations, eightBit);
+}
+
+BENCHMARK("software_fx/ascii_1080p")
+{
+    runStage(iterations, ascii);
+}
+
+BENCHMARK("software_fx/chain_separate_1080p")
+{
+    const Settings settings = getSettings();
+    Image output;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        process(getFrame(), output, Stage_Grading | Stage_Sharpen | Stage_Gamma, settings, false);
+        bench::doNotOptimize(output.pixels[0]);
+    }
+}
+
+BENCHMARK("software_fx/chain_fused_1080p")
+{
+    const Settings settings = getSettings();
+    Image output;
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        process(getFrame(), output, Stage_Grading | Stage_Sharpen | Stage_Gamma, settings, true);
+        bench::doNotOptimize(output.pixels[0]);
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "benchmark.h"
+#include "utility/string_utility.h"
+
+BENCHMARK("string/to_string_int_padded")
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const std::string result = stringUtility::toString((int)(i & 0xFFFF), 6);
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("string/to_hex_string")
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const std::string result = stringUtility::toHexString((uint32_t)i, 8);
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("string/to_bool")
+{
+    const std::string values[] = { "true", "false" };
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const bool result = stringUtility::toBool(values[i & 1]);
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("string/trim_copy")
+{
+    const std::string input = " \t  object/tangible/furniture/all/shared_frn_all_chair_wooden_s2.iff \r\n";
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        const std::string result = stringUtility::trim_copy(input);
+        bench::doNotOptimize(result);
+    }
+}
+
+BENCHMARK("string/const_char_length")
+{
+    const char* input = "object/tangible/furniture/all/shared_frn_all_chair_wooden_s2.iff";
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        bench::doNotOptimize(input);
+        const size_t result = constCharUtility::length(input);
+        bench::doNotOptimize(result);
+    }
+}
@@ -0,0 +1,174 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "test.h"
+#include "utility/depth_fx.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace utinni::depthFx;
+using utinni::softwareFx::Image;
+
+namespace
+{
+constexpr uint32_t width = 64;
+constexpr uint32_t height = 48;
+
+// The raw depth buffer value of a linear depth, the inverse of Projection::getLinearDepth
+float getRawDepth(const Projection& projection, float linearDepth)
+{
+    return (projection.farPlane - projection.nearPlane * projection.farPlane / linearDepth) / (projection.farPlane - projection.nearPlane);
+}
+
+Image makeNoiseImage()
+{
+    Image image(width, height);
+    uint32_t state = 0x13579bdf;
+    for (size_t i = 0; i < image.pixels.size(); ++i)
+    {
+        state = state * 1664525 + 1013904223;
+        image.pixels[i] = i % 4 == 3 ? 255 : (uint8_t)(state >> 24);
+    }
+    return image;
+}
+
+bool isPixelEqual(const Image& a, const Image& b, uint32_t x, uint32_t y)
+{
+    return std::equal(a.getRow(y) + x * 4, a.getRow(y) + x * 4 + 4, b.getRow(y) + x * 4);
+}
+}
+
+TEST("depth_fx/flat_depth_has_no_occlusion")
+{
+    // A wall facing the camera, every neighbour is on the surface so the bias keeps it from occluding itself
+    const Projection projection;
+    const Image src = makeNoiseImage();
+    for (const Quality quality : { Quality::low, Quality::medium, Quality::high, Quality::ultra })
+    {
+        for (const float linearDepth : { 2.0f, 10.0f, 300.0f })
+        {
+            const FloatImage depth(width, height, getRawDepth(projection, linearDepth));
+            SsaoSettings settings;
+            applyPreset(quality, settings);
+            settings.strength = 1;
+
+            FloatImage occlusion;
+            FloatImage occlusionDepth;
+            computeOcclusion(depth, projection, settings, occlusion, occlusionDepth);
+            CHECK(*std::min_element(occlusion.values.begin(), occlusion.values.end()) == 1.0f);
+
+            Image dst;
+            ssao(src, depth, projection, settings, dst);
+            CHECK(dst.pixels == src.pixels);
+        }
+    }
+
+    // The sky is left alone whatever it looks like
+    const FloatImage sky(width, height, 1.0f);
+    Image dst;
+    ssao(src, sky, projection, SsaoSettings(), dst);
+    CHECK(dst.pixels == src.pixels);
+}
+
+TEST("depth_fx/step_in_depth_occludes")
+{
+    // Keeps the flat test honest: a box half a unit in front of a wall darkens the wall around it
+    const Projection projection;
+    FloatImage depth(width, height, getRawDepth(projection, 10));
+    for (uint32_t y = height / 4; y < height * 3 / 4; ++y)
+    {
+        std::fill(depth.getRow(y) + width / 4, depth.getRow(y) + width * 3 / 4, getRawDepth(projection, 9.5f));
+    }
+
+    SsaoSettings settings;
+    FloatImage occlusion;
+    FloatImage occlusionDepth;
+    computeOcclusion(depth, projection, settings, occlusion, occlusionDepth);
+    CHECK(*std::min_element(occlusion.values.begin(), occlusion.values.end()) < 0.9f);
+    CHECK(*std::max_element(occlusion.values.begin(), occlusion.values.end()) == 1.0f);
+}
+
+TEST("depth_fx/circle_of_confusion")
+{
+    DofSettings settings;
+    CHECK(getCircleOfConfusion(settings.focusDistance, settings) == 0);
+    CHECK(getCircleOfConfusion(settings.focusDistance + settings.focusRange, settings) == 0);
+    CHECK(getCircleOfConfusion(settings.focusDistance - settings.focusRange, settings) == 0);
+    CHECK_NEAR(getCircleOfConfusion(settings.focusDistance + settings.focusRange + settings.blurRange * 0.5f, settings), 0.5f, 1e-5f);
+    CHECK(getCircleOfConfusion(settings.focusDistance + settings.focusRange + settings.blurRange * 2, settings) == 1);
+    CHECK(getCircleOfConfusion(settings.focusDistance - settings.focusRange - settings.blurRange * 0.5f, settings) < 0);
+}
+
+TEST("depth_fx/in_focus_pixels_are_unchanged")
+{
+    // The left half is in the sharp range and the right half far behind it, only the right half may change
+    const Projection projection;
+    const DofSettings defaults;
+    FloatImage depth(width, height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const float linearDepth = x < width / 2 ? defaults.focusDistance + defaults.focusRange * ((float)y / (float)height * 2 - 1) : 200.0f;
+            depth.getRow(y)[x] = getRawDepth(projection, linearDepth);
+        }
+    }
+
+    const Image src = makeNoiseImage();
+    for (const Quality quality : { Quality::low, Quality::medium, Quality::high, Quality::ultra })
+    {
+        DofSettings settings;
+        applyPreset(quality, settings);
+        Image dst;
+        depthOfField(src, depth, projection, settings, dst);
+        if (!CHECK(dst.width == width && dst.height == height))
+        {
+            continue;
+        }
+
+        uint32_t changed = 0;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const float coc = getCircleOfConfusion(projection.getLinearDepth(depth.getRow(y)[x]), settings);
+                if (coc == 0)
+                {
+                    CHECK(isPixelEqual(dst, src, x, y));
+                }
+                else if (!isPixelEqual(dst, src, x, y))
+                {
+                    changed++;
+                }
+            }
+        }
+        CHECK(changed > width * height / 4);
+    }
+
+    // Everything in focus is the identity
+    const FloatImage focused(width, height, getRawDepth(projection, defaults.focusDistance));
+    Image dst;
+    depthOfField(src, focused, projection, defaults, dst);
+    CHECK(dst.pixels == src.pixels);
+}
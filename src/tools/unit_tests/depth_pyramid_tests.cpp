@@ -0,0 +1,242 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "test.h"
+#include "utility/depth_pyramid.h"
+#include <algorithm>
+
+using utinni::gpu::DepthPyramid;
+using utinni::gpu::DepthRange;
+
+namespace
+{
+constexpr float wallDepth = 0.2f; // Near the camera, occludes the tested bounds
+constexpr float holeDepth = 0.95f; // Behind the tested bounds
+constexpr float boundsDepth = 0.5f;
+
+struct DepthBuffer
+{
+    uint32_t width;
+    uint32_t height;
+    std::vector<float> depth;
+
+    DepthBuffer(uint32_t width, uint32_t height, float value) : width(width), height(height), depth((size_t)width * height, value) { }
+
+    // The exact range over [x0, x1) x [y0, y1) clamped to the buffer, what the pyramid has to contain
+    DepthRange getRange(int x0, int y0, int x1, int y1) const
+    {
+        DepthRange range = { 1.0f, 0.0f };
+        for (int y = std::max(y0, 0); y < std::min(y1, (int)height); ++y)
+        {
+            for (int x = std::max(x0, 0); x < std::min(x1, (int)width); ++x)
+            {
+                range.min = std::min(range.min, depth[(size_t)y * width + x]);
+                range.max = std::max(range.max, depth[(size_t)y * width + x]);
+            }
+        }
+        return range;
+    }
+};
+
+DepthBuffer makeNoiseBuffer(uint32_t width, uint32_t height)
+{
+    DepthBuffer buffer(width, height, 0);
+    uint32_t state = 0x2468ace1;
+    for (float& value : buffer.depth)
+    {
+        state = state * 1664525 + 1013904223;
+        value = (float)(state >> 8) / (float)(1 << 24);
+    }
+    return buffer;
+}
+
+// Level 1 of a full resolution pyramid as the min/max pairs the GPU pyramid reads back
+DepthPyramid makeShiftedPyramid(const DepthBuffer& buffer)
+{
+    DepthPyramid full;
+    full.build(buffer.depth.data(), buffer.width, buffer.height);
+
+    const uint32_t width = full.getLevelWidth(1);
+    const uint32_t height = full.getLevelHeight(1);
+    std::vector<float> ranges;
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        ranges.emplace_back(full.getLevel(1)[i].min);
+        ranges.emplace_back(full.getLevel(1)[i].max);
+    }
+
+    DepthPyramid shifted;
+    shifted.buildFromRanges(ranges.data(), width, height, 1, buffer.width, buffer.height);
+    return shifted;
+}
+
+// Every rectangle up to maxSize, including ones hanging over the edges, has to get a range containing the exact one
+bool containsExactRanges(const DepthPyramid& pyramid, const DepthBuffer& buffer, int maxSize)
+{
+    for (int y0 = -2; y0 < (int)buffer.height; y0 += 3)
+    {
+        for (int x0 = -2; x0 < (int)buffer.width; x0 += 2)
+        {
+            for (int size = 1; size <= maxSize; size = size * 2 + 1)
+            {
+                const DepthRange exact = buffer.getRange(x0, y0, x0 + size, y0 + size + 1);
+                const DepthRange range = pyramid.getRange(x0, y0, x0 + size, y0 + size + 1);
+                if (exact.min > exact.max)
+                {
+                    continue; // Off the screen
+                }
+                if (!CHECK(range.min <= exact.min && range.max >= exact.max))
+                {
+                    printf("    rectangle %d, %d, size %d\n", x0, y0, size);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// A hole behind the bounds at every pixel in turn, every rectangle over it has to stay visible
+bool holesAreNeverOccluded(uint32_t width, uint32_t height, bool shifted)
+{
+    for (uint32_t holeY = 0; holeY < height; holeY += 2)
+    {
+        for (uint32_t holeX = 0; holeX < width; holeX += 3)
+        {
+            DepthBuffer buffer(width, height, wallDepth);
+            buffer.depth[(size_t)holeY * width + holeX] = holeDepth;
+
+            DepthPyramid pyramid;
+            if (shifted)
+            {
+                pyramid = makeShiftedPyramid(buffer);
+            }
+            else
+            {
+                pyramid.build(buffer.depth.data(), width, height);
+            }
+
+            for (const int size : { 1, 2, 5, 16 })
+            {
+                for (int offset = 0; offset < size; offset += std::max(size / 3, 1))
+                {
+                    const int x0 = (int)holeX - offset;
+                    const int y0 = (int)holeY - (size - 1 - offset);
+                    if (!CHECK(!pyramid.isOccluded(x0, y0, x0 + size, y0 + size, boundsDepth)))
+                    {
+                        printf("    %ux%u, hole at %u, %u, rectangle %d, %d, size %d\n", width, height, holeX, holeY, x0, y0, size);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+}
+
+TEST("depth_pyramid/levels_halve_rounding_up")
+{
+    const DepthBuffer buffer = makeNoiseBuffer(37, 23);
+    DepthPyramid pyramid;
+    pyramid.build(buffer.depth.data(), buffer.width, buffer.height);
+
+    const uint32_t widths[] = { 37, 19, 10, 5, 3, 2, 1 };
+    const uint32_t heights[] = { 23, 12, 6, 3, 2, 1, 1 };
+    if (CHECK(pyramid.getLevelCount() == 7))
+    {
+        for (uint32_t level = 0; level < 7; ++level)
+        {
+            CHECK(pyramid.getLevelWidth(level) == widths[level]);
+            CHECK(pyramid.getLevelHeight(level) == heights[level]);
+        }
+
+        // The last row and column of an odd level are folded into the texel above them, not dropped
+        const DepthRange exact = buffer.getRange(0, 0, 37, 23);
+        CHECK(pyramid.getLevel(6)[0].min == exact.min);
+        CHECK(pyramid.getLevel(6)[0].max == exact.max);
+    }
+}
+
+TEST("depth_pyramid/ranges_contain_the_exact_range")
+{
+    for (const auto& [width, height] : { std::pair<uint32_t, uint32_t>{ 64, 48 }, { 37, 23 }, { 1, 17 }, { 33, 1 } })
+    {
+        const DepthBuffer buffer = makeNoiseBuffer(width, height);
+        DepthPyramid pyramid;
+        pyramid.build(buffer.depth.data(), width, height);
+        CHECK(containsExactRanges(pyramid, buffer, 40));
+    }
+}
+
+TEST("depth_pyramid/ranges_contain_the_exact_range_with_a_base_shift")
+{
+    for (const auto& [width, height] : { std::pair<uint32_t, uint32_t>{ 64, 48 }, { 37, 23 }, { 3, 17 } })
+    {
+        const DepthBuffer buffer = makeNoiseBuffer(width, height);
+        const DepthPyramid pyramid = makeShiftedPyramid(buffer);
+        CHECK(pyramid.getBaseWidth() == width);
+        CHECK(pyramid.getLevelShift(0) == 1);
+        CHECK(containsExactRanges(pyramid, buffer, 40));
+    }
+}
+
+TEST("depth_pyramid/rectangles_over_a_hole_are_never_occluded")
+{
+    CHECK(holesAreNeverOccluded(32, 32, false));
+    CHECK(holesAreNeverOccluded(37, 23, false));
+    CHECK(holesAreNeverOccluded(37, 23, true));
+    CHECK(holesAreNeverOccluded(5, 9, true));
+}
+
+TEST("depth_pyramid/solid_wall_occludes")
+{
+    const DepthBuffer buffer(37, 23, wallDepth);
+    DepthPyramid pyramid;
+    pyramid.build(buffer.depth.data(), buffer.width, buffer.height);
+    const DepthPyramid shifted = makeShiftedPyramid(buffer);
+
+    for (const int size : { 1, 4, 9, 37 })
+    {
+        CHECK(pyramid.isOccluded(3, 2, 3 + size, 2 + size, boundsDepth));
+        CHECK(shifted.isOccluded(3, 2, 3 + size, 2 + size, boundsDepth));
+        CHECK(!pyramid.isOccluded(3, 2, 3 + size, 2 + size, wallDepth)); // Touching the wall is not behind it
+    }
+}
+
+TEST("depth_pyramid/nothing_is_occluded_without_a_pyramid_or_off_screen")
+{
+    DepthPyramid pyramid;
+    CHECK(!pyramid.isOccluded(0, 0, 8, 8, boundsDepth));
+
+    const DepthBuffer buffer(16, 16, wallDepth);
+    pyramid.build(buffer.depth.data(), buffer.width, buffer.height);
+    CHECK(!pyramid.isOccluded(-8, 0, 0, 8, boundsDepth));
+    CHECK(!pyramid.isOccluded(16, 16, 24, 24, boundsDepth));
+    CHECK(!pyramid.isOccluded(4, 4, 4, 8, boundsDepth)); // Empty
+
+    pyramid.clear();
+    CHECK(pyramid.isEmpty());
+    CHECK(!pyramid.isOccluded(0, 0, 8, 8, boundsDepth));
+}
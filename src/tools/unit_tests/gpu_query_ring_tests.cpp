@@ -0,0 +1,240 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "test.h"
+#include "utility/gpu_query_ring.h"
+#include <algorithm>
+#include <cstring>
+
+using utinni::gpu::Aggregator;
+using utinni::gpu::QueryRing;
+using utinni::gpu::ZoneStats;
+
+namespace
+{
+constexpr uint64_t frequency = 1000000; // 1 tick = 1 us
+
+// Records a frame with one "scene" zone, timestamps[] gets the frame and zone times in ticks
+uint32_t recordFrame(QueryRing& ring, uint64_t* timestamps, uint64_t frameTicks, uint64_t sceneTicks)
+{
+    const uint32_t slot = ring.beginFrame();
+    timestamps[QueryRing::frameBeginQuery] = 1000;
+
+    const int begin = ring.beginZone("scene");
+    const int end = ring.endZone();
+    ring.endFrame();
+
+    timestamps[begin] = 1000;
+    timestamps[end] = 1000 + sceneTicks;
+    timestamps[QueryRing::frameEndQuery] = 1000 + frameTicks;
+    return slot;
+}
+
+const ZoneStats* findZone(const Aggregator& aggregator, const char* name)
+{
+    for (const ZoneStats& zone : aggregator.getZones())
+    {
+        if (strcmp(zone.name, name) == 0)
+        {
+            return &zone;
+        }
+    }
+    return nullptr;
+}
+}
+
+TEST("gpu_query_ring/slots_are_read_after_the_latency_and_reused")
+{
+    QueryRing ring;
+    uint64_t timestamps[QueryRing::maxQueries] = {};
+
+    // Nothing is ready until the GPU is frameLatency frames behind
+    for (uint32_t i = 0; i < QueryRing::frameLatency; ++i)
+    {
+        CHECK(recordFrame(ring, timestamps, 16000, 8000) == i);
+        if (i + 1 < QueryRing::frameLatency)
+        {
+            CHECK(ring.getReadySlot() < 0);
+        }
+    }
+    CHECK(ring.getReadySlot() == 0);
+
+    // Reading back in order frees every slot for reuse without dropping anything
+    for (uint32_t frame = QueryRing::frameLatency; frame < 4 * QueryRing::slotCount; ++frame)
+    {
+        const int ready = ring.getReadySlot();
+        if (!CHECK(ready >= 0))
+        {
+            return;
+        }
+        CHECK(ring.getFrame((uint32_t)ready).index + QueryRing::frameLatency == frame);
+        ring.release((uint32_t)ready);
+
+        CHECK(recordFrame(ring, timestamps, 16000, 8000) == frame % QueryRing::slotCount);
+    }
+    CHECK(ring.getDroppedCount() == 0);
+}
+
+TEST("gpu_query_ring/unread_slots_are_dropped_on_wrap")
+{
+    QueryRing ring;
+    uint64_t timestamps[QueryRing::maxQueries] = {};
+
+    for (uint32_t i = 0; i < QueryRing::slotCount; ++i)
+    {
+        recordFrame(ring, timestamps, 16000, 8000);
+    }
+    CHECK(ring.getDroppedCount() == 0);
+
+    // The oldest slot was never read back, recording over it drops it instead of waiting
+    CHECK(recordFrame(ring, timestamps, 16000, 8000) == 0);
+    CHECK(ring.getDroppedCount() == 1);
+    CHECK(ring.getFrame(0).index == QueryRing::slotCount);
+    CHECK(ring.getFrame(0).pending);
+    CHECK(ring.getReadySlot() == 1);
+}
+
+TEST("gpu_query_ring/zone_overflow_keeps_nesting_balanced")
+{
+    QueryRing ring;
+    ring.beginFrame();
+
+    for (uint32_t i = 0; i < QueryRing::maxDepth + 4; ++i)
+    {
+        ring.beginZone("nested");
+    }
+    for (uint32_t i = 0; i < QueryRing::maxDepth + 4; ++i)
+    {
+        ring.endZone();
+    }
+
+    // Back at the top level, a new zone starts at depth 0
+    CHECK(ring.beginZone("top") >= 0);
+    const QueryRing::Frame& frame = ring.getFrame(ring.getCurrentSlot());
+    CHECK(frame.zones[frame.zoneCount - 1].depth == 0);
+    ring.endZone();
+
+    // Zones still open at the end of the frame end with it
+    ring.beginZone("open");
+    CHECK(ring.endFrame() == (int)QueryRing::frameEndQuery);
+    CHECK(frame.zones[frame.zoneCount - 1].endQuery == QueryRing::frameEndQuery);
+}
+
+TEST("gpu_query_ring/disjoint_and_invalid_frames_are_discarded")
+{
+    QueryRing ring;
+    Aggregator aggregator;
+    uint64_t timestamps[QueryRing::maxQueries] = {};
+    const uint32_t slot = recordFrame(ring, timestamps, 16000, 8000);
+    const QueryRing::Frame& frame = ring.getFrame(slot);
+
+    CHECK(!aggregator.addFrame(frame, timestamps, frequency, true));
+    CHECK(!aggregator.addFrame(frame, timestamps, 0));
+
+    uint64_t backwards[QueryRing::maxQueries] = {};
+    std::copy(timestamps, timestamps + QueryRing::maxQueries, backwards);
+    backwards[QueryRing::frameEndQuery] = backwards[QueryRing::frameBeginQuery] - 1;
+    CHECK(!aggregator.addFrame(frame, backwards, frequency));
+
+    CHECK(aggregator.getDiscardedCount() == 3);
+    CHECK(aggregator.getFrameCount() == 0);
+    CHECK(aggregator.getZones().empty());
+    CHECK(aggregator.getLastFrameMs() == 0);
+
+    CHECK(aggregator.addFrame(frame, timestamps, frequency));
+    CHECK(aggregator.getFrameCount() == 1);
+    CHECK_NEAR(aggregator.getLastFrameMs(), 16.0, 1e-9);
+
+    aggregator.reset();
+    CHECK(aggregator.getDiscardedCount() == 0);
+}
+
+TEST("gpu_query_ring/aggregate_averages")
+{
+    QueryRing ring;
+    Aggregator aggregator;
+    uint64_t timestamps[QueryRing::maxQueries] = {};
+
+    // The first frame seeds the averages, later ones move them by a fixed weight
+    uint32_t slot = recordFrame(ring, timestamps, 10000, 4000);
+    aggregator.addFrame(ring.getFrame(slot), timestamps, frequency);
+    CHECK_NEAR(aggregator.getAverageFrameMs(), 10.0, 1e-9);
+
+    const ZoneStats* scene = findZone(aggregator, "scene");
+    if (!CHECK(scene != nullptr))
+    {
+        return;
+    }
+    CHECK_NEAR(scene->averageMs, 4.0, 1e-9);
+
+    slot = recordFrame(ring, timestamps, 20000, 6000);
+    aggregator.addFrame(ring.getFrame(slot), timestamps, frequency);
+    CHECK_NEAR(aggregator.getLastFrameMs(), 20.0, 1e-9);
+    CHECK_NEAR(aggregator.getAverageFrameMs(), 10.0 + (20.0 - 10.0) * 0.05, 1e-9);
+
+    scene = findZone(aggregator, "scene");
+    CHECK_NEAR(scene->lastMs, 6.0, 1e-9);
+    CHECK_NEAR(scene->averageMs, 4.0 + (6.0 - 4.0) * 0.05, 1e-9);
+    CHECK_NEAR(scene->maxMs, 6.0, 1e-9);
+
+    // A steady load converges on its own value
+    for (int i = 0; i < 500; ++i)
+    {
+        slot = recordFrame(ring, timestamps, 16000, 8000);
+        aggregator.addFrame(ring.getFrame(slot), timestamps, frequency);
+    }
+    scene = findZone(aggregator, "scene");
+    CHECK_NEAR(aggregator.getAverageFrameMs(), 16.0, 1e-6);
+    CHECK_NEAR(scene->averageMs, 8.0, 1e-6);
+    CHECK(scene->frameCount == 502);
+
+    // The 6 ms spike has left both max windows by now
+    CHECK_NEAR(scene->maxMs, 8.0, 1e-9);
+}
+
+TEST("gpu_query_ring/marks_split_the_frame")
+{
+    QueryRing ring;
+    Aggregator aggregator;
+    uint64_t timestamps[QueryRing::maxQueries] = {};
+
+    const uint32_t slot = ring.beginFrame();
+    const int shadows = ring.mark("shadows");
+    const int scene = ring.mark("scene");
+    ring.endFrame();
+
+    timestamps[QueryRing::frameBeginQuery] = 0;
+    timestamps[shadows] = 2000;
+    timestamps[scene] = 9000;
+    timestamps[QueryRing::frameEndQuery] = 10000;
+    aggregator.addFrame(ring.getFrame(slot), timestamps, frequency);
+
+    const ZoneStats* shadowStats = findZone(aggregator, "shadows");
+    const ZoneStats* sceneStats = findZone(aggregator, "scene");
+    if (CHECK(shadowStats != nullptr && sceneStats != nullptr))
+    {
+        CHECK_NEAR(shadowStats->lastMs, 2.0, 1e-9);
+        CHECK_NEAR(sceneStats->lastMs, 7.0, 1e-9);
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+// Assertion tests for the parts of the core that don't need the client: the pattern scanner, the GPU query ring, the
+// shader cache index, the software post processing, the depth effects, the resolution controller and the depth pyramid.
+// Built from the core sources with UTINNI_STATIC like the micro benchmarks, so it also runs on Linux:
+//
+//     g++ -std=c++17 -O2 -pthread -DUTINNI_STATIC -DDEFAULT_PLUGINS=\"\" -I../../core -I../../../external -o unit_tests
+//         *.cpp ../../core/utility/pattern_scanner.cpp ../../core/utility/gpu_query_ring.cpp
+//         ../../core/utility/shader_cache_index.cpp ../../core/utility/software_fx.cpp
+//         ../../core/utility/depth_fx.cpp ../../core/utility/resolution_controller.cpp
+//         ../../core/utility/depth_pyramid.cpp
+//
+//     unit_tests [--filter <text>]
+//
+// Exits with 1 when any check failed.
+
+#include "test.h"
+#include <algorithm>
+#include <cstring>
+
+namespace test
+{
+std::vector<Test>& getTests()
+{
+    static std::vector<Test> tests;
+    return tests;
+}
+
+int& getFailureCount()
+{
+    static int failures = 0;
+    return failures;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--filter <text>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<test::Test> tests = test::getTests();
+    std::sort(tests.begin(), tests.end(), [](const test::Test& a, const test::Test& b) { return strcmp(a.name, b.name) < 0; });
+
+    int run = 0;
+    int failed = 0;
+    for (const test::Test& test : tests)
+    {
+        if (filter != nullptr && strstr(test.name, filter) == nullptr)
+        {
+            continue;
+        }
+
+        test::getFailureCount() = 0;
+        test.function();
+        run++;
+
+        if (test::getFailureCount() == 0)
+        {
+            printf("PASS  %s\n", test.name);
+        }
+        else
+        {
+            printf("FAIL  %s\n", test.name);
+            failed++;
+        }
+        fflush(stdout);
+    }
+
+    printf("%d of %d test(s) passed\n", run - failed, run);
+    return failed == 0 ? 0 : 1;
+}
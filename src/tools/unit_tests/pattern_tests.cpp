@@ -0,0 +1,146 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "test.h"
+#include "utility/pattern_scanner.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+constexpr size_t bufferSize = 4096;
+
+// swgptr is 32 bit, so the scanned memory has to live in the low 4 GB on a 64 bit host
+byte* getBuffer()
+{
+    static byte* buffer = nullptr;
+    if (buffer == nullptr)
+    {
+#ifdef _WIN32
+        buffer = new byte[bufferSize];
+#else
+        void* memory = mmap(nullptr, bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+        buffer = memory != MAP_FAILED ? (byte*)memory : nullptr;
+#endif
+    }
+    if (buffer != nullptr)
+    {
+        memset(buffer, 0xCC, bufferSize);
+    }
+    return buffer;
+}
+
+swgptr toAddress(const byte* pointer)
+{
+    return (swgptr)(uintptr_t)pointer;
+}
+}
+
+TEST("pattern/mask_wildcards_ignore_placeholder_bytes")
+{
+    byte* buffer = getBuffer();
+    if (!CHECK(buffer != nullptr))
+    {
+        return;
+    }
+
+    static const byte code[] = { 0xC7, 0x06, 0x10, 0x20, 0x30, 0x40, 0x89, 0x86 };
+    memcpy(buffer + 100, code, sizeof(code));
+
+    // Non-zero placeholders under '?' used to be compared against the masked memory and never matched
+    const memory::Pattern pattern("\xC7\x06\xEE\xEE\xEE\xEE\x89\x86", "xx????xx");
+    CHECK(pattern.isValid());
+    CHECK(pattern.matches(buffer + 100));
+
+    memory::PatternScanner scanner;
+    scanner.add("\xC7\x06\xEE\xEE\xEE\xEE", "xx????");
+    const auto matches = scanner.scan(toAddress(buffer), bufferSize);
+    if (CHECK(matches.size() == 1))
+    {
+        CHECK(matches[0].address == toAddress(buffer + 100));
+    }
+}
+
+TEST("pattern/signature_and_mask_forms_agree")
+{
+    byte* buffer = getBuffer();
+    if (!CHECK(buffer != nullptr))
+    {
+        return;
+    }
+
+    static const byte code[] = { 0x55, 0x8B, 0xEC, 0x6A, 0xFF, 0x68, 0x3C, 0x9A, 0x12, 0x01, 0x64, 0xA1 };
+    memcpy(buffer + 1000, code, sizeof(code));
+
+    memory::PatternScanner scanner;
+    scanner.add("55 8B EC 6A FF 68 ?? ?? ?? ?? 64 A1");
+    scanner.add("\x55\x8B\xEC\x6A\xFF\x68\x01\x02\x03\x04\x64\xA1", "xxxxxx????xx");
+    const auto matches = scanner.scan(toAddress(buffer), bufferSize);
+    if (CHECK(matches.size() == 2))
+    {
+        CHECK(matches[0].address == toAddress(buffer + 1000));
+        CHECK(matches[1].address == toAddress(buffer + 1000));
+    }
+}
+
+TEST("pattern/overlapping_and_first_only")
+{
+    byte* buffer = getBuffer();
+    if (!CHECK(buffer != nullptr))
+    {
+        return;
+    }
+
+    // "AB AB AC" has to be found at 201 even though the compare from 200 fails on the third byte
+    static const byte code[] = { 0xAB, 0xAB, 0xAB, 0xAC };
+    memcpy(buffer + 200, code, sizeof(code));
+    memcpy(buffer + 3000, code, sizeof(code));
+
+    memory::PatternScanner scanner;
+    scanner.add("AB AB AC");
+    const auto all = scanner.scan(toAddress(buffer), bufferSize);
+    if (CHECK(all.size() == 2))
+    {
+        CHECK(all[0].address == toAddress(buffer + 201));
+        CHECK(all[1].address == toAddress(buffer + 3001));
+    }
+
+    const auto first = scanner.scan(toAddress(buffer), bufferSize, true);
+    if (CHECK(first.size() == 1))
+    {
+        CHECK(first[0].address == toAddress(buffer + 201));
+    }
+}
+
+TEST("pattern/invalid_patterns")
+{
+    CHECK(!memory::Pattern("?? ?? ??").isValid());
+    CHECK(!memory::Pattern("8B 4").isValid());
+    CHECK(!memory::Pattern("8B XY").isValid());
+    CHECK(!memory::Pattern("\x01\x02", "??").isValid());
+    CHECK(memory::Pattern("8b ? 4C").isValid());
+}
@@ -0,0 +1,145 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "test.h"
+#include "utility/resolution_controller.h"
+#include <algorithm>
+#include <vector>
+
+using utinni::gpu::ResolutionController;
+
+namespace
+{
+// A trace of what the scene would cost at full resolution, frame by frame. Replaying it charges each frame with the cost
+// scaled by the pixel count the controller picked for it
+struct Trace
+{
+    std::vector<float> fullScaleMs;
+
+    Trace& add(float ms, uint32_t frames)
+    {
+        fullScaleMs.insert(fullScaleMs.end(), frames, ms);
+        return *this;
+    }
+};
+
+// The scale after every frame
+std::vector<float> replay(ResolutionController& controller, const Trace& trace)
+{
+    std::vector<float> scales;
+    scales.reserve(trace.fullScaleMs.size());
+    for (const float ms : trace.fullScaleMs)
+    {
+        const float scale = controller.getScale();
+        scales.push_back(controller.update(ms * scale * scale));
+    }
+    return scales;
+}
+}
+
+TEST("resolution_controller/drops_soon_after_going_over")
+{
+    ResolutionController controller;
+    const ResolutionController::Settings& settings = controller.getSettings();
+    const std::vector<float> scales = replay(controller, Trace().add(10, 120).add(25, 120));
+
+    // Nothing moves while the frames fit
+    CHECK(std::all_of(scales.begin(), scales.begin() + 120, [](float scale) { return scale == 1.0f; }));
+
+    const size_t firstDrop = (size_t)(std::find_if(scales.begin() + 120, scales.end(), [](float scale) { return scale < 1.0f; }) - scales.begin());
+    if (!CHECK(firstDrop < scales.size()))
+    {
+        return;
+    }
+    CHECK(firstDrop - 120 < settings.dropFrames + settings.settleFrames);
+
+    // Every change is bounded and settles before the next
+    for (size_t i = 121; i < scales.size(); ++i)
+    {
+        CHECK(std::abs(scales[i] - scales[i - 1]) <= settings.maxStep + 1e-4f);
+    }
+    CHECK(scales.back() * scales.back() * 25 <= settings.targetMs);
+}
+
+TEST("resolution_controller/never_below_min_scale")
+{
+    for (const float minScale : { 0.5f, 0.7f })
+    {
+        ResolutionController controller;
+        ResolutionController::Settings settings;
+        settings.minScale = minScale;
+        controller.setSettings(settings);
+
+        // Far more than even the lowest scale can absorb
+        const std::vector<float> scales = replay(controller, Trace().add(200, 600));
+        CHECK(*std::min_element(scales.begin(), scales.end()) >= minScale - 1e-4f);
+        CHECK_NEAR(scales.back(), minScale, 1e-4f);
+    }
+}
+
+TEST("resolution_controller/single_hitch_keeps_scale")
+{
+    // At full scale with room to spare
+    ResolutionController controller;
+    replay(controller, Trace().add(15, 120));
+    CHECK(controller.getScale() == 1.0f);
+    CHECK(controller.getChangeCount() == 0);
+
+    std::vector<float> scales = replay(controller, Trace().add(30, 1).add(15, 300));
+    CHECK(std::all_of(scales.begin(), scales.end(), [](float scale) { return scale == 1.0f; }));
+    CHECK(controller.getChangeCount() == 0);
+
+    // Settled at a reduced scale, the same hitch in frame time is absorbed as well
+    controller.reset();
+    replay(controller, Trace().add(22, 600));
+    const float settled = controller.getScale();
+    const uint64_t changes = controller.getChangeCount();
+    CHECK(settled < 1.0f);
+
+    scales = replay(controller, Trace().add(30 / (settled * settled), 1).add(22, 300));
+    CHECK(std::all_of(scales.begin(), scales.end(), [&](float scale) { return scale == settled; }));
+    CHECK(controller.getChangeCount() == changes);
+}
+
+TEST("resolution_controller/recovers_after_load")
+{
+    ResolutionController controller;
+    const ResolutionController::Settings& settings = controller.getSettings();
+    replay(controller, Trace().add(40, 300));
+    CHECK(controller.getScale() < 0.7f);
+
+    // Back to a light scene, raises are slow but get all the way back
+    const std::vector<float> scales = replay(controller, Trace().add(8, 1200));
+    CHECK(scales.back() == settings.maxScale);
+    for (size_t i = 1; i < scales.size(); ++i)
+    {
+        CHECK(scales[i] >= scales[i - 1]);
+    }
+
+    // And it stays there
+    const uint64_t changes = controller.getChangeCount();
+    replay(controller, Trace().add(8, 600));
+    CHECK(controller.getScale() == settings.maxScale);
+    CHECK(controller.getChangeCount() == changes);
+}
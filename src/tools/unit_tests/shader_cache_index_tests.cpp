@@ -0,0 +1,163 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "test.h"
+#include "utility/shader_cache_index.h"
+#include <algorithm>
+
+namespace shaderCache = utinni::shaderCache;
+
+namespace
+{
+std::vector<uint8_t> makeBytecode(size_t size)
+{
+    std::vector<uint8_t> bytecode(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        bytecode[i] = (uint8_t)(i * 31 + 7);
+    }
+    return bytecode;
+}
+}
+
+TEST("shader_cache_index/keys")
+{
+    static const char shaderSource[] = "float4 main() : COLOR { return 1; }";
+    const uint64_t source = shaderCache::hash(shaderSource, sizeof(shaderSource) - 1);
+    const uint64_t key = shaderCache::makeKey(source, "ps_3_0", "main", { { "HUE", "1" }, { "GAMMA", "1" } });
+
+    CHECK(key == shaderCache::makeKey(source, "ps_3_0", "main", { { "GAMMA", "1" }, { "HUE", "1" } }));
+    CHECK(key != shaderCache::makeKey(source, "ps_3_0", "main", { { "HUE", "1" } }));
+    CHECK(key != shaderCache::makeKey(source, "ps_2_0", "main", { { "HUE", "1" }, { "GAMMA", "1" } }));
+    CHECK(key != shaderCache::makeKey(source + 1, "ps_3_0", "main", { { "HUE", "1" }, { "GAMMA", "1" } }));
+    CHECK(shaderCache::makeKey(source, "ps_3_0", "ab", { { "c", "" } }) != shaderCache::makeKey(source, "ps_3_0", "a", { { "bc", "" } }));
+    CHECK(shaderCache::getFileName(0x0123456789abcdefull) == "0123456789abcdef.cso");
+}
+
+TEST("shader_cache_index/pack_unpack_round_trip")
+{
+    const std::vector<uint8_t> bytecode = makeBytecode(1000);
+    const std::vector<uint8_t> file = shaderCache::pack(42, bytecode);
+
+    std::vector<uint8_t> unpacked;
+    CHECK(shaderCache::unpack(file, 42, unpacked));
+    CHECK(unpacked == bytecode);
+
+    std::vector<uint8_t> empty;
+    CHECK(shaderCache::unpack(shaderCache::pack(7, {}), 7, empty));
+    CHECK(empty.empty());
+}
+
+TEST("shader_cache_index/unpack_rejects_damaged_files")
+{
+    const std::vector<uint8_t> bytecode = makeBytecode(256);
+    const std::vector<uint8_t> file = shaderCache::pack(42, bytecode);
+    std::vector<uint8_t> unpacked;
+
+    // A flipped bit in the bytecode only shows up in the checksum
+    std::vector<uint8_t> corrupted = file;
+    corrupted[corrupted.size() - 10] ^= 0x04;
+    CHECK(!shaderCache::unpack(corrupted, 42, unpacked));
+
+    // So does one in the stored checksum, the last 8 bytes of the header
+    corrupted = file;
+    corrupted[file.size() - bytecode.size() - 1] ^= 0x80;
+    CHECK(!shaderCache::unpack(corrupted, 42, unpacked));
+
+    std::vector<uint8_t> truncated(file.begin(), file.end() - 1);
+    CHECK(!shaderCache::unpack(truncated, 42, unpacked));
+
+    std::vector<uint8_t> extended = file;
+    extended.push_back(0);
+    CHECK(!shaderCache::unpack(extended, 42, unpacked));
+
+    std::vector<uint8_t> headerOnly(file.begin(), file.begin() + 8);
+    CHECK(!shaderCache::unpack(headerOnly, 42, unpacked));
+
+    CHECK(!shaderCache::unpack(file, 43, unpacked));
+    CHECK(unpacked.empty());
+}
+
+TEST("shader_cache_index/serialize_round_trip")
+{
+    shaderCache::Index index;
+    index.beginSession();
+    index.touch(0xfedcba9876543210ull, 1000);
+    index.beginSession();
+    index.touch(1, 200);
+    index.touch(2, 30);
+
+    shaderCache::Index loaded;
+    loaded.deserialize(index.serialize());
+    CHECK(loaded.getSession() == 2);
+    CHECK(loaded.getCount() == 3);
+    CHECK(loaded.getTotalSize() == 1230);
+    CHECK(loaded.contains(0xfedcba9876543210ull));
+    CHECK(loaded.contains(1) && loaded.contains(2));
+    CHECK(loaded.serialize() == index.serialize());
+
+    // Unreadable lines are skipped, a repeated key replaces the earlier one
+    loaded.deserialize("session 5\ngarbage\n0000000000000003 100 4\n0000000000000003 50 5\n\nzz 1 1\n");
+    CHECK(loaded.getSession() == 5);
+    CHECK(loaded.getCount() == 1);
+    CHECK(loaded.getTotalSize() == 50);
+}
+
+TEST("shader_cache_index/evicts_least_recently_used")
+{
+    shaderCache::Index index;
+    index.beginSession(); // 1
+    index.touch(1, 100);
+    index.touch(2, 100);
+    index.beginSession(); // 2
+    index.touch(3, 100);
+    index.beginSession(); // 3
+    index.touch(4, 100);
+    index.touch(1, 100); // Used again, now the newest
+
+    CHECK(index.evict(400).empty());
+
+    std::vector<uint64_t> evicted = index.evict(250);
+    std::sort(evicted.begin(), evicted.end());
+    if (CHECK(evicted.size() == 2))
+    {
+        CHECK(evicted[0] == 2);
+        CHECK(evicted[1] == 3);
+    }
+    CHECK(index.getTotalSize() == 200);
+    CHECK(index.contains(1) && index.contains(4));
+
+    // The evicted state survives a save and load
+    shaderCache::Index loaded;
+    loaded.deserialize(index.serialize());
+    CHECK(loaded.getCount() == 2);
+    CHECK(loaded.getTotalSize() == 200);
+    CHECK(!loaded.contains(2) && !loaded.contains(3));
+
+    index.remove(4);
+    index.remove(4);
+    CHECK(index.getTotalSize() == 100);
+    CHECK(index.evict(0).size() == 1);
+    CHECK(index.getCount() == 0 && index.getTotalSize() == 0);
+}
@@ -0,0 +1,266 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#include "test.h"
+#include "utility/software_fx.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace utinni::softwareFx;
+
+namespace
+{
+// Every channel value shows up, so the per channel tables are covered completely
+Image makeTestImage(uint32_t width, uint32_t height)
+{
+    Image image(width, height);
+    uint32_t state = 0x2468ace0;
+    for (size_t i = 0; i < image.pixels.size(); ++i)
+    {
+        state = state * 1664525 + 1013904223;
+        image.pixels[i] = i < 256 * 4 ? (uint8_t)(i / 4) : (uint8_t)(state >> 24);
+    }
+    return image;
+}
+
+// A strip that maps every colour to itself, the LUT texel values are exact in 8 bits for a size of 16
+Image makeLutStrip(uint32_t size, bool invert)
+{
+    Image strip(size * size, size);
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        uint8_t* row = strip.getRow(y);
+        for (uint32_t x = 0; x < size * size; ++x)
+        {
+            const uint32_t values[3] = { x % size, y, x / size };
+            for (uint32_t channel = 0; channel < 3; ++channel)
+            {
+                const uint8_t value = (uint8_t)(values[channel] * 255 / (size - 1));
+                row[x * 4 + channel] = invert ? (uint8_t)(255 - value) : value;
+            }
+            row[x * 4 + 3] = 255;
+        }
+    }
+    return strip;
+}
+
+// Largest difference over the colour channels, alpha is ignored since the full screen passes write it as 1
+int getMaxColourDifference(const Image& a, const Image& b)
+{
+    if (a.width != b.width || a.height != b.height)
+    {
+        return 256;
+    }
+
+    int difference = 0;
+    for (size_t i = 0; i < a.pixels.size(); ++i)
+    {
+        if (i % 4 != 3)
+        {
+            difference = std::max(difference, std::abs((int)a.pixels[i] - (int)b.pixels[i]));
+        }
+    }
+    return difference;
+}
+
+Image makeFlatImage(uint32_t width, uint32_t height, uint8_t value)
+{
+    Image image(width, height);
+    for (size_t i = 0; i < image.pixels.size(); ++i)
+    {
+        image.pixels[i] = i % 4 == 3 ? 255 : value;
+    }
+    return image;
+}
+
+uint8_t* getPixel(Image& image, uint32_t x, uint32_t y)
+{
+    return image.getRow(y) + x * 4;
+}
+}
+
+TEST("software_fx/neutral_settings_are_identity")
+{
+    const Image src = makeTestImage(64, 48);
+    Settings settings;
+    settings.threadCount = 2;
+    Image dst;
+
+    hue(src, dst, settings);
+    CHECK(dst.pixels == src.pixels);
+
+    gamma(src, dst, settings);
+    CHECK(dst.pixels == src.pixels);
+
+    sharpen(src, dst, settings);
+    CHECK(getMaxColourDifference(dst, src) == 0);
+
+    for (const uint32_t stages : { (uint32_t)Stage_Hue, (uint32_t)Stage_Sharpen, (uint32_t)Stage_Gamma, (uint32_t)(Stage_Hue | Stage_Sharpen | Stage_Gamma) })
+    {
+        fused(src, dst, stages, settings);
+        CHECK(getMaxColourDifference(dst, src) == 0);
+    }
+}
+
+TEST("software_fx/identity_lut")
+{
+    const Image src = makeTestImage(64, 48);
+    Lut lut;
+    CHECK(lut.load(makeLutStrip(16, false)));
+    CHECK(!lut.load(Image(16, 15)));
+
+    Settings settings;
+    settings.lut = &lut;
+    Image dst;
+
+    grading(src, dst, settings);
+    CHECK(getMaxColourDifference(dst, src) == 0);
+
+    fused(src, dst, Stage_Grading, settings);
+    CHECK(getMaxColourDifference(dst, src) == 0);
+
+    // Point filtering snaps to the nearest of the 16 levels
+    settings.lutSampler.filter = Filter::point;
+    grading(src, dst, settings);
+    CHECK(getMaxColourDifference(dst, src) <= 255 / 15 / 2 + 1);
+}
+
+TEST("software_fx/golden_inverted_lut")
+{
+    Lut lut;
+    CHECK(lut.load(makeLutStrip(2, true)));
+    Settings settings;
+    settings.lut = &lut;
+
+    Image src(2, 1);
+    const uint8_t pixels[] = { 0, 64, 200, 10, 255, 128, 1, 20 };
+    std::copy(pixels, pixels + sizeof(pixels), src.pixels.begin());
+
+    Image dst;
+    grading(src, dst, settings);
+    const uint8_t expected[] = { 255, 191, 55, 10, 0, 127, 254, 20 }; // Alpha passes through
+    CHECK(dst.pixels == std::vector<uint8_t>(expected, expected + sizeof(expected)));
+}
+
+TEST("software_fx/golden_hue_and_gamma")
+{
+    Image src(3, 1);
+    const uint8_t pixels[] = { 200, 100, 100, 255, 64, 128, 200, 255, 255, 0, 255, 255 };
+    std::copy(pixels, pixels + sizeof(pixels), src.pixels.begin());
+
+    Settings settings;
+    settings.tone[0] = 0.5f;
+    settings.tone[2] = 2.0f;
+    Image dst;
+    hue(src, dst, settings);
+    const uint8_t hueExpected[] = { 100, 100, 200, 255, 32, 128, 255, 255, 128, 0, 255, 255 };
+    CHECK(dst.pixels == std::vector<uint8_t>(hueExpected, hueExpected + sizeof(hueExpected)));
+
+    // pow(x, 1 / 2.2) rounded to 8 bits
+    settings = Settings();
+    settings.gamma = 2.2f;
+    gamma(src, dst, settings);
+    const uint8_t gammaExpected[] = { 228, 167, 167, 255, 136, 186, 228, 255, 255, 0, 255, 255 };
+    CHECK(dst.pixels == std::vector<uint8_t>(gammaExpected, gammaExpected + sizeof(gammaExpected)));
+
+    fused(src, dst, Stage_Gamma, settings);
+    CHECK(getMaxColourDifference(dst, src) > 0);
+    Image separate;
+    gamma(src, separate, settings);
+    CHECK(getMaxColourDifference(dst, separate) <= 1);
+}
+
+TEST("software_fx/golden_sharpen")
+{
+    // One brighter pixel on a flat background, the cross around it darkens and the diagonals stay
+    Image src = makeFlatImage(5, 5, 40);
+    getPixel(src, 2, 2)[0] = getPixel(src, 2, 2)[1] = getPixel(src, 2, 2)[2] = 120;
+
+    Settings settings;
+    settings.sharpenAmount = 0.25f;
+    Image dst;
+    sharpen(src, dst, settings);
+
+    CHECK(getPixel(dst, 2, 2)[0] == 200); // 120 + (4 * 120 - 4 * 40) / 4
+    CHECK(getPixel(dst, 2, 1)[1] == 20);  // 40 + (4 * 40 - 120 - 3 * 40) / 4
+    CHECK(getPixel(dst, 1, 2)[2] == 20);
+    CHECK(getPixel(dst, 3, 2)[0] == 20);
+    CHECK(getPixel(dst, 2, 3)[0] == 20);
+    CHECK(getPixel(dst, 1, 1)[0] == 40);
+    CHECK(getPixel(dst, 0, 0)[0] == 40); // Clamped edges see the same flat background
+    CHECK(getPixel(dst, 4, 4)[3] == 255);
+
+    Image fusedDst;
+    fused(src, fusedDst, Stage_Sharpen, settings);
+    CHECK(getMaxColourDifference(fusedDst, dst) == 0);
+}
+
+TEST("software_fx/process_orders_and_fuses_the_chain")
+{
+    const Image src = makeTestImage(32, 32);
+    Settings settings;
+    settings.tone[1] = 0.75f;
+    settings.sharpenAmount = 0.3f;
+    settings.gamma = 1.8f;
+
+    // Separate passes through process match running the stages by hand in plugin order
+    Image separate;
+    process(src, separate, Stage_Gamma | Stage_Sharpen | Stage_Hue, settings, false);
+    Image coloured;
+    Image sharpened;
+    Image expected;
+    hue(src, coloured, settings);
+    sharpen(coloured, sharpened, settings);
+    gamma(sharpened, expected, settings);
+    CHECK(getMaxColourDifference(separate, expected) == 0);
+
+    Image fusedDst;
+    process(src, fusedDst, Stage_Gamma | Stage_Sharpen | Stage_Hue, settings, true);
+    Image direct;
+    fused(src, direct, Stage_Hue | Stage_Sharpen | Stage_Gamma, settings);
+    CHECK(getMaxColourDifference(fusedDst, direct) == 0);
+
+    // No stages is a copy
+    Image copy;
+    process(src, copy, 0, settings, true);
+    CHECK(copy.pixels == src.pixels);
+}
+
+TEST("software_fx/threading_does_not_change_the_result")
+{
+    const Image src = makeTestImage(100, 77);
+    Settings settings;
+    settings.tone[0] = 1.2f;
+    settings.sharpenAmount = 0.4f;
+    settings.gamma = 0.8f;
+
+    settings.threadCount = 1;
+    Image single;
+    process(src, single, Stage_Hue | Stage_Sharpen | Stage_Gamma, settings, true);
+
+    settings.threadCount = 7;
+    Image threaded;
+    process(src, threaded, Stage_Hue | Stage_Sharpen | Stage_Gamma, settings, true);
+    CHECK(threaded.pixels == single.pixels);
+}
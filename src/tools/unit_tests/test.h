@@ -0,0 +1,90 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Philip Klatt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+**/
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Minimal assertion harness. A failed CHECK reports the expression and keeps going, so one run shows every broken
+// invariant of a test; the runner exits non-zero when any check failed.
+namespace test
+{
+using Function = void (*)();
+
+struct Test
+{
+    const char* name;
+    Function function;
+};
+
+std::vector<Test>& getTests();
+
+// Failed checks of the test that is currently running
+int& getFailureCount();
+
+struct Registration
+{
+    Registration(const char* name, Function function)
+    {
+        getTests().push_back({ name, function });
+    }
+};
+
+inline bool check(bool passed, const char* expression, const char* file, int line)
+{
+    if (!passed)
+    {
+        printf("    %s(%d): CHECK(%s) failed\n", file, line, expression);
+        getFailureCount()++;
+    }
+    return passed;
+}
+
+inline bool checkNear(double actual, double expected, double tolerance, const char* expression, const char* file, int line)
+{
+    const bool passed = std::fabs(actual - expected) <= tolerance;
+    if (!passed)
+    {
+        printf("    %s(%d): CHECK_NEAR(%s) failed, %g is not within %g of %g\n", file, line, expression, actual, tolerance, expected);
+        getFailureCount()++;
+    }
+    return passed;
+}
+}
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+// TEST("group/name") { CHECK(...); }
+#define TEST(name) TEST_IMPL(name, TEST_CONCAT(test_, __LINE__))
+#define TEST_IMPL(name, function) \
+    static void function(); \
+    static test::Registration TEST_CONCAT(function, _registration)(name, function); \
+    static void function()
+
+// Both return whether the check passed, so a test can bail out before indexing into a result that isn't there
+#define CHECK(expression) test::check((expression), #expression, __FILE__, __LINE__)
+#define CHECK_NEAR(actual, expected, tolerance) test::checkNear((actual), (expected), (tolerance), #actual " ~ " #expected, __FILE__, __LINE__)